@@ -30,7 +30,6 @@
 #include <cassert>
 
 #include <QtCore/QMutex>
-#include <QtCore/QAtomicInt>
 #include <QtCore/QTimer>
 #include <QtCore/QDebug>
 
@@ -54,7 +53,7 @@ struct AbortableRenderInfoPrivate
 {
     AbortableRenderInfo* _p;
     bool canAbort;
-    QAtomicInt aborted;
+    RenderAbortFlagPtr abortFlag;
     U64 age;
     mutable QMutex threadsMutex;
     ThreadSet threadsForThisRender;
@@ -68,7 +67,7 @@ struct AbortableRenderInfoPrivate
                                U64 age)
         : _p(p)
         , canAbort(canAbort)
-        , aborted()
+        , abortFlag(new RenderAbortFlag)
         , age(age)
         , threadsMutex()
         , threadsForThisRender()
@@ -77,8 +76,6 @@ struct AbortableRenderInfoPrivate
         , abortTimeoutTimer(new QTimer)
         , ownerThread( QThread::currentThread() )
     {
-        aborted.fetchAndStoreAcquire(0);
-
         abortTimeoutTimer->setSingleShot(true);
         QObject::connect( abortTimeoutTimer, SIGNAL(timeout()), p, SLOT(onAbortTimerTimeout()) );
         QObject::connect( p, SIGNAL(startTimerInOriginalThread()), p, SLOT(onStartTimerInOriginalThreadTriggered()) );
@@ -119,15 +116,19 @@ AbortableRenderInfo::canAbort() const
 bool
 AbortableRenderInfo::isAborted() const
 {
-    return (int)_imp->aborted > 0;
+    return _imp->abortFlag->isAborted();
+}
+
+const RenderAbortFlagPtr&
+AbortableRenderInfo::getAbortFlag() const
+{
+    return _imp->abortFlag;
 }
 
 void
 AbortableRenderInfo::setAborted()
 {
-    int abortedValue = _imp->aborted.fetchAndAddAcquire(1);
-
-    if (abortedValue > 0) {
+    if ( !_imp->abortFlag->setAborted() ) {
         return;
     }
     bool callInSeparateThread = false;
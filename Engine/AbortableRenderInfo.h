@@ -31,16 +31,57 @@
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #endif
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
 
 #include "Engine/EngineFwd.h"
 
 
+// The size of a cache line on the architectures we run on
+#define NATRON_CACHE_LINE_SIZE 64
+
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief The abort state of one render. The render threads get it with the ParallelRenderArgs of the frame
+ * they render and poll it in EffectInstance::aborted(), which plug-ins may call in their inner loops: it is
+ * alone on its cache line so that polling it never competes with writes to neighbouring data.
+ **/
+class RenderAbortFlag
+{
+public:
+
+    RenderAbortFlag()
+        : _aborted(0)
+    {
+    }
+
+    bool isAborted() const
+    {
+        return (int)_aborted != 0;
+    }
+
+    /**
+     * @brief Returns false if the render was already aborted
+     **/
+    bool setAborted()
+    {
+        return _aborted.fetchAndStoreOrdered(1) == 0;
+    }
+
+private:
+
+CLANG_DIAG_OFF(unused-private-field)
+    char _paddingBefore[NATRON_CACHE_LINE_SIZE];
+    QAtomicInt _aborted;
+    char _paddingAfter[NATRON_CACHE_LINE_SIZE - sizeof(QAtomicInt)];
+CLANG_DIAG_ON(unused-private-field)
+};
+
 /**
  * @brief Holds infos necessary to identify one render request and whether it was aborted or not.
  *
@@ -107,6 +148,9 @@ public:
     // Is this render aborted ? This is extremely fast as it just dereferences an atomic integer
     bool isAborted() const;
 
+    // The flag behind isAborted(), to be polled by the render threads without holding this object
+    const RenderAbortFlagPtr& getAbortFlag() const;
+
     /**
      * @brief Set this render as aborted, cannot be reversed. This is call when the function GenericSchedulerThread::abortThreadedTask() is called
      **/
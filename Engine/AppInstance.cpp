@@ -605,6 +605,21 @@ AppInstance::loadInternal(const CLArgs& cl,
 
 
         if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+            ///When given the writers to render, only create the nodes they need. Python commands
+            ///passed on the command-line may reference any node, in which case everything is loaded.
+            const std::list<CLArgs::WriterArg>& writerArgs = cl.getWriterArgs();
+            if ( !writerArgs.empty() && cl.getPythonCommands().empty() && cl.getDefaultOnProjectLoadedScript().isEmpty() ) {
+                std::list<std::string> outputs;
+                for (std::list<CLArgs::WriterArg>::const_iterator it = writerArgs.begin(); it != writerArgs.end(); ++it) {
+                    outputs.push_back( it->name.toStdString() );
+                }
+                const std::list<CLArgs::ReaderArg>& readerArgs = cl.getReaderArgs();
+                for (std::list<CLArgs::ReaderArg>::const_iterator it = readerArgs.begin(); it != readerArgs.end(); ++it) {
+                    outputs.push_back( it->name.toStdString() );
+                }
+                _imp->_currentProject->setLazyLoadOutputs(outputs);
+            }
+
             ///Load the project
             if ( !_imp->_currentProject->loadProject( info.path(), info.fileName() ) ) {
                 throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
@@ -906,6 +921,8 @@ AppInstance::createNodeFromPythonModule(Plugin* plugin,
 
         int appID = getAppID() + 1;
         std::stringstream ss;
+        // The module is not imported at launch when its informations were found in the PyPlugs cache
+        ss << "import " << moduleName.toStdString() << "\n";
         ss << moduleName.toStdString();
         ss << ".createInstance(app" << appID;
         if (istoolsetScript) {
@@ -1591,7 +1608,14 @@ AppInstance::exportDocs(const QString path)
 NodePtr
 AppInstance::getNodeByFullySpecifiedName(const std::string & name) const
 {
-    return _imp->_currentProject->getNodeByFullySpecifiedName(name);
+    NodePtr ret = _imp->_currentProject->getNodeByFullySpecifiedName(name);
+
+    if ( !ret && _imp->_currentProject->hasDormantNodes() ) {
+        _imp->_currentProject->loadDormantNodes();
+        ret = _imp->_currentProject->getNodeByFullySpecifiedName(name);
+    }
+
+    return ret;
 }
 
 ProjectPtr
@@ -1728,6 +1752,8 @@ AppInstance::startWritersRenderingFromNames(bool enableRenderStats,
         }
     } else {
         //start rendering for all writers found in the project
+        // A project reused by a render server job may have been loaded lazily for other writers: load them all
+        getProject()->loadDormantNodes();
         std::list<OutputEffectInstance*> writers;
         getProject()->getWriters(&writers);
 
@@ -1789,7 +1815,9 @@ AppInstance::startWritersRendering(bool doBlockingRender,
         item.savePath = savePath;
 
         if (renderInSeparateProcess) {
-            item.process = boost::make_shared<ProcessHandler>(savePath, item.work.writer);
+            item.process = boost::make_shared<ProcessHandler>(savePath, item.work.writer,
+                                                              item.work.firstFrame, item.work.lastFrame, item.work.frameStep,
+                                                              appPTR->getCurrentSettings()->getNumberOfRenderProcesses());
             QObject::connect( item.process.get(), SIGNAL(processFinished(int)), this, SLOT(onBackgroundRenderProcessFinished()) );
         } else {
             QObject::connect(item.work.writer->getRenderEngine().get(), SIGNAL(renderFinished(int)), this, SLOT(onQueuedRenderFinished(int)), Qt::UniqueConnection);
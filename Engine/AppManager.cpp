@@ -125,12 +125,14 @@
 #include "Engine/ProcessHandler.h" // ProcessInputChannel
 #include "Engine/Project.h"
 #include "Engine/PrecompNode.h"
+#include "Engine/PyPlugCache.h"
 #include "Engine/ReadNode.h"
 #include "Engine/RotoPaint.h"
 #include "Engine/RotoSmear.h"
 #include "Engine/StandardPaths.h"
 #include "Engine/TrackerNode.h"
 #include "Engine/ThreadPool.h"
+#include "Engine/Timer.h"
 #include "Engine/Utils.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h" // RenderStatsMap
@@ -1073,6 +1075,7 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
 
         _imp->_nodeCache = boost::make_shared<Cache<Image> >("NodeCache", NATRON_CACHE_VERSION, maxCacheRAM, 1.);
         _imp->_diskCache = boost::make_shared<Cache<Image> >("DiskCache", NATRON_CACHE_VERSION, maxDiskCacheNode, 0.);
+        _imp->_diskCache->setCompressionEnabled( _imp->_settings->isDiskCacheNodeCompressionEnabled() );
         _imp->_viewerCache = boost::make_shared<Cache<FrameEntry> >("ViewerCache", NATRON_CACHE_VERSION, viewerCacheSize, 0.);
         _imp->setViewerCacheTileSize();
     } catch (std::logic_error&) {
@@ -1156,6 +1159,26 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
     } else {
         onLoadCompleted();
 
+        ///In render server mode, render the jobs sent by clients until asked to quit, re-using the loaded plug-ins and project
+        if ( (_imp->_appType == eAppTypeBackground) && !args.getRenderServerName().isEmpty() ) {
+            _imp->renderServer.reset( new RenderServer( args.getRenderServerName() ) );
+            int ret = _imp->renderServer->exec(mainInstance);
+            _imp->renderServer.reset();
+            try {
+                mainInstance->getProject()->reset(true/*aboutToQuit*/, true /*blocking*/);
+            } catch (std::logic_error&) {
+                // ignore
+            }
+
+            try {
+                mainInstance->quitNow();
+            } catch (std::logic_error&) {
+                // ignore
+            }
+
+            return ret == 0;
+        }
+
         ///In background project auto-run the rendering is finished at this point, just exit the instance
         if ( ( (_imp->_appType == eAppTypeBackgroundAutoRun) ||
                ( _imp->_appType == eAppTypeBackgroundAutoRunLaunchedFromGui) ||
@@ -1475,6 +1498,10 @@ AppManager::writeToOutputPipe(const QString & longMessage,
                               const QString & shortMessage,
                               bool printIfNoChannel)
 {
+    if (_imp->renderServer) {
+        // Report the progress of the job to the client that sent it
+        _imp->renderServer->writeToClient(shortMessage);
+    }
     if (!_imp->_backgroundIPC) {
         if (printIfNoChannel) {
             QMutexLocker k(&_imp->errorLogMutex);
@@ -1510,26 +1537,52 @@ AppManager::setApplicationsCachesMaximumDiskSpace(unsigned long long size)
     _imp->_diskCache->setMaximumCacheSize(size);
 }
 
+void
+AppManager::setDiskCacheCompressionEnabled(bool enabled)
+{
+    _imp->_diskCache->setCompressionEnabled(enabled);
+}
+
 void
 AppManager::loadAllPlugins()
 {
     assert( _imp->_plugins.empty() );
     assert( _imp->_formats.empty() );
 
+    // When NATRON_STARTUP_TIMINGS is set, print how long each step takes so that startup can be benchmarked
+    bool printTimings = !qgetenv(NATRON_STARTUP_TIMINGS_ENV_VAR).isEmpty();
+    TimeLapse timer;
+    double builtinTime, ofxTime, pythonTime, settingsTime, labelsTime;
+
     // Load plug-ins bundled into Natron
     loadBuiltinNodePlugins(&_imp->readerPlugins, &_imp->writerPlugins);
+    builtinTime = timer.getTimeElapsedReset();
 
     // Load OpenFX plug-ins
     _imp->ofxHost->loadOFXPlugins( &_imp->readerPlugins, &_imp->writerPlugins);
+    ofxTime = timer.getTimeElapsedReset();
 
     // Load PyPlugs and init.py & initGui.py scripts
     // Should be done after settings are declared
     loadPythonGroups();
+    pythonTime = timer.getTimeElapsedReset();
 
     _imp->_settings->restorePluginSettings();
+    settingsTime = timer.getTimeElapsedReset();
 
 
     onAllPluginsLoaded();
+    labelsTime = timer.getTimeElapsedReset();
+
+    if (printTimings) {
+        std::cout << "Startup timings (s): built-in plug-ins: " << builtinTime
+                  << ", OpenFX plug-ins: " << ofxTime
+                  << ", PyPlugs and init scripts: " << pythonTime
+                  << ", plug-in settings: " << settingsTime
+                  << ", plug-in labels: " << labelsTime
+                  << ", total: " << timer.getTimeSinceCreation()
+                  << " (" << _imp->_plugins.size() << " plug-ins)" << std::endl;
+    }
 }
 
 void
@@ -1548,6 +1601,26 @@ AppManager::onAllPluginsLoaded()
 
     //Make sure there is no duplicates with the same label
     const PluginsMap& plugins = getPluginsList();
+
+    // For each label without suffix, the user creatable plug-ins having it, in the order of the plug-ins map.
+    // This avoids comparing every plug-in against every other one, which is slow with thousands of plug-ins.
+    std::map<QString, std::vector<PluginsMap::const_iterator> > pluginsByLabel;
+    for (PluginsMap::const_iterator it = plugins.begin(); it != plugins.end(); ++it) {
+        if ( it->second.empty() ) {
+            continue;
+        }
+        bool isUserCreatable = false;
+        for (PluginVersionsOrdered::reverse_iterator itver = it->second.rbegin(); itver != it->second.rend(); ++itver) {
+            if ( (*itver)->getIsUserCreatable() ) {
+                isUserCreatable = true;
+                break;
+            }
+        }
+        if (isUserCreatable) {
+            pluginsByLabel[Plugin::makeLabelWithoutSuffix( (*it->second.rbegin())->getPluginLabel() )].push_back(it);
+        }
+    }
+
     for (PluginsMap::const_iterator it = plugins.begin(); it != plugins.end(); ++it) {
         assert( !it->second.empty() );
         if (it->second.empty()) {
@@ -1569,35 +1642,20 @@ AppManager::onAllPluginsLoaded()
         QString labelWithoutSuffix = Plugin::makeLabelWithoutSuffix( (*first)->getPluginLabel() );
 
         //Find a duplicate
-        for (PluginsMap::const_iterator it2 = plugins.begin(); it2 != plugins.end(); ++it2) {
-            if (it->first == it2->first) {
-                continue;
-            }
-
-
-            PluginVersionsOrdered::reverse_iterator other = it2->second.rbegin();
-            bool isOtherUserCreatable = false;
-            for (PluginVersionsOrdered::reverse_iterator it2ver = it2->second.rbegin(); it2ver != it2->second.rend(); ++it2ver) {
-                if ( (*it2ver)->getIsUserCreatable() ) {
-                    isOtherUserCreatable = true;
-                    break;
-                }
-            }
-
-            if (!isOtherUserCreatable) {
+        const std::vector<PluginsMap::const_iterator>& sameLabel = pluginsByLabel[labelWithoutSuffix];
+        for (std::vector<PluginsMap::const_iterator>::const_iterator it2 = sameLabel.begin(); it2 != sameLabel.end(); ++it2) {
+            if (it->first == (*it2)->first) {
                 continue;
             }
 
-            QString otherLabelWithoutSuffix = Plugin::makeLabelWithoutSuffix( (*other)->getPluginLabel() );
-            if (otherLabelWithoutSuffix == labelWithoutSuffix) {
-                QString otherGrouping = (*other)->getGrouping().join( QChar::fromLatin1('/') );
-                const QStringList& thisGroupingSplit = (*first)->getGrouping();
-                QString thisGrouping = thisGroupingSplit.join( QChar::fromLatin1('/') );
-                if (otherGrouping == thisGrouping) {
-                    labelWithoutSuffix = (*first)->getPluginLabel();
-                }
-                break;
+            PluginVersionsOrdered::reverse_iterator other = (*it2)->second.rbegin();
+            QString otherGrouping = (*other)->getGrouping().join( QChar::fromLatin1('/') );
+            const QStringList& thisGroupingSplit = (*first)->getGrouping();
+            QString thisGrouping = thisGroupingSplit.join( QChar::fromLatin1('/') );
+            if (otherGrouping == thisGrouping) {
+                labelWithoutSuffix = (*first)->getPluginLabel();
             }
+            break;
         }
 
 
@@ -2053,6 +2111,9 @@ AppManager::loadPythonGroups()
 
     appPTR->setLoadingStatus( tr("Loading PyPlugs...") );
 
+    PyPlugCache pyPlugCache;
+    pyPlugCache.load();
+
     Q_FOREACH(const QString &plugin, allPlugins) {
         QString moduleName = plugin;
         QString modulePath;
@@ -2068,7 +2129,10 @@ AppManager::loadPythonGroups()
         }
 
 
-        {
+        // Only read and import the scripts that changed since the last launch
+        PyPlugCacheEntry entry;
+        bool isCached = pyPlugCache.lookup(plugin, &entry);
+        if (!isCached) {
             // Open the file and check for a line that imports NatronGui, if so do not attempt to load the script.
             QFile file(plugin);
             if (!file.open(QIODevice::ReadOnly)) {
@@ -2103,29 +2167,35 @@ AppManager::loadPythonGroups()
                     isPyPlug = true;
                 }
             }
-            if (appPTR->isBackground() && gotNatronGuiImport) {
-                continue;
+            entry.isPyPlug = isPyPlug;
+            entry.importsNatronGui = gotNatronGuiImport;
+        }
+        if ( !entry.isPyPlug || (appPTR->isBackground() && entry.importsNatronGui) ) {
+            if (!isCached) {
+                pyPlugCache.insert(plugin, entry);
             }
-            if (!isPyPlug) {
+            continue;
+        }
+
+        if (!entry.hasGroupInfos) {
+            bool gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(modulePath.toStdString(), moduleName.toStdString(), &entry.pluginID, &entry.pluginLabel, &entry.iconFilePath, &entry.grouping, &entry.description, &entry.isToolset, &entry.version);
+            if (!gotInfos) {
+                // Do not cache failures: the script may depend on something that will be fixed by the next launch
                 continue;
             }
+            entry.hasGroupInfos = true;
+            pyPlugCache.insert(plugin, entry);
         }
 
-        std::string pluginLabel, pluginID, pluginGrouping, iconFilePath, pluginDescription;
-        unsigned int version;
-        bool isToolset;
-        bool gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(modulePath.toStdString(), moduleName.toStdString(), &pluginID, &pluginLabel, &iconFilePath, &pluginGrouping, &pluginDescription, &isToolset, &version);
-
-
-        if (gotInfos) {
-            qDebug() << "Loading " << moduleName;
-            QStringList grouping = QString::fromUtf8( pluginGrouping.c_str() ).split( QChar::fromLatin1('/') );
-            Plugin* p = registerPlugin(modulePath, grouping, QString::fromUtf8( pluginID.c_str() ), QString::fromUtf8( pluginLabel.c_str() ), QString::fromUtf8( iconFilePath.c_str() ), QStringList(), false, false, 0, false, version, 0, false);
+        qDebug() << "Loading " << moduleName;
+        QStringList grouping = QString::fromUtf8( entry.grouping.c_str() ).split( QChar::fromLatin1('/') );
+        Plugin* p = registerPlugin(modulePath, grouping, QString::fromUtf8( entry.pluginID.c_str() ), QString::fromUtf8( entry.pluginLabel.c_str() ), QString::fromUtf8( entry.iconFilePath.c_str() ), QStringList(), false, false, 0, false, entry.version, 0, false);
 
-            p->setPythonModule(modulePath + moduleName);
-            p->setToolsetScript(isToolset);
-        }
+        p->setPythonModule(modulePath + moduleName);
+        p->setToolsetScript(entry.isToolset);
     }
+
+    pyPlugCache.save();
 } // AppManager::loadPythonGroups
 
 Plugin*
@@ -2581,6 +2651,40 @@ AppManager::getCachesTotalMemorySize() const
     return  _imp->_nodeCache->getMemoryCacheSize();
 }
 
+U64
+AppManager::getCachesMaximumMemorySize() const
+{
+    return  _imp->_nodeCache->getMaximumMemorySize();
+}
+
+U64
+AppManager::getViewerCacheSize() const
+{
+    return _imp->_viewerCache->getMemoryCacheSize() + _imp->_viewerCache->getDiskCacheSize();
+}
+
+U64
+AppManager::getViewerCacheMaximumSize() const
+{
+    return _imp->_viewerCache->getMaximumSize();
+}
+
+void
+AppManager::getCachesEvictionStats(const std::string& holderID,
+                                   U64* nImages,
+                                   U64* bytes,
+                                   double* renderTime) const
+{
+    U64 nDiskImages, diskBytes;
+    double diskRenderTime;
+
+    _imp->_nodeCache->getEvictionStats(holderID, nImages, bytes, renderTime);
+    _imp->_diskCache->getEvictionStats(holderID, &nDiskImages, &diskBytes, &diskRenderTime);
+    *nImages += nDiskImages;
+    *bytes += diskBytes;
+    *renderTime += diskRenderTime;
+}
+
 U64
 AppManager::getCachesTotalDiskSize() const
 {
@@ -3777,6 +3881,12 @@ AppManager::getGPUContextPool() const
     return _imp->renderingContextPool.get();
 }
 
+RenderThreadScheduler*
+AppManager::getRenderThreadScheduler() const
+{
+    return _imp->renderThreadScheduler.get();
+}
+
 void
 AppManager::refreshOpenGLRenderingFlagOnAllInstances()
 {
@@ -220,6 +220,15 @@ public:
 
 
     U64 getCachesTotalMemorySize() const;
+    U64 getCachesMaximumMemorySize() const;
+    U64 getViewerCacheSize() const;
+    U64 getViewerCacheMaximumSize() const;
+
+    /**
+     * @brief Returns the number of images of the given cache holder (i.e: node) that were evicted from the node
+     * and DiskCache caches to make room for others, their total size and the time spent rendering them.
+     **/
+    void getCachesEvictionStats(const std::string& holderID, U64* nImages, U64* bytes, double* renderTime) const;
     U64 getCachesTotalDiskSize() const;
     CacheSignalEmitterPtr getOrActivateViewerCacheSignalEmitter() const;
 
@@ -229,6 +238,8 @@ public:
 
     void setApplicationsCachesMaximumDiskSpace(unsigned long long size);
 
+    void setDiskCacheCompressionEnabled(bool enabled);
+
     void removeFromNodeCache(const ImagePtr & image);
     void removeFromViewerCache(const FrameEntryPtr & texture);
 
@@ -499,6 +510,7 @@ public:
     AppTLS* getAppTLS() const;
     const OfxHost* getOFXHost() const;
     GPUContextPool* getGPUContextPool() const;
+    RenderThreadScheduler* getRenderThreadScheduler() const;
 
 
     /**
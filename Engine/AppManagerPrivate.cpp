@@ -101,6 +101,7 @@ AppManagerPrivate::AppManagerPrivate()
     , diskCachesLocationMutex()
     , diskCachesLocation()
     , _backgroundIPC()
+    , renderServer()
     , _loaded(false)
     , _binaryPath()
     , _nodesGlobalMemoryUse(0)
@@ -135,6 +136,7 @@ AppManagerPrivate::AppManagerPrivate()
     , hasInitializedOpenGLFunctions(false)
     , openGLFunctionsMutex()
     , renderingContextPool()
+    , renderThreadScheduler( new RenderThreadScheduler() )
     , openGLRenderers()
 {
     setMaxCacheFiles();
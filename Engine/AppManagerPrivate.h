@@ -58,6 +58,7 @@
 #include "Engine/Image.h"
 #include "Engine/GPUContextPool.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
+#include "Engine/ThreadPool.h"
 #include "Engine/TLSHolder.h"
 
 // include breakpad after Engine, because it includes /usr/include/AssertMacros.h on OS X which defines a check(x) macro, which conflicts with boost
@@ -109,6 +110,7 @@ public:
     QString diskCachesLocation;
     boost::scoped_ptr<ProcessInputChannel> _backgroundIPC; //< object used to communicate with the main app
     //if this app is background, see the ProcessInputChannel def
+    boost::scoped_ptr<RenderServer> renderServer; //< set while NatronRenderer runs as a render server, see RenderServer
     bool _loaded; //< true when the first instance is completely loaded.
     QString _binaryPath; //< the path to the application's binary
     U64 _nodesGlobalMemoryUse; //< how much memory all the nodes are using (besides the cache)
@@ -203,6 +205,7 @@ public:
 #endif
 
     boost::scoped_ptr<GPUContextPool> renderingContextPool;
+    boost::scoped_ptr<RenderThreadScheduler> renderThreadScheduler; //< shares the global thread pool between render priorities
     std::list<OpenGLRendererInfo> openGLRenderers;
     boost::scoped_ptr<QCoreApplication> _qApp;
 
@@ -31,6 +31,7 @@
 #include <cmath>
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 
 #include <QtCore/QLineF>
 #include <QtCore/QDebug>
@@ -471,6 +472,69 @@ inline void addPointConditionnally(const Point& p, double t, std::list<Parametri
     }
 }
 
+/**
+ * @brief Evaluates the cubic p0,p1,p2,p3 at t = 0, step, 2 * step... for nbPoints points using forward differences:
+ * each point costs 3 additions per coordinate instead of the 6 interpolations of the de Casteljau formula.
+ * The x and y recurrences are independent so that the compiler can vectorize them.
+ **/
+static void
+bezierForwardDifferences(const Point& p0,
+                         const Point& p1,
+                         const Point& p2,
+                         const Point& p3,
+                         double step,
+                         int nbPoints,
+                         ParametricPoint* points) ///< output, nbPoints elements
+{
+    // P(t) = a * t^3 + b * t^2 + c * t + p0
+    double a[2] = { p3.x - p0.x + 3. * (p1.x - p2.x), p3.y - p0.y + 3. * (p1.y - p2.y) };
+    double b[2] = { 3. * (p0.x - 2. * p1.x + p2.x), 3. * (p0.y - 2. * p1.y + p2.y) };
+    double c[2] = { 3. * (p1.x - p0.x), 3. * (p1.y - p0.y) };
+    double step2 = step * step;
+    double step3 = step2 * step;
+    double f[2] = { p0.x, p0.y };
+    double df[2], d2f[2], d3f[2];
+
+    for (int i = 0; i < 2; ++i) {
+        df[i] = a[i] * step3 + b[i] * step2 + c[i] * step;
+        d2f[i] = 6. * a[i] * step3 + 2. * b[i] * step2;
+        d3f[i] = 6. * a[i] * step3;
+    }
+    for (int p = 0; p < nbPoints; ++p) {
+        points[p].x = f[0];
+        points[p].y = f[1];
+        points[p].t = p * step;
+        for (int i = 0; i < 2; ++i) {
+            f[i] += df[i];
+            df[i] += d2f[i];
+            d2f[i] += d3f[i];
+        }
+    }
+}
+
+#define ROTO_BEZIER_MAX_POINTS_PER_SEGMENT 4096
+
+/**
+ * @brief Returns the number of evenly spaced points needed so that the polyline through them is within
+ * ROTO_BEZIER_FLATNESS_TOLERANCE of the cubic p0,p1,p2,p3 (Wang's formula): nearly straight segments only need their
+ * end points whatever their length, curved ones get more points the more they bend.
+ **/
+static int
+bezierFlatnessNbPoints(const Point& p0,
+                       const Point& p1,
+                       const Point& p2,
+                       const Point& p3)
+{
+    double ax = p0.x - 2. * p1.x + p2.x;
+    double ay = p0.y - 2. * p1.y + p2.y;
+    double bx = p1.x - 2. * p2.x + p3.x;
+    double by = p1.y - 2. * p2.y + p3.y;
+    double maxSecondDifference = std::sqrt( std::max(ax * ax + ay * ay, bx * bx + by * by) );
+    double nbSegments = std::ceil( std::sqrt( 0.75 * maxSecondDifference / ROTO_BEZIER_FLATNESS_TOLERANCE ) );
+
+    return (int)std::max( 2., std::min(nbSegments + 1., (double)ROTO_BEZIER_MAX_POINTS_PER_SEGMENT) );
+}
+
 #ifndef ROTO_BEZIER_EVAL_ITERATIVE
 /**
  * @brief Recursively subdivide the bezier segment p0,p1,p2,p3 until the cubic curve is assumed to be flat. The errorScale is used to determine the stopping criterion.
@@ -775,32 +839,17 @@ bezierSegmentEval(bool useGuiCurves,
 
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
     if (nbPointsPerSegment == -1) {
-        /*
-         * Approximate the necessary number of line segments, using http://antigrain.com/research/adaptive_bezier/
-         */
-        double dx1, dy1, dx2, dy2, dx3, dy3;
-        dx1 = p1.x - p0.x;
-        dy1 = p1.y - p0.y;
-        dx2 = p2.x - p1.x;
-        dy2 = p2.y - p1.y;
-        dx3 = p3.x - p2.x;
-        dy3 = p3.y - p2.y;
-        double length = std::sqrt(dx1 * dx1 + dy1 * dy1) +
-                        std::sqrt(dx2 * dx2 + dy2 * dy2) +
-                        std::sqrt(dx3 * dx3 + dy3 * dy3);
-        nbPointsPerSegment = (int)std::max(length * 0.25, 2.);
-    }
-
-    double incr = 1. / (double)(nbPointsPerSegment - 1);
-    Point cur;
-    for (int i = 0; i < nbPointsPerSegment; ++i) {
-        ParametricPoint p;
-        p.t = incr * i;
-        Bezier::bezierPoint(p0, p1, p2, p3, p.t, &cur);
-        p.x = cur.x;
-        p.y = cur.y;
-        points->push_back(p);
+        nbPointsPerSegment = bezierFlatnessNbPoints(p0, p1, p2, p3);
     }
+    nbPointsPerSegment = std::max(nbPointsPerSegment, 2);
+
+    std::vector<ParametricPoint> segmentPoints(nbPointsPerSegment);
+    bezierForwardDifferences(p0, p1, p2, p3, 1. / (double)(nbPointsPerSegment - 1), nbPointsPerSegment, &segmentPoints.front());
+    // The end point is shared with the next segment: do not let it accumulate the rounding errors of the differences
+    segmentPoints.back().x = p3.x;
+    segmentPoints.back().y = p3.y;
+    segmentPoints.back().t = 1.;
+    points->insert( points->end(), segmentPoints.begin(), segmentPoints.end() );
 #else
     static const int maxRecursion = 32;
     recursiveBezier(p0, p1, p2, p3, errorScale, maxRecursion, points);
@@ -866,16 +915,20 @@ bezierSegmentMeetsPoint(bool useGuiCurves,
     // 1/incr = 2.0 -> 3 points   +        o       o
     // 1/incr = 2.1 -> 4 points   +       o       o+
     int nbPoints = std::ceil(1. / incr) + 1;
+    // All points but the last one are evenly spaced, the last one is at t == 1
+    std::vector<ParametricPoint> points(nbPoints);
+    bezierForwardDifferences(p02d, p12d, p22d, p32d, incr, nbPoints - 1, &points.front());
+    points.back().x = p32d.x;
+    points.back().y = p32d.y;
+    points.back().t = 1.;
     for (int i = 0; i < nbPoints; ++i) {
-        double t = std::min(i * incr, 1.);
+        const ParametricPoint& p = points[i];
         // the last point should be t == 1;
-        assert( t < 1 || (t == 1. && i == nbPoints - 1) );
-        Point p;
-        Bezier::bezierPoint(p02d, p12d, p22d, p32d, t, &p);
+        assert( p.t < 1 || (p.t == 1. && i == nbPoints - 1) );
         double sqdist = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
         if ( (sqdist <= sqDistance) && (sqdist < minSqDistance) ) {
             minSqDistance = sqdist;
-            tForMin = t;
+            tForMin = p.t;
         }
     }
 
@@ -2630,6 +2683,93 @@ Bezier::evaluateAtTime_DeCasteljau(bool useGuiPoints,
                                          0, pointsSingleList, bbox);
 }
 
+/**
+ * @brief Returns a hash of everything an evaluation of the points of a Bezier depends upon, used to find it in the
+ * flattened polygons of the Bezier. This costs a lookup of the control points and not their evaluation.
+ **/
+static U64
+getFlattenedPolygonKey(bool useGuiCurves,
+                       bool feather,
+                       bool evaluateIfEqual,
+                       const BezierCPs& points,
+                       const BezierCPs& featherPoints,
+                       bool finished,
+                       bool isOpenBezier,
+                       double time,
+                       unsigned int mipMapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                       int nbPointsPerSegment,
+#else
+                       double errorScale,
+#endif
+                       const Transform::Matrix3x3& transform)
+{
+    Hash64 hash;
+
+    hash.append(useGuiCurves);
+    hash.append(feather);
+    hash.append(evaluateIfEqual);
+    hash.append(finished);
+    hash.append(isOpenBezier);
+    hash.append(mipMapLevel);
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+    hash.append(nbPointsPerSegment);
+#else
+    hash.append(errorScale);
+#endif
+    double matrix[9] = {transform.a, transform.b, transform.c, transform.d, transform.e, transform.f, transform.g, transform.h, transform.i};
+    for (int i = 0; i < 9; ++i) {
+        hash.append(matrix[i]);
+    }
+    for (int list = 0; list < 2; ++list) {
+        // The feather segments equal to the control points segments are skipped, hence the feather depends on both
+        if ( (list == 1) && !feather ) {
+            break;
+        }
+        const BezierCPs& cps = list == 0 ? points : featherPoints;
+        hash.append( (U64)cps.size() );
+        for (BezierCPs::const_iterator it = cps.begin(); it != cps.end(); ++it) {
+            double x, y, lx, ly, rx, ry;
+            (*it)->getPositionAtTime(useGuiCurves, time, ViewIdx(0), &x, &y);
+            (*it)->getLeftBezierPointAtTime(useGuiCurves, time, ViewIdx(0), &lx, &ly);
+            (*it)->getRightBezierPointAtTime(useGuiCurves, time, ViewIdx(0), &rx, &ry);
+            hash.append(x);
+            hash.append(y);
+            hash.append(lx);
+            hash.append(ly);
+            hash.append(rx);
+            hash.append(ry);
+        }
+    }
+    hash.computeHash();
+
+    return hash.value();
+} // getFlattenedPolygonKey
+
+/**
+ * @brief Copies a flattened polygon to the outputs of the evaluation functions
+ **/
+static void
+copyFlattenedPolygon(const BezierFlattenedPolygon& polygon,
+                     std::list<std::list<ParametricPoint> >* points,
+                     std::list<ParametricPoint >* pointsSingleList,
+                     RectD* bbox)
+{
+    if (points) {
+        points->insert( points->end(), polygon.segments.begin(), polygon.segments.end() );
+    } else {
+        for (std::list<std::list<ParametricPoint> >::const_iterator it = polygon.segments.begin(); it != polygon.segments.end(); ++it) {
+            pointsSingleList->insert( pointsSingleList->end(), it->begin(), it->end() );
+        }
+    }
+    if (bbox) {
+        bbox->x1 = std::min(bbox->x1, polygon.bbox.x1);
+        bbox->x2 = std::max(bbox->x2, polygon.bbox.x2);
+        bbox->y1 = std::min(bbox->y1, polygon.bbox.y1);
+        bbox->y2 = std::max(bbox->y2, polygon.bbox.y2);
+    }
+}
+
 void
 Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
                                             double time,
@@ -2648,13 +2788,27 @@ Bezier::evaluateAtTime_DeCasteljau_internal(bool useGuiCurves,
 
     getTransformAtTime(time, &transform);
     QMutexLocker l(&itemMutex);
-    deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipMapLevel, _imp->finished,
+    U64 key = getFlattenedPolygonKey(useGuiCurves, false, true, _imp->points, _imp->featherPoints, _imp->finished, isOpenBezier(), time, mipMapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                                     nbPointsPerSegment,
+#else
+                                     errorScale,
+#endif
+                                     transform);
+    BezierFlattenedPolygonPtr polygon = _imp->findFlattenedPolygon(key);
+    if (!polygon) {
+        polygon = boost::make_shared<BezierFlattenedPolygon>();
+        polygon->key = key;
+        deCastelJau(isOpenBezier(), useGuiCurves, _imp->points, time, mipMapLevel, _imp->finished,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                nbPointsPerSegment,
+                    nbPointsPerSegment,
 #else
-                errorScale,
+                    errorScale,
 #endif
-                transform, points, pointsSingleList, bbox);
+                    transform, &polygon->segments, 0, &polygon->bbox);
+        _imp->insertFlattenedPolygon(polygon);
+    }
+    copyFlattenedPolygon(*polygon, points, pointsSingleList, bbox);
 }
 
 void
@@ -2717,6 +2871,26 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
     if ( _imp->points.empty() ) {
         return;
     }
+
+    Transform::Matrix3x3 transform;
+    getTransformAtTime(time, &transform);
+
+    U64 key = getFlattenedPolygonKey(useGuiPoints, true, evaluateIfEqual, _imp->points, _imp->featherPoints, _imp->finished, isOpenBezier(), time, mipMapLevel,
+#ifdef ROTO_BEZIER_EVAL_ITERATIVE
+                                     nbPointsPerSegment,
+#else
+                                     errorScale,
+#endif
+                                     transform);
+    BezierFlattenedPolygonPtr polygon = _imp->findFlattenedPolygon(key);
+    if (polygon) {
+        copyFlattenedPolygon(*polygon, points, pointsSingleList, bbox);
+
+        return;
+    }
+    polygon = boost::make_shared<BezierFlattenedPolygon>();
+    polygon->key = key;
+
     BezierCPs::const_iterator itCp = _imp->points.begin();
     BezierCPs::const_iterator next = _imp->featherPoints.begin();
     if ( next != _imp->featherPoints.end() ) {
@@ -2727,9 +2901,6 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         ++nextCp;
     }
 
-    Transform::Matrix3x3 transform;
-    getTransformAtTime(time, &transform);
-
     for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end();
          ++it) {
         if ( next == _imp->featherPoints.end() ) {
@@ -2744,39 +2915,22 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         if ( !evaluateIfEqual && bezierSegmenEqual(useGuiPoints, time, ViewIdx(0), **itCp, **nextCp, **it, **next) ) {
             continue;
         }
-        if (points) {
-            std::list<ParametricPoint> segmentPoints;
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
+        std::list<ParametricPoint> segmentPoints;
+        bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
 #ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
+                          nbPointsPerSegment,
 #else
-                              errorScale,
+                          errorScale,
 #endif
-                              transform, &segmentPoints, bbox);
+                          transform, &segmentPoints, &polygon->bbox);
 
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!segmentPoints.empty()) {
-                    segmentPoints.pop_back();
-                }
-            }
-            points->push_back(segmentPoints);
-        } else {
-            assert(pointsSingleList);
-            bezierSegmentEval(useGuiPoints, *(*it), *(*next), time, ViewIdx(0),  mipMapLevel,
-#ifdef ROTO_BEZIER_EVAL_ITERATIVE
-                              nbPointsPerSegment,
-#else
-                              errorScale,
-#endif
-                              transform, pointsSingleList, bbox);
-            // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
-            if (!isOpenBezier() || next != _imp->featherPoints.end()) {
-                if (!pointsSingleList->empty()) {
-                    pointsSingleList->pop_back();
-                }
+        // If we are a closed bezier or we are not on the last segment, remove the last point so we don't add duplicates
+        if (!isOpenBezier() || next != _imp->featherPoints.end()) {
+            if (!segmentPoints.empty()) {
+                segmentPoints.pop_back();
             }
         }
+        polygon->segments.push_back(segmentPoints);
 
         // increment for next iteration
         if ( itCp != _imp->featherPoints.end() ) {
@@ -2790,6 +2944,8 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau_internal(bool useGuiPoints,
         }
     } // for(it)
 
+    _imp->insertFlattenedPolygon(polygon);
+    copyFlattenedPolygon(*polygon, points, pointsSingleList, bbox);
 }
 
 void
@@ -2814,6 +2970,82 @@ Bezier::evaluateFeatherPointsAtTime_DeCasteljau(bool useGuiPoints,
                                                      evaluateIfEqual, points, 0, bbox);
 } // Bezier::evaluateFeatherPointsAtTime_DeCasteljau
 
+// Number of intervals of the shutter over which the path of the control points is measured
+#define ROTO_BEZIER_DISPLACEMENT_MEASURE_INTERVALS 4
+
+static double
+getControlPointsMaxDisplacementInternal(const BezierCPs& cps,
+                                        const std::vector<double>& times,
+                                        const std::vector<Transform::Matrix3x3>& transforms)
+{
+    double ret = 0.;
+
+    for (BezierCPs::const_iterator it = cps.begin(); it != cps.end(); ++it) {
+        // Length of the path followed by the point and its 2 tangents
+        double travelled[3] = {0., 0., 0.};
+        Transform::Point3D prev[3];
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            Transform::Point3D cur[3];
+            (*it)->getPositionAtTime(false, times[i], ViewIdx(0), &cur[0].x, &cur[0].y);
+            (*it)->getLeftBezierPointAtTime(false, times[i], ViewIdx(0), &cur[1].x, &cur[1].y);
+            (*it)->getRightBezierPointAtTime(false, times[i], ViewIdx(0), &cur[2].x, &cur[2].y);
+            for (int j = 0; j < 3; ++j) {
+                cur[j].z = 1.;
+                cur[j] = Transform::matApply(transforms[i], cur[j]);
+                cur[j].x /= cur[j].z;
+                cur[j].y /= cur[j].z;
+                if (i > 0) {
+                    double dx = cur[j].x - prev[j].x;
+                    double dy = cur[j].y - prev[j].y;
+                    travelled[j] += std::sqrt(dx * dx + dy * dy);
+                }
+                prev[j] = cur[j];
+            }
+        }
+        ret = std::max( ret, std::max( travelled[0], std::max(travelled[1], travelled[2]) ) );
+    }
+
+    return ret;
+}
+
+double
+Bezier::getControlPointsMaxDisplacement(double startTime,
+                                        double endTime) const
+{
+    if (endTime <= startTime) {
+        return 0.;
+    }
+
+    // Measuring the path rather than the distance between both ends of the shutter catches shapes
+    // going back and forth within the shutter
+    std::vector<double> times(ROTO_BEZIER_DISPLACEMENT_MEASURE_INTERVALS + 1);
+    std::vector<Transform::Matrix3x3> transforms( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        times[i] = startTime + (endTime - startTime) * i / ROTO_BEZIER_DISPLACEMENT_MEASURE_INTERVALS;
+        getTransformAtTime(times[i], &transforms[i]);
+    }
+
+    QMutexLocker l(&itemMutex);
+    double ret = getControlPointsMaxDisplacementInternal(_imp->points, times, transforms);
+    if ( useFeatherPoints() && !_imp->isOpenBezier ) {
+        ret = std::max( ret, getControlPointsMaxDisplacementInternal(_imp->featherPoints, times, transforms) );
+    }
+
+    return ret;
+}
+
+int
+Bezier::getMotionBlurSamplesCount(double displacement,
+                                  int maxSamples)
+{
+    if (displacement <= 0.) {
+        return 0;
+    }
+    int nbSamples = (int)std::ceil(displacement / NATRON_ROTO_MOTION_BLUR_PIXELS_PER_SAMPLE);
+
+    return std::min(nbSamples, maxSamples);
+}
+
 void
 Bezier::getMotionBlurSettings(const double time,
                               double* startTime,
@@ -2827,31 +3059,40 @@ Bezier::getMotionBlurSettings(const double time,
     if ( isOpenBezier() || (motionBlurAmnt == 0) ) {
         return;
     }
-    int nbSamples = std::floor(motionBlurAmnt * 10 + 0.5);
+    int maxSamples = std::floor(motionBlurAmnt * 10 + 0.5);
     double shutterInterval = getShutterKnob()->getValueAtTime(time);
-    if (shutterInterval == 0) {
+    if ( (shutterInterval == 0) || (maxSamples == 0) ) {
         return;
     }
     int shutterType_i = getShutterTypeKnob()->getValueAtTime(time);
-    if (nbSamples != 0) {
-        *timeStep = shutterInterval / nbSamples;
-    }
+    double shutterStart, shutterEnd;
     if (shutterType_i == 0) { // centered
-        *startTime = time - shutterInterval / 2.;
-        *endTime = time + shutterInterval / 2.;
+        shutterStart = time - shutterInterval / 2.;
+        shutterEnd = time + shutterInterval / 2.;
     } else if (shutterType_i == 1) { // start
-        *startTime = time;
-        *endTime = time + shutterInterval;
+        shutterStart = time;
+        shutterEnd = time + shutterInterval;
     } else if (shutterType_i == 2) { // end
-        *startTime = time - shutterInterval;
-        *endTime = time;
+        shutterStart = time - shutterInterval;
+        shutterEnd = time;
     } else if (shutterType_i == 3) { // custom
-        *startTime = time + getShutterOffsetKnob()->getValueAtTime(time);
-        *endTime = *startTime + shutterInterval;
+        shutterStart = time + getShutterOffsetKnob()->getValueAtTime(time);
+        shutterEnd = shutterStart + shutterInterval;
     } else {
         assert(false);
+
+        return;
     }
 
+    // The motion blur amount only gives the maximum number of samples: a shape that barely moves
+    // during the shutter needs fewer, and a static one is rendered once at the current time
+    int nbSamples = getMotionBlurSamplesCount(getControlPointsMaxDisplacement(shutterStart, shutterEnd), maxSamples);
+    if (nbSamples == 0) {
+        return;
+    }
+    *startTime = shutterStart;
+    *endTime = shutterEnd;
+    *timeStep = shutterInterval / nbSamples;
 
 #endif
 }
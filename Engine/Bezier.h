@@ -50,6 +50,9 @@ CLANG_DIAG_ON(deprecated-declarations)
 
 #define ROTO_BEZIER_EVAL_ITERATIVE
 
+// Maximum distance in pixels between a Bezier segment and the polyline approximating it
+#define ROTO_BEZIER_FLATNESS_TOLERANCE 0.25
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -325,6 +328,18 @@ public:
                                double* endTime,
                                double* timeStep) const;
 
+    /**
+     * @brief Returns the length of the longest path followed by a control point, a tangent or a feather point
+     * of the shape between startTime and endTime, in canonical coordinates and with the transform applied.
+     **/
+    double getControlPointsMaxDisplacement(double startTime, double endTime) const;
+
+    /**
+     * @brief Returns how many motion blur samples a shape whose points travel the given displacement needs,
+     * at most maxSamples. Returns 0 when the shape does not move and needs no motion blur.
+     **/
+    static int getMotionBlurSamplesCount(double displacement, int maxSamples);
+
 private:
 
     void smoothOrCuspPointAtIndex(bool isSmooth, int index, double time, const std::pair<double, double>& pixelScale);
@@ -61,6 +61,7 @@ public:
     bool useDefaultSettings;
     bool clearCacheOnLaunch;
     QString ipcPipe;
+    QString renderServerName;
     int error;
     bool isInterpreterMode;
     std::list<std::pair<int, std::pair<int, int> > > frameRanges;
@@ -88,6 +89,7 @@ public:
         , useDefaultSettings(false)
         , clearCacheOnLaunch(false)
         , ipcPipe()
+        , renderServerName()
         , error(0)
         , isInterpreterMode(false)
         , frameRanges()
@@ -224,6 +226,7 @@ CLArgs::operator=(const CLArgs& other)
     _imp->settingCommands = other._imp->settingCommands;
     _imp->isBackground = other._imp->isBackground;
     _imp->ipcPipe = other._imp->ipcPipe;
+    _imp->renderServerName = other._imp->renderServerName;
     _imp->error = other._imp->error;
     _imp->isInterpreterMode = other._imp->isInterpreterMode;
     _imp->frameRanges = other._imp->frameRanges;
@@ -292,7 +295,15 @@ CLArgs::printUsage(const std::string& programName)
         "    Execute custom Python code passed as a script prior to executing the Python\n"
         "    script or loading the project passed as parameter. This option may be used\n"
         "    multiple times and each python command is executed in the order given on\n"
-        "    the command-line.\n\n"
+        "    the command-line.\n"
+        "  --render-server <name>\n"
+        "    Stay resident and render the jobs sent by clients to the local server\n"
+        "    (named pipe) with the given name, instead of rendering a single project.\n"
+        "    Plug-ins are loaded once, the image cache stays warm between jobs and a\n"
+        "    project is only loaded again if its file changed. A job is a series of\n"
+        "    lines: \"project <file>\", then optionally \"writer <name>\",\n"
+        "    \"range <frameRange>\", \"set <node>.<param> <Python value>\" and\n"
+        "    \"stats\", and finally \"render\". \"quit\" stops the server.\n\n"
         "\n"
         /* Text must hold in 80 columns ************************************************/
         "Options for the execution of %1 projects:\n"
@@ -511,6 +522,12 @@ CLArgs::getIPCPipeName() const
     return _imp->ipcPipe;
 }
 
+const QString&
+CLArgs::getRenderServerName() const
+{
+    return _imp->renderServerName;
+}
+
 bool
 CLArgs::areRenderStatsEnabled() const
 {
@@ -728,6 +745,13 @@ tryParseMultipleFrameRanges(const QString& args,
     return added;
 }
 
+bool
+CLArgs::parseFrameRanges(const QString& str,
+                         std::list<std::pair<int, std::pair<int, int> > >* frameRanges)
+{
+    return tryParseMultipleFrameRanges(str, *frameRanges);
+}
+
 void
 CLArgsPrivate::parse()
 {
@@ -910,6 +934,22 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-server"), QString() );
+        if ( it != args.end() ) {
+            ++it;
+            if ( it != args.end() ) {
+                renderServerName = *it;
+                args.erase(it);
+            } else {
+                std::cout << tr("You must specify the render server name").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("onload"), QString::fromUtf8("l") );
         if ( it != args.end() ) {
@@ -947,7 +987,7 @@ CLArgsPrivate::parse()
         QStringList::iterator it = findFileNameWithExtension( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) );
         if ( it == args.end() ) {
             it = findFileNameWithExtension( QString::fromUtf8("py") );
-            if ( ( it == args.end() ) && !isInterpreterMode && isBackground ) {
+            if ( ( it == args.end() ) && !isInterpreterMode && renderServerName.isEmpty() && isBackground ) {
                 std::cout << tr("You must specify the filename of a script or %1 project. (.%2)").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).arg( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ).toStdString() << std::endl;
                 error = 1;
 
@@ -101,6 +101,13 @@ public:
     static void printBackGroundWelcomeMessage();
     static void printUsage(const std::string& programName);
 
+    /**
+     * @brief Parses frame ranges in the command line format, e.g: 1-10:2,20-30,45
+     * Each range is appended to frameRanges as (frameStep, (firstFrame, lastFrame)).
+     * @returns True if at least one range was parsed.
+     **/
+    static bool parseFrameRanges(const QString& str, std::list<std::pair<int, std::pair<int, int> > >* frameRanges);
+
     int getError() const;
 
     const std::list<CLArgs::WriterArg>& getWriterArgs() const;
@@ -134,6 +141,11 @@ public:
     const QString& getDefaultOnProjectLoadedScript() const;
     const QString& getIPCPipeName() const;
 
+    /*
+     * @brief The name of the local server to listen to for render jobs, if NatronRenderer was launched as a render server.
+     */
+    const QString& getRenderServerName() const;
+
     bool isPythonScript() const;
 
     bool areRenderStatsEnabled() const;
@@ -32,6 +32,7 @@
 #include <fstream>
 #include <functional>
 #include <list>
+#include <map>
 #include <set>
 #include <cstddef>
 #include <utility>
@@ -69,6 +70,9 @@ GCC_DIAG_ON(deprecated)
 //Beyond that percentage of occupation, the cache will start evicting LRU entries
 #define NATRON_CACHE_LIMIT_PERCENT 0.9
 
+//Number of least recently used entries among which the one with the lowest eviction cost is evicted from memory
+#define NATRON_CACHE_EVICTION_CANDIDATES 16
+
 #define NATRON_TILE_CACHE_FILE_SIZE_BYTES 2000000000
 
 ///When defined, number of opened files, memory size and disk size of the cache are printed whenever there's activity.
@@ -323,6 +327,167 @@ private:
     }
 };
 
+/**
+ * @brief The point of this thread is to compress the backing files of entries leaving the memory portion of a compressed cache,
+ * so that the thread evicting entries (usually a render thread) doesn't wait on the compression and the disk writes.
+ * Once a file is compressed, the raw file is removed. A file which was not compressed yet is still a valid cache file.
+ **/
+class CacheWriteBehindThread
+    : public QThread
+{
+    struct CompressRequest
+    {
+        MemoryFilePtr file;
+        std::string path;
+        std::size_t dataTypeSize;
+    };
+
+    mutable QMutex _requestQueueMutex;
+    std::list<CompressRequest> _requestsQueue;
+    QWaitCondition _requestsQueueNotEmptyCond;
+
+    // The path of the file being compressed, protected by _requestQueueMutex
+    std::string _currentFilePath;
+    QWaitCondition _currentFileDoneCond;
+
+    // Once set, the thread doesn't accept requests anymore, protected by _requestQueueMutex
+    bool mustQuit;
+
+public:
+
+    CacheWriteBehindThread()
+        : QThread()
+        , _requestQueueMutex()
+        , _requestsQueue()
+        , _requestsQueueNotEmptyCond()
+        , _currentFilePath()
+        , _currentFileDoneCond()
+        , mustQuit(false)
+    {
+        setObjectName( QString::fromUtf8("CacheWriteBehind") );
+    }
+
+    virtual ~CacheWriteBehindThread()
+    {
+    }
+
+    void appendToQueue(const MemoryFilePtr& file,
+                       std::size_t dataTypeSize)
+    {
+        {
+            QMutexLocker k(&_requestQueueMutex);
+            if (!mustQuit) {
+                CompressRequest r;
+                r.file = file;
+                r.path = file->path();
+                r.dataTypeSize = dataTypeSize;
+                _requestsQueue.push_back(r);
+                if ( isRunning() ) {
+                    _requestsQueueNotEmptyCond.wakeOne();
+                } else {
+                    start();
+                }
+
+                return;
+            }
+        }
+        // We are quitting, leave the file uncompressed
+        file->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+    }
+
+    MemoryFilePtr cancelRequest(const std::string& filepath)
+    {
+        QMutexLocker k(&_requestQueueMutex);
+
+        for (std::list<CompressRequest>::iterator it = _requestsQueue.begin(); it != _requestsQueue.end(); ++it) {
+            if (it->path == filepath) {
+                MemoryFilePtr ret = it->file;
+                _requestsQueue.erase(it);
+
+                return ret;
+            }
+        }
+        while (_currentFilePath == filepath) {
+            _currentFileDoneCond.wait(&_requestQueueMutex);
+        }
+
+        return MemoryFilePtr();
+    }
+
+    /**
+     * @brief Stops the thread: the files waiting for compression are left uncompressed.
+     **/
+    void quitThread()
+    {
+        {
+            QMutexLocker k(&_requestQueueMutex);
+            mustQuit = true;
+            _requestsQueueNotEmptyCond.wakeOne();
+        }
+        wait();
+    }
+
+    bool isWorking() const
+    {
+        QMutexLocker k(&_requestQueueMutex);
+
+        return !_requestsQueue.empty() || !_currentFilePath.empty();
+    }
+
+    /**
+     * @brief Blocks until all the files queued so far are compressed.
+     **/
+    void waitForQueueDone()
+    {
+        QMutexLocker k(&_requestQueueMutex);
+
+        while ( !_requestsQueue.empty() || !_currentFilePath.empty() ) {
+            _currentFileDoneCond.wait(&_requestQueueMutex);
+        }
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        for (;; ) {
+            CompressRequest front;
+            {
+                QMutexLocker k(&_requestQueueMutex);
+                while ( _requestsQueue.empty() && !mustQuit ) {
+                    _requestsQueueNotEmptyCond.wait(&_requestQueueMutex);
+                }
+                if (mustQuit) {
+                    for (std::list<CompressRequest>::iterator it = _requestsQueue.begin(); it != _requestsQueue.end(); ++it) {
+                        it->file->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+                    }
+                    _requestsQueue.clear();
+
+                    return;
+                }
+                front = _requestsQueue.front();
+                _requestsQueue.pop_front();
+                _currentFilePath = front.path;
+            }
+
+            bool compressed = front.file->data() && CacheCompression::writeCompressedFile( front.file->data(), front.file->size(), front.dataTypeSize,
+                                                                                            CacheCompression::getCompressedFilePath(front.path) );
+            if (compressed) {
+                front.file->remove();
+            } else {
+                front.file->flush(MemoryFile::eFlushTypeAsync, 0, 0);
+            }
+            front.file.reset();
+
+            {
+                QMutexLocker k(&_requestQueueMutex);
+                _currentFilePath.clear();
+                _currentFileDoneCond.wakeAll();
+            }
+        }
+    }
+};
+
 
 class CacheSignalEmitter
     : public QObject
@@ -495,6 +660,28 @@ private:
     mutable DeleterThread<EntryType> _deleterThread;
     mutable QWaitCondition _memoryFullCondition; //< protected by _sizeLock
     mutable CacheCleanerThread _cleanerThread;
+    mutable CacheWriteBehindThread _writeBehindThread;
+
+    // If true, backing files of entries leaving the memory portion are compressed, protected by _tileCacheMutex
+    bool _compressionEnabled;
+
+    // Entries evicted to make room for others, per holder (i.e: per node)
+    struct EvictionStats
+    {
+        U64 nEntries;
+        U64 bytes;
+        double renderTime;
+
+        EvictionStats()
+            : nEntries(0)
+            , bytes(0)
+            , renderTime(0.)
+        {
+        }
+    };
+
+    mutable QMutex _evictionStatsMutex;
+    mutable std::map<std::string, EvictionStats> _evictionStats;
 
     // If tiled, the cache will consist only of a few large files that each contain tiles of the same size.
     // This is useful to cache chunks of data that always have the same size.
@@ -537,6 +724,10 @@ public:
         , _deleterThread(this)
         , _memoryFullCondition()
         , _cleanerThread(this)
+        , _writeBehindThread()
+        , _compressionEnabled(false)
+        , _evictionStatsMutex()
+        , _evictionStats()
         , _tileCacheMutex()
         , _isTiled(false)
         , _tileByteSize(0)
@@ -550,6 +741,9 @@ public:
 
     virtual ~Cache()
     {
+        // Entries destroyed below must not be queued for compression anymore
+        _writeBehindThread.quitThread();
+
         QMutexLocker locker(&_lock);
 
         _tearingDown = true;
@@ -582,10 +776,35 @@ public:
     }
 
 
+    virtual bool isCompressionEnabled() const OVERRIDE FINAL
+    {
+        QMutexLocker k(&_tileCacheMutex);
+        return _compressionEnabled;
+    }
+
+    /**
+     * @brief Set whether backing files of entries leaving the memory portion of the cache should be compressed.
+     * This is only relevant for non-tiled caches storing entries on disk and only affects entries allocated afterwards.
+     **/
+    void setCompressionEnabled(bool enabled)
+    {
+        QMutexLocker k(&_tileCacheMutex);
+        _compressionEnabled = enabled;
+    }
+
+    /**
+     * @brief Blocks until the backing files queued for compression so far are written.
+     **/
+    void waitForPendingCompressions()
+    {
+        _writeBehindThread.waitForQueueDone();
+    }
+
     void waitForDeleterThread()
     {
         _deleterThread.quitThread();
         _cleanerThread.quitThread();
+        _writeBehindThread.quitThread();
     }
 
     /**
@@ -615,6 +834,16 @@ private:
 
 
 
+    virtual void compressBackingFileAsync(const MemoryFilePtr& file, std::size_t dataTypeSize) OVERRIDE FINAL
+    {
+        _writeBehindThread.appendToQueue(file, dataTypeSize);
+    }
+
+    virtual MemoryFilePtr cancelBackingFileCompression(const std::string& filepath) OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return _writeBehindThread.cancelRequest(filepath);
+    }
+
     virtual TileCacheFilePtr getTileCacheFile(const std::string& filepath, std::size_t dataOffset) OVERRIDE FINAL WARN_UNUSED_RETURN
     {
         QMutexLocker k(&_tileCacheMutex);
@@ -1202,7 +1431,31 @@ public:
     }
 
     /**
-     * @brief Removes the last recently used entry from the in-memory cache.
+     * @brief Returns the number of entries of the given holder that were evicted from the cache to make room
+     * for others, their total size in bytes and the time that was spent rendering them.
+     **/
+    void getEvictionStats(const std::string& holderID,
+                          U64* nEntries,
+                          U64* bytes,
+                          double* renderTime) const
+    {
+        QMutexLocker k(&_evictionStatsMutex);
+        typename std::map<std::string, EvictionStats>::const_iterator found = _evictionStats.find(holderID);
+
+        if ( found == _evictionStats.end() ) {
+            *nEntries = 0;
+            *bytes = 0;
+            *renderTime = 0.;
+        } else {
+            *nEntries = found->second.nEntries;
+            *bytes = found->second.bytes;
+            *renderTime = found->second.renderTime;
+        }
+    }
+
+    /**
+     * @brief Removes an entry from the in-memory cache: among the least recently used entries, the one
+     * that was the cheapest to render per byte is removed (@see AbstractCacheEntryBase::getEvictionCost()).
      * This is expensive since it takes the lock. Returns false
      * if there's nothing left to evict.
      **/
@@ -1805,10 +2058,20 @@ private:
         }
     }
 
+    void recordEviction(const EntryTypePtr& entry) const
+    {
+        QMutexLocker k(&_evictionStatsMutex);
+        EvictionStats& stats = _evictionStats[entry->getKey().getCacheHolderID()];
+
+        ++stats.nEntries;
+        stats.bytes += entry->getSizeInBytesFromParams();
+        stats.renderTime += entry->getRenderTime();
+    }
+
     bool tryEvictInMemoryEntry(std::list<EntryTypePtr> & entriesToBeDeleted) const
     {
         assert( !_lock.tryLock() );
-        std::pair<hash_type, EntryTypePtr> evicted = _memoryCache.evict();
+        std::pair<hash_type, EntryTypePtr> evicted = _memoryCache.evictCheapest(NATRON_CACHE_EVICTION_CANDIDATES);
         //if the cache couldn't evict that means all entries are used somewhere and we shall not remove them!
         //we'll let the user of these entries purge the extra entries left in the cache later on
         if (!evicted.second) {
@@ -1819,6 +2082,7 @@ private:
         // If the cache is tiled, the entry is sharing the same file with other entries so we cannot close the file.
         // Just deallocate it
         if ( !evicted.second->isStoredOnDisk()) {
+            recordEviction(evicted.second);
             entriesToBeDeleted.push_back(evicted.second);
         } else {
 
@@ -1849,6 +2113,7 @@ private:
                 ///Erase the file from the disk if we reach the limit.
                 evictedFromDisk.second->removeAnyBackingFile();
 
+                recordEviction(evictedFromDisk.second);
                 entriesToBeDeleted.push_back(evictedFromDisk.second);
 
                 {
@@ -1889,6 +2154,7 @@ private:
             // Erase the file from the disk if we reach the limit.
             evicted.second->removeAnyBackingFile();
         }
+        recordEviction(evicted.second);
         entriesToBeDeleted.push_back(evicted.second);
         return true;
     }
@@ -0,0 +1,502 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "CacheCompression.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cstdio> // for std::remove
+#include <cstring> // for std::memcpy
+#include <stdexcept>
+
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
+#include "Global/GlobalDefines.h"
+#include "Global/FStreamsSupport.h"
+#include "Engine/MemoryFile.h"
+
+// Blocks are compressed independently so they can be decompressed in parallel.
+// This must be a multiple of all data type sizes (1, 2 and 4 bytes).
+#define NATRON_CACHE_COMPRESSION_BLOCK_SIZE (1 << 20)
+
+// Blocks which do not compress are stored as-is, this bit of the block size indicates it
+#define NATRON_CACHE_COMPRESSION_RAW_BLOCK_BIT 0x80000000u
+
+#define NATRON_CACHE_COMPRESSION_MAGIC "NCZ1"
+
+// LZ parameters
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_LOG 14
+#define LZ_MAX_OFFSET 65535
+// The last bytes of a block are always encoded as literals
+#define LZ_LAST_LITERALS 5
+
+NATRON_NAMESPACE_ENTER
+
+namespace CacheCompression {
+namespace {
+struct FileHeader
+{
+    char magic[4];
+    U32 dataTypeSize;
+    U64 size;
+    U32 blockSize;
+    U32 nBlocks;
+};
+
+inline U32
+read32(const U8* p)
+{
+    U32 v;
+
+    std::memcpy(&v, p, sizeof(U32));
+
+    return v;
+}
+
+inline U32
+hash32(U32 v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+inline void
+writeLength(std::size_t len,
+            std::vector<U8>& out)
+{
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back( (U8)len );
+}
+
+inline bool
+readLength(const U8** ip,
+           const U8* iend,
+           std::size_t* len)
+{
+    for (;; ) {
+        if (*ip >= iend) {
+            return false;
+        }
+        U8 v = **ip;
+        ++(*ip);
+        *len += v;
+        if (v != 255) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Compresses n bytes of src. Returns false if the output is not smaller than the input.
+ **/
+bool
+lzCompress(const U8* src,
+           std::size_t n,
+           std::vector<U8>& out)
+{
+    out.clear();
+    out.reserve(n);
+
+    const U8* ip = src;
+    const U8* anchor = src;
+    const U8* iend = src + n;
+    // Matches may not start after this point: there must be enough room to read 4 bytes and leave LZ_LAST_LITERALS literals
+    const U8* mflimit = n > LZ_MIN_MATCH + LZ_LAST_LITERALS ? iend - (LZ_MIN_MATCH + LZ_LAST_LITERALS) : src;
+    const U8* matchlimit = iend - LZ_LAST_LITERALS;
+    std::vector<U32> table(1 << LZ_HASH_LOG, 0);
+
+    while (ip < mflimit) {
+        U32 seq = read32(ip);
+        U32 h = hash32(seq);
+        const U8* ref = src + table[h];
+        table[h] = (U32)(ip - src);
+        if ( (ref >= ip) || (ip - ref > LZ_MAX_OFFSET) || (read32(ref) != seq) ) {
+            ++ip;
+            continue;
+        }
+
+        // Extend the match forward
+        const U8* m = ip + LZ_MIN_MATCH;
+        const U8* r = ref + LZ_MIN_MATCH;
+        while (m < matchlimit && *m == *r) {
+            ++m;
+            ++r;
+        }
+
+        std::size_t litLen = ip - anchor;
+        std::size_t matchLen = (m - ip) - LZ_MIN_MATCH;
+        U8 token = (U8)( ( std::min(litLen, (std::size_t)15) << 4 ) | std::min(matchLen, (std::size_t)15) );
+        out.push_back(token);
+        if (litLen >= 15) {
+            writeLength(litLen - 15, out);
+        }
+        out.insert(out.end(), anchor, ip);
+        std::size_t offset = ip - ref;
+        out.push_back( (U8)(offset & 0xff) );
+        out.push_back( (U8)(offset >> 8) );
+        if (matchLen >= 15) {
+            writeLength(matchLen - 15, out);
+        }
+        if (out.size() >= n) {
+            return false;
+        }
+        ip = m;
+        anchor = ip;
+    }
+
+    // Last literals
+    std::size_t litLen = iend - anchor;
+    out.push_back( (U8)(std::min(litLen, (std::size_t)15) << 4) );
+    if (litLen >= 15) {
+        writeLength(litLen - 15, out);
+    }
+    out.insert(out.end(), anchor, iend);
+
+    return out.size() < n;
+} // lzCompress
+
+bool
+lzDecompress(const U8* src,
+             std::size_t srcSize,
+             U8* dst,
+             std::size_t dstSize)
+{
+    const U8* ip = src;
+    const U8* iend = src + srcSize;
+    U8* op = dst;
+    U8* oend = dst + dstSize;
+
+    for (;; ) {
+        if (ip >= iend) {
+            return false;
+        }
+        U8 token = *ip++;
+        std::size_t litLen = token >> 4;
+        if ( (litLen == 15) && !readLength(&ip, iend, &litLen) ) {
+            return false;
+        }
+        if ( ( litLen > (std::size_t)(iend - ip) ) || ( litLen > (std::size_t)(oend - op) ) ) {
+            return false;
+        }
+        std::memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == iend) {
+            // The last sequence has only literals
+            return op == oend;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        std::size_t matchLen = token & 0xf;
+        if ( (matchLen == 15) && !readLength(&ip, iend, &matchLen) ) {
+            return false;
+        }
+        matchLen += LZ_MIN_MATCH;
+        if ( (offset == 0) || ( offset > (std::size_t)(op - dst) ) || ( matchLen > (std::size_t)(oend - op) ) ) {
+            return false;
+        }
+        const U8* ref = op - offset;
+        if (offset >= matchLen) {
+            std::memcpy(op, ref, matchLen);
+            op += matchLen;
+        } else {
+            // Overlapping copy: repeats the pattern
+            for (std::size_t i = 0; i < matchLen; ++i) {
+                *op++ = *ref++;
+            }
+        }
+    }
+} // lzDecompress
+
+/**
+ * @brief Transposes elements of typeSize bytes into byte-planes. The trailing bytes which do not make a full element are copied as-is.
+ **/
+void
+shuffle(const U8* src,
+        std::size_t n,
+        std::size_t typeSize,
+        U8* dst)
+{
+    std::size_t nElements = n / typeSize;
+
+    for (std::size_t b = 0; b < typeSize; ++b) {
+        U8* dstPlane = dst + b * nElements;
+        const U8* srcPix = src + b;
+        for (std::size_t i = 0; i < nElements; ++i, srcPix += typeSize) {
+            dstPlane[i] = *srcPix;
+        }
+    }
+    std::memcpy(dst + nElements * typeSize, src + nElements * typeSize, n - nElements * typeSize);
+}
+
+void
+unshuffle(const U8* src,
+          std::size_t n,
+          std::size_t typeSize,
+          U8* dst)
+{
+    std::size_t nElements = n / typeSize;
+
+    for (std::size_t b = 0; b < typeSize; ++b) {
+        const U8* srcPlane = src + b * nElements;
+        U8* dstPix = dst + b;
+        for (std::size_t i = 0; i < nElements; ++i, dstPix += typeSize) {
+            *dstPix = srcPlane[i];
+        }
+    }
+    std::memcpy(dst + nElements * typeSize, src + nElements * typeSize, n - nElements * typeSize);
+}
+
+struct DecompressBlockArgs
+{
+    const U8* src;
+    std::size_t srcSize;
+    bool isRaw;
+    U8* dst;
+    std::size_t dstSize;
+    std::size_t typeSize;
+};
+
+bool
+decompressBlock(const DecompressBlockArgs& args)
+{
+    if (args.isRaw) {
+        if (args.srcSize != args.dstSize) {
+            return false;
+        }
+        std::memcpy(args.dst, args.src, args.dstSize);
+
+        return true;
+    }
+    if (args.typeSize <= 1) {
+        return lzDecompress(args.src, args.srcSize, args.dst, args.dstSize);
+    }
+    std::vector<U8> shuffled(args.dstSize);
+    if ( !lzDecompress(args.src, args.srcSize, &shuffled[0], args.dstSize) ) {
+        return false;
+    }
+    unshuffle(&shuffled[0], args.dstSize, args.typeSize, args.dst);
+
+    return true;
+}
+} // anon namespace
+
+std::string
+getCompressedFilePath(const std::string& filepath)
+{
+    return filepath + "." NATRON_CACHE_COMPRESSED_FILE_EXT;
+}
+
+void
+compress(const char* data,
+         std::size_t size,
+         std::size_t dataTypeSize,
+         std::vector<char>* compressed)
+{
+    if (dataTypeSize == 0) {
+        dataTypeSize = 1;
+    }
+    U32 nBlocks = (U32)( (size + NATRON_CACHE_COMPRESSION_BLOCK_SIZE - 1) / NATRON_CACHE_COMPRESSION_BLOCK_SIZE );
+    FileHeader header;
+    std::memcpy(header.magic, NATRON_CACHE_COMPRESSION_MAGIC, 4);
+    header.dataTypeSize = (U32)dataTypeSize;
+    header.size = size;
+    header.blockSize = NATRON_CACHE_COMPRESSION_BLOCK_SIZE;
+    header.nBlocks = nBlocks;
+
+    std::size_t headerSize = sizeof(FileHeader) + nBlocks * sizeof(U32);
+    compressed->resize(headerSize);
+    compressed->reserve(headerSize + size / 2);
+    std::memcpy( &(*compressed)[0], &header, sizeof(FileHeader) );
+
+    std::vector<U8> shuffled;
+    std::vector<U8> block;
+    for (U32 i = 0; i < nBlocks; ++i) {
+        const U8* src = (const U8*)data + (std::size_t)i * NATRON_CACHE_COMPRESSION_BLOCK_SIZE;
+        std::size_t n = std::min( (std::size_t)NATRON_CACHE_COMPRESSION_BLOCK_SIZE, size - (std::size_t)i * NATRON_CACHE_COMPRESSION_BLOCK_SIZE );
+        const U8* toCompress = src;
+        if (dataTypeSize > 1) {
+            shuffled.resize(n);
+            shuffle(src, n, dataTypeSize, &shuffled[0]);
+            toCompress = &shuffled[0];
+        }
+        U32 blockSize;
+        if ( lzCompress(toCompress, n, block) ) {
+            blockSize = (U32)block.size();
+            compressed->insert( compressed->end(), block.begin(), block.end() );
+        } else {
+            blockSize = (U32)n | NATRON_CACHE_COMPRESSION_RAW_BLOCK_BIT;
+            compressed->insert(compressed->end(), (const char*)src, (const char*)src + n);
+        }
+        std::memcpy( &(*compressed)[sizeof(FileHeader) + i * sizeof(U32)], &blockSize, sizeof(U32) );
+    }
+} // compress
+
+std::size_t
+getDecompressedSize(const char* compressed,
+                    std::size_t compressedSize)
+{
+    if ( compressedSize < sizeof(FileHeader) ) {
+        return 0;
+    }
+    FileHeader header;
+    std::memcpy( &header, compressed, sizeof(FileHeader) );
+    if (std::memcmp(header.magic, NATRON_CACHE_COMPRESSION_MAGIC, 4) != 0) {
+        return 0;
+    }
+
+    return header.size;
+}
+
+bool
+decompress(const char* compressed,
+           std::size_t compressedSize,
+           char* data,
+           std::size_t size,
+           bool multiThreaded)
+{
+    if ( getDecompressedSize(compressed, compressedSize) != size ) {
+        return false;
+    }
+    FileHeader header;
+    std::memcpy( &header, compressed, sizeof(FileHeader) );
+    if ( (header.blockSize == 0) || (header.dataTypeSize == 0) ) {
+        return false;
+    }
+    std::size_t headerSize = sizeof(FileHeader) + (std::size_t)header.nBlocks * sizeof(U32);
+    if ( (headerSize > compressedSize) || ( (std::size_t)header.nBlocks * header.blockSize < size ) ) {
+        return false;
+    }
+
+    std::vector<DecompressBlockArgs> blocks(header.nBlocks);
+    std::size_t srcOffset = headerSize;
+    for (U32 i = 0; i < header.nBlocks; ++i) {
+        U32 blockSize;
+        std::memcpy( &blockSize, compressed + sizeof(FileHeader) + i * sizeof(U32), sizeof(U32) );
+        DecompressBlockArgs& b = blocks[i];
+        b.isRaw = (blockSize & NATRON_CACHE_COMPRESSION_RAW_BLOCK_BIT) != 0;
+        b.srcSize = blockSize & ~NATRON_CACHE_COMPRESSION_RAW_BLOCK_BIT;
+        b.src = (const U8*)compressed + srcOffset;
+        b.dst = (U8*)data + (std::size_t)i * header.blockSize;
+        b.dstSize = std::min( (std::size_t)header.blockSize, size - (std::size_t)i * header.blockSize );
+        b.typeSize = header.dataTypeSize;
+        srcOffset += b.srcSize;
+        if (srcOffset > compressedSize) {
+            return false;
+        }
+    }
+
+    if ( !multiThreaded || (blocks.size() <= 1) ) {
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            if ( !decompressBlock(blocks[i]) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    QList<bool> rets = QtConcurrent::blockingMapped<QList<bool> >( blocks, decompressBlock );
+    for (QList<bool>::const_iterator it = rets.begin(); it != rets.end(); ++it) {
+        if (!*it) {
+            return false;
+        }
+    }
+
+    return true;
+} // decompress
+
+bool
+writeCompressedFile(const char* data,
+                    std::size_t size,
+                    std::size_t dataTypeSize,
+                    const std::string& filepath)
+{
+    std::vector<char> compressed;
+
+    compress(data, size, dataTypeSize, &compressed);
+
+    {
+        FStreamsSupport::ofstream ofile;
+        FStreamsSupport::open(&ofile, filepath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if (!ofile) {
+            return false;
+        }
+        ofile.write( &compressed[0], compressed.size() );
+        if (!ofile) {
+            ofile.close();
+            std::remove( filepath.c_str() );
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+readCompressedFile(const std::string& compressedFilePath,
+                   MemoryFile* file)
+{
+    std::vector<char> compressed;
+    {
+        FStreamsSupport::ifstream ifile;
+        FStreamsSupport::open(&ifile, compressedFilePath, std::ios_base::in | std::ios_base::binary);
+        if (!ifile) {
+            return false;
+        }
+        ifile.seekg(0, std::ios_base::end);
+        std::streamoff fileSize = ifile.tellg();
+        ifile.seekg(0, std::ios_base::beg);
+        if (fileSize <= 0) {
+            return false;
+        }
+        compressed.resize( (std::size_t)fileSize );
+        ifile.read( &compressed[0], fileSize );
+        if (!ifile) {
+            return false;
+        }
+    }
+    std::size_t size = getDecompressedSize( &compressed[0], compressed.size() );
+    if (size == 0) {
+        return false;
+    }
+    try {
+        file->resize(size);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    return decompress( &compressed[0], compressed.size(), file->data(), size );
+}
+} // namespace CacheCompression
+
+NATRON_NAMESPACE_EXIT
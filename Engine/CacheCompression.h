@@ -0,0 +1,86 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_CACHECOMPRESSION_H
+#define NATRON_ENGINE_CACHECOMPRESSION_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Engine/EngineFwd.h"
+
+// Extension appended to the path of a cache file once it has been compressed
+#define NATRON_CACHE_COMPRESSED_FILE_EXT "lz"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Lossless compression of cache entries stored on disk.
+ * The codec is a fast LZ77 byte-oriented compressor (in the spirit of LZ4) working on independent blocks,
+ * so that blocks can be decompressed in parallel. Before compression, multi-byte elements
+ * (short, half or float pixels) are shuffled into byte-planes: the most significant bytes of
+ * neighbouring pixels are very often equal, which makes them much more compressible.
+ **/
+namespace CacheCompression {
+/**
+ * @brief Returns the path of the compressed file corresponding to the given cache file.
+ **/
+std::string getCompressedFilePath(const std::string& filepath);
+
+/**
+ * @brief Compresses size bytes of data made of elements of dataTypeSize bytes into compressed.
+ **/
+void compress(const char* data, std::size_t size, std::size_t dataTypeSize, std::vector<char>* compressed);
+
+/**
+ * @brief Returns the size in bytes of the data once decompressed, or 0 if the buffer is not a valid compressed buffer.
+ **/
+std::size_t getDecompressedSize(const char* compressed, std::size_t compressedSize);
+
+/**
+ * @brief Decompresses the buffer into data which must be getDecompressedSize() bytes long.
+ * Blocks are decompressed in parallel using the global thread-pool if multiThreaded is true.
+ * @returns False if the compressed buffer is corrupted.
+ **/
+bool decompress(const char* compressed, std::size_t compressedSize, char* data, std::size_t size, bool multiThreaded = true);
+
+/**
+ * @brief Compresses the data and writes it to the given file path.
+ * @returns False on failure, in which case no file is left behind.
+ **/
+bool writeCompressedFile(const char* data, std::size_t size, std::size_t dataTypeSize, const std::string& filepath);
+
+/**
+ * @brief Decompresses the file at compressedFilePath into the memory mapped file, which is resized accordingly.
+ * @returns False on failure.
+ **/
+bool readCompressedFile(const std::string& compressedFilePath, MemoryFile* file);
+} // namespace CacheCompression
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_CACHECOMPRESSION_H
@@ -61,6 +61,7 @@
 #endif
 
 #include "Engine/Hash64.h"
+#include "Engine/CacheCompression.h"
 #include "Engine/CacheEntryHolder.h"
 #include "Engine/MemoryFile.h"
 #include "Engine/NonKeyParams.h"
@@ -240,6 +241,25 @@ public:
      **/
     virtual void freeTile(const TileCacheFilePtr& file, std::size_t dataOffset) = 0;
 
+    /**
+     * @brief Returns true if the backing files of entries leaving the memory portion of the cache should be compressed.
+     **/
+    virtual bool isCompressionEnabled() const = 0;
+
+    /**
+     * @brief Relevant only for compressed caches. Hands over the mapped backing file of an entry to a background thread
+     * which compresses it and then removes the raw file, so that the caller does not wait on the compression and the disk.
+     * The caller must not use the file anymore.
+     **/
+    virtual void compressBackingFileAsync(const MemoryFilePtr& file, std::size_t dataTypeSize) = 0;
+
+    /**
+     * @brief Relevant only for compressed caches. If the backing file at the given path is still waiting to be compressed,
+     * its compression is canceled and the file, still mapped, is returned. If it is being compressed, this function waits
+     * for the compression to be done and returns NULL.
+     **/
+    virtual MemoryFilePtr cancelBackingFileCompression(const std::string& filepath) = 0;
+
 #ifdef DEBUG
     static bool checkFileNameMatchesHash(const std::string &originalFileName,
                                          U64 hash)
@@ -310,6 +330,14 @@ public:
         return fs.is_open() && fs.good();
 #endif
     }
+
+    /**
+     * @brief Returns true if the cache file exists, either raw or compressed.
+     **/
+    static bool cacheFileExists(const std::string& filename)
+    {
+        return fileExists(filename) || fileExists( CacheCompression::getCompressedFilePath(filename) );
+    }
 };
 
 class AbstractCacheEntryBase : boost::noncopyable
@@ -317,6 +345,9 @@ class AbstractCacheEntryBase : boost::noncopyable
 public:
 
     AbstractCacheEntryBase()
+        : _evictionCostMutex()
+        , _renderTime(0.)
+        , _cachePriority(1.)
     {
 
     }
@@ -330,12 +361,61 @@ public:
     virtual void freeTile(const TileCacheFilePtr& file, std::size_t dataOffset) = 0;
     virtual TileCacheFilePtr getTileCacheFile(const std::string& filepath, std::size_t dataOffset) = 0;
     virtual std::size_t getCacheTileSizeBytes() const = 0;
+    virtual void compressBackingFileAsync(const MemoryFilePtr& file, std::size_t dataTypeSize) = 0;
+    virtual MemoryFilePtr cancelBackingFileCompression(const std::string& filepath) = 0;
 
     virtual size_t size() const = 0;
     virtual double getTime() const = 0;
     virtual U64 getElementsCountFromParams() const = 0;
 
     virtual void syncBackingFile() const = 0;
+
+    /**
+     * @brief Adds to the time spent rendering the content of this entry. This may be called concurrently
+     * by the threads rendering different parts of the entry.
+     **/
+    void addRenderTime(double seconds)
+    {
+        QMutexLocker k(&_evictionCostMutex);
+
+        _renderTime += seconds;
+    }
+
+    double getRenderTime() const
+    {
+        QMutexLocker k(&_evictionCostMutex);
+
+        return _renderTime;
+    }
+
+    /**
+     * @brief Multiplies the eviction cost of the entry: above 1 the entry is kept longer in the cache,
+     * below 1 it is evicted earlier.
+     **/
+    void setCachePriority(double priority)
+    {
+        QMutexLocker k(&_evictionCostMutex);
+
+        _cachePriority = priority;
+    }
+
+    /**
+     * @brief What it would cost to evict this entry: the time spent rendering it per byte, weighted by its priority.
+     * Among its least recently used entries, the cache evicts the one with the lowest cost first.
+     **/
+    double getEvictionCost() const
+    {
+        std::size_t bytes = size();
+        QMutexLocker k(&_evictionCostMutex);
+
+        return bytes == 0 ? 0. : (_renderTime * _cachePriority / bytes);
+    }
+
+private:
+
+    mutable QMutex _evictionCostMutex;
+    double _renderTime;
+    double _cachePriority;
 };
 
 
@@ -392,6 +472,7 @@ public:
         , _entry(0)
         , _cacheFile()
         , _cacheFileDataOffset(0)
+        , _compressedDataTypeSize(0)
         , _storageMode(eStorageModeRAM)
     {
     }
@@ -413,8 +494,14 @@ public:
         _buffer->resize(count);
     }
 
+    /**
+     * @param compressedDataTypeSize If non 0, the file is compressed by the cache when the buffer is deallocated and the
+     * data is made of elements of this size in bytes.
+     **/
     void allocateMMAP(U64 count,
-                      const std::string& path)
+                      const std::string& path,
+                      AbstractCacheEntryBase* entry,
+                      std::size_t compressedDataTypeSize)
     {
         assert( _path.empty() );
         if (_backingFile) {
@@ -422,6 +509,8 @@ public:
         }
         _storageMode = eStorageModeDisk;
         _path = path;
+        _entry = entry;
+        _compressedDataTypeSize = entry ? compressedDataTypeSize : 0;
         try {
             _backingFile.reset( new MemoryFile(_path, MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
         } catch (const std::runtime_error & r) {
@@ -549,6 +638,31 @@ public:
     void reOpenFileMapping() const
     {
         assert(!_backingFile && _storageMode == eStorageModeDisk);
+        if (_compressedDataTypeSize > 0) {
+            // If the compression did not happen yet, the file is still mapped
+            _backingFile = _entry->cancelBackingFileCompression(_path);
+            if (_backingFile) {
+                return;
+            }
+            std::string compressedPath = CacheCompression::getCompressedFilePath(_path);
+            if ( CacheAPI::fileExists(compressedPath) ) {
+                try {
+                    _backingFile.reset( new MemoryFile(_path, MemoryFile::eFileOpenModeEnumIfExistsTruncateElseCreate) );
+                } catch (const std::exception & e) {
+                    _backingFile.reset();
+                    throw std::bad_alloc();
+                }
+                if ( !CacheCompression::readCompressedFile(compressedPath, _backingFile.get()) ) {
+                    _backingFile->remove();
+                    _backingFile.reset();
+                    throw std::bad_alloc();
+                }
+                int ret_code = std::remove( compressedPath.c_str() );
+                Q_UNUSED(ret_code);
+
+                return;
+            }
+        }
         try{
             _backingFile.reset( new MemoryFile(_path, MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
         } catch (const std::exception & e) {
@@ -557,9 +671,10 @@ public:
         }
     }
 
-    void restoreBufferFromFile(const std::string & path, std::size_t dataOffset, AbstractCacheEntryBase* entry, bool isTileCache)
+    void restoreBufferFromFile(const std::string & path, std::size_t dataOffset, AbstractCacheEntryBase* entry, bool isTileCache, std::size_t compressedDataTypeSize)
     {
         _entry = entry;
+        _compressedDataTypeSize = isTileCache ? 0 : compressedDataTypeSize;
         if (isTileCache) {
             _cacheFile = entry->getTileCacheFile(path, dataOffset);
             if (!_cacheFile) {
@@ -578,7 +693,11 @@ public:
                 _buffer->clear();
             }
         } else if (_storageMode == eStorageModeDisk) {
-            if (_backingFile) {
+            if ( _backingFile && (_compressedDataTypeSize > 0) ) {
+                // The cache compresses and writes the file in the background
+                _entry->compressBackingFileAsync(_backingFile, _compressedDataTypeSize);
+                _backingFile.reset();
+            } else if (_backingFile) {
                 bool flushOk = _backingFile->flush(MemoryFile::eFlushTypeAsync, 0, 0);
                 _backingFile.reset();
                 if (!flushOk) {
@@ -608,6 +727,14 @@ public:
     bool removeAnyBackingFile() const
     {
         if (_storageMode == eStorageModeDisk && !_cacheFile) {
+            if ( !_backingFile && (_compressedDataTypeSize > 0) ) {
+                MemoryFilePtr pendingFile = _entry->cancelBackingFileCompression(_path);
+                if (pendingFile) {
+                    pendingFile->remove();
+                }
+                int ret_code = std::remove( CacheCompression::getCompressedFilePath(_path).c_str() );
+                Q_UNUSED(ret_code);
+            }
             if (_backingFile) {
                 _backingFile->remove();
                 _backingFile.reset();
@@ -725,13 +852,16 @@ private:
 
     /*mutable so the reOpenFileMapping function can reopen the mapped file. It doesn't
        change the underlying data*/
-    mutable boost::scoped_ptr<MemoryFile> _backingFile;
+    mutable MemoryFilePtr _backingFile;
 
-    // Set if the cache is a tile cache
+    // Set if the cache is a tile cache or a compressed cache
     AbstractCacheEntryBase* _entry;
     TileCacheFilePtr _cacheFile;
     std::size_t _cacheFileDataOffset;
 
+    // If non 0, the backing file is compressed when deallocated. This is the size of a data element in bytes.
+    std::size_t _compressedDataTypeSize;
+
     // Used when we store images as OpenGL textures
     boost::scoped_ptr<Texture> _glTexture;
     StorageModeEnum _storageMode;
@@ -1166,6 +1296,18 @@ private:
         return const_cast<CacheAPI*>(_cache)->getTileCacheFile(filepath, dataOffset);
     }
 
+    virtual void compressBackingFileAsync(const MemoryFilePtr& file, std::size_t dataTypeSize) OVERRIDE FINAL
+    {
+        assert(_cache);
+        const_cast<CacheAPI*>(_cache)->compressBackingFileAsync(file, dataTypeSize);
+    }
+
+    virtual MemoryFilePtr cancelBackingFileCompression(const std::string& filepath) OVERRIDE FINAL
+    {
+        assert(_cache);
+        return const_cast<CacheAPI*>(_cache)->cancelBackingFileCompression(filepath);
+    }
+
 
 
     /** @brief This function is called in allocateMeory(...) and before the object is exposed
@@ -1202,10 +1344,10 @@ private:
                 //Check if the filename already exists, if so append a 0-based index after the hash (separated by a '_')
                 //and try again
                 int index = 0;
-                if ( CacheAPI::fileExists(fileName) ) {
+                if ( CacheAPI::cacheFileExists(fileName) ) {
                     fileName.insert(fileName.size() - 4, "_0");
                 }
-                while ( CacheAPI::fileExists(fileName) ) {
+                while ( CacheAPI::cacheFileExists(fileName) ) {
                     ++index;
                     std::stringstream ss;
                     ss << index;
@@ -1217,7 +1359,7 @@ private:
                 }
 #endif
                 U64 count = getElementsCountFromParams();
-                _data.allocateMMAP(count, fileName);
+                _data.allocateMMAP(count, fileName, this, _cache->isCompressionEnabled() ? info.dataTypeSize : 0);
             }
         } else if (info.mode == eStorageModeRAM) {
             U64 count = getElementsCountFromParams();
@@ -1236,10 +1378,16 @@ private:
     {
 
         bool isTileCache = _cache && _cache->isTileCache();
-        if (!isTileCache && !CacheAPI::fileExists(path) ) {
+        if (!isTileCache && !CacheAPI::cacheFileExists(path) ) {
             throw std::runtime_error("Cache restore, no such file: " + path);
         }
-        _data.restoreBufferFromFile(path, offset, this, isTileCache);
+        // Whether an entry is compressed does not depend on the current setting, which only applies to new entries,
+        // but on how it was written by the session that saved the cache
+        std::size_t compressedDataTypeSize = 0;
+        if ( !isTileCache && CacheAPI::fileExists( CacheCompression::getCompressedFilePath(path) ) ) {
+            compressedDataTypeSize = _params->getStorageInfo().dataTypeSize;
+        }
+        _data.restoreBufferFromFile(path, offset, this, isTileCache, compressedDataTypeSize);
     }
 
 protected:
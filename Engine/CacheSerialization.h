@@ -139,7 +139,7 @@ Cache<EntryType>::restore(const CacheTOC & tableOfContents)
 
         try {
             value = new EntryType(it->key, it->params, this);
-            if (it->size != getTileSizeBytes()) {
+            if ( isTileCache() && (it->size != getTileSizeBytes()) ) {
                 delete value;
                 continue;
             }
@@ -152,6 +152,11 @@ Cache<EntryType>::restore(const CacheTOC & tableOfContents)
         }
         const std::string& filePath = value->getFilePath();
         usedFilePaths.insert(QString::fromUtf8(filePath.c_str()));
+        // The entry may have been compressed when it left the memory portion of the cache
+        std::string compressedFilePath = CacheCompression::getCompressedFilePath(filePath);
+        if ( CacheAPI::fileExists(compressedFilePath) ) {
+            usedFilePaths.insert( QString::fromUtf8( compressedFilePath.c_str() ) );
+        }
         {
             QMutexLocker locker(&_lock);
             sealEntry(EntryTypePtr(value), false /*inMemory*/);
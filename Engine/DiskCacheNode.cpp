@@ -71,6 +71,8 @@ DiskCacheNode::addAcceptedComponents(int /*inputNb*/,
 void
 DiskCacheNode::addSupportedBitDepth(std::list<ImageBitDepthEnum>* depths) const
 {
+    // Half is listed first so that half inputs are cached as half, see Node::getClosestSupportedBitDepth
+    depths->push_back(eImageBitDepthHalf);
     depths->push_back(eImageBitDepthFloat);
 }
 
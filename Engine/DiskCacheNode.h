@@ -115,7 +115,7 @@ public:
     virtual void addAcceptedComponents(int inputNb, std::list<ImagePlaneDesc>* comps) OVERRIDE FINAL;
     virtual void addSupportedBitDepth(std::list<ImageBitDepthEnum>* depths) const OVERRIDE FINAL;
 
-    ///Doesn't really matter here since it won't be used (this effect is always an identity)
+    ///The render is a copy of the source: the host slices it in tiles rendered concurrently
     virtual RenderSafetyEnum renderThreadSafety() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
         return eRenderSafetyFullySafeFrame;
@@ -123,7 +123,12 @@ public:
 
     virtual bool supportsTiles() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
-        return false;
+        return true;
+    }
+
+    virtual bool isRenderSingleThreaded() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return true;
     }
 
     virtual bool supportsMultiResolution() const OVERRIDE FINAL WARN_UNUSED_RETURN
@@ -76,6 +76,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/ReadNode.h"
 #include "Engine/Settings.h"
+#include "Engine/ThreadPool.h"
 #include "Engine/Timer.h"
 #include "Engine/Transform.h"
 #include "Engine/UndoCommand.h"
@@ -313,7 +314,14 @@ EffectInstance::setParallelRenderArgsTLS(double time,
     }
     assert(abortInfo);
     args->abortInfo = abortInfo;
+    // Renders in response to a user interaction that cannot be aborted are never aborted, see Implementation::aborted()
+    if ( !isRenderUserInteraction || abortInfo->canAbort() ) {
+        args->abortFlag = abortInfo->getAbortFlag();
+    } else {
+        args->abortFlag.reset();
+    }
     args->treeRoot = treeRoot;
+    args->renderThreadPriority = RenderThreadScheduler::getRenderPriority(treeRoot);
     args->visitsCount = visitsCount;
     args->textureIndex = textureIndex;
     args->isAnalysis = isAnalysis;
@@ -474,6 +482,22 @@ EffectInstance::Implementation::aborted(bool isRenderResponseToUserInteraction,
 bool
 EffectInstance::aborted() const
 {
+    /*
+       The frame being rendered by this thread carries the abort flag of its render in its ParallelRenderArgs:
+       polling it does not take any lock, which matters since plug-ins call this in their inner loops.
+       The flag is raised for all the reasons Implementation::aborted() checks for: when the render is aborted,
+       and by the ParallelRenderArgsSetter and the render engine when the output node aborts its renders.
+     */
+    {
+        EffectTLSDataPtr tls = _imp->tlsData->getTLSData();
+        if ( tls && !tls->frameArgs.empty() ) {
+            const RenderAbortFlagPtr& abortFlag = tls->frameArgs.back()->abortFlag;
+            if (abortFlag) {
+                return abortFlag->isAborted();
+            }
+        }
+    }
+
     QThread* thisThread = QThread::currentThread();
 
     /* If this thread is an AbortableThread, this function will be extremely fast*/
@@ -1793,11 +1817,37 @@ EffectInstance::getImageFromCacheAndConvertIfNeeded(bool /*useCache*/,
                 dstRoi.intersect(imgToConvertBounds, &dstRoi);
 
                 if (imgToConvertBounds.area() > 1) {
+                    /*
+                       The levels in-between are built on the way: cache them too, so that a later request for one of them
+                       does not have to downscale again from the image we are converting.
+                     */
+                    std::vector<ImagePtr> intermediateImages;
+                    std::vector<Image*> intermediateOutputs;
+                    if ( imageToConvert->usesBitMap() ) {
+                        for (unsigned int level = imageToConvert->getMipMapLevel() + 1; level < mipMapLevel; ++level) {
+                            RectI levelBounds = dstRoi.downscalePowerOfTwoSmallestEnclosing( level - imageToConvert->getMipMapLevel() );
+                            ImageParamsPtr levelParams = Image::makeParams(rod,
+                                                                           levelBounds,
+                                                                           oldParams->getPixelAspectRatio(),
+                                                                           level,
+                                                                           oldParams->isRodProjectFormat(),
+                                                                           oldParams->getComponents(),
+                                                                           oldParams->getBitDepth(),
+                                                                           oldParams->getPremultiplication(),
+                                                                           oldParams->getFieldingOrder(),
+                                                                           eStorageModeRAM);
+                            ImagePtr levelImg;
+                            getOrCreateFromCacheInternal(key, levelParams, true, &levelImg);
+                            intermediateImages.push_back(levelImg);
+                            intermediateOutputs.push_back( levelImg.get() );
+                        }
+                    }
                     imageToConvert->downscaleMipMap( rod,
                                                      dstRoi,
                                                      imageToConvert->getMipMapLevel(), img->getMipMapLevel(),
                                                      imageToConvert->usesBitMap(),
-                                                     img.get() );
+                                                     img.get(),
+                                                     intermediateOutputs.empty() ? 0 : &intermediateOutputs );
                 } else {
                     img->pasteFrom(*imageToConvert, imgToConvertBounds);
                 }
@@ -2250,6 +2300,9 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
         return eRenderingFunctorRetOK;
     }
 
+    ///Let the tiles of more urgent renders run first, see RenderThreadScheduler
+    RenderThreadSchedulerTask scheduledTask( tls->frameArgs.empty() ? eRenderThreadPriorityBackground : tls->frameArgs.back()->renderThreadPriority );
+
 
     ///This RAII struct controls the lifetime of the validArgs Flag in tls->currentRenderArgs
     Implementation::ScopedRenderArgs scopedArgs(tls,
@@ -2397,13 +2450,10 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                                               const ImagePremultiplicationEnum originalImagePremultiplication,
                                               ImagePlanesToRender & planes)
 {
-    TimeLapsePtr timeRecorder;
+    // Always measured: the cache uses the render time to decide which images to keep
+    TimeLapse timeRecorder;
     const ParallelRenderArgsPtr& frameArgs = tls->frameArgs.back();
 
-    if (frameArgs->stats) {
-        timeRecorder = boost::make_shared<TimeLapse>();
-    }
-
     const EffectInstance::PlaneToRender & firstPlane = planes.planes.begin()->second;
     const double time = tls->currentRenderArgs.time;
     const ViewIdx view = tls->currentRenderArgs.view;
@@ -2491,7 +2541,7 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                 it->second.renderMappedImage->fillZero(renderMappedRectToRender, glContext);
 
                 if ( frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
-                    frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  NodePtr(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder->getTimeSinceCreation() );
+                    frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  NodePtr(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder.getTimeSinceCreation() );
                 }
             }
 
@@ -2508,7 +2558,7 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                     it->second.renderMappedImage->fillZero(renderMappedRectToRender, glContext);
 
                     if ( frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
-                        frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  tls->currentRenderArgs.identityInput->getNode(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder->getTimeSinceCreation() );
+                        frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  tls->currentRenderArgs.identityInput->getNode(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder.getTimeSinceCreation() );
                     }
                 }
 
@@ -2582,7 +2632,7 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
                     }
 
                     if ( frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
-                        frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  tls->currentRenderArgs.identityInput->getNode(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder->getTimeSinceCreation() );
+                        frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  tls->currentRenderArgs.identityInput->getNode(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder.getTimeSinceCreation() );
                     }
                 }
 
@@ -2751,6 +2801,7 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
     bool useMaskMix = _publicInterface->isHostMaskingEnabled() || _publicInterface->isHostMixingEnabled();
     double mix = useMaskMix ? _publicInterface->getNode()->getHostMixingValue(time, view) : 1.;
     bool doMask = useMaskMix ? _publicInterface->getNode()->isMaskEnabled(_publicInterface->getNInputs() - 1) : false;
+    const double cachePriority = _publicInterface->getNode()->getCachePriority();
 
     //Check for NaNs, copy to output image and mark for rendered
     for (std::map<ImagePlaneDesc, EffectInstance::PlaneToRender>::const_iterator it = outputPlanes.begin(); it != outputPlanes.end(); ++it) {
@@ -2907,8 +2958,17 @@ EffectInstance::Implementation::renderHandler(const EffectTLSDataPtr& tls,
             } // if (renderFullScaleThenDownscale) {
         } // if (it->second.isAllocatedOnTheFly) {
 
+        // Expensive images are kept longer in the cache
+        const double renderTime = timeRecorder.getTimeSinceCreation();
+        it->second.fullscaleImage->addRenderTime(renderTime);
+        it->second.fullscaleImage->setCachePriority(cachePriority);
+        if (it->second.downscaleImage != it->second.fullscaleImage) {
+            it->second.downscaleImage->addRenderTime(renderTime);
+            it->second.downscaleImage->setCachePriority(cachePriority);
+        }
+
         if ( frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
-            frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  NodePtr(), it->first.getChannelsLabel(), renderMappedRectToRender, timeRecorder->getTimeSinceCreation() );
+            frameArgs->stats->addRenderInfosForNode( _publicInterface->getNode(),  NodePtr(), it->first.getChannelsLabel(), renderMappedRectToRender, renderTime );
         }
     } // for (std::map<ImagePlaneDesc,PlaneToRender>::const_iterator it = outputPlanes.begin(); it != outputPlanes.end(); ++it) {
 
@@ -4746,6 +4806,10 @@ EffectInstance::onKnobValueChanged_public(KnobI* k,
         return false;
     }
 
+    if (reason != eValueChangedReasonTimeChanged) {
+        node->incrementSerializationAge();
+    }
+
     // for image readers, image writers, and video writers, frame range must be updated before kOfxActionInstanceChanged is called on kOfxImageEffectFileParamName
     bool mustCallOnFileNameParameterChanged = false;
     if ( (reason != eValueChangedReasonTimeChanged) && ( isReader() || isWriter() ) && k && (k->getName() == kOfxImageEffectFileParamName) ) {
@@ -1267,6 +1267,17 @@ public:
         return false;
     }
 
+    /**
+     * @brief Returns true if the render action does not multi-thread itself. If the effect is also eRenderSafetyFullySafeFrame
+     * and supports tiles, the host slices the render window in tiles that are rendered concurrently, and tiles for which
+     * isIdentity returns true are copied from the identity input instead.
+     * OpenFX plug-ins are expected to use the multi-thread suite instead.
+     **/
+    virtual bool isRenderSingleThreaded() const
+    {
+        return false;
+    }
+
     /**
      * @brief Does this effect supports multiresolution ?
      * http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#kOfxImageEffectPropSupportsMultiResolution
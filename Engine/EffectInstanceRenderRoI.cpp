@@ -87,7 +87,9 @@ NATRON_NAMESPACE_ENTER
 /*
  * @brief Split all rects to render in smaller rects and check if each one of them is identity.
  * For identity rectangles, we just call renderRoI again on the identity input in the tiledRenderingFunctor.
- * For non-identity rectangles, compute the bounding box of them and render it
+ * For non-identity rectangles, compute the bounding box of them and render it, or if mergeNonIdentityRects is false
+ * render each of them separately (so that they can be rendered concurrently).
+ * splitsCount is passed to RectI::splitIntoSmallerRects, 0 means automatic.
  */
 static void
 optimizeRectsToRender(EffectInstance* self,
@@ -96,10 +98,12 @@ optimizeRectsToRender(EffectInstance* self,
                       const double time,
                       const ViewIdx view,
                       const RenderScale & renderMappedScale,
+                      int splitsCount,
+                      bool mergeNonIdentityRects,
                       std::list<EffectInstance::RectToRender>* finalRectsToRender)
 {
     for (std::list<RectI>::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
-        std::vector<RectI> splits = it->splitIntoSmallerRects(0);
+        std::vector<RectI> splits = it->splitIntoSmallerRects(splitsCount);
         EffectInstance::RectToRender nonIdentityRect;
         nonIdentityRect.isIdentity = false;
         nonIdentityRect.identityTime = 0;
@@ -149,6 +153,12 @@ optimizeRectsToRender(EffectInstance* self,
                 r.identityView = inputIdentityView;
                 r.rect = splits[i];
                 finalRectsToRender->push_back(r);
+            } else if (!mergeNonIdentityRects) {
+                EffectInstance::RectToRender r;
+                r.isIdentity = false;
+                r.identityTime = 0;
+                r.rect = splits[i];
+                finalRectsToRender->push_back(r);
             } else {
                 nonIdentityRectSet = true;
                 nonIdentityRect.rect.x1 = std::min(splits[i].x1, nonIdentityRect.rect.x1);
@@ -180,6 +190,12 @@ EffectInstance::convertPlanesFormatsIfNeeded(const AppInstancePtr& app,
     bool imageConversionNeeded = ( /*!targetIsMultiPlanar &&*/ targetComponents.getNumComponents() != inputImage->getComponents().getNumComponents() ) || targetDepth != inputImage->getBitDepth();
 
     if (!imageConversionNeeded) {
+        if ( inputImage->getComponents() != targetComponents ) {
+            // Same memory layout under another name (e.g. a plane fetched by an identity node with a channel selector):
+            // return a view of the input rather than a copy.
+            return boost::make_shared<Image>(inputImage, targetComponents, inputImage->getPremultiplication());
+        }
+
         return inputImage;
     } else {
         /**
@@ -543,7 +559,13 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
                         if ( (inputRetCode == eRenderRoIRetCodeAborted) || (inputRetCode == eRenderRoIRetCodeFailed) || inputPlanes.empty() ) {
                             return inputRetCode;
                         }
-                        outputPlanes->insert( std::make_pair(*it, inputPlanes.begin()->second) );
+                        ImagePtr inputPlane = inputPlanes.begin()->second;
+                        if ( ( inputPlane->getComponents() != *it ) && ( inputPlane->getComponents().getNumComponents() == it->getNumComponents() ) &&
+                             ( inputPlane->getStorageMode() != eStorageModeGLTex ) ) {
+                            // The plane is passed through under the name that was requested: alias its pixels rather than copying them
+                            inputPlane = boost::make_shared<Image>(inputPlane, *it, inputPlane->getPremultiplication());
+                        }
+                        outputPlanes->insert( std::make_pair(*it, inputPlane) );
                     }
                 }
             }
@@ -1274,8 +1296,14 @@ EffectInstance::renderRoI(const RenderRoIArgs & args,
     }
 
 
-    if (tryIdentityOptim) {
-        optimizeRectsToRender(this, inputsRoDIntersectionPixel, rectsLeftToRender, args.time, args.view, renderMappedScale, &planesToRender->rectsToRender);
+    // Effects whose render action is single-threaded get their rectangles sliced in tiles rendered concurrently.
+    // Each tile is checked for identity, so that the tiles the effect leaves untouched are copied from its input.
+    bool splitForThreads = (safety == eRenderSafetyFullySafeFrame) && !planesToRender->useOpenGL && isRenderSingleThreaded();
+
+    if (splitForThreads) {
+        optimizeRectsToRender(this, tryIdentityOptim ? inputsRoDIntersectionPixel : RectI(), rectsLeftToRender, args.time, args.view, renderMappedScale, appPTR->getMaxThreadCount(), false, &planesToRender->rectsToRender);
+    } else if (tryIdentityOptim) {
+        optimizeRectsToRender(this, inputsRoDIntersectionPixel, rectsLeftToRender, args.time, args.view, renderMappedScale, 0, true, &planesToRender->rectsToRender);
     } else {
         // If plug-in wants host frame threading and there is only 1 rect to render, split it
         /*if (safety == eRenderSafetyFullySafeFrame && rectsLeftToRender.size() == 1 && frameArgs->tilesSupported) {
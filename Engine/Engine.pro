@@ -76,6 +76,7 @@ SOURCES += \
     BlockingBackgroundRender.cpp \
     CLArgs.cpp \
     Cache.cpp \
+    CacheCompression.cpp \
     CoonsRegularization.cpp \
     CreateNodeArgs.cpp \
     Curve.cpp \
@@ -99,6 +100,7 @@ SOURCES += \
     GenericSchedulerThreadWatcher.cpp \
     GroupInput.cpp \
     GroupOutput.cpp \
+    Half.cpp \
     Hash64.cpp \
     HistogramCPU.cpp \
     HostOverlaySupport.cpp \
@@ -163,10 +165,12 @@ SOURCES += \
     PyNode.cpp \
     PyNodeGroup.cpp \
     PyParameter.cpp \
+    PyPlugCache.cpp \
     PyRoto.cpp \
     PySideCompat.cpp \
     PyTracker.cpp \
     ReadNode.cpp \
+    ReadNodePrefetcher.cpp \
     RectD.cpp \
     RectI.cpp \
     RenderStats.cpp \
@@ -177,6 +181,7 @@ SOURCES += \
     RotoPaint.cpp \
     RotoPaintInteract.cpp \
     RotoSmear.cpp \
+    RotoSpatialIndex.cpp \
     RotoStrokeItem.cpp \
     RotoUndoCommand.cpp \
     ScriptObject.cpp \
@@ -200,6 +205,7 @@ SOURCES += \
     Transform.cpp \
     Utils.cpp \
     ViewerInstance.cpp \
+    ViewerSpeculativeRenderer.cpp \
     WriteNode.cpp \
     ../Global/glad_source.c \
     ../Global/FStreamsSupport.cpp \
@@ -272,6 +278,7 @@ HEADERS += \
     BufferableObject.h \
     CLArgs.h \
     Cache.h \
+    CacheCompression.h \
     CacheEntry.h \
     CacheEntryHolder.h \
     CacheSerialization.h \
@@ -306,6 +313,7 @@ HEADERS += \
     GenericSchedulerThreadWatcher.h \
     GroupInput.h \
     GroupOutput.h \
+    Half.h \
     Hash64.h \
     HistogramCPU.h \
     HostOverlaySupport.h \
@@ -379,10 +387,12 @@ HEADERS += \
     PyNode.h \
     PyNodeGroup.h \
     PyParameter.h \
+    PyPlugCache.h \
     PyRoto.h \
     PyTracker.h \
     Pyside_Engine_Python.h \
     ReadNode.h \
+    ReadNodePrefetcher.h \
     RectD.h \
     RectDSerialization.h \
     RectI.h \
@@ -401,6 +411,7 @@ HEADERS += \
     RotoPaintInteract.h \
     RotoPoint.h \
     RotoSmear.h \
+    RotoSpatialIndex.h \
     RotoStrokeItem.h \
     RotoStrokeItemSerialization.h \
     RotoUndoCommand.h \
@@ -437,6 +448,7 @@ HEADERS += \
     ViewIdx.h \
     ViewerInstance.h \
     ViewerInstancePrivate.h \
+    ViewerSpeculativeRenderer.h \
     WriteNode.h \
     fstream_mingw.h \
     ../Global/Enums.h \
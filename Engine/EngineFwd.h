@@ -232,8 +232,11 @@ class ProjectBeingLoadedInfo;
 class ProjectSerialization;
 class RectD;
 class RectI;
+class RenderAbortFlag;
 class RenderEngine;
+class RenderServer;
 class RenderStats;
+class RenderThreadScheduler;
 class RenderingFlagSetter;
 class RotoContext;
 class RotoDrawableItem;
@@ -398,6 +401,7 @@ typedef boost::shared_ptr<PluginMemory> PluginMemoryPtr;
 typedef boost::shared_ptr<PrecompNode> PrecompNodePtr;
 typedef boost::shared_ptr<ProcessHandler> ProcessHandlerPtr;
 typedef boost::shared_ptr<Project> ProjectPtr;
+typedef boost::shared_ptr<RenderAbortFlag> RenderAbortFlagPtr;
 typedef boost::shared_ptr<RenderEngine> RenderEnginePtr;
 typedef boost::shared_ptr<RenderStats> RenderStatsPtr;
 typedef boost::shared_ptr<RenderingFlagSetter> RenderingFlagSetterPtr;
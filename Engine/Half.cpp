@@ -0,0 +1,157 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Half.h"
+
+// The row conversions use the F16C instructions (which work on ymm registers, hence also need AVX)
+// either because the whole build targets them, or, with GCC and Clang on x86, through functions
+// compiled for that target and selected at runtime after checking the CPU and the OS.
+#if defined(__F16C__)
+#define NATRON_HALF_F16C
+#define NATRON_HALF_F16C_TARGET
+#elif defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define NATRON_HALF_F16C
+#define NATRON_HALF_F16C_RUNTIME_CHECK
+#define NATRON_HALF_F16C_TARGET __attribute__( ( target("avx,f16c") ) )
+#endif
+
+#ifdef NATRON_HALF_F16C
+#include <immintrin.h>
+#endif
+#ifdef NATRON_HALF_F16C_RUNTIME_CHECK
+#include <cpuid.h>
+#endif
+
+NATRON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+#ifdef NATRON_HALF_F16C
+
+#ifdef NATRON_HALF_F16C_RUNTIME_CHECK
+bool
+detectF16C()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if ( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ) {
+        return false;
+    }
+    // F16C (bit 29), AVX (bit 28) and OSXSAVE (bit 27)
+    const unsigned int features = (1u << 29) | (1u << 28) | (1u << 27);
+    if ( (ecx & features) != features ) {
+        return false;
+    }
+    // the OS must also save the xmm and ymm registers on context switches
+    unsigned int xcr0, xcr0High;
+    __asm__ __volatile__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+
+    return (xcr0 & 6) == 6;
+}
+
+#endif
+
+bool
+hasF16C()
+{
+#ifdef NATRON_HALF_F16C_RUNTIME_CHECK
+    static const bool supported = detectF16C();
+
+    return supported;
+#else
+
+    return true;
+#endif
+}
+
+// Both return the number of values converted, a multiple of 8: the caller converts the remainder.
+NATRON_HALF_F16C_TARGET std::size_t
+toFloatF16C(const unsigned short* src,
+            float* dst,
+            std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128( (const __m128i*)(src + i) );
+        _mm256_storeu_ps( dst + i, _mm256_cvtph_ps(h) );
+    }
+
+    return i;
+}
+
+NATRON_HALF_F16C_TARGET std::size_t
+fromFloatF16C(const float* src,
+              unsigned short* dst,
+              std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 f = _mm256_loadu_ps(src + i);
+        _mm_storeu_si128( (__m128i*)(dst + i), _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT) );
+    }
+
+    return i;
+}
+
+#endif // NATRON_HALF_F16C
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+Half::toFloat(const Half* src,
+              float* dst,
+              std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef NATRON_HALF_F16C
+    if ( hasF16C() ) {
+        i = toFloatF16C(&src->_bits, dst, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = bitsToFloat(src[i]._bits);
+    }
+}
+
+void
+Half::fromFloat(const float* src,
+                Half* dst,
+                std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef NATRON_HALF_F16C
+    if ( hasF16C() ) {
+        i = fromFloatF16C(src, &dst->_bits, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i]._bits = floatToBits(src[i]);
+    }
+}
+
+NATRON_NAMESPACE_EXIT
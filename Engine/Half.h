@@ -0,0 +1,220 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_HALF_H
+#define NATRON_ENGINE_HALF_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <cstring> // memcpy
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief A 16-bit IEEE 754 floating point value (1 sign bit, 5 exponent bits, 10 mantissa bits),
+ * the pixel type of eImageBitDepthHalf images. It has the same layout as the OpenEXR and OpenFX half type.
+ * Like OpenEXR's half, it converts implicitly from and to float, so that pixel processing templates
+ * can be instantiated with it: all arithmetic is done in float.
+ * The single value conversions are inline: they use the F16C instructions only when the whole build
+ * targets them (-mf16c), otherwise a portable implementation with the same round-to-nearest-even
+ * behaviour is used. The row conversions (toFloat/fromFloat) also check the CPU at runtime
+ * (with GCC and Clang on x86) and use F16C when it is available, see Half.cpp.
+ **/
+class Half
+{
+public:
+
+    /// Uninitialized, like a float
+    Half()
+    {
+    }
+
+    Half(float f)
+        : _bits( floatToBits(f) )
+    {
+    }
+
+    operator float() const
+    {
+        return bitsToFloat(_bits);
+    }
+
+    Half& operator+=(float f)
+    {
+        _bits = floatToBits(bitsToFloat(_bits) + f);
+
+        return *this;
+    }
+
+    Half& operator-=(float f)
+    {
+        _bits = floatToBits(bitsToFloat(_bits) - f);
+
+        return *this;
+    }
+
+    Half& operator*=(float f)
+    {
+        _bits = floatToBits(bitsToFloat(_bits) * f);
+
+        return *this;
+    }
+
+    Half& operator/=(float f)
+    {
+        _bits = floatToBits(bitsToFloat(_bits) / f);
+
+        return *this;
+    }
+
+    unsigned short bits() const
+    {
+        return _bits;
+    }
+
+    bool isNan() const
+    {
+        return (_bits & 0x7fff) > 0x7c00;
+    }
+
+    static Half fromBits(unsigned short bits)
+    {
+        Half h;
+
+        h._bits = bits;
+
+        return h;
+    }
+
+    static float bitsToFloat(unsigned short h);
+    static unsigned short floatToBits(float f);
+
+    /**
+     * @brief Converts count consecutive values. These are the functions to use on whole image rows:
+     * they use the F16C instructions whenever the CPU has them, even if the build does not target F16C.
+     **/
+    static void toFloat(const Half* src, float* dst, std::size_t count);
+    static void fromFloat(const float* src, Half* dst, std::size_t count);
+
+private:
+
+    unsigned short _bits;
+};
+
+inline float
+Half::bitsToFloat(unsigned short h)
+{
+#ifdef __F16C__
+
+    return _cvtsh_ss(h);
+#else
+    unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+    unsigned int exponent = (h >> 10) & 0x1f;
+    unsigned int mantissa = h & 0x3ff;
+    unsigned int bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            // +/- 0
+            bits = sign;
+        } else {
+            // denormal: renormalize it, all half denormals are normal floats
+            exponent = 127 - 15 + 1;
+            while ( !(mantissa & 0x400) ) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x3ff;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 0x1f) {
+        // inf or nan
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits = sign | ( (exponent + 127 - 15) << 23 ) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy( &f, &bits, sizeof(float) );
+
+    return f;
+#endif
+}
+
+inline unsigned short
+Half::floatToBits(float f)
+{
+#ifdef __F16C__
+
+    return _cvtss_sh(f, 0);
+#else
+    unsigned int x;
+    std::memcpy( &x, &f, sizeof(float) );
+    unsigned int sign = (x >> 16) & 0x8000;
+    x &= 0x7fffffff;
+
+    if (x >= 0x7f800000) {
+        // inf or nan (keep it a quiet nan)
+        return (unsigned short)( sign | 0x7c00 | ( (x > 0x7f800000) ? ( 0x200 | ( (x >> 13) & 0x3ff ) ) : 0 ) );
+    }
+    if (x >= 0x477ff000) {
+        // 65520 and above round to infinity
+        return (unsigned short)(sign | 0x7c00);
+    }
+    if (x < 0x38800000) {
+        // below the smallest normal half (2^-14): denormal or zero
+        if (x <= 0x33000000) {
+            // 2^-25 and below round to zero
+            return (unsigned short)sign;
+        }
+        unsigned int exponent = x >> 23;
+        unsigned int mantissa = (x & 0x7fffff) | 0x800000;
+        unsigned int shift = 126 - exponent;
+        unsigned int d = mantissa >> shift;
+        unsigned int rem = mantissa & ( (1u << shift) - 1 );
+        unsigned int halfway = 1u << (shift - 1);
+        if ( (rem > halfway) || ( (rem == halfway) && (d & 1) ) ) {
+            ++d;
+        }
+
+        return (unsigned short)(sign | d);
+    }
+    // normal: rebias the exponent and round the mantissa to nearest even
+    unsigned int h = (x - 0x38000000) >> 13;
+    unsigned int rem = x & 0x1fff;
+    if ( (rem > 0x1000) || ( (rem == 0x1000) && (h & 1) ) ) {
+        ++h;
+    }
+
+    return (unsigned short)(sign | h);
+#endif
+}
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_HALF_H
@@ -223,52 +223,9 @@ HistogramCPU::getMostRecentlyProducedHistogram(std::vector<float>* histogram1,
     return true;
 }
 
-///putting these in an anonymous namespace will yield this error on gcc 4.2:
-///"function has not external linkage"
-struct pix_red
-{
-    static float val(const float *pix)
-    {
-        return pix[0];
-    }
-};
-
-struct pix_green
-{
-    static float val(const float *pix)
-    {
-        return pix[1];
-    }
-};
-
-struct pix_blue
-{
-    static float val(const float *pix)
-    {
-        return pix[2];
-    }
-};
-
-struct pix_alpha
-{
-    static float val(const float *pix)
-    {
-        return pix[3];
-    }
-};
-
-struct pix_lum
-{
-    static float val(const float *pix)
-    {
-        return 0.299 * pix[0] + 0.587 * pix[1] + 0.114 * pix[2];
-    }
-};
-
-
-template <float pix_func(const float*)>
-void
+static void
 computeHisto(const HistogramRequest & request,
+             const std::vector<float> & values,
              int upscale,
              std::vector<float> *histo)
 {
@@ -277,28 +234,19 @@ computeHisto(const HistogramRequest & request,
     std::fill(histo->begin(), histo->end(), 0.f);
     double binSize = (request.vmax - request.vmin) / histo->size();
 
-    ///Images come from the viewer which is in float.
-    assert(request.image->getBitDepth() == eImageBitDepthFloat);
-
-    Image::ReadAccess acc = request.image->getReadRights();
-
-    for (int y = request.rect.bottom(); y < request.rect.top(); ++y) {
-        for (int x = request.rect.left(); x < request.rect.right(); ++x) {
-            const float *pix = (const float*)acc.pixelAt(x, y);
-            float v = pix_func(pix);
-            if ( (request.vmin <= v) && (v < request.vmax) ) {
-                int index = (int)( (v - request.vmin) / binSize );
-                assert( 0 <= index && index < (int)histo->size() );
-                (*histo)[index] += 1.f;
-            }
+    for (std::vector<float>::const_iterator it = values.begin(); it != values.end(); ++it) {
+        float v = *it;
+        if ( (request.vmin <= v) && (v < request.vmax) ) {
+            int index = (int)( (v - request.vmin) / binSize );
+            assert( 0 <= index && index < (int)histo->size() );
+            (*histo)[index] += 1.f;
         }
     }
 }
 
-
-
 static void
 computeHistogramStatic(const HistogramRequest & request,
+                       const std::vector<float> & values,
                        FinishedHistogramPtr ret,
                        int histogramIndex)
 {
@@ -323,39 +271,11 @@ computeHistogramStatic(const HistogramRequest & request,
         return;
     }
 
-    /// keep the mode parameter in sync with Histogram::DisplayModeEnum
-
-    int mode = request.mode;
-
-    ///if the mode is RGB, adjust the mode to either R,G or B depending on the histogram index
-    if (mode == 0) {
-        mode = histogramIndex + 2;
-    }
-
     ret->pixelsCount = request.rect.area();
     // a histogram with upscale more bins
     std::vector<float> histo_upscaled;
-    switch (mode) {
-    case 1:     //< A
-        computeHisto<&pix_alpha::val>(request, upscale, &histo_upscaled);
-        break;
-    case 2:     //<Y
-        computeHisto<&pix_lum::val>(request, upscale, &histo_upscaled);
-        break;
-    case 3:     //< R
-        computeHisto<&pix_red::val>(request, upscale, &histo_upscaled);
-        break;
-    case 4:     //< G
-        computeHisto<&pix_green::val>(request, upscale, &histo_upscaled);
-        break;
-    case 5:     //< B
-        computeHisto<&pix_blue::val>(request, upscale, &histo_upscaled);
-        break;
+    computeHisto(request, values, upscale, &histo_upscaled);
 
-    default:
-        assert(false);
-        break;
-    }
     double sigma = upscale;
     if (request.smoothingKernelSize > 1) {
         sigma *= request.smoothingKernelSize;
@@ -419,24 +339,50 @@ HistogramCPU::run()
         ret->mipMapLevel = request.image->getMipMapLevel();
 
 
+        /// keep the mode parameter in sync with Histogram::DisplayModeEnum
+        std::vector<int> channels;
         switch (request.mode) {
         case 0:     //< RGB
-            computeHistogramStatic(request, ret, 1);
-            computeHistogramStatic(request, ret, 2);
-            computeHistogramStatic(request, ret, 3);
+        case 2:     //< Y
+            channels.push_back(0);
+            channels.push_back(1);
+            channels.push_back(2);
+            break;
+        case 1:     //< A
+            channels.push_back(3);
             break;
-        case 1:
-        case 2:
-        case 3:
-        case 4:
-        case 5:
-            computeHistogramStatic(request, ret, 1);
+        case 3:     //< R
+        case 4:     //< G
+        case 5:     //< B
+            channels.push_back(request.mode - 3);
             break;
         default:
             assert(false);     //< unknown case.
             break;
         }
+        if ( !channels.empty() ) {
+            ///Images come from the viewer which is in float.
+            assert(request.image->getBitDepth() == eImageBitDepthFloat);
+
+            ///Each histogram scans a single channel, so read them from planes rather than from the interleaved pixels
+            std::vector<std::vector<float> > planes;
+            request.image->copyChannelsToPlanar(request.rect, channels, &planes);
+
+            if (request.mode == 2) {
+                std::vector<float>& lum = planes[0];
+                const std::vector<float>& g = planes[1];
+                const std::vector<float>& b = planes[2];
+                for (std::size_t i = 0; i < lum.size(); ++i) {
+                    lum[i] = 0.299 * lum[i] + 0.587 * g[i] + 0.114 * b[i];
+                }
+            }
 
+            computeHistogramStatic(request, planes[0], ret, 1);
+            if (request.mode == 0) {
+                computeHistogramStatic(request, planes[1], ret, 2);
+                computeHistogramStatic(request, planes[2], ret, 3);
+            }
+        }
 
         {
             QMutexLocker l(&_imp->producedMutex);
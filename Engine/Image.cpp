@@ -29,13 +29,21 @@
 #include <cstring> // for std::memcpy, std::memset
 #include <stdexcept>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
+#include <boost/bind.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #endif
 
 #include <QtCore/QDebug>
+#include <QtCore/QThreadPool>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/AppManager.h"
 #include "Engine/ViewIdx.h"
@@ -49,6 +57,9 @@ NATRON_NAMESPACE_ENTER
 
 #define PIXEL_UNAVAILABLE 2
 
+///The minimum number of pixels processed by a task when an image operation is split over the global thread pool.
+#define NATRON_IMAGE_MIN_PIXELS_PER_BAND 16384
+
 template <int trimap>
 RectI
 minimalNonMarkedBbox_internal(const RectI& roi,
@@ -621,7 +632,7 @@ Image::printUnrenderedPixels(const RectI& roi) const
     if (!_useBitmap) {
         return;
     }
-    QReadLocker k(&_entryLock);
+    QReadLocker k( &getEntryLock() );
     const char* bm = _bitmap.getBitmapAt(roi.x1, roi.y1);
     int roiw = roi.x2 - roi.x1;
     int boundsW = _bitmap.getBounds().width();
@@ -771,8 +782,43 @@ Image::Image(const ImagePlaneDesc& components,
     allocateMemory();
 }
 
+Image::Image(const ImagePtr& viewedImage,
+             const ImagePlaneDesc& components,
+             ImagePremultiplicationEnum premult)
+    : CacheEntryHelper<unsigned char, ImageKey, ImageParams>()
+    , _useBitmap(false)
+    , _viewedImage(viewedImage->_viewedImage ? viewedImage->_viewedImage : viewedImage) // a view of a view is a view of the same image
+{
+    assert( _viewedImage->getStorageMode() != eStorageModeGLTex );
+    assert( (int)components.getNumComponents() == _viewedImage->_nbComponents );
+
+    QReadLocker k( &_viewedImage->getEntryLock() );
+    ImageParamsPtr params = boost::make_shared<ImageParams>( *_viewedImage->getParams() );
+    params->setComponents(components);
+    params->setPremultiplication(premult);
+    params->getStorageInfo().mode = eStorageModeRAM;
+    setCacheEntry(_viewedImage->getKey(), params, NULL /*cacheAPI*/);
+
+    _bitDepth = _viewedImage->_bitDepth;
+    _depthBytesSize = _viewedImage->_depthBytesSize;
+    _nbComponents = _viewedImage->_nbComponents;
+    _rod = _viewedImage->_rod;
+    _bounds = _viewedImage->_bounds;
+    _par = _viewedImage->_par;
+    _premult = premult;
+    _fielding = _viewedImage->_fielding;
+
+    // No memory is allocated: pixelAt() reads the buffer of the viewed image
+    QMutexLocker l(&_viewedImage->_viewsMutex);
+    _viewedImage->_views.push_back(this);
+}
+
 Image::~Image()
 {
+    if (_viewedImage) {
+        QMutexLocker l(&_viewedImage->_viewsMutex);
+        _viewedImage->_views.remove(this);
+    }
     deallocate();
 }
 
@@ -798,7 +844,7 @@ Image::onMemoryAllocated(bool diskRestoration)
 void
 Image::setBitmapDirtyZone(const RectI& zone)
 {
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
 
     _bitmap.setDirtyZone(zone);
 }
@@ -916,13 +962,13 @@ Image::pasteFromForDepth(const Image & srcImg,
     ///Cannot copy images with different bit depth, this is not the purpose of this function.
     ///@see convert
     assert( getBitDepth() == srcImg.getBitDepth() );
-    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthHalf && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
     // NOTE: before removing the following asserts, please explain why an empty image may happen
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     boost::scoped_ptr<QReadLocker> k2;
     if (takeSrcLock && &srcImg != this) {
-        k2.reset( new QReadLocker(&srcImg._entryLock) );
+        k2.reset( new QReadLocker( &srcImg.getEntryLock() ) );
     }
 
     const RectI & bounds = _bounds;
@@ -969,7 +1015,7 @@ Image::pasteFromForDepth(const Image & srcImg,
 void
 Image::setRoD(const RectD& rod)
 {
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
 
     _rod = rod;
     _params->setRoD(rod);
@@ -1110,7 +1156,7 @@ Image::resizeInternal(const Image* srcImg,
         (*outputImage)->pasteFromForDepth<unsigned short>(*srcImg, srcBounds, srcImg->usesBitMap(), false);
         break;
     case eImageBitDepthHalf:
-        assert(false);
+        (*outputImage)->pasteFromForDepth<Half>(*srcImg, srcBounds, srcImg->usesBitMap(), false);
         break;
     case eImageBitDepthFloat:
         (*outputImage)->pasteFromForDepth<float>(*srcImg, srcBounds, srcImg->usesBitMap(), false);
@@ -1132,7 +1178,7 @@ Image::copyAndResizeIfNeeded(const RectI& newBounds,
     }
     assert(output);
 
-    QReadLocker k(&_entryLock);
+    QReadLocker k( &getEntryLock() );
     RectI merge = newBounds;
     merge.merge(_bounds);
 
@@ -1148,11 +1194,13 @@ Image::ensureBounds(const RectI& newBounds,
 {
     // OpenGL textures are not resizable yet
     assert(_params->getStorageInfo().mode != eStorageModeGLTex);
+    // Views do not own their buffer, they are resized with the viewed image
+    assert(!_viewedImage);
     if ( getBounds().contains(newBounds) ) {
         return false;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     RectI merge = newBounds;
     merge.merge(_bounds);
 
@@ -1169,6 +1217,15 @@ Image::ensureBounds(const RectI& newBounds,
         _bitmap.swap(tmpImg->_bitmap);
     }
 
+    ///The views share our lock, so no one is reading their bounds
+    {
+        QMutexLocker l(&_viewsMutex);
+        for (std::list<Image*>::iterator it = _views.begin(); it != _views.end(); ++it) {
+            (*it)->_bounds = merge;
+            (*it)->_params->setBounds(merge);
+        }
+    }
+
     return true;
 }
 
@@ -1391,7 +1448,7 @@ Image::pasteFrom(const Image & src,
             pasteFromForDepth<unsigned short>(src, srcRoi, copyBitmap, true);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            pasteFromForDepth<Half>(src, srcRoi, copyBitmap, true);
             break;
         case eImageBitDepthFloat:
             pasteFromForDepth<float>(src, srcRoi, copyBitmap, true);
@@ -1410,7 +1467,7 @@ Image::fillForDepthForComponents(const RectI & roi_,
                                  float b,
                                  float a)
 {
-    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthHalf && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
 
     RectI roi = roi_;
     bool doInteresect = roi.intersect(_bounds, &roi);
@@ -1476,7 +1533,7 @@ Image::fill(const RectI & roi,
             float a,
             const OSGLContextPtr& glContext)
 {
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
 
     if (getStorageMode() == eStorageModeGLTex) {
         RectI realRoI = roi;
@@ -1527,7 +1584,7 @@ Image::fill(const RectI & roi,
         fillForDepth<unsigned short, 65535>(roi, r, g, b, a);
         break;
     case eImageBitDepthHalf:
-        assert(false);
+        fillForDepth<Half, 1>(roi, r, g, b, a);
         break;
     case eImageBitDepthFloat:
         fillForDepth<float, 1>(roi, r, g, b, a);
@@ -1547,7 +1604,7 @@ Image::fillZero(const RectI& roi,
         return;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     RectI intersection;
 
     if ( !roi.intersect(_bounds, &intersection) ) {
@@ -1564,7 +1621,7 @@ Image::fillZero(const RectI& roi,
         rowSize *= sizeof(unsigned short);
         break;
     case eImageBitDepthHalf:
-        rowSize *= sizeof(unsigned short);
+        rowSize *= sizeof(Half);
         break;
     case eImageBitDepthFloat:
         rowSize *= sizeof(float);
@@ -1593,7 +1650,7 @@ Image::fillBoundsZero(const OSGLContextPtr& glContext)
         return;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     std::size_t rowSize =  (std::size_t)_nbComponents;
 
     switch ( getBitDepth() ) {
@@ -1604,7 +1661,7 @@ Image::fillBoundsZero(const OSGLContextPtr& glContext)
         rowSize *= sizeof(unsigned short);
         break;
     case eImageBitDepthHalf:
-        rowSize *= sizeof(unsigned short);
+        rowSize *= sizeof(Half);
         break;
     case eImageBitDepthFloat:
         rowSize *= sizeof(float);
@@ -1623,6 +1680,9 @@ unsigned char*
 Image::pixelAt(int x,
                int y)
 {
+    if (_viewedImage) {
+        return _viewedImage->pixelAt(x, y);
+    }
     if ( ( x < _bounds.x1 ) || ( x >= _bounds.x2 ) || ( y < _bounds.y1 ) || ( y >= _bounds.y2 ) ) {
         return NULL;
     } else {
@@ -1638,6 +1698,43 @@ Image::pixelAt(int x,
     }
 }
 
+const unsigned char*
+Image::rowPortionAt(int y,
+                    int* x1,
+                    int* x2) const
+{
+    if ( (y < _bounds.y1) || (y >= _bounds.y2) ) {
+        return NULL;
+    }
+    *x1 = std::max(*x1, _bounds.x1);
+    *x2 = std::min(*x2, _bounds.x2);
+    if (*x1 >= *x2) {
+        return NULL;
+    }
+
+    return pixelAt(*x1, y);
+}
+
+void
+Image::getRowBands(const RectI& roi,
+                   std::vector<RectI>* bands)
+{
+    int nBands = std::min( roi.height(), (int)(roi.area() / NATRON_IMAGE_MIN_PIXELS_PER_BAND) );
+
+    nBands = std::min(nBands, QThreadPool::globalInstance()->maxThreadCount() * 4);
+    if (nBands <= 1) {
+        bands->push_back(roi);
+
+        return;
+    }
+    for (int i = 0; i < nBands; ++i) {
+        RectI band = roi;
+        band.y1 = roi.y1 + (int)( (qint64)roi.height() * i / nBands );
+        band.y2 = roi.y1 + (int)( (qint64)roi.height() * (i + 1) / nBands );
+        bands->push_back(band);
+    }
+}
+
 unsigned char*
 Image::pixelAtStatic(int x,
                      int y,
@@ -1665,6 +1762,9 @@ const unsigned char*
 Image::pixelAt(int x,
                int y) const
 {
+    if (_viewedImage) {
+        return _viewedImage->pixelAt(x, y);
+    }
     if ( ( x < _bounds.x1 ) || ( x >= _bounds.x2 ) || ( y < _bounds.y1 ) || ( y >= _bounds.y2 ) ) {
         return NULL;
     } else {
@@ -1802,166 +1902,441 @@ Image::getPremultiplication() const
 unsigned int
 Image::getRowElements() const
 {
-    QReadLocker k(&_entryLock);
+    QReadLocker k( &getEntryLock() );
 
     return getComponentsCount() * _bounds.width();
 }
 
+namespace {
+/*
+   The mipmap levels are built by halving: each pixel of a level is the average of the (up to) 4 pixels it covers
+   in the previous level. See halvePyramidForDepth().
+ */
+
+///Where the rows of one halving are read and written. The pointers are offset so that they correspond to pixel (0,0).
+struct MipMapHalving
+{
+    const void* srcData;
+    void* dstData;
+    const char* srcBmData;
+    char* dstBmData;
+    int srcRowSize;
+    int dstRowSize;
+    int srcBmRowSize;
+    int dstBmRowSize;
+    RectI srcBounds;
+    RectI dstRoI;
+};
+
+///A band of rows built by one task: the rows y of level i with bandStart <= floor(y / 2^(nLevels - i)) < bandEnd.
+struct MipMapBand
+{
+    int bandStart;
+    int bandEnd;
+};
+
+inline int
+floorDiv(int a,
+         int b)
+{
+    return (a >= 0) ? (a / b) : -( (-a + b - 1) / b );
+}
+
 // code proofread and fixed by @devernay on 4/12/2014
-template <typename PIX, int maxValue>
+template <typename PIX>
 void
-Image::halveRoIForDepth(const RectI & roi,
-                        bool copyBitMap,
-                        Image* output) const
+halvePixelForDepth(const PIX* srcPixStart,
+                   PIX* dstPixStart,
+                   int nComps,
+                   int srcRowSize,
+                   bool pickThisRow,
+                   bool pickNextRow,
+                   bool pickThisCol,
+                   bool pickNextCol)
+{
+    int sumW = (int)pickThisCol + (int)pickNextCol;
+    int sumH = (int)pickNextRow + (int)pickThisRow;
+
+    assert(sumW == 1 || sumW == 2);
+    assert(sumH == 1 || sumH == 2);
+    const int sum = sumW * sumH;
+    assert(0 < sum && sum <= 4);
+
+    if (sum == 0) { // never happens
+        for (int k = 0; k < nComps; ++k) {
+            dstPixStart[k] = 0;
+        }
+
+        return;
+    }
+
+    for (int k = 0; k < nComps; ++k) {
+        ///a b
+        ///c d
+
+        const PIX a = (pickThisCol && pickThisRow) ? *(srcPixStart + k) : PIX(0);
+        const PIX b = (pickNextCol && pickThisRow) ? *(srcPixStart + k + nComps) : PIX(0);
+        const PIX c = (pickThisCol && pickNextRow) ? *(srcPixStart + k + srcRowSize) : PIX(0);
+        const PIX d = (pickNextCol && pickNextRow) ? *(srcPixStart + k + srcRowSize  + nComps)  : PIX(0);
+
+        assert( sumW == 2 || ( sumW == 1 && ( (a == 0 && c == 0) || (b == 0 && d == 0) ) ) );
+        assert( sumH == 2 || ( sumH == 1 && ( (a == 0 && b == 0) || (c == 0 && d == 0) ) ) );
+        dstPixStart[k] = (a + b + c + d) / sum;
+    }
+}
+
+void
+halveBitmapPixel(const char* srcBmPixStart,
+                 char* dstBmPixStart,
+                 int srcBmRowSize,
+                 bool pickThisRow,
+                 bool pickNextRow,
+                 bool pickThisCol,
+                 bool pickNextCol)
 {
-    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) ||
-            (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) ||
-            (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    int sumW = (int)pickThisCol + (int)pickNextCol;
+    int sumH = (int)pickNextRow + (int)pickThisRow;
+    const int sum = sumW * sumH;
 
-    ///handle case where there is only 1 column/row
-    if ( (roi.width() == 1) || (roi.height() == 1) ) {
-        assert( !(roi.width() == 1 && roi.height() == 1) ); /// can't be 1x1
-        halve1DImage(roi, output);
+    if (sum == 0) { // never happens
+        dstBmPixStart[0] = 0;
 
         return;
     }
 
-    /// Take the lock for both bitmaps since we're about to read/write from them!
-    QWriteLocker k1(&output->_entryLock);
-    QReadLocker k2(&_entryLock);
+    ///a b
+    ///c d
 
-    ///The source rectangle, intersected to this image region of definition in pixels
-    const RectI &srcBounds = _bounds;
-    const RectI &dstBounds = output->_bounds;
-    const RectI &srcBmBounds = _bitmap.getBounds();
-    const RectI &dstBmBounds = output->_bitmap.getBounds();
-    assert( !copyBitMap || usesBitMap() );
-    assert( !usesBitMap() || (srcBmBounds == srcBounds && dstBmBounds == dstBounds) );
-
-    // the srcRoD of the output should be enclosed in half the roi.
-    // It does not have to be exactly half of the input.
-    //    assert(dstRoD.x1*2 >= roi.x1 &&
-    //           dstRoD.x2*2 <= roi.x2 &&
-    //           dstRoD.y1*2 >= roi.y1 &&
-    //           dstRoD.y2*2 <= roi.y2 &&
-    //           dstRoD.width()*2 <= roi.width() &&
-    //           dstRoD.height()*2 <= roi.height());
-    assert( getComponents() == output->getComponents() );
+    char a = (pickThisCol && pickThisRow) ? *(srcBmPixStart) : 0;
+    char b = (pickNextCol && pickThisRow) ? *(srcBmPixStart + 1) : 0;
+    char c = (pickThisCol && pickNextRow) ? *(srcBmPixStart + srcBmRowSize) : 0;
+    char d = (pickNextCol && pickNextRow) ? *(srcBmPixStart + srcBmRowSize  + 1)  : 0;
+#if NATRON_ENABLE_TRIMAP
+    /*
+       The only correct solution is to convert pixels being rendered to 0 otherwise the caller
+       would have to wait for the original fullscale image render to be finished and then re-downscale again.
+     */
+    if (a == PIXEL_UNAVAILABLE) {
+        a = 0;
+    }
+    if (b == PIXEL_UNAVAILABLE) {
+        b = 0;
+    }
+    if (c == PIXEL_UNAVAILABLE) {
+        c = 0;
+    }
+    if (d == PIXEL_UNAVAILABLE) {
+        d = 0;
+    }
+#endif
+    assert( sumW == 2 || ( sumW == 1 && ( (a == 0 && c == 0) || (b == 0 && d == 0) ) ) );
+    assert( sumH == 2 || ( sumH == 1 && ( (a == 0 && b == 0) || (c == 0 && d == 0) ) ) );
+    assert(a + b + c + d <= sum); // bitmaps are 0 or 1
+    // the following is an integer division, the result can be 0 or 1
+    dstBmPixStart[0] = (a + b + c + d) / sum;
+    assert(dstBmPixStart[0] == 0 || dstBmPixStart[0] == 1);
+}
 
-    RectI dstRoI;
-    RectI srcRoI = roi;
-    srcRoI.intersect(srcBounds, &srcRoI); // intersect srcRoI with the region of definition
-
-    dstRoI.x1 = (srcRoI.x1 + 1) / 2; // equivalent to ceil(srcRoI.x1/2.0)
-    dstRoI.y1 = (srcRoI.y1 + 1) / 2; // equivalent to ceil(srcRoI.y1/2.0)
-    dstRoI.x2 = srcRoI.x2 / 2; // equivalent to floor(srcRoI.x2/2.0)
-    dstRoI.y2 = srcRoI.y2 / 2; // equivalent to floor(srcRoI.y2/2.0)
-
-
-    const PIX* const srcPixels      = (const PIX*)pixelAt(srcBounds.x1,   srcBounds.y1);
-    const char* const srcBmPixels   = _bitmap.getBitmapAt(srcBmBounds.x1, srcBmBounds.y1);
-    PIX* const dstPixels          = (PIX*)output->pixelAt(dstBounds.x1,   dstBounds.y1);
-    char* const dstBmPixels = output->_bitmap.getBitmapAt(dstBmBounds.x1, dstBmBounds.y1);
-    int srcRowSize = srcBounds.width() * _nbComponents;
-    int dstRowSize = dstBounds.width() * _nbComponents;
-
-    // offset pointers so that srcData and dstData correspond to pixel (0,0)
-    const PIX* const srcData = srcPixels - (srcBounds.x1 * _nbComponents + srcRowSize * srcBounds.y1);
-    PIX* const dstData       = dstPixels - (dstBounds.x1 * _nbComponents + dstRowSize * dstBounds.y1);
-    const int srcBmRowSize = srcBmBounds.width();
-    const int dstBmRowSize = dstBmBounds.width();
-    const char* const srcBmData = srcBmPixels - (srcBmBounds.x1 + srcBmRowSize * srcBmBounds.y1);
-    char* const dstBmData       = dstBmPixels - (dstBmBounds.x1 + dstBmRowSize * dstBmBounds.y1);
-
-    for (int y = dstRoI.y1; y < dstRoI.y2; ++y) {
-        const PIX* const srcLineStart    = srcData + y * 2 * srcRowSize;
-        PIX* const dstLineStart          = dstData + y     * dstRowSize;
-        const char* const srcBmLineStart = srcBmData + y * 2 * srcBmRowSize;
-        char* const dstBmLineStart       = dstBmData + y     * dstBmRowSize;
+/**
+ * @brief Halves the pixels [x1, x2) of a row whose 4 source pixels are all inside the source bounds.
+ * This is halvePixelForDepth with sum == 4, without the branches, so that the compiler can vectorize it.
+ * The sums are done in the same order so that the result is the same.
+ **/
+template <typename PIX>
+void
+halveInteriorPixelsForDepth(const PIX* srcLineStart,
+                            PIX* dstLineStart,
+                            int nComps,
+                            int srcRowSize,
+                            int x1,
+                            int x2)
+{
+    for (int x = x1; x < x2; ++x) {
+        const PIX* const srcPixStart = srcLineStart + x * 2 * nComps;
+        PIX* const dstPixStart = dstLineStart + x * nComps;
+        for (int k = 0; k < nComps; ++k) {
+            const PIX a = srcPixStart[k];
+            const PIX b = srcPixStart[k + nComps];
+            const PIX c = srcPixStart[k + srcRowSize];
+            const PIX d = srcPixStart[k + srcRowSize + nComps];
+            dstPixStart[k] = (a + b + c + d) / 4;
+        }
+    }
+}
+
+template <typename PIX>
+void
+halveInteriorRowForDepth(const PIX* srcLineStart,
+                         PIX* dstLineStart,
+                         int nComps,
+                         int srcRowSize,
+                         int x1,
+                         int x2)
+{
+    halveInteriorPixelsForDepth<PIX>(srcLineStart, dstLineStart, nComps, srcRowSize, x1, x2);
+}
+
+#ifdef __SSE2__
+// Multiplying by 0.25 is exact, like dividing by 4, so this gives the same result as the generic version.
+template <>
+void
+halveInteriorRowForDepth<float>(const float* srcLineStart,
+                                float* dstLineStart,
+                                int nComps,
+                                int srcRowSize,
+                                int x1,
+                                int x2)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    int x = x1;
+
+    if (nComps == 4) {
+        // one pixel per vector
+        for (; x < x2; ++x) {
+            const float* const src = srcLineStart + x * 8;
+            __m128 a = _mm_loadu_ps(src);
+            __m128 b = _mm_loadu_ps(src + 4);
+            __m128 c = _mm_loadu_ps(src + srcRowSize);
+            __m128 d = _mm_loadu_ps(src + srcRowSize + 4);
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(a, b), c), d);
+            _mm_storeu_ps( dstLineStart + x * 4, _mm_mul_ps(sum, quarter) );
+        }
+    } else if (nComps == 1) {
+        // 4 pixels per vector: split the even and odd columns of the 8 source pixels
+        for (; x + 4 <= x2; x += 4) {
+            const float* const src = srcLineStart + x * 2;
+            __m128 thisRow0 = _mm_loadu_ps(src);
+            __m128 thisRow1 = _mm_loadu_ps(src + 4);
+            __m128 nextRow0 = _mm_loadu_ps(src + srcRowSize);
+            __m128 nextRow1 = _mm_loadu_ps(src + srcRowSize + 4);
+            __m128 a = _mm_shuffle_ps( thisRow0, thisRow1, _MM_SHUFFLE(2, 0, 2, 0) );
+            __m128 b = _mm_shuffle_ps( thisRow0, thisRow1, _MM_SHUFFLE(3, 1, 3, 1) );
+            __m128 c = _mm_shuffle_ps( nextRow0, nextRow1, _MM_SHUFFLE(2, 0, 2, 0) );
+            __m128 d = _mm_shuffle_ps( nextRow0, nextRow1, _MM_SHUFFLE(3, 1, 3, 1) );
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(a, b), c), d);
+            _mm_storeu_ps( dstLineStart + x, _mm_mul_ps(sum, quarter) );
+        }
+    }
+    halveInteriorPixelsForDepth<float>(srcLineStart, dstLineStart, nComps, srcRowSize, x, x2);
+}
+
+#endif // __SSE2__
+
+///Halves the rows [y1, y2) of h.dstRoI
+template <typename PIX>
+void
+halveRowsForDepth(const MipMapHalving& h,
+                  int nComps,
+                  bool copyBitMap,
+                  int y1,
+                  int y2)
+{
+    const PIX* const srcData = (const PIX*)h.srcData;
+    PIX* const dstData = (PIX*)h.dstData;
+    const RectI & srcBounds = h.srcBounds;
+    const RectI & dstRoI = h.dstRoI;
+
+    // The dst columns whose 2 src columns are both within srcBounds: srcBounds.x1 <= x*2 and x*2+1 < srcBounds.x2
+    int interiorX1 = std::min( std::max(dstRoI.x1, floorDiv(srcBounds.x1 + 1, 2)), dstRoI.x2 );
+    int interiorX2 = std::max( std::min(dstRoI.x2, floorDiv(srcBounds.x2, 2)), interiorX1 );
+
+    for (int y = std::max(y1, dstRoI.y1); y < std::min(y2, dstRoI.y2); ++y) {
+        const PIX* const srcLineStart    = srcData + y * 2 * h.srcRowSize;
+        PIX* const dstLineStart          = dstData + y     * h.dstRowSize;
+        const char* const srcBmLineStart = h.srcBmData + y * 2 * h.srcBmRowSize;
+        char* const dstBmLineStart       = h.dstBmData + y     * h.dstBmRowSize;
 
         // The current dst row, at y, covers the src rows y*2 (thisRow) and y*2+1 (nextRow).
         // Check that if are within srcBounds.
         int srcy = y * 2;
         bool pickThisRow = srcBounds.y1 <= (srcy + 0) && (srcy + 0) < srcBounds.y2;
         bool pickNextRow = srcBounds.y1 <= (srcy + 1) && (srcy + 1) < srcBounds.y2;
-        int sumH = (int)pickNextRow + (int)pickThisRow;
-        assert(sumH == 1 || sumH == 2);
+        bool interiorRow = pickThisRow && pickNextRow;
 
         for (int x = dstRoI.x1; x < dstRoI.x2; ++x) {
-            const PIX* const srcPixStart    = srcLineStart   + x * 2 * _nbComponents;
-            const char* const srcBmPixStart = srcBmLineStart + x * 2;
-            PIX* const dstPixStart          = dstLineStart   + x * _nbComponents;
-            char* const dstBmPixStart       = dstBmLineStart + x;
+            if ( interiorRow && (x == interiorX1) && (interiorX1 < interiorX2) ) {
+                halveInteriorRowForDepth<PIX>(srcLineStart, dstLineStart, nComps, h.srcRowSize, interiorX1, interiorX2);
+                if (copyBitMap) {
+                    for (int bx = interiorX1; bx < interiorX2; ++bx) {
+                        halveBitmapPixel(srcBmLineStart + bx * 2, dstBmLineStart + bx, h.srcBmRowSize, true, true, true, true);
+                    }
+                }
+                x = interiorX2 - 1;
+                continue;
+            }
 
             // The current dst col, at y, covers the src cols x*2 (thisCol) and x*2+1 (nextCol).
             // Check that if are within srcBounds.
             int srcx = x * 2;
             bool pickThisCol = srcBounds.x1 <= (srcx + 0) && (srcx + 0) < srcBounds.x2;
             bool pickNextCol = srcBounds.x1 <= (srcx + 1) && (srcx + 1) < srcBounds.x2;
-            int sumW = (int)pickThisCol + (int)pickNextCol;
-            assert(sumW == 1 || sumW == 2);
-            const int sum = sumW * sumH;
-            assert(0 < sum && sum <= 4);
-
-            if (sum == 0) { // never happens
-                for (int k = 0; k < _nbComponents; ++k) {
-                    dstPixStart[k] = 0;
-                }
-                if (copyBitMap) {
-                    dstBmPixStart[0] = 0;
-                }
-                continue;
+            halvePixelForDepth<PIX>(srcLineStart + x * 2 * nComps, dstLineStart + x * nComps, nComps, h.srcRowSize,
+                                    pickThisRow, pickNextRow, pickThisCol, pickNextCol);
+            if (copyBitMap) {
+                halveBitmapPixel(srcBmLineStart + x * 2, dstBmLineStart + x, h.srcBmRowSize,
+                                 pickThisRow, pickNextRow, pickThisCol, pickNextCol);
             }
+        }
+    }
+} // halveRowsForDepth
 
-            for (int k = 0; k < _nbComponents; ++k) {
-                ///a b
-                ///c d
-
-                const PIX a = (pickThisCol && pickThisRow) ? *(srcPixStart + k) : 0;
-                const PIX b = (pickNextCol && pickThisRow) ? *(srcPixStart + k + _nbComponents) : 0;
-                const PIX c = (pickThisCol && pickNextRow) ? *(srcPixStart + k + srcRowSize) : 0;
-                const PIX d = (pickNextCol && pickNextRow) ? *(srcPixStart + k + srcRowSize  + _nbComponents)  : 0;
+///Builds all the levels of a band, from the first to the last: each level only reads the rows of the band in the previous one.
+template <typename PIX>
+void
+halveBandForDepth(const std::vector<MipMapHalving>& halvings,
+                  int nComps,
+                  bool copyBitMap,
+                  const MipMapBand& band)
+{
+    int nLevels = (int)halvings.size();
 
-                assert( sumW == 2 || ( sumW == 1 && ( (a == 0 && c == 0) || (b == 0 && d == 0) ) ) );
-                assert( sumH == 2 || ( sumH == 1 && ( (a == 0 && b == 0) || (c == 0 && d == 0) ) ) );
-                dstPixStart[k] = (a + b + c + d) / sum;
-            }
+    for (int i = 0; i < nLevels; ++i) {
+        int rowsPerBand = 1 << (nLevels - 1 - i);
+        halveRowsForDepth<PIX>(halvings[i], nComps, copyBitMap, band.bandStart * rowsPerBand, band.bandEnd * rowsPerBand);
+    }
+}
+} // anon namespace
 
-            if (copyBitMap) {
-                ///a b
-                ///c d
+template <typename PIX>
+void
+Image::halvePyramidForDepth(const std::vector<RectI>& rois,
+                            bool copyBitMap,
+                            const std::vector<Image*>& levels) const
+{
+    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) ||
+            (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) ||
+            (getBitDepth() == eImageBitDepthHalf && sizeof(PIX) == 2) ||
+            (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    assert( !rois.empty() && rois.size() == levels.size() );
+    assert( !copyBitMap || usesBitMap() );
 
-                char a = (pickThisCol && pickThisRow) ? *(srcBmPixStart) : 0;
-                char b = (pickNextCol && pickThisRow) ? *(srcBmPixStart + 1) : 0;
-                char c = (pickThisCol && pickNextRow) ? *(srcBmPixStart + srcBmRowSize) : 0;
-                char d = (pickNextCol && pickNextRow) ? *(srcBmPixStart + srcBmRowSize  + 1)  : 0;
-#if NATRON_ENABLE_TRIMAP
-                /*
-                   The only correct solution is to convert pixels being rendered to 0 otherwise the caller
-                   would have to wait for the original fullscale image render to be finished and then re-downscale again.
-                 */
-                if (a == PIXEL_UNAVAILABLE) {
-                    a = 0;
-                }
-                if (b == PIXEL_UNAVAILABLE) {
-                    b = 0;
-                }
-                if (c == PIXEL_UNAVAILABLE) {
-                    c = 0;
-                }
-                if (d == PIXEL_UNAVAILABLE) {
-                    d = 0;
-                }
-#endif
-                assert( sumW == 2 || ( sumW == 1 && ( (a == 0 && c == 0) || (b == 0 && d == 0) ) ) );
-                assert( sumH == 2 || ( sumH == 1 && ( (a == 0 && b == 0) || (c == 0 && d == 0) ) ) );
-                assert(a + b + c + d <= sum); // bitmaps are 0 or 1
-                // the following is an integer division, the result can be 0 or 1
-                dstBmPixStart[0] = (a + b + c + d) / sum;
-                assert(dstBmPixStart[0] == 0 || dstBmPixStart[0] == 1);
+    int nLevels = (int)levels.size();
+    std::vector<MipMapHalving> halvings(nLevels);
+    // The range of bands covering the rows to build in all levels
+    int firstBand = 0, lastBand = 0;
+
+    for (int i = 0; i < nLevels; ++i) {
+        const Image* srcImg = (i == 0) ? this : levels[i - 1];
+        Image* output = levels[i];
+        MipMapHalving& h = halvings[i];
+
+        ///The source rectangle, intersected to this image region of definition in pixels
+        const RectI &srcBounds = srcImg->_bounds;
+        const RectI &dstBounds = output->_bounds;
+        const RectI &srcBmBounds = srcImg->_bitmap.getBounds();
+        const RectI &dstBmBounds = output->_bitmap.getBounds();
+        assert( !srcImg->usesBitMap() || (srcBmBounds == srcBounds && dstBmBounds == dstBounds) );
+
+        // the srcRoD of the output should be enclosed in half the roi.
+        // It does not have to be exactly half of the input.
+        assert( srcImg->getComponents() == output->getComponents() );
+
+        RectI srcRoI = rois[i];
+        srcRoI.intersect(srcBounds, &srcRoI); // intersect srcRoI with the region of definition
+
+        h.dstRoI.x1 = (srcRoI.x1 + 1) / 2; // equivalent to ceil(srcRoI.x1/2.0)
+        h.dstRoI.y1 = (srcRoI.y1 + 1) / 2; // equivalent to ceil(srcRoI.y1/2.0)
+        h.dstRoI.x2 = srcRoI.x2 / 2; // equivalent to floor(srcRoI.x2/2.0)
+        h.dstRoI.y2 = srcRoI.y2 / 2; // equivalent to floor(srcRoI.y2/2.0)
+        h.srcBounds = srcBounds;
+
+        const PIX* const srcPixels      = (const PIX*)srcImg->pixelAt(srcBounds.x1,   srcBounds.y1);
+        const char* const srcBmPixels   = srcImg->_bitmap.getBitmapAt(srcBmBounds.x1, srcBmBounds.y1);
+        PIX* const dstPixels          = (PIX*)output->pixelAt(dstBounds.x1,   dstBounds.y1);
+        char* const dstBmPixels = output->_bitmap.getBitmapAt(dstBmBounds.x1, dstBmBounds.y1);
+        h.srcRowSize = srcBounds.width() * _nbComponents;
+        h.dstRowSize = dstBounds.width() * _nbComponents;
+        h.srcBmRowSize = srcBmBounds.width();
+        h.dstBmRowSize = dstBmBounds.width();
+
+        // offset pointers so that srcData and dstData correspond to pixel (0,0)
+        h.srcData = srcPixels - (srcBounds.x1 * _nbComponents + h.srcRowSize * srcBounds.y1);
+        h.dstData = dstPixels - (dstBounds.x1 * _nbComponents + h.dstRowSize * dstBounds.y1);
+        h.srcBmData = srcBmPixels - (srcBmBounds.x1 + h.srcBmRowSize * srcBmBounds.y1);
+        h.dstBmData = dstBmPixels - (dstBmBounds.x1 + h.dstBmRowSize * dstBmBounds.y1);
+
+        if ( !h.dstRoI.isNull() ) {
+            int rowsPerBand = 1 << (nLevels - 1 - i);
+            int levelFirstBand = floorDiv(h.dstRoI.y1, rowsPerBand);
+            int levelLastBand = floorDiv(h.dstRoI.y2 - 1, rowsPerBand) + 1;
+            if (firstBand == lastBand) {
+                firstBand = levelFirstBand;
+                lastBand = levelLastBand;
+            } else {
+                firstBand = std::min(firstBand, levelFirstBand);
+                lastBand = std::max(lastBand, levelLastBand);
             }
         }
     }
+
+    if (firstBand == lastBand) {
+        return;
+    }
+
+    // Split the bands in tasks so that each thread of the pool gets a few of them, unless the image is small
+    int nBands = lastBand - firstBand;
+    int nTasks = std::min( nBands, (int)(halvings[0].dstRoI.area() / NATRON_IMAGE_MIN_PIXELS_PER_BAND) );
+    nTasks = std::min(nTasks, QThreadPool::globalInstance()->maxThreadCount() * 4);
+    if (nTasks <= 1) {
+        MipMapBand band;
+        band.bandStart = firstBand;
+        band.bandEnd = lastBand;
+        halveBandForDepth<PIX>(halvings, _nbComponents, copyBitMap, band);
+
+        return;
+    }
+
+    std::vector<MipMapBand> bands(nTasks);
+    for (int t = 0; t < nTasks; ++t) {
+        bands[t].bandStart = firstBand + (int)( (qint64)nBands * t / nTasks );
+        bands[t].bandEnd = firstBand + (int)( (qint64)nBands * (t + 1) / nTasks );
+    }
+    QtConcurrent::blockingMap( bands, boost::bind(&halveBandForDepth<PIX>, boost::cref(halvings), _nbComponents, copyBitMap, _1) );
+} // halvePyramidForDepth
+
+void
+Image::halvePyramid(const std::vector<RectI>& rois,
+                    bool copyBitMap,
+                    const std::vector<Image*>& levels) const
+{
+    switch ( getBitDepth() ) {
+    case eImageBitDepthByte:
+        halvePyramidForDepth<unsigned char>(rois, copyBitMap, levels);
+        break;
+    case eImageBitDepthShort:
+        halvePyramidForDepth<unsigned short>(rois, copyBitMap, levels);
+        break;
+    case eImageBitDepthHalf:
+        halvePyramidForDepth<Half>(rois, copyBitMap, levels);
+        break;
+    case eImageBitDepthFloat:
+        halvePyramidForDepth<float>(rois, copyBitMap, levels);
+        break;
+    case eImageBitDepthNone:
+        break;
+    }
+}
+
+// code proofread and fixed by @devernay on 4/12/2014
+template <typename PIX, int maxValue>
+void
+Image::halveRoIForDepth(const RectI & roi,
+                        bool copyBitMap,
+                        Image* output) const
+{
+    ///handle case where there is only 1 column/row
+    if ( (roi.width() == 1) || (roi.height() == 1) ) {
+        assert( !(roi.width() == 1 && roi.height() == 1) ); /// can't be 1x1
+        halve1DImage(roi, output);
+
+        return;
+    }
+
+    /// Take the lock for both bitmaps since we're about to read/write from them!
+    QWriteLocker k1( &output->getEntryLock() );
+    QReadLocker k2( &getEntryLock() );
+
+    halvePyramidForDepth<PIX>( std::vector<RectI>(1, roi), copyBitMap, std::vector<Image*>(1, output) );
 } // halveRoIForDepth
 
 // code proofread and fixed by @devernay on 8/8/2014
@@ -1978,7 +2353,7 @@ Image::halveRoI(const RectI & roi,
         halveRoIForDepth<unsigned short, 65535>(roi, copyBitMap, output);
         break;
     case eImageBitDepthHalf:
-        assert(false);
+        halveRoIForDepth<Half, 1>(roi, copyBitMap, output);
         break;
     case eImageBitDepthFloat:
         halveRoIForDepth<float, 1>(roi, copyBitMap, output);
@@ -2001,8 +2376,8 @@ Image::halve1DImageForDepth(const RectI & roi,
     assert( output->getComponents() == getComponents() );
 
     /// Take the lock for both bitmaps since we're about to read/write from them!
-    QWriteLocker k1(&output->_entryLock);
-    QReadLocker k2(&_entryLock);
+    QWriteLocker k1( &output->getEntryLock() );
+    QReadLocker k2( &getEntryLock() );
     const RectI & srcBounds = _bounds;
     const RectI & dstBounds = output->_bounds;
 //    assert(dstBounds.x1 * 2 == roi.x1 &&
@@ -2054,7 +2429,7 @@ Image::halve1DImage(const RectI & roi,
         halve1DImageForDepth<unsigned short, 65535>(roi, output);
         break;
     case eImageBitDepthHalf:
-        assert(false);
+        halve1DImageForDepth<Half, 1>(roi, output);
         break;
     case eImageBitDepthFloat:
         halve1DImageForDepth<float, 1>(roi, output);
@@ -2071,7 +2446,8 @@ Image::downscaleMipMap(const RectD& dstRod,
                        unsigned int fromLevel,
                        unsigned int toLevel,
                        bool copyBitMap,
-                       Image* output) const
+                       Image* output,
+                       const std::vector<Image*>* intermediateOutputs) const
 {
     assert(getStorageMode() != eStorageModeGLTex);
 
@@ -2092,7 +2468,7 @@ Image::downscaleMipMap(const RectD& dstRod,
     RectI dstRoI  = roi.downscalePowerOfTwoSmallestEnclosing(downscaleLvls);
     ImagePtr tmpImg = boost::make_shared<Image>( getComponents(), dstRod, dstRoI, toLevel, par, getBitDepth(), getPremultiplication(), getFieldingOrder(), true);
 
-    buildMipMapLevel( dstRod, roi, downscaleLvls, copyBitMap, tmpImg.get() );
+    buildMipMapLevel( dstRod, roi, downscaleLvls, copyBitMap, tmpImg.get(), intermediateOutputs );
 
     // check that the downscaled mipmap is inside the output image (it may not be equal to it)
     assert(dstRoI.x1 >= output->_bounds.x1);
@@ -2107,16 +2483,31 @@ Image::downscaleMipMap(const RectD& dstRod,
 bool
 Image::checkForNaNs(const RectI& roi)
 {
-    if (getBitDepth() != eImageBitDepthFloat) {
+    if ( (getBitDepth() != eImageBitDepthFloat) && (getBitDepth() != eImageBitDepthHalf) ) {
         return false;
     }
     if (getStorageMode() == eStorageModeGLTex) {
         return false;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     unsigned int compsCount = getComponentsCount();
     bool hasnan = false;
+    if (getBitDepth() == eImageBitDepthHalf) {
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            Half* pix = (Half*)pixelAt(roi.x1, y);
+            Half* const end = pix +  compsCount * roi.width();
+
+            for (; pix < end; ++pix) {
+                if ( pix->isNan() ) {
+                    *pix = 1.f;
+                    hasnan = true;
+                }
+            }
+        }
+
+        return hasnan;
+    }
     for (int y = roi.y1; y < roi.y2; ++y) {
         float* pix = (float*)pixelAt(roi.x1, y);
         float* const end = pix +  compsCount * roi.width();
@@ -2143,7 +2534,7 @@ Image::upscaleMipMapForDepth(const RectI & roi,
                              Image* output) const
 {
     assert( getBitDepth() == output->getBitDepth() );
-    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) || (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthHalf && sizeof(PIX) == 2) || (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
 
     ///You should not call this function with a level equal to 0.
     assert(fromLevel > toLevel);
@@ -2168,8 +2559,8 @@ Image::upscaleMipMapForDepth(const RectI & roi,
         return;
     }
 
-    QWriteLocker k1(&output->_entryLock);
-    QReadLocker k2(&_entryLock);
+    QWriteLocker k1( &output->getEntryLock() );
+    QReadLocker k2( &getEntryLock() );
     int srcRowSize = _bounds.width() * _nbComponents;
     int dstRowSize = output->_bounds.width() * _nbComponents;
     const PIX *src = (const PIX*)pixelAt(srcRoi.x1, srcRoi.y1);
@@ -2232,7 +2623,7 @@ Image::upscaleMipMap(const RectI & roi,
         upscaleMipMapForDepth<unsigned short, 65535>(roi, fromLevel, toLevel, output);
         break;
     case eImageBitDepthHalf:
-        assert(false);
+        upscaleMipMapForDepth<Half, 1>(roi, fromLevel, toLevel, output);
         break;
     case eImageBitDepthFloat:
         upscaleMipMapForDepth<float, 1>(roi, fromLevel, toLevel, output);
@@ -2248,7 +2639,8 @@ Image::buildMipMapLevel(const RectD& dstRoD,
                         const RectI & roi,
                         unsigned int level,
                         bool copyBitMap,
-                        Image* output) const
+                        Image* output,
+                        const std::vector<Image*>* intermediateOutputs) const
 {
     ///The last mip map level we will make with closestPo2
     RectI lastLevelRoI = roi.downscalePowerOfTwoSmallestEnclosing(level);
@@ -2265,43 +2657,55 @@ Image::buildMipMapLevel(const RectD& dstRoD,
         return;
     }
 
-    const Image* srcImg = this;
-    Image* dstImg = NULL;
-    bool mustFreeSrc = false;
+    ///Allocate all the mipmap levels until we reach the one we are interested in
+    std::vector<ImagePtr> levelImages(level);
+    std::vector<Image*> levels(level);
+    std::vector<RectI> levelRoIs(level);
+    bool hasRowOrColumn = false;
     RectI previousRoI = roi;
-    ///Build all the mipmap levels until we reach the one we are interested in
     for (unsigned int i = 1; i <= level; ++i) {
         ///Halve the smallest enclosing po2 rect as we need to render a minimum of the renderWindow
         RectI halvedRoI = previousRoI.downscalePowerOfTwoSmallestEnclosing(1);
 
         ///Allocate an image with half the size of the source image
-        dstImg = new Image( getComponents(), dstRoD, halvedRoI, getMipMapLevel() + i, getPixelAspectRatio(), getBitDepth(), getPremultiplication(), getFieldingOrder(), true);
+        levelImages[i - 1] = boost::make_shared<Image>( getComponents(), dstRoD, halvedRoI, getMipMapLevel() + i, getPixelAspectRatio(), getBitDepth(), getPremultiplication(), getFieldingOrder(), true);
+        levels[i - 1] = levelImages[i - 1].get();
 
-        ///Half the source image into dstImg.
         ///We pass the closestPo2 roi which might not be the entire size of the source image
         ///If the source image'sroi was originally a po2.
-        srcImg->halveRoI(previousRoI, copyBitMap, dstImg);
-
-        ///Clean-up, we should use shared_ptrs for safety
-        if (mustFreeSrc) {
-            delete srcImg;
+        levelRoIs[i - 1] = previousRoI;
+        if ( (previousRoI.width() == 1) || (previousRoI.height() == 1) ) {
+            hasRowOrColumn = true;
         }
 
-        ///Switch for next pass
         previousRoI = halvedRoI;
-        srcImg = dstImg;
-        mustFreeSrc = true;
     }
 
-    assert(srcImg->getBounds() == lastLevelRoI);
+    if (!hasRowOrColumn) {
+        ///Build all the levels in a single pass over the source image
+        QReadLocker k( &getEntryLock() );
+        halvePyramid(levelRoIs, copyBitMap, levels);
+    } else {
+        ///The 1D levels are halved by halve1DImage, build them one after the other
+        for (unsigned int i = 0; i < level; ++i) {
+            const Image* srcImg = (i == 0) ? this : levels[i - 1];
+            srcImg->halveRoI(levelRoIs[i], copyBitMap, levels[i]);
+        }
+    }
 
-    ///Finally copy the last mipmap level into output.
-    output->pasteFrom( *srcImg, srcImg->getBounds(), copyBitMap);
+    assert(levels.back()->getBounds() == lastLevelRoI);
 
-    ///Clean-up, we should use shared_ptrs for safety
-    if (mustFreeSrc) {
-        delete srcImg;
+    ///Copy the intermediate levels the caller wants to keep
+    if (intermediateOutputs) {
+        for (std::size_t i = 0; i < intermediateOutputs->size() && i + 1 < levels.size(); ++i) {
+            if ( (*intermediateOutputs)[i] ) {
+                (*intermediateOutputs)[i]->pasteFrom( *levels[i], levels[i]->getBounds(), copyBitMap );
+            }
+        }
     }
+
+    ///Finally copy the last mipmap level into output.
+    output->pasteFrom( *levels.back(), levels.back()->getBounds(), copyBitMap);
 } // buildMipMapLevel
 
 double
@@ -2382,11 +2786,67 @@ Bitmap::copyBitmapPortion(const RectI& roi,
     }
 }
 
+namespace {
+template <typename PIX, bool doPremult>
+void
+premultRow(PIX* dstPix,
+           int width)
+{
+    for (int x = 0; x < width; ++x, dstPix += 4) {
+        for (int c = 0; c < 3; ++c) {
+            if (doPremult) {
+                dstPix[c] = PIX(float(dstPix[c]) * dstPix[3]);
+            } else {
+                if (dstPix[3] != 0) {
+                    dstPix[c] = PIX( dstPix[c] / float(dstPix[3]) );
+                }
+            }
+        }
+    }
+}
+
+#ifdef __SSE2__
+// One pixel per vector. The products and quotients are the ones of the generic version, the alpha is put back as is.
+template <>
+void
+premultRow<float, true>(float* dstPix,
+                        int width)
+{
+    for (int x = 0; x < width; ++x, dstPix += 4) {
+        __m128 p = _mm_loadu_ps(dstPix);
+        __m128 a = _mm_shuffle_ps( p, p, _MM_SHUFFLE(3, 3, 3, 3) );
+        __m128 r = _mm_mul_ps(p, a);
+        // r0 r1 r2 p3
+        __m128 t = _mm_shuffle_ps( r, p, _MM_SHUFFLE(3, 3, 2, 2) );
+        _mm_storeu_ps( dstPix, _mm_shuffle_ps( r, t, _MM_SHUFFLE(2, 0, 1, 0) ) );
+    }
+}
+
+template <>
+void
+premultRow<float, false>(float* dstPix,
+                         int width)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int x = 0; x < width; ++x, dstPix += 4) {
+        __m128 p = _mm_loadu_ps(dstPix);
+        __m128 a = _mm_shuffle_ps( p, p, _MM_SHUFFLE(3, 3, 3, 3) );
+        // where alpha is 0 the pixel is left untouched
+        __m128 nonZero = _mm_cmpneq_ps(a, zero);
+        __m128 r = _mm_or_ps( _mm_and_ps( nonZero, _mm_div_ps(p, a) ), _mm_andnot_ps(nonZero, p) );
+        __m128 t = _mm_shuffle_ps( r, p, _MM_SHUFFLE(3, 3, 2, 2) );
+        _mm_storeu_ps( dstPix, _mm_shuffle_ps( r, t, _MM_SHUFFLE(2, 0, 1, 0) ) );
+    }
+}
+
+#endif // __SSE2__
+} // anon namespace
+
 template <typename PIX, bool doPremult>
 void
 Image::premultInternal(const RectI& roi)
 {
-    WriteAccess acc(this);
     RectI renderWindow;
 
     roi.intersect(_bounds, &renderWindow);
@@ -2394,19 +2854,9 @@ Image::premultInternal(const RectI& roi)
     assert(getComponentsCount() == 4);
 
     int srcRowElements = 4 * _bounds.width();
-    PIX* dstPix = (PIX*)acc.pixelAt(renderWindow.x1, renderWindow.y1);
-    for ( int y = renderWindow.y1; y < renderWindow.y2; ++y, dstPix += (srcRowElements - (renderWindow.x2 - renderWindow.x1) * 4) ) {
-        for (int x = renderWindow.x1; x < renderWindow.x2; ++x, dstPix += 4) {
-            for (int c = 0; c < 3; ++c) {
-                if (doPremult) {
-                    dstPix[c] = PIX(float(dstPix[c]) * dstPix[3]);
-                } else {
-                    if (dstPix[3] != 0) {
-                        dstPix[c] = PIX( dstPix[c] / float(dstPix[3]) );
-                    }
-                }
-            }
-        }
+    PIX* dstPix = (PIX*)pixelAt(renderWindow.x1, renderWindow.y1);
+    for ( int y = renderWindow.y1; y < renderWindow.y2; ++y, dstPix += srcRowElements ) {
+        premultRow<PIX, doPremult>( dstPix, renderWindow.width() );
     }
 }
 
@@ -2417,7 +2867,28 @@ Image::premultForDepth(const RectI& roi)
     if (getComponentsCount() != 4) {
         return;
     }
+
+    WriteAccess acc(this);
+    RectI renderWindow;
+    if ( !roi.intersect(_bounds, &renderWindow) ) {
+        return;
+    }
+
+    std::vector<RectI> bands;
+    getRowBands(renderWindow, &bands);
+    if (bands.size() == 1) {
+        premultForRoI<doPremult>(renderWindow);
+    } else {
+        QtConcurrent::blockingMap( bands, boost::bind(&Image::premultForRoI<doPremult>, this, _1) );
+    }
+}
+
+template <bool doPremult>
+void
+Image::premultForRoI(const RectI& roi)
+{
     ImageBitDepthEnum depth = getBitDepth();
+
     switch (depth) {
     case eImageBitDepthByte:
         premultInternal<unsigned char, doPremult>(roi);
@@ -2425,6 +2896,9 @@ Image::premultForDepth(const RectI& roi)
     case eImageBitDepthShort:
         premultInternal<unsigned short, doPremult>(roi);
         break;
+    case eImageBitDepthHalf:
+        premultInternal<Half, doPremult>(roi);
+        break;
     case eImageBitDepthFloat:
         premultInternal<float, doPremult>(roi);
         break;
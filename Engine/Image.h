@@ -29,6 +29,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <algorithm> // min, max
 #include <bitset>
 
@@ -38,11 +39,13 @@ CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QHash>
 CLANG_DIAG_ON(deprecated)
 #include <QtCore/QReadWriteLock>
+#include <QtCore/QMutex>
 
 #include "Engine/ImageKey.h"
 #include "Engine/ImagePlaneDesc.h"
 #include "Engine/ImageParams.h"
 #include "Engine/CacheEntry.h"
+#include "Engine/Half.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/RectD.h"
 #include "Engine/ViewIdx.h"
@@ -201,11 +204,32 @@ public:
     Image(const ImageKey & key,
           const ImageParamsPtr& params);
 
+    /**
+     * @brief Creates a view of viewedImage: an image that does not own any memory and reads and writes the pixels
+     * of viewedImage instead, but describes them with the given components and premultiplication state.
+     * components must have the same number of channels as viewedImage, which may not be an OpenGL texture. The view has the same
+     * bounds, bit depth and key as viewedImage and shares its lock, and it follows viewedImage when the latter is
+     * resized by ensureBounds(). It has no bitmap, like a local image.
+     * This is used to hand the planes of an identity or pass-through node downstream under another name
+     * without copying them.
+     **/
+    Image(const ImagePtr& viewedImage,
+          const ImagePlaneDesc& components,
+          ImagePremultiplicationEnum premult);
+
 
     virtual ~Image();
 
     bool usesBitMap() const { return _useBitmap; }
 
+    /**
+     * @brief Returns the image whose pixels this image is a view of, or NULL if it owns its pixels.
+     **/
+    const ImagePtr& getViewedImage() const
+    {
+        return _viewedImage;
+    }
+
     StorageModeEnum getStorageMode() const
     {
         return _params->getStorageInfo().mode;
@@ -293,7 +317,7 @@ public:
      **/
     RectI getBounds() const
     {
-        QReadLocker k(&_entryLock);
+        QReadLocker k( &getEntryLock() );
 
         return _bounds;
     };
@@ -513,6 +537,19 @@ private:
     unsigned char* pixelAt(int x, int y);
     const unsigned char* pixelAt(int x, int y) const;
 
+    /**
+     * @brief Clips the columns [*x1, *x2) of row y to the bounds of the image and returns the address of the pixel
+     * at (*x1, y), or NULL if none of them is in the image. The kernels that read another image at the same
+     * coordinates use it once per row rather than calling pixelAt() for each pixel.
+     **/
+    const unsigned char* rowPortionAt(int y, int* x1, int* x2) const;
+
+    /**
+     * @brief Splits roi into bands of rows to be processed in parallel on the global thread pool.
+     * If roi is too small for it to be worth it, roi is the only band.
+     **/
+    static void getRowBands(const RectI& roi, std::vector<RectI>* bands);
+
     /**
      * @brief Locks the image for read/write access.
      * There can be a deadlock situation in the following situation:
@@ -532,17 +569,26 @@ private:
      **/
     void lockForRead() const
     {
-        _entryLock.lockForRead();
+        getEntryLock().lockForRead();
     }
 
     void lockForWrite() const
     {
-        _entryLock.lockForWrite();
+        getEntryLock().lockForWrite();
     }
 
     void unlock() const
     {
-        _entryLock.unlock();
+        getEntryLock().unlock();
+    }
+
+    /**
+     * @brief The lock protecting the buffer and the bounds of the image: this is the lock of the viewed image
+     * for a view, so that locking a view locks the pixels it reads.
+     **/
+    QReadWriteLock& getEntryLock() const
+    {
+        return _viewedImage ? _viewedImage->getEntryLock() : _entryLock;
     }
 
     template <typename SRCPIX, typename DSTPIX, int srcMaxValue, int dstMaxValue>
@@ -754,12 +800,15 @@ public:
      * This function will adjust roi to the largest enclosed rectangle for the
      * given mipmap level,
      * and then computes the mipmap of the given level of that rectangle.
+     * If intermediateOutputs is not NULL, the levels between fromLevel and toLevel that are computed on the way
+     * are also copied to them: (*intermediateOutputs)[i] receives the level fromLevel + i + 1 (it may be NULL).
      **/
     void downscaleMipMap(const RectD& rod,
                          const RectI & roi,
                          unsigned int fromLevel, unsigned int toLevel,
                          bool copyBitMap,
-                         Image* output) const;
+                         Image* output,
+                         const std::vector<Image*>* intermediateOutputs = 0) const;
 
     /**
      * @brief Upscales a portion of this image into output.
@@ -818,8 +867,23 @@ public:
                                bool requiresUnpremult,
                                Image* dstImg) const;
 
+    /**
+     * @brief Copies the given channels of the pixels in roi to planes: one buffer of roi.area() floats per channel,
+     * stored row by row from roi.y1. Values are converted to float without any colorspace conversion and the pixels
+     * of roi that are outside of the image are 0.
+     * Images are stored interleaved: this converts the window that a consumer reading channels one by one
+     * (e.g. the histograms) needs to the planar layout, in a single pass.
+     **/
+    void copyChannelsToPlanar(const RectI& roi,
+                              const std::vector<int>& channels,
+                              std::vector<std::vector<float> >* planes) const;
+
 private:
 
+    template <typename PIX>
+    void copyChannelsToPlanarForDepth(const RectI& roi,
+                                      const std::vector<int>& channels,
+                                      std::vector<std::vector<float> >* planes) const;
 
     void convertToFormatCommon(const RectI & renderWindow,
                                ViewerColorSpaceEnum srcColorSpace,
@@ -834,6 +898,8 @@ private:
     void premultInternal(const RectI& roi);
     template <bool doPremult>
     void premultForDepth(const RectI& roi);
+    template <bool doPremult>
+    void premultForRoI(const RectI& roi);
 
 public:
 
@@ -935,6 +1001,13 @@ private:
                                       bool maskInvert,
                                       float mix);
 
+    void applyMaskMixForRoI(const RectI& roi,
+                            const Image* maskImg,
+                            const Image* originalImg,
+                            bool masked,
+                            bool maskInvert,
+                            float mix);
+
     template <typename PIX, int maxValue, int srcNComps, int dstNComps, bool doR, bool doG, bool doB, bool doA, bool premult, bool originalPremult, bool ignorePremult>
     void copyUnProcessedChannelsForPremult(std::bitset<4> processChannels,
                                            const RectI& roi,
@@ -979,14 +1052,37 @@ private:
                                          bool originalPremult,
                                          bool ignorePremult);
 
+    void copyUnProcessedChannelsForRoI(bool premult,
+                                       const RectI& roi,
+                                       std::bitset<4> processChannels,
+                                       const ImagePtr& originalImage,
+                                       bool originalPremult,
+                                       bool ignorePremult);
+
 
     /**
      * @brief Given the output buffer,the region of interest and the mip map level, this
      * function computes the mip map of this image in the given roi.
      * If roi is NOT a power of 2, then it will be rounded to the closest power of 2.
+     * All the levels are built in a single pass, see halvePyramid.
      **/
     void buildMipMapLevel(const RectD& dstRoD, const RectI & roiCanonical, unsigned int level, bool copyBitMap,
-                          Image* output) const;
+                          Image* output, const std::vector<Image*>* intermediateOutputs = 0) const;
+
+    /**
+     * @brief Builds the levels of a mipmap pyramid: levels[i] is the halving of rois[i] in the previous level,
+     * levels[0] being the halving of rois[0] in this image. The levels are built together by bands of rows, so
+     * that a band is still in the CPU caches when its next level is built, and the bands are spread over the
+     * global thread pool when the image is large enough.
+     * None of the rois may be a single row or column (see halve1DImage).
+     * The caller must hold the locks of the images.
+     **/
+    void halvePyramid(const std::vector<RectI>& rois, bool copyBitMap,
+                      const std::vector<Image*>& levels) const;
+
+    template <typename PIX>
+    void halvePyramidForDepth(const std::vector<RectI>& rois, bool copyBitMap,
+                              const std::vector<Image*>& levels) const;
 
 
     /**
@@ -1036,6 +1132,13 @@ private:
     ImagePremultiplicationEnum _premult;
     bool _useBitmap;
     int _nbComponents;
+
+    // The image this image is a view of, if any
+    ImagePtr _viewedImage;
+
+    // The views of this image, whose bounds are updated by ensureBounds()
+    QMutex _viewsMutex;
+    std::list<Image*> _views;
 };
 
 //template <> inline unsigned char clamp(unsigned char v) { return v; }
@@ -1070,6 +1173,10 @@ template<>
 inline float
 Image::clampIfInt(float v) { return v; }
 
+template<>
+inline Half
+Image::clampIfInt(float v) { return Half(v); }
+
 NATRON_NAMESPACE_EXIT
 
 #endif // NATRON_ENGINE_IMAGE_H
@@ -29,11 +29,14 @@
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
+#include <boost/bind.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #endif
 
 #include <QtCore/QDebug>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/OSGLContext.h"
 #include "Engine/GLShader.h"
@@ -64,7 +67,6 @@ Image::copyUnProcessedChannelsForPremult(const std::bitset<4> processChannels,
             ( (doG == !processChannels[1]) || !(dstNComps >= 2) ) &&
             ( (doB == !processChannels[2]) || !(dstNComps >= 3) ) &&
             ( (doA == !processChannels[3]) || !(dstNComps == 1 || dstNComps == 4) ) );
-    ReadAccess acc( originalImage.get() );
     int dstRowElements = dstNComps * _bounds.width();
     PIX* dst_pixels = (PIX*)pixelAt(roi.x1, roi.y1);
     assert(dst_pixels);
@@ -72,8 +74,11 @@ Image::copyUnProcessedChannelsForPremult(const std::bitset<4> processChannels,
     assert(dstNComps == 1 || dstNComps == 4 || !premult); // only A or RGBA can be premult
 
     for ( int y = roi.y1; y < roi.y2; ++y, dst_pixels += (dstRowElements - (roi.x2 - roi.x1) * dstNComps) ) {
+        // The portion of the row that is in the original image: outside of it there is no source pixel
+        int srcX1 = roi.x1, srcX2 = roi.x2;
+        const PIX* src_row = originalImage ? (const PIX*)originalImage->rowPortionAt(y, &srcX1, &srcX2) : 0;
         for (int x = roi.x1; x < roi.x2; ++x, dst_pixels += dstNComps) {
-            const PIX* src_pixels = originalImage ? (const PIX*)acc.pixelAt(x, y) : 0;
+            const PIX* src_pixels = ( src_row && (srcX1 <= x) && (x < srcX2) ) ? src_row + (x - srcX1) * srcNComps : 0;
             PIX srcA = src_pixels ? maxValue : 0; /* be opaque for anything that doesn't contain alpha */
             if ( ( (srcNComps == 1) || (srcNComps == 4) ) && src_pixels ) {
 #             ifdef DEBUG
@@ -125,7 +130,7 @@ Image::copyUnProcessedChannelsForPremult(const std::bitset<4> processChannels,
                // Just copy the channels, after all if the user unchecked a channel,
                // we do not want to change the values behind his back.
                // Rather we display a warning in  the GUI.
-#           define DOCHANNEL(c) dst_pixels[c] = (!src_pixels || c >= srcNComps) ? 0 : src_pixels[c];
+#           define DOCHANNEL(c) dst_pixels[c] = (!src_pixels || c >= srcNComps) ? PIX(0) : src_pixels[c];
 #         endif // !NATRON_COPY_CHANNELS_UNPREMULT
 
             if ( (dstNComps == 1) || (dstNComps == 4) ) {
@@ -211,7 +216,6 @@ Image::copyUnProcessedChannelsForPremult(const bool premult,
                                          const RectI& roi,
                                          const ImagePtr& originalImage)
 {
-    ReadAccess acc( originalImage.get() );
     int dstRowElements = dstNComps * _bounds.width();
     PIX* dst_pixels = (PIX*)pixelAt(roi.x1, roi.y1);
 
@@ -226,8 +230,11 @@ Image::copyUnProcessedChannelsForPremult(const bool premult,
     Q_UNUSED(originalPremult);
 
     for ( int y = roi.y1; y < roi.y2; ++y, dst_pixels += (dstRowElements - (roi.x2 - roi.x1) * dstNComps) ) {
+        // The portion of the row that is in the original image: outside of it there is no source pixel
+        int srcX1 = roi.x1, srcX2 = roi.x2;
+        const PIX* src_row = originalImage ? (const PIX*)originalImage->rowPortionAt(y, &srcX1, &srcX2) : 0;
         for (int x = roi.x1; x < roi.x2; ++x, dst_pixels += dstNComps) {
-            const PIX* src_pixels = originalImage ? (const PIX*)acc.pixelAt(x, y) : 0;
+            const PIX* src_pixels = ( src_row && (srcX1 <= x) && (x < srcX2) ) ? src_row + (x - srcX1) * srcNComps : 0;
             PIX srcA = src_pixels ? maxValue : 0; /* be opaque for anything that doesn't contain alpha */
             if ( ( (srcNComps == 1) || (srcNComps == 4) ) && src_pixels ) {
 #             ifdef DEBUG
@@ -618,7 +625,7 @@ Image::copyUnProcessedChannels(const RectI& roi,
         return;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     assert( !originalImage || getBitDepth() == originalImage->getBitDepth() );
 
 
@@ -682,6 +689,24 @@ Image::copyUnProcessedChannels(const RectI& roi,
 
     bool premult = (outputPremult == eImagePremultiplicationPremultiplied);
     bool originalPremult = (originalImagePremult == eImagePremultiplicationPremultiplied);
+    ReadAccess acc( originalImage.get() );
+    std::vector<RectI> bands;
+    getRowBands(srcRoi, &bands);
+    if (bands.size() == 1) {
+        copyUnProcessedChannelsForRoI(premult, srcRoi, processChannels, originalImage, originalPremult, ignorePremult);
+    } else {
+        QtConcurrent::blockingMap( bands, boost::bind(&Image::copyUnProcessedChannelsForRoI, this, premult, _1, processChannels, boost::cref(originalImage), originalPremult, ignorePremult) );
+    }
+} // copyUnProcessedChannels
+
+void
+Image::copyUnProcessedChannelsForRoI(const bool premult,
+                                     const RectI& roi,
+                                     const std::bitset<4> processChannels,
+                                     const ImagePtr& originalImage,
+                                     const bool originalPremult,
+                                     const bool ignorePremult)
+{
     switch ( getBitDepth() ) {
     case eImageBitDepthByte:
         copyUnProcessedChannelsForDepth<unsigned char, 255>(premult, roi, processChannels, originalImage, originalPremult, ignorePremult);
@@ -689,13 +714,15 @@ Image::copyUnProcessedChannels(const RectI& roi,
     case eImageBitDepthShort:
         copyUnProcessedChannelsForDepth<unsigned short, 65535>(premult, roi, processChannels, originalImage, originalPremult, ignorePremult);
         break;
+    case eImageBitDepthHalf:
+        copyUnProcessedChannelsForDepth<Half, 1>(premult, roi, processChannels, originalImage, originalPremult, ignorePremult);
+        break;
     case eImageBitDepthFloat:
         copyUnProcessedChannelsForDepth<float, 1>(premult, roi, processChannels, originalImage, originalPremult, ignorePremult);
         break;
     default:
-
-        return;
+        break;
     }
-} // copyUnProcessedChannels
+}
 
 NATRON_NAMESPACE_EXIT
@@ -26,11 +26,67 @@
 
 #include <cassert>
 #include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
+#include <boost/bind.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
+
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
 #include "Engine/GLShader.h"
 #include "Engine/OSGLContext.h"
 
 NATRON_NAMESPACE_ENTER
 
+namespace {
+///Dissolves dst_pixels to src_pixels (or to 0 if src_pixels is NULL) with the given alpha
+template<int srcNComps, int dstNComps, typename PIX>
+void
+mixPixel(PIX* dst_pixels,
+         const PIX* src_pixels,
+         float alpha)
+{
+    if (src_pixels) {
+        for (int c = 0; c < dstNComps; ++c) {
+            if (c < srcNComps) {
+                float v = float(dst_pixels[c]) * alpha + (1.f - alpha) * float(src_pixels[c]);
+                dst_pixels[c] = Image::clampIfInt<PIX>(v);
+            }
+        }
+    } else {
+        for (int c = 0; c < dstNComps; ++c) {
+            float v = float(dst_pixels[c]) * alpha;
+            dst_pixels[c] = Image::clampIfInt<PIX>(v);
+        }
+    }
+}
+
+#ifdef __SSE2__
+// One RGBA pixel per vector, with the same operations as the generic version
+template<>
+void
+mixPixel<4, 4, float>(float* dst_pixels,
+                      const float* src_pixels,
+                      float alpha)
+{
+    __m128 v = _mm_mul_ps( _mm_loadu_ps(dst_pixels), _mm_set1_ps(alpha) );
+
+    if (src_pixels) {
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_set1_ps(1.f - alpha), _mm_loadu_ps(src_pixels) ) );
+    }
+    _mm_storeu_ps(dst_pixels, v);
+}
+
+#endif // __SSE2__
+} // anon namespace
+
 template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked, bool maskInvert>
 void
 Image::applyMaskMixForMaskInvert(const RectI& roi,
@@ -40,32 +96,24 @@ Image::applyMaskMixForMaskInvert(const RectI& roi,
 {
     PIX* dst_pixels = (PIX*)pixelAt(roi.x1, roi.y1);
     unsigned int dstRowElements = _bounds.width() * getComponentsCount();
+    const int maskNComps = maskImg ? (int)maskImg->getComponentsCount() : 1;
 
     for ( int y = roi.y1; y < roi.y2; ++y,
           dst_pixels += (dstRowElements - (roi.x2 - roi.x1) * dstNComps) ) { // 1 row stride minus what was done at previous iteration
+        // The portions of the row that are in the original and mask images: outside of them there is no pixel
+        int srcX1 = roi.x1, srcX2 = roi.x2;
+        const PIX* src_row = originalImg ? (const PIX*)originalImg->rowPortionAt(y, &srcX1, &srcX2) : 0;
+        int maskX1 = roi.x1, maskX2 = roi.x2;
+        const PIX* mask_row = (masked && maskImg) ? (const PIX*)maskImg->rowPortionAt(y, &maskX1, &maskX2) : 0;
+
         for (int x = roi.x1; x < roi.x2; ++x,
              dst_pixels += dstNComps) {
-            const PIX* src_pixels = originalImg ? (const PIX*)originalImg->pixelAt(x, y) : 0;
-            float maskScale = 1.f;
-            if (!masked) {
-                // just mix
-                float alpha = mix;
-                if (src_pixels) {
-                    for (int c = 0; c < dstNComps; ++c) {
-                        if (c < srcNComps) {
-                            float v = float(dst_pixels[c]) * alpha + (1.f - alpha) * float(src_pixels[c]);
-                            dst_pixels[c] = clampIfInt<PIX>(v);
-                        }
-                    }
-                } else {
-                    for (int c = 0; c < dstNComps; ++c) {
-                        float v = float(dst_pixels[c]) * alpha;
-                        dst_pixels[c] = clampIfInt<PIX>(v);
-                    }
-                }
-            } else {
-                const PIX* maskPixels = maskImg ? (const PIX*)maskImg->pixelAt(x, y) : 0;
+            const PIX* src_pixels = ( src_row && (srcX1 <= x) && (x < srcX2) ) ? src_row + (x - srcX1) * srcNComps : 0;
+            float alpha = mix;
+            if (masked) {
+                const PIX* maskPixels = ( mask_row && (maskX1 <= x) && (x < maskX2) ) ? mask_row + (x - maskX1) * maskNComps : 0;
                 // figure the scale factor from that pixel
+                float maskScale;
                 if (maskPixels == 0) {
                     maskScale = maskInvert ? 1.f : 0.f;
                 } else {
@@ -74,21 +122,9 @@ Image::applyMaskMixForMaskInvert(const RectI& roi,
                         maskScale = 1.f - maskScale;
                     }
                 }
-                float alpha = mix * maskScale;
-                if (src_pixels) {
-                    for (int c = 0; c < dstNComps; ++c) {
-                        if (c < srcNComps) {
-                            float v = float(dst_pixels[c]) * alpha + (1.f - alpha) * float(src_pixels[c]);
-                            dst_pixels[c] = clampIfInt<PIX>(v);
-                        }
-                    }
-                } else {
-                    for (int c = 0; c < dstNComps; ++c) {
-                        float v = float(dst_pixels[c]) * alpha;
-                        dst_pixels[c] = clampIfInt<PIX>(v);
-                    }
-                }
+                alpha = mix * maskScale;
             }
+            mixPixel<srcNComps, dstNComps, PIX>(dst_pixels, src_pixels, alpha);
         }
     }
 } // Image::applyMaskMixForMaskInvert
@@ -142,6 +178,9 @@ Image::applyMaskMixForDstComponents(const RectI& roi,
     case eImageBitDepthShort:
         applyMaskMixForDepth<srcNComps, dstNComps, unsigned short, 65535>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
+    case eImageBitDepthHalf:
+        applyMaskMixForDepth<srcNComps, dstNComps, Half, 1>(roi, maskImg, originalImg, masked, maskInvert, mix);
+        break;
     case eImageBitDepthFloat:
         applyMaskMixForDepth<srcNComps, dstNComps, float, 1>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
@@ -198,14 +237,14 @@ Image::applyMaskMix(const RectI& roi,
         return;
     }
 
-    QWriteLocker k(&_entryLock);
+    QWriteLocker k( &getEntryLock() );
     boost::scoped_ptr<QReadLocker> originalLock;
     boost::scoped_ptr<QReadLocker> maskLock;
     if (originalImg) {
-        originalLock.reset( new QReadLocker(&originalImg->_entryLock) );
+        originalLock.reset( new QReadLocker( &originalImg->getEntryLock() ) );
     }
     if (maskImg) {
-        maskLock.reset( new QReadLocker(&maskImg->_entryLock) );
+        maskLock.reset( new QReadLocker( &maskImg->getEntryLock() ) );
     }
     RectI realRoI;
     roi.intersect(_bounds, &realRoI);
@@ -274,27 +313,44 @@ Image::applyMaskMix(const RectI& roi,
         return;
     }
 
+    std::vector<RectI> bands;
+    getRowBands(realRoI, &bands);
+    if (bands.size() == 1) {
+        applyMaskMixForRoI(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+    } else {
+        QtConcurrent::blockingMap( bands, boost::bind(&Image::applyMaskMixForRoI, this, _1, maskImg, originalImg, masked, maskInvert, mix) );
+    }
+} // applyMaskMix
+
+void
+Image::applyMaskMixForRoI(const RectI& roi,
+                          const Image* maskImg,
+                          const Image* originalImg,
+                          bool masked,
+                          bool maskInvert,
+                          float mix)
+{
     int srcNComps = originalImg ? (int)originalImg->getComponentsCount() : 0;
     //assert(0 < srcNComps && srcNComps <= 4);
     switch (srcNComps) {
     //case 0:
-    //    applyMaskMixForSrcComponents<0>(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+    //    applyMaskMixForSrcComponents<0>(roi, maskImg, originalImg, masked, maskInvert, mix);
     //    break;
     case 1:
-        applyMaskMixForSrcComponents<1>(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+        applyMaskMixForSrcComponents<1>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
     case 2:
-        applyMaskMixForSrcComponents<2>(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+        applyMaskMixForSrcComponents<2>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
     case 3:
-        applyMaskMixForSrcComponents<3>(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+        applyMaskMixForSrcComponents<3>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
     case 4:
-        applyMaskMixForSrcComponents<4>(realRoI, maskImg, originalImg, masked, maskInvert, mix);
+        applyMaskMixForSrcComponents<4>(roi, maskImg, originalImg, masked, maskInvert, mix);
         break;
     default:
         break;
     }
-} // applyMaskMix
+}
 
 NATRON_NAMESPACE_EXIT
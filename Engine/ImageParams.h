@@ -202,6 +202,11 @@ public:
         return _components;
     }
 
+    void setComponents(const ImagePlaneDesc& components)
+    {
+        _components = components;
+    }
+
     ImageFieldingOrderEnum getFieldingOrder() const
     {
         return _fielding;
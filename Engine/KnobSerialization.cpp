@@ -308,6 +308,22 @@ KnobSerialization::restoreExpressions(const KnobIPtr & knob,
     }
 }
 
+void
+KnobSerialization::getLinks(std::list<std::string>* masterNodeNames,
+                            std::list<std::string>* expressions) const
+{
+    for (std::list<MasterSerialization>::const_iterator it = _masters.begin(); it != _masters.end(); ++it) {
+        if ( !it->masterNodeName.empty() ) {
+            masterNodeNames->push_back(it->masterNodeName);
+        }
+    }
+    for (std::size_t i = 0; i < _expressions.size(); ++i) {
+        if ( !_expressions[i].first.empty() ) {
+            expressions->push_back(_expressions[i].first);
+        }
+    }
+}
+
 void
 KnobSerialization::setChoiceExtraString(const std::string& label)
 {
@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <list>
 #include <map>
 #include <vector>
 #include <string>
@@ -939,6 +940,12 @@ public:
     void restoreExpressions(const KnobIPtr & knob,
                             const std::map<std::string, std::string>& oldNewScriptNamesMapping);
 
+    /**
+     * @brief Appends the names of the nodes this knob is slaved to and its expressions, so that the nodes it depends on
+     * can be found before it is restored.
+     **/
+    void getLinks(std::list<std::string>* masterNodeNames, std::list<std::string>* expressions) const;
+
     virtual KnobIPtr getKnob() const OVERRIDE FINAL
     {
         return _knob;
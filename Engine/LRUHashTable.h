@@ -42,6 +42,7 @@
 //ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
 //OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <cstddef> // size_t
 #include <map>
 #include <list>
 #include <utility>
@@ -112,6 +113,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 ///WARNING: Cached element must have a use_count() method that returns
 ///the current reference counting of the object. Typically a shared_ptr.
+///evictCheapest() also requires the pointed object to have a getEvictionCost() method.
 
 
 template <typename K, typename V, template<typename ...> class MAP>
@@ -219,6 +221,51 @@ public:
         return std::make_pair( key_type(), V() );
     }
 
+    // Purge, among the nCandidates least-recently-used elements that can be purged,
+    // the one with the lowest eviction cost. The oldest wins ties, so with
+    // costs all equal this is the same as evict().
+    std::pair<key_type, V> evictCheapest(std::size_t nCandidates)
+    {
+        typename key_to_value_type::iterator best = _key_to_value.end();
+        typename std::list<V>::iterator bestValue;
+        double bestCost = 0.;
+        std::size_t nFound = 0;
+
+        for (typename key_tracker_type::iterator k = _key_tracker.begin(); k != _key_tracker.end() && nFound < nCandidates; ++k) {
+            typename key_to_value_type::iterator it = _key_to_value.find(*k);
+            for (typename std::list<V>::iterator it2 = it->second.first.begin();
+                 it2 != it->second.first.end() && nFound < nCandidates;
+                 ++it2) {
+                if ( (*it2).use_count() == 1 ) {
+                    double cost = (*it2)->getEvictionCost();
+                    if ( (nFound == 0) || (cost < bestCost) ) {
+                        best = it;
+                        bestValue = it2;
+                        bestCost = cost;
+                    }
+                    ++nFound;
+                }
+            }
+            if ( (nFound > 0) && (bestCost <= 0.) ) {
+                // Nothing can be cheaper
+                break;
+            }
+        }
+        if ( best == _key_to_value.end() ) {
+            return std::make_pair( key_type(), V() );
+        }
+
+        std::pair<key_type, V> ret = std::make_pair(best->first, *bestValue);
+        if (best->second.first.size() == 1) {
+            _key_tracker.erase(best->second.second);
+            _key_to_value.erase(best);
+        } else {
+            best->second.first.erase(bestValue);
+        }
+
+        return ret;
+    }
+
     unsigned int size()
     {
         return _container.size();
@@ -332,6 +379,47 @@ public:
         return std::make_pair( key_type(), V() );
     }
 
+    // Purge, among the nCandidates least-recently-used elements that can be purged,
+    // the one with the lowest eviction cost. The oldest wins ties, so with
+    // costs all equal this is the same as evict().
+    std::pair<key_type, V> evictCheapest(std::size_t nCandidates)
+    {
+        typename container_type::right_iterator best = _container.right.end();
+        typename std::list<V>::iterator bestValue;
+        double bestCost = 0.;
+        std::size_t nFound = 0;
+
+        for (typename container_type::right_iterator it = _container.right.begin(); it != _container.right.end() && nFound < nCandidates; ++it) {
+            for (typename std::list<V>::iterator it2 = it->first.begin(); it2 != it->first.end() && nFound < nCandidates; ++it2) {
+                if ( (*it2).use_count() == 1 ) {
+                    double cost = (*it2)->getEvictionCost();
+                    if ( (nFound == 0) || (cost < bestCost) ) {
+                        best = it;
+                        bestValue = it2;
+                        bestCost = cost;
+                    }
+                    ++nFound;
+                }
+            }
+            if ( (nFound > 0) && (bestCost <= 0.) ) {
+                // Nothing can be cheaper
+                break;
+            }
+        }
+        if ( best == _container.right.end() ) {
+            return std::make_pair( key_type(), V() );
+        }
+
+        std::pair<key_type, V> ret = std::make_pair(best->second, *bestValue);
+        if (best->first.size() == 1) {
+            _container.right.erase(best);
+        } else {
+            best->first.erase(bestValue);
+        }
+
+        return ret;
+    }
+
     unsigned int size()
     {
         return _container.size();
@@ -453,6 +541,51 @@ public:
         return std::make_pair( key_type(), V() );
     }
 
+    // Purge, among the nCandidates least-recently-used elements that can be purged,
+    // the one with the lowest eviction cost. The oldest wins ties, so with
+    // costs all equal this is the same as evict().
+    std::pair<key_type, V> evictCheapest(std::size_t nCandidates)
+    {
+        typename key_to_value_type::iterator best = _key_to_value.end();
+        typename std::list<V>::iterator bestValue;
+        double bestCost = 0.;
+        std::size_t nFound = 0;
+
+        for (typename key_tracker_type::iterator k = _key_tracker.begin(); k != _key_tracker.end() && nFound < nCandidates; ++k) {
+            typename key_to_value_type::iterator it = _key_to_value.find(*k);
+            for (typename std::list<V>::iterator it2 = it->second.first.begin();
+                 it2 != it->second.first.end() && nFound < nCandidates;
+                 ++it2) {
+                if ( (*it2).use_count() == 1 ) {
+                    double cost = (*it2)->getEvictionCost();
+                    if ( (nFound == 0) || (cost < bestCost) ) {
+                        best = it;
+                        bestValue = it2;
+                        bestCost = cost;
+                    }
+                    ++nFound;
+                }
+            }
+            if ( (nFound > 0) && (bestCost <= 0.) ) {
+                // Nothing can be cheaper
+                break;
+            }
+        }
+        if ( best == _key_to_value.end() ) {
+            return std::make_pair( key_type(), V() );
+        }
+
+        std::pair<key_type, V> ret = std::make_pair(best->first, *bestValue);
+        if (best->second.first.size() == 1) {
+            _key_tracker.erase(best->second.second);
+            _key_to_value.erase(best);
+        } else {
+            best->second.first.erase(bestValue);
+        }
+
+        return ret;
+    }
+
     unsigned int size()
     {
         return _key_to_value.size();
@@ -560,6 +693,47 @@ public:
         return std::make_pair( key_type(), V() );
     }
 
+    // Purge, among the nCandidates least-recently-used elements that can be purged,
+    // the one with the lowest eviction cost. The oldest wins ties, so with
+    // costs all equal this is the same as evict().
+    std::pair<key_type, V> evictCheapest(std::size_t nCandidates)
+    {
+        typename container_type::right_iterator best = _container.right.end();
+        typename std::list<V>::iterator bestValue;
+        double bestCost = 0.;
+        std::size_t nFound = 0;
+
+        for (typename container_type::right_iterator it = _container.right.begin(); it != _container.right.end() && nFound < nCandidates; ++it) {
+            for (typename std::list<V>::iterator it2 = it->first.begin(); it2 != it->first.end() && nFound < nCandidates; ++it2) {
+                if ( (*it2).use_count() == 1 ) {
+                    double cost = (*it2)->getEvictionCost();
+                    if ( (nFound == 0) || (cost < bestCost) ) {
+                        best = it;
+                        bestValue = it2;
+                        bestCost = cost;
+                    }
+                    ++nFound;
+                }
+            }
+            if ( (nFound > 0) && (bestCost <= 0.) ) {
+                // Nothing can be cheaper
+                break;
+            }
+        }
+        if ( best == _container.right.end() ) {
+            return std::make_pair( key_type(), V() );
+        }
+
+        std::pair<key_type, V> ret = std::make_pair(best->second, *bestValue);
+        if (best->first.size() == 1) {
+            _container.right.erase(best);
+        } else {
+            best->first.erase(bestValue);
+        }
+
+        return ret;
+    }
+
     unsigned int size()
     {
         return _container.size();
@@ -662,6 +836,47 @@ public:
         return std::make_pair( key_type(), V() );
     }
 
+    // Purge, among the nCandidates least-recently-used elements that can be purged,
+    // the one with the lowest eviction cost. The oldest wins ties, so with
+    // costs all equal this is the same as evict().
+    std::pair<key_type, V> evictCheapest(std::size_t nCandidates)
+    {
+        typename container_type::right_iterator best = _container.right.end();
+        typename std::list<V>::iterator bestValue;
+        double bestCost = 0.;
+        std::size_t nFound = 0;
+
+        for (typename container_type::right_iterator it = _container.right.begin(); it != _container.right.end() && nFound < nCandidates; ++it) {
+            for (typename std::list<V>::iterator it2 = it->first.begin(); it2 != it->first.end() && nFound < nCandidates; ++it2) {
+                if ( (*it2).use_count() == 1 ) {
+                    double cost = (*it2)->getEvictionCost();
+                    if ( (nFound == 0) || (cost < bestCost) ) {
+                        best = it;
+                        bestValue = it2;
+                        bestCost = cost;
+                    }
+                    ++nFound;
+                }
+            }
+            if ( (nFound > 0) && (bestCost <= 0.) ) {
+                // Nothing can be cheaper
+                break;
+            }
+        }
+        if ( best == _container.right.end() ) {
+            return std::make_pair( key_type(), V() );
+        }
+
+        std::pair<key_type, V> ret = std::make_pair(best->second, *bestValue);
+        if (best->first.size() == 1) {
+            _container.right.erase(best);
+        } else {
+            best->first.erase(bestValue);
+        }
+
+        return ret;
+    }
+
     unsigned int size()
     {
         return _container.size();
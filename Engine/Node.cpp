@@ -1308,6 +1308,22 @@ Node::getKnobsAge() const
     return _imp->knobsAge;
 }
 
+U64
+Node::getSerializationAge() const
+{
+    QReadLocker l(&_imp->knobsAgeMutex);
+
+    return _imp->serializationAge;
+}
+
+void
+Node::incrementSerializationAge()
+{
+    QWriteLocker l(&_imp->knobsAgeMutex);
+
+    ++_imp->serializationAge;
+}
+
 bool
 Node::isRenderingPreview() const
 {
@@ -1602,6 +1618,7 @@ Node::makeInfoForInput(int inputNumber) const
                 break;
             case eImageBitDepthHalf:
                 depthStr = tr("16fp");
+                break;
             case eImageBitDepthNone:
                 break;
         }
@@ -1755,6 +1772,25 @@ Node::createNodePage(const KnobPagePtr& settingsPage)
     _imp->forceCaching = fCaching;
     settingsPage->addKnob(fCaching);
 
+    KnobChoicePtr cachePriority = AppManager::createKnob<KnobChoice>(_imp->effect.get(), tr("Cache priority"), 1, false);
+    {
+        std::vector<ChoiceOption> entries;
+        entries.push_back( ChoiceOption("Low", "", tr("Images of this node are the first to leave the cache when room is needed.").toStdString() ) );
+        entries.push_back( ChoiceOption("Normal", "", tr("Images leave the cache according to how recently they were used and how long they took to render.").toStdString() ) );
+        entries.push_back( ChoiceOption("High", "", tr("Images of this node stay in the cache longer than the images of other nodes.").toStdString() ) );
+        cachePriority->populateChoices(entries);
+    }
+    cachePriority->setName("cachePriority");
+    cachePriority->setDefaultValue(1);
+    cachePriority->setAnimationEnabled(false);
+    cachePriority->setIsPersistent(true);
+    cachePriority->setEvaluateOnChange(false);
+    cachePriority->setHintToolTip( tr("When the cache is full, the least recently used images that were the fastest to render are "
+                                      "removed first. This weighs the render time of the images of this node, so that for instance "
+                                      "the output of an expensive Read or Roto node is kept over intermediate images.") );
+    _imp->cachePriority = cachePriority;
+    settingsPage->addKnob(cachePriority);
+
     KnobBoolPtr previewEnabled = AppManager::createKnob<KnobBool>(_imp->effect.get(), tr("Preview"), 1, false);
     assert(previewEnabled);
     previewEnabled->setDefaultValue( makePreviewByDefault() );
@@ -2606,6 +2642,21 @@ Node::isForceCachingEnabled() const
     return b ? b->getValue() : false;
 }
 
+double
+Node::getCachePriority() const
+{
+    KnobChoicePtr k = _imp->cachePriority.lock();
+    int priority = k ? k->getValue() : 1;
+
+    if (priority == 0) {
+        return 0.1;
+    } else if (priority == 2) {
+        return 10.;
+    }
+
+    return 1.;
+}
+
 void
 Node::onSetSupportRenderScaleMaybeSet(int support)
 {
@@ -3423,8 +3474,10 @@ Node::makePreviewImage(SequenceTime time,
             renderPreviewForDepth<unsigned short, 65535>(*img, elemCount, width, height, convertToSrgb, buf);
             break;
         }
-        case eImageBitDepthHalf:
+        case eImageBitDepthHalf: {
+            renderPreviewForDepth<Half, 1>(*img, elemCount, width, height, convertToSrgb, buf);
             break;
+        }
         case eImageBitDepthFloat: {
             renderPreviewForDepth<float, 1>(*img, elemCount, width, height, convertToSrgb, buf);
             break;
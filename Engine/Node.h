@@ -877,6 +877,14 @@ public:
 
     U64 getKnobsAge() const;
 
+    /**
+     * @brief Incremented whenever a parameter of the node changes, even if it does not affect renders.
+     * The auto-save uses it to find the nodes that changed since it last ran.
+     **/
+    U64 getSerializationAge() const;
+
+    void incrementSerializationAge();
+
     void onAllKnobsSlaved(bool isSlave, KnobHolder* master);
 
     void onKnobSlaved(const KnobIPtr& slave, const KnobIPtr& master, int dimension, bool isSlave);
@@ -1080,6 +1088,12 @@ public:
 
     bool isForceCachingEnabled() const;
 
+    /**
+     * @brief The factor applied to the render time of the images of this node when the cache picks the images
+     * to evict, from the "Cache priority" parameter.
+     **/
+    double getCachePriority() const;
+
 
     /**
      * @brief Declares to Python all parameters as attribute of the variable representing this node.
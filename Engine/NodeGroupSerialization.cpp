@@ -25,6 +25,7 @@
 #include "NodeGroupSerialization.h"
 
 #include <cassert>
+#include <set>
 #include <stdexcept>
 
 #include <QtCore/QDateTime>
@@ -32,6 +33,7 @@
 
 #include "Engine/AppManager.h"
 #include "Engine/CreateNodeArgs.h"
+#include "Engine/KnobTypes.h"
 #include "Engine/Settings.h"
 #include "Engine/AppInstance.h"
 #include "Engine/NodeGroup.h"
@@ -455,4 +457,220 @@ NodeCollectionSerialization::restoreFromSerialization(const std::list<NodeSerial
     return !mustShowErrorsLog;
 } // NodeCollectionSerialization::restoreFromSerialization
 
+// Returns the name of the top-level node of a fully specified node name, e.g "Group1" for "Group1.Blur1"
+static std::string
+getTopLevelNodeName(const std::string& fullySpecifiedName)
+{
+    std::size_t foundDot = fullySpecifiedName.find('.');
+
+    return foundDot == std::string::npos ? fullySpecifiedName : fullySpecifiedName.substr(0, foundDot);
+}
+
+// Appends to dependencies the names of the top-level nodes referenced by the given expression:
+// expressions reference other nodes by their script-name, which must be a Python identifier
+static void
+getNodesReferencedByExpression(const std::string& expression,
+                               const std::map<std::string, NodeSerializationPtr>& nodesByName,
+                               std::list<std::string>* dependencies)
+{
+    std::size_t i = 0;
+
+    while ( i < expression.size() ) {
+        char c = expression[i];
+        if ( ( (c >= 'a') && (c <= 'z') ) || ( (c >= 'A') && (c <= 'Z') ) || (c == '_') ) {
+            std::size_t start = i;
+            while ( i < expression.size() ) {
+                c = expression[i];
+                if ( ( (c >= 'a') && (c <= 'z') ) || ( (c >= 'A') && (c <= 'Z') ) || ( (c >= '0') && (c <= '9') ) || (c == '_') ) {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            std::string token = expression.substr(start, i - start);
+            if ( nodesByName.find(token) != nodesByName.end() ) {
+                dependencies->push_back(token);
+            }
+        } else if ( (c >= '0') && (c <= '9') ) {
+            // Skip numbers so that e.g 1e10 is not seen as the identifier e10
+            while ( i < expression.size() ) {
+                c = expression[i];
+                if ( ( (c >= 'a') && (c <= 'z') ) || ( (c >= 'A') && (c <= 'Z') ) || ( (c >= '0') && (c <= '9') ) || (c == '_') || (c == '.') ) {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+        } else {
+            ++i;
+        }
+    }
+}
+
+static void
+getKnobDependencies(const KnobSerializationBasePtr& knob,
+                    const std::map<std::string, NodeSerializationPtr>& nodesByName,
+                    std::list<std::string>* dependencies)
+{
+    GroupKnobSerializationPtr isGroup = boost::dynamic_pointer_cast<GroupKnobSerialization>(knob);
+
+    if (isGroup) {
+        const std::list<KnobSerializationBasePtr>& children = isGroup->getChildren();
+        for (std::list<KnobSerializationBasePtr>::const_iterator it = children.begin(); it != children.end(); ++it) {
+            getKnobDependencies(*it, nodesByName, dependencies);
+        }
+
+        return;
+    }
+    KnobSerializationPtr isKnob = boost::dynamic_pointer_cast<KnobSerialization>(knob);
+    if (!isKnob) {
+        return;
+    }
+    std::list<std::string> masterNodeNames, expressions;
+    isKnob->getLinks(&masterNodeNames, &expressions);
+    for (std::list<std::string>::iterator it = masterNodeNames.begin(); it != masterNodeNames.end(); ++it) {
+        dependencies->push_back( getTopLevelNodeName(*it) );
+    }
+    for (std::list<std::string>::iterator it = expressions.begin(); it != expressions.end(); ++it) {
+        getNodesReferencedByExpression(*it, nodesByName, dependencies);
+    }
+}
+
+// Appends to dependencies the names of the nodes that must exist for the given node to be restored and rendered.
+// The nodes of a group are visited as well since they may reference nodes outside of the group.
+static void
+getNodeDependencies(const NodeSerializationPtr& node,
+                    const std::map<std::string, NodeSerializationPtr>& nodesByName,
+                    std::list<std::string>* dependencies)
+{
+    const std::map<std::string, std::string>& inputs = node->getInputs();
+
+    for (std::map<std::string, std::string>::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+        if ( !it->second.empty() ) {
+            dependencies->push_back(it->second);
+        }
+    }
+    const std::vector<std::string>& oldInputs = node->getOldInputs();
+    for (std::size_t i = 0; i < oldInputs.size(); ++i) {
+        if ( !oldInputs[i].empty() ) {
+            dependencies->push_back(oldInputs[i]);
+        }
+    }
+    if ( !node->getMasterNodeName().empty() ) {
+        dependencies->push_back( getTopLevelNodeName( node->getMasterNodeName() ) );
+    }
+    if ( !node->getMultiInstanceParentName().empty() ) {
+        dependencies->push_back( node->getMultiInstanceParentName() );
+    }
+
+    const NodeSerialization::KnobValues& knobs = node->getKnobsValues();
+    for (NodeSerialization::KnobValues::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        getKnobDependencies(*it, nodesByName, dependencies);
+    }
+    const std::list<GroupKnobSerializationPtr>& userPages = node->getUserPages();
+    for (std::list<GroupKnobSerializationPtr>::const_iterator it = userPages.begin(); it != userPages.end(); ++it) {
+        getKnobDependencies(*it, nodesByName, dependencies);
+    }
+    const std::list<NodeSerializationPtr>& children = node->getNodesCollection();
+    for (std::list<NodeSerializationPtr>::const_iterator it = children.begin(); it != children.end(); ++it) {
+        getNodeDependencies(*it, nodesByName, dependencies);
+    }
+}
+
+// Returns true if the given node or one of the nodes of its group has a Python callback set. Callbacks are names of
+// Python functions whose body is not in the project, so the nodes they reference cannot be found.
+static bool
+hasPythonCallback(const NodeSerializationPtr& node)
+{
+    static const char* callbackKnobNames[] = {
+        "onParamChanged", "onInputChanged", "afterNodeCreated", "beforeNodeRemoval",
+        "beforeFrameRender", "beforeRender", "afterFrameRender", "afterRender", 0
+    };
+    const NodeSerialization::KnobValues& knobs = node->getKnobsValues();
+
+    for (NodeSerialization::KnobValues::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        KnobStringPtr isString = boost::dynamic_pointer_cast<KnobString>( (*it)->getKnob() );
+        if ( !isString || isString->getValue().empty() ) {
+            continue;
+        }
+        for (int i = 0; callbackKnobNames[i]; ++i) {
+            if (isString->getName() == callbackKnobNames[i]) {
+                return true;
+            }
+        }
+    }
+    const std::list<NodeSerializationPtr>& children = node->getNodesCollection();
+    for (std::list<NodeSerializationPtr>::const_iterator it = children.begin(); it != children.end(); ++it) {
+        if ( hasPythonCallback(*it) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+NodeCollectionSerialization::getNodesNeededByOutputs(const std::list<NodeSerializationPtr> & serializedNodes,
+                                                     const std::list<std::string>& outputNodeNames,
+                                                     std::list<NodeSerializationPtr>* neededNodes,
+                                                     std::list<NodeSerializationPtr>* otherNodes)
+{
+    std::map<std::string, NodeSerializationPtr> nodesByName;
+    // Multi-instance children (e.g the tracks of the old tracker) are restored along with their parent
+    std::multimap<std::string, std::string> multiInstanceChildren;
+
+    for (std::list<NodeSerializationPtr>::const_iterator it = serializedNodes.begin(); it != serializedNodes.end(); ++it) {
+        nodesByName[(*it)->getNodeScriptName()] = *it;
+        if ( !(*it)->getMultiInstanceParentName().empty() ) {
+            multiInstanceChildren.insert( std::make_pair( (*it)->getMultiInstanceParentName(), (*it)->getNodeScriptName() ) );
+        }
+    }
+
+    std::list<std::string> toVisit;
+    for (std::list<std::string>::const_iterator it = outputNodeNames.begin(); it != outputNodeNames.end(); ++it) {
+        std::string name = getTopLevelNodeName(*it);
+        if ( nodesByName.find(name) == nodesByName.end() ) {
+            neededNodes->insert( neededNodes->end(), serializedNodes.begin(), serializedNodes.end() );
+
+            return false;
+        }
+        toVisit.push_back(name);
+    }
+
+    std::set<std::string> needed;
+    while ( !toVisit.empty() ) {
+        std::string name = toVisit.front();
+        toVisit.pop_front();
+        std::map<std::string, NodeSerializationPtr>::const_iterator found = nodesByName.find(name);
+        if ( ( found == nodesByName.end() ) || !needed.insert(name).second ) {
+            continue;
+        }
+        getNodeDependencies(found->second, nodesByName, &toVisit);
+        std::pair<std::multimap<std::string, std::string>::const_iterator,
+                  std::multimap<std::string, std::string>::const_iterator> children = multiInstanceChildren.equal_range(name);
+        for (std::multimap<std::string, std::string>::const_iterator it = children.first; it != children.second; ++it) {
+            toVisit.push_back(it->second);
+        }
+    }
+
+    // The callbacks of the needed nodes run during the render and may reference any node, e.g as app.Blur1
+    for (std::set<std::string>::const_iterator it = needed.begin(); it != needed.end(); ++it) {
+        if ( hasPythonCallback(nodesByName[*it]) ) {
+            neededNodes->insert( neededNodes->end(), serializedNodes.begin(), serializedNodes.end() );
+
+            return false;
+        }
+    }
+
+    for (std::list<NodeSerializationPtr>::const_iterator it = serializedNodes.begin(); it != serializedNodes.end(); ++it) {
+        if ( needed.find( (*it)->getNodeScriptName() ) != needed.end() ) {
+            neededNodes->push_back(*it);
+        } else {
+            otherNodes->push_back(*it);
+        }
+    }
+
+    return true;
+} // NodeCollectionSerialization::getNodesNeededByOutputs
+
 NATRON_NAMESPACE_EXIT
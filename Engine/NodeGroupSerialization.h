@@ -89,11 +89,28 @@ public:
         _serializedNodes.push_back(s);
     }
 
+    void setNodesSerialization(const std::list<NodeSerializationPtr>& nodes)
+    {
+        _serializedNodes = nodes;
+    }
+
     static bool restoreFromSerialization(const std::list<NodeSerializationPtr> & serializedNodes,
                                          const NodeCollectionPtr& group,
                                          bool createNodes,
                                          std::map<std::string, bool>* moduleUpdatesProcessed);
 
+    /**
+     * @brief Splits serializedNodes in the nodes that the given output nodes depend upon, either through their inputs,
+     * through links or through expressions, and the others. Both lists keep the order of serializedNodes.
+     * Only the top-level nodes are considered: a group is needed as a whole.
+     * Returns false if one of the outputs could not be found, or if one of the nodes needed has a Python callback
+     * (which may reference any node), in which case all nodes are needed.
+     **/
+    static bool getNodesNeededByOutputs(const std::list<NodeSerializationPtr> & serializedNodes,
+                                        const std::list<std::string>& outputNodeNames,
+                                        std::list<NodeSerializationPtr>* neededNodes,
+                                        std::list<NodeSerializationPtr>* otherNodes);
+
 private:
 
     friend class ::boost::serialization::access;
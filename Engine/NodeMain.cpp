@@ -881,6 +881,7 @@ Node::isSupportedComponent(int inputNb,
 ImageBitDepthEnum
 Node::getClosestSupportedBitDepth(ImageBitDepthEnum depth)
 {
+    bool foundHalf = false;
     bool foundShort = false;
     bool foundByte = false;
 
@@ -889,13 +890,17 @@ Node::getClosestSupportedBitDepth(ImageBitDepthEnum depth)
             return depth;
         } else if (*it == eImageBitDepthFloat) {
             return eImageBitDepthFloat;
+        } else if (*it == eImageBitDepthHalf) {
+            foundHalf = true;
         } else if (*it == eImageBitDepthShort) {
             foundShort = true;
         } else if (*it == eImageBitDepthByte) {
             foundByte = true;
         }
     }
-    if (foundShort) {
+    if (foundHalf) {
+        return eImageBitDepthHalf;
+    } else if (foundShort) {
         return eImageBitDepthShort;
     } else if (foundByte) {
         return eImageBitDepthByte;
@@ -910,6 +915,7 @@ Node::getClosestSupportedBitDepth(ImageBitDepthEnum depth)
 ImageBitDepthEnum
 Node::getBestSupportedBitDepth() const
 {
+    bool foundHalf = false;
     bool foundShort = false;
     bool foundByte = false;
 
@@ -924,6 +930,7 @@ Node::getBestSupportedBitDepth() const
             break;
 
         case eImageBitDepthHalf:
+            foundHalf = true;
             break;
 
         case eImageBitDepthFloat:
@@ -935,7 +942,9 @@ Node::getBestSupportedBitDepth() const
         }
     }
 
-    if (foundShort) {
+    if (foundHalf) {
+        return eImageBitDepthHalf;
+    } else if (foundShort) {
         return eImageBitDepthShort;
     } else if (foundByte) {
         return eImageBitDepthByte;
@@ -274,6 +274,7 @@ OfxHost::setProperties()
     _properties.setStringProperty(kOfxImageEffectPropSupportedPixelDepths, kOfxBitDepthFloat, 0);
     _properties.setStringProperty(kOfxImageEffectPropSupportedPixelDepths, kOfxBitDepthShort, 1);
     _properties.setStringProperty(kOfxImageEffectPropSupportedPixelDepths, kOfxBitDepthByte, 2);
+    _properties.setStringProperty(kOfxImageEffectPropSupportedPixelDepths, kOfxBitDepthHalf, 3);
 
     _properties.setStringProperty(kOfxImageEffectPropSupportedContexts, kOfxImageEffectContextGenerator, 0 );
     _properties.setStringProperty(kOfxImageEffectPropSupportedContexts, kOfxImageEffectContextFilter, 1);
@@ -1213,6 +1214,7 @@ threadFunctionWrapper(OfxThreadFunctionV1 func,
                       unsigned int threadIndex,
                       unsigned int threadMax,
                       QThread* spawnerThread,
+                      RenderThreadPriorityEnum priority,
                       void *customArg)
 {
 #ifdef DEBUG
@@ -1221,6 +1223,8 @@ threadFunctionWrapper(OfxThreadFunctionV1 func,
                                                            boost_adaptbx::floating_point::exception_trapping::overflow);
 #endif
     assert(threadIndex < threadMax);
+    // The threads of the render share the thread pool with the other renders, see RenderThreadScheduler
+    RenderThreadSchedulerTask scheduledTask(priority);
     OfxHost::OfxHostDataTLSPtr tls = appPTR->getOFXHost()->getTLSData();
     tls->threadIndexes.push_back( (int)threadIndex );
 
@@ -1361,7 +1365,11 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
 
         /// DON'T set the maximum thread count, this is a global application setting, and see the documentation excerpt above
         //QThreadPool::globalInstance()->setMaxThreadCount(nThreads);
-        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(threadFunctionWrapper, func, _1, nThreads, spawnerThread, customArg) );
+        RenderThreadPriorityEnum priority;
+        if ( !appPTR->getRenderThreadScheduler()->getCurrentThreadTaskPriority(&priority) ) {
+            priority = eRenderThreadPriorityBackground;
+        }
+        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(threadFunctionWrapper, func, _1, nThreads, spawnerThread, priority, customArg) );
         future.waitForFinished();
         ///DON'T reset back to the original value the maximum thread count
         //QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
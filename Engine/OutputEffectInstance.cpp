@@ -505,6 +505,10 @@ OutputEffectInstance::reportStats(int time,
         ofile << "Nb cache hit: " << nbCacheMiss << std::endl;
         ofile << "Nb cache miss: " << nbCacheMiss << std::endl;
         ofile << "Nb cache hit requiring mipmap downscaling: " << nbCacheHitButDownscaled << std::endl;
+        int nbEvictedImages;
+        double evictedRenderTime;
+        it->second.getCacheEvictionInfos(&nbEvictedImages, &evictedRenderTime);
+        ofile << "Nb images evicted from the cache: " << nbEvictedImages << " (render time lost: " << Timer::printAsTime(evictedRenderTime, false).toStdString() << ")" << std::endl;
 
         const std::set<std::string> & planes = it->second.getPlanesRendered();
         ofile << "Plane(s) rendered: ";
@@ -29,6 +29,7 @@
 #include <list>
 #include <algorithm> // min, max
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 #include <sstream> // stringstream
 
@@ -58,6 +59,7 @@
 #include "Engine/OpenGLViewerI.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
 #include "Engine/Project.h"
+#include "Engine/ReadNodePrefetcher.h"
 #include "Engine/RenderStats.h"
 #include "Engine/RotoContext.h"
 #include "Engine/Settings.h"
@@ -67,6 +69,7 @@
 #include "Engine/UpdateViewerParams.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
+#include "Engine/ViewerSpeculativeRenderer.h"
 #include "Engine/WriteNode.h"
 
 #ifdef DEBUG
@@ -90,6 +93,12 @@
 
 #define NATRON_SCHEDULER_ABORT_AFTER_X_UNSUCCESSFUL_ITERATIONS 5000
 
+// The maximum number of mipmap levels the viewer may be lowered by to hold the frame rate during playback
+#define NATRON_PLAYBACK_MAX_MIPMAP_LEVEL_BIAS 3
+
+// The number of frames rendered at a playback mipmap level before the level may change again
+#define NATRON_PLAYBACK_MIN_FRAME_COST_SAMPLES 3
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -242,6 +251,9 @@ struct OutputSchedulerThreadPrivate
     QMutex bufferedOutputMutex;
     int lastBufferedOutputSize;
 
+    // Decodes the frames of the Read nodes ahead of the render threads
+    ReadNodePrefetcher readAhead;
+
 
     OutputSchedulerThreadPrivate(RenderEngine* engine,
                                  const OutputEffectInstancePtr& effect,
@@ -281,6 +293,7 @@ struct OutputSchedulerThreadPrivate
 #endif
         , bufferedOutputMutex()
         , lastBufferedOutputSize(0)
+        , readAhead()
     {
     }
 
@@ -843,6 +856,10 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread,
         }
     }
 
+    if (gotFrame) {
+        _imp->readAhead.setPlayHead(frame);
+    }
+
     // thread is quitting, make sure we notified the application it is no longer running
     if (!gotFrame) {
         thread->notifyIsRunning(false);
@@ -953,6 +970,7 @@ OutputSchedulerThread::startTasks(int startingFrame)
     PlaybackModeEnum pMode = _imp->engine->getPlaybackMode();
     if (firstFrame == lastFrame) {
         RenderThreadTask* task = createRunnable(startingFrame, useStats, viewsToRender);
+        _imp->readAhead.setPlayHead(startingFrame);
         _imp->appendRunnable(task);
 
         QMutexLocker k(&_imp->framesToRenderMutex);
@@ -962,6 +980,7 @@ OutputSchedulerThread::startTasks(int startingFrame)
         RenderDirectionEnum newDirection = direction;
         for (int i = 0; i < nFrames; ++i) {
             RenderThreadTask* task = createRunnable(frame, useStats, viewsToRender);
+            _imp->readAhead.setPlayHead(frame);
             _imp->appendRunnable(task);
 
 
@@ -1053,6 +1072,13 @@ OutputSchedulerThread::startRender()
 
     aboutToStartRender();
 
+    // A sequential render aborts the renders of the current frame on the viewer (see the ParallelRenderArgsSetter):
+    // raise the abort flag of those that started before
+    ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>( _imp->outputEffect.lock().get() );
+    if (isViewer) {
+        isViewer->abortAllOnGoingRenders();
+    }
+
     ///Notify everyone that the render is started
     _imp->engine->s_renderStarted(forward);
 
@@ -1104,6 +1130,11 @@ OutputSchedulerThread::startRender()
         }
     }
 
+    _imp->readAhead.start( _imp->outputEffect.lock()->getNode(),
+                           firstFrame, lastFrame, frameStep, forward,
+                           _imp->engine->getPlaybackMode() == ePlaybackModeLoop,
+                           isFPSRegulationNeeded() ? getDesiredFPS() : 0. );
+
     {
         QMutexLocker k(&_imp->framesToRenderMutex);
         _imp->expectFrameToRender = startingFrame;
@@ -1160,6 +1191,8 @@ OutputSchedulerThread::stopRender()
 #endif
     _imp->waitForRenderThreadsToQuit();
 
+    _imp->readAhead.stop();
+
     ///If the output effect is sequential (only WriteFFMPEG for now)
     EffectInstancePtr effect = _imp->outputEffect.lock();
     WriteNode* isWriteNode = dynamic_cast<WriteNode*>( effect.get() );
@@ -2686,6 +2719,10 @@ ViewerDisplayScheduler::ViewerDisplayScheduler(RenderEngine* engine,
                                                const ViewerInstancePtr& viewer)
     : OutputSchedulerThread(engine, viewer, eProcessFrameByMainThread) //< OpenGL rendering is done on the main-thread
     , _viewer(viewer)
+    , _playbackLevelMutex()
+    , _playbackLevel(0)
+    , _frameCostAverage(0.)
+    , _nFrameCostSamples(0)
 {
 }
 
@@ -2720,6 +2757,59 @@ ViewerDisplayScheduler::processFrame(const BufferedFrames& frames)
     }
 }
 
+void
+ViewerDisplayScheduler::notifyFrameRenderCost(double timeElapsedSeconds,
+                                              unsigned int playbackMipMapLevelBias)
+{
+    if ( !appPTR->getCurrentSettings()->isAdaptivePlaybackResolutionEnabled() ) {
+        return;
+    }
+
+    double fps = getDesiredFPS();
+    if (fps <= 0.) {
+        return;
+    }
+
+    // Frames are rendered concurrently, so each render thread has this much time to render a frame
+    double frameBudget = std::max(1, getNRenderThreads()) / fps;
+    unsigned int newLevel;
+    {
+        QMutexLocker k(&_playbackLevelMutex);
+
+        // Ignore frames that were started before the level last changed
+        if (playbackMipMapLevelBias != _playbackLevel) {
+            return;
+        }
+        _frameCostAverage = _nFrameCostSamples == 0 ? timeElapsedSeconds : 0.75 * _frameCostAverage + 0.25 * timeElapsedSeconds;
+        ++_nFrameCostSamples;
+        if (_nFrameCostSamples < NATRON_PLAYBACK_MIN_FRAME_COST_SAMPLES) {
+            return;
+        }
+
+        // Each mipmap level divides the number of pixels to render by 4.
+        // Go down in resolution as soon as we are late, but only go up if the frame would still be rendered in time
+        // at the higher resolution, with some margin so that we do not oscillate between two levels.
+        double costRatio = _frameCostAverage / frameBudget;
+        newLevel = _playbackLevel;
+        if (costRatio > 1.1) {
+            int levelsToAdd = std::max( 1, (int)std::ceil( std::log(costRatio) / std::log(4.) ) );
+            newLevel = std::min(_playbackLevel + levelsToAdd, (unsigned int)NATRON_PLAYBACK_MAX_MIPMAP_LEVEL_BIAS);
+        } else if ( (_playbackLevel > 0) && (costRatio * 4. < 0.6) ) {
+            newLevel = _playbackLevel - 1;
+        }
+        if (newLevel == _playbackLevel) {
+            return;
+        }
+#ifdef TRACE_SCHEDULER
+        qDebug() << "Viewer Scheduler: frame render cost" << _frameCostAverage << "s for a budget of" << frameBudget
+                 << "s, setting playback mipmap level bias to" << newLevel;
+#endif
+        _playbackLevel = newLevel;
+        _nFrameCostSamples = 0;
+    }
+    _viewer.lock()->setPlaybackMipMapLevelBias(newLevel);
+}
+
 void
 ViewerDisplayScheduler::timelineStepOne(RenderDirectionEnum direction)
 {
@@ -2762,25 +2852,28 @@ class ViewerRenderFrameRunnable
     : public RenderThreadTask
 {
     ViewerInstanceWPtr _viewer;
+    ViewerDisplayScheduler* _displayScheduler;
 
 public:
 
 #ifndef NATRON_PLAYBACK_USES_THREAD_POOL
     ViewerRenderFrameRunnable(const ViewerInstancePtr& viewer,
-                              OutputSchedulerThread* scheduler)
+                              ViewerDisplayScheduler* scheduler)
         : RenderThreadTask(viewer, scheduler)
         , _viewer(viewer)
+        , _displayScheduler(scheduler)
     {
     }
 
 #else
     ViewerRenderFrameRunnable(const ViewerInstancePtr& viewer,
-                              OutputSchedulerThread* scheduler,
+                              ViewerDisplayScheduler* scheduler,
                               const int frame,
                               const bool useRenderStarts,
                               const std::vector<int>& viewsToRender)
         : RenderThreadTask(viewer, scheduler, frame, useRenderStarts, viewsToRender)
         , _viewer(viewer)
+        , _displayScheduler(scheduler)
     {
     }
 
@@ -2863,9 +2956,14 @@ private:
         }
 
 
+        bool frameRendered = false;
+        unsigned int playbackMipMapLevelBias = 0;
+        TimeLapse renderTime;
         if ( ( args[0] && (status[0] != ViewerInstance::eViewerRenderRetCodeFail) ) || ( args[1] && (status[1] != ViewerInstance::eViewerRenderRetCodeFail) ) ) {
+            playbackMipMapLevelBias = args[0] ? args[0]->playbackMipMapLevelBias : args[1]->playbackMipMapLevelBias;
             try {
                 stat = viewer->renderViewer(view, false, true, viewerHash, true, NodePtr(), true,  args, ViewerCurrentFrameRequestSchedulerStartArgsPtr(), stats);
+                frameRendered = true;
             } catch (...) {
                 stat = ViewerInstance::eViewerRenderRetCodeFail;
             }
@@ -2875,6 +2973,9 @@ private:
             ///"Render failed", instead we let the plug-in that failed post an error message which will be more helpful.
             _imp->scheduler->notifyRenderFailure( std::string() );
         } else {
+            if (frameRendered) {
+                _displayScheduler->notifyFrameRenderCost(renderTime.getTimeSinceCreation(), playbackMipMapLevelBias);
+            }
             for (int i = 0; i < 2; ++i) {
                 if (args[i] && args[i]->params) {
                     toAppend.push_back(args[i]->params);
@@ -2912,12 +3013,30 @@ ViewerDisplayScheduler::handleRenderFailure(const std::string& /*errorMessage*/)
     _viewer.lock()->disconnectViewer();
 }
 
+void
+ViewerDisplayScheduler::aboutToStartRender()
+{
+    // Start from the resolution the previous playback ended with
+    unsigned int level = 0;
+    if ( appPTR->getCurrentSettings()->isAdaptivePlaybackResolutionEnabled() ) {
+        QMutexLocker k(&_playbackLevelMutex);
+        _nFrameCostSamples = 0;
+        level = _playbackLevel;
+    }
+    _viewer.lock()->setPlaybackMipMapLevelBias(level);
+}
+
 void
 ViewerDisplayScheduler::onRenderStopped(bool /*/aborted*/)
 {
     ///Refresh all previews in the tree
     ViewerInstancePtr viewer = _viewer.lock();
 
+    // The last frame displayed may have been rendered at a lower resolution
+    if (viewer->getPlaybackMipMapLevelBias() > 0) {
+        viewer->refineCurrentFrameAfterPlayback();
+    }
+
     viewer->getApp()->refreshAllPreviews();
 
     if ( !viewer->getApp() || viewer->getApp()->isGuiFrozen() ) {
@@ -3011,6 +3130,9 @@ RenderEngine::renderFrameRange(bool isBlocking,
                                RenderDirectionEnum forward)
 {
     setPlaybackAutoRestartEnabled(true);
+    if (_imp->currentFrameScheduler) {
+        _imp->currentFrameScheduler->abortSpeculativeRenders();
+    }
 
     {
         QMutexLocker k(&_imp->schedulerCreationLock);
@@ -3028,6 +3150,9 @@ RenderEngine::renderFromCurrentFrame(bool enableRenderStats,
                                      RenderDirectionEnum forward)
 {
     setPlaybackAutoRestartEnabled(true);
+    if (_imp->currentFrameScheduler) {
+        _imp->currentFrameScheduler->abortSpeculativeRenders();
+    }
 
     {
         QMutexLocker k(&_imp->schedulerCreationLock);
@@ -3189,6 +3314,7 @@ RenderEngine::abortRenderingInternal(bool keepOldestRender)
 
     if (_imp->currentFrameScheduler) {
         ret |= _imp->currentFrameScheduler->abortThreadedTask(keepOldestRender);
+        _imp->currentFrameScheduler->abortSpeculativeRenders();
     }
 
     if ( _imp->scheduler && _imp->scheduler->isWorking() ) {
@@ -3469,6 +3595,9 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     // Used to attribute an age to each renderCurrentFrameRequest
     U64 ageCounter;
 
+    // Renders the frames around the current frame once it is displayed
+    ViewerSpeculativeRenderer speculativeRenderer;
+
     ViewerCurrentFrameRequestSchedulerPrivate(ViewerInstance* viewer)
         : viewer(viewer)
         , threadPool( QThreadPool::globalInstance() )
@@ -3479,6 +3608,7 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
         , currentFrameRenderTasksCond()
         , currentFrameRenderTasks()
         , ageCounter(0)
+        , speculativeRenderer(viewer)
     {
     }
 
@@ -3619,9 +3749,11 @@ public:
 
     RenderStatsPtr stats;
     BufferableObjectPtrList frames;
+    U64 age;
 
     ViewerCurrentFrameRequestSchedulerExecOnMT()
         : GenericThreadExecOnMainThreadArgs()
+        , age(0)
     {
     }
 
@@ -3667,6 +3799,7 @@ ViewerCurrentFrameRequestScheduler::threadLoopOnce(const GenericThreadStartArgsP
 
     ///Wait for the work to be done
     ViewerCurrentFrameRequestSchedulerExecOnMTPtr mtArgs = boost::make_shared<ViewerCurrentFrameRequestSchedulerExecOnMT>();
+    mtArgs->age = args->age;
     {
         QMutexLocker k(&_imp->producedFramesMutex);
         ProducedFrameSet::iterator found = _imp->producedFrames.end();
@@ -3744,6 +3877,13 @@ ViewerCurrentFrameRequestScheduler::executeOnMainThread(const GenericThreadExecO
     assert(args);
     if (args) {
         _imp->processProducedFrame(args->stats, args->frames);
+
+        // Once the latest request is displayed, use the idle time to render the frames around it
+        if ( !args->frames.empty() && (args->age + 1 == _imp->ageCounter) ) {
+            int viewsCount = _imp->viewer->getRenderViewsCount();
+            ViewIdx view = viewsCount > 0 ? _imp->viewer->getViewerCurrentView() : ViewIdx(0);
+            _imp->speculativeRenderer.start(_imp->viewer->getTimeline()->currentFrame(), view);
+        }
     }
 }
 
@@ -3789,12 +3929,14 @@ ViewerCurrentFrameRequestScheduler::onAbortRequested(bool keepOldestRender)
     //and each node actually check if the render has been aborted in EffectInstance::Implementation::aborted()
     _imp->viewer->markAllOnGoingRendersAsAborted(keepOldestRender);
     _imp->backupThread.abortThreadedTask();
+    _imp->speculativeRenderer.abort();
 }
 
 void
 ViewerCurrentFrameRequestScheduler::onQuitRequested(bool allowRestarts)
 {
     _imp->backupThread.quitThread(allowRestarts);
+    _imp->speculativeRenderer.abort();
 }
 
 void
@@ -3802,6 +3944,7 @@ ViewerCurrentFrameRequestScheduler::onWaitForThreadToQuit()
 {
     _imp->waitForRunnableTasks();
     _imp->backupThread.waitForThreadToQuit_enforce_blocking();
+    _imp->speculativeRenderer.quit();
 }
 
 void
@@ -3819,10 +3962,19 @@ ViewerCurrentFrameRequestScheduler::notifyFrameProduced(const BufferableObjectPt
     _imp->notifyFrameProduced(frames, stats,  request->age);
 }
 
+void
+ViewerCurrentFrameRequestScheduler::abortSpeculativeRenders()
+{
+    _imp->speculativeRenderer.abort();
+}
+
 void
 ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats,
                                                        bool canAbort)
 {
+    // The frame requested by the user comes first
+    _imp->speculativeRenderer.abort();
+
     int frame = _imp->viewer->getTimeline()->currentFrame();
     int viewsCount = _imp->viewer->getRenderViewsCount();
     ViewIdx view = viewsCount > 0 ? _imp->viewer->getViewerCurrentView() : ViewIdx(0);
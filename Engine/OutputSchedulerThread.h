@@ -518,6 +518,14 @@ public:
 
     virtual ~ViewerDisplayScheduler();
 
+    /**
+     * @brief Called by the render threads with the time it took to render a frame during playback, at the given
+     * playback mipmap level bias. If frames cannot be rendered at the desired frame rate with the current number
+     * of render threads, the viewer is asked to render at a lower resolution, and back at a higher resolution
+     * when there is enough headroom. Only used if enabled in the preferences.
+     **/
+    void notifyFrameRenderCost(double timeElapsedSeconds, unsigned int playbackMipMapLevelBias);
+
 private:
 
     virtual void processFrame(const BufferedFrames& frames) OVERRIDE FINAL;
@@ -538,8 +546,19 @@ private:
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL { return eSchedulingPolicyOrdered; }
 
     virtual int getLastRenderedTime() const OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual void aboutToStartRender() OVERRIDE FINAL;
     virtual void onRenderStopped(bool aborted) OVERRIDE FINAL;
     ViewerInstanceWPtr _viewer;
+
+    // Protects the members below
+    QMutex _playbackLevelMutex;
+
+    // The playback mipmap level bias, kept from one playback to the next
+    unsigned int _playbackLevel;
+
+    // Moving average of the render time of a frame at _playbackLevel
+    double _frameCostAverage;
+    int _nFrameCostSamples;
 };
 
 /**
@@ -567,6 +586,11 @@ public:
 
     void renderCurrentFrame(bool enableRenderStats, bool canAbort);
 
+    /**
+     * @brief Aborts the renders of the frames around the current frame, @see ViewerSpeculativeRenderer
+     **/
+    void abortSpeculativeRenders();
+
     void notifyFrameProduced(const BufferableObjectPtrList& frames, const RenderStatsPtr& stats, const ViewerCurrentFrameRequestSchedulerStartArgsPtr& request);
 
 private:
@@ -38,6 +38,7 @@
 #include "Engine/NodeGroup.h"
 #include "Engine/GPUContextPool.h"
 #include "Engine/OSGLContext.h"
+#include "Engine/OutputEffectInstance.h"
 #include "Engine/RotoContext.h"
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/ViewIdx.h"
@@ -702,6 +703,17 @@ ParallelRenderArgsSetter::ParallelRenderArgsSetter(double time,
 {
     assert(treeRoot);
 
+    // EffectInstance::aborted() only polls the abort flag of the render: raise it now if the output node
+    // already wants its renders aborted. Later on, the render engine raises it itself.
+    if ( abortInfo && ( !isRenderUserInteraction || abortInfo->canAbort() ) ) {
+        OutputEffectInstance* isOutput = dynamic_cast<OutputEffectInstance*>( treeRoot->getEffectInstance().get() );
+        if (isOutput) {
+            if ( isRenderUserInteraction ? isOutput->isDoingSequentialRender() : isOutput->isSequentialRenderBeingAborted() ) {
+                abortInfo->setAborted();
+            }
+        }
+    }
+
     // Ensure this thread gets an OpenGL context for the render of the frame
     OSGLContextPtr glContext;
     try {
@@ -879,6 +891,7 @@ ParallelRenderArgs::ParallelRenderArgs()
     , request()
     , view(0)
     , abortInfo()
+    , abortFlag()
     , treeRoot()
     , visitsCount(0)
     , rotoPaintNodes()
@@ -887,6 +900,7 @@ ParallelRenderArgs::ParallelRenderArgs()
     , textureIndex(0)
     , currentThreadSafety(eRenderSafetyInstanceSafe)
     , currentOpenglSupport(ePluginOpenGLRenderSupportNone)
+    , renderThreadPriority(eRenderThreadPriorityBackground)
     , isRenderResponseToUserInteraction(false)
     , isSequentialRender(false)
     , isAnalysis(false)
@@ -39,6 +39,7 @@
 #include "Global/GlobalDefines.h"
 
 #include "Engine/RectD.h"
+#include "Engine/ThreadPool.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
 
@@ -104,6 +105,9 @@ public:
     ///A number identifying the current frame render to determine if we can really abort for abortable renders
     AbortableRenderInfoWPtr abortInfo;
 
+    ///The abort flag of abortInfo, polled by EffectInstance::aborted(). NULL if the render cannot be aborted through it
+    RenderAbortFlagPtr abortFlag;
+
     ///A pointer to the node that requested the current render.
     NodePtr treeRoot;
 
@@ -130,6 +134,9 @@ public:
     ///Current OpenGL support: it might change during instanceChanged action
     PluginOpenGLRenderSupport currentOpenglSupport;
 
+    ///How urgent the render is compared to the other renders sharing the thread pool, see RenderThreadScheduler
+    RenderThreadPriorityEnum renderThreadPriority;
+
     /// is this a render due to user interaction ? Generally this is true when rendering because
     /// of a user parameter tweek or timeline seek, or more generally by calling RenderEngine::renderCurrentFrame
     bool isRenderResponseToUserInteraction : 1;
@@ -24,9 +24,12 @@
 
 #include "ProcessHandler.h"
 
+#include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
 
+#include <boost/make_shared.hpp>
+
 #include <QtCore/QtGlobal> // for Q_OS_*
 #include <QtCore/QProcess>
 #include <QtNetwork/QLocalServer>
@@ -37,31 +40,81 @@
 #include <QtCore/QMutex>
 #include <QtCore/QDir>
 #include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
 
 #ifdef DEBUG
 #include "Global/FloatingPointExceptions.h"
 #endif
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
+#include "Engine/CLArgs.h"
 #include "Engine/Node.h"
 #include "Engine/OutputEffectInstance.h"
+#include "Engine/Project.h"
 
 NATRON_NAMESPACE_ENTER
 
-ProcessHandler::ProcessHandler(const QString & projectPath,
-                               OutputEffectInstance* writer)
-    : _process(new QProcess)
-    , _writer(writer)
-    , _ipcServer(0)
-    , _bgProcessOutputSocket(0)
-    , _bgProcessInputSocket(0)
-    , _earlyCancel(false)
-    , _processLog()
-    , _processArgs()
+// Minimum number of frames handed out to a worker at once: each chunk pays for the startup of a new process
+#define NATRON_BACKGROUND_RENDER_MIN_CHUNK_FRAMES 4
+
+struct BackgroundRenderWorker
+{
+    int index; //< index of the worker, for the log
+    QProcess* process; //< the process executing the render
+    QLocalServer* ipcServer; //< the server for IPC with the background process
+    QString ipcServerName;
+    QLocalSocket* bgProcessOutputSocket; //< the socket where data is output by the process
+
+    //the socket where data is read by the process
+    //note that this socket is initialized only when the background process sends the message
+    //kBgProcessServerCreatedShort, meaning it created its server for the input pipe and we can actually open it.
+    QLocalSocket* bgProcessInputSocket;
+    bool earlyCancel; //< true if the user pressed cancel but the bgProcessInput socket was not created yet
+    bool running; //< true while the process is rendering a chunk
+    int chunkFirstIndex, chunkLastIndex; //< the frame indices (in the range of the ProcessHandler) of the current chunk
+
+    BackgroundRenderWorker(int index_)
+        : index(index_)
+        , process(new QProcess)
+        , ipcServer(new QLocalServer)
+        , ipcServerName()
+        , bgProcessOutputSocket(0)
+        , bgProcessInputSocket(0)
+        , earlyCancel(false)
+        , running(false)
+        , chunkFirstIndex(0)
+        , chunkLastIndex(-1)
+    {
+    }
+
+    ~BackgroundRenderWorker()
+    {
+        closeSockets();
+        ipcServer->close();
+        delete ipcServer;
+        process->close();
+        delete process;
+    }
+
+    void closeSockets()
+    {
+        if (bgProcessInputSocket) {
+            bgProcessInputSocket->close();
+            delete bgProcessInputSocket;
+            bgProcessInputSocket = 0;
+        }
+        if (bgProcessOutputSocket) {
+            // Owned by the server
+            bgProcessOutputSocket->close();
+            bgProcessOutputSocket->deleteLater();
+            bgProcessOutputSocket = 0;
+        }
+    }
+};
+
+static QString
+makeIPCServerName()
 {
-    ///setup the server used to listen the output of the background process
-    _ipcServer = new QLocalServer();
-    QObject::connect( _ipcServer, SIGNAL(newConnection()), this, SLOT(onNewConnectionPending()) );
     QString tmpFileName;
 #if defined(Q_OS_WIN)
     tmpFileName += QString::fromUtf8("//./pipe");
@@ -91,48 +144,182 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
         tmpf.remove();
 #endif
     }
-    _ipcServer->listen(tmpFileName);
 
+    return tmpFileName;
+}
+
+ProcessHandler::ProcessHandler(const QString & projectPath,
+                               OutputEffectInstance* writer,
+                               int firstFrame,
+                               int lastFrame,
+                               int frameStep,
+                               int nProcesses)
+    : _writer(writer)
+    , _workers()
+    , _processLog()
+    , _processArgs()
+    , _useFrameRange(false)
+    , _firstFrame(firstFrame)
+    , _lastFrame(lastFrame)
+    , _frameStep( std::max(1, frameStep) )
+    , _nFrames(0)
+    , _nextFrameIndex(0)
+    , _framesDone()
+    , _nFramesDone(0)
+    , _contiguousFramesDone(0)
+    , _canceled(false)
+    , _returnCode(0)
+    , _finished(false)
+{
+    // Negative frames cannot be passed on the command-line since they would be mistaken for options
+    _useFrameRange = firstFrame >= 0 && lastFrame >= firstFrame;
+    if (_useFrameRange) {
+        _nFrames = (_lastFrame - _firstFrame) / _frameStep + 1;
+        _framesDone.resize(_nFrames, false);
+    }
+
+    // Frames of a video file cannot be written by several processes
+    if ( !_useFrameRange || writer->isVideoWriter() ) {
+        nProcesses = 1;
+    }
+    nProcesses = std::max( 1, std::min(nProcesses, (_nFrames + NATRON_BACKGROUND_RENDER_MIN_CHUNK_FRAMES - 1) / NATRON_BACKGROUND_RENDER_MIN_CHUNK_FRAMES) );
 
     _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8( writer->getScriptName_mt_safe().c_str() );
-    _processArgs << QString::fromUtf8("--IPCpipe") <<  tmpFileName;
     _processArgs << projectPath;
 
-    ///connect the useful slots of the process
-    QObject::connect( _process, SIGNAL(readyReadStandardOutput()), this, SLOT(onStandardOutputBytesWritten()) );
-    QObject::connect( _process, SIGNAL(readyReadStandardError()), this, SLOT(onStandardErrorBytesWritten()) );
-    QObject::connect( _process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onProcessError(QProcess::ProcessError)) );
-    QObject::connect( _process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onProcessEnd(int,QProcess::ExitStatus)) );
+    for (int i = 0; i < nProcesses; ++i) {
+        BackgroundRenderWorkerPtr worker = boost::make_shared<BackgroundRenderWorker>(i);
+
+        ///setup the server used to listen the output of the background process
+        QObject::connect( worker->ipcServer, SIGNAL(newConnection()), this, SLOT(onNewConnectionPending()) );
+        worker->ipcServerName = makeIPCServerName();
+        worker->ipcServer->listen(worker->ipcServerName);
 
+        ///connect the useful slots of the process
+        QObject::connect( worker->process, SIGNAL(readyReadStandardOutput()), this, SLOT(onStandardOutputBytesWritten()) );
+        QObject::connect( worker->process, SIGNAL(readyReadStandardError()), this, SLOT(onStandardErrorBytesWritten()) );
+        QObject::connect( worker->process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onProcessError(QProcess::ProcessError)) );
+        QObject::connect( worker->process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onProcessEnd(int,QProcess::ExitStatus)) );
 
-    ///start the process
-    _processLog.push_back( tr("Starting background rendering: %1 %2")
-                           .arg( QCoreApplication::applicationFilePath() )
-                           .arg( _processArgs.join( QString::fromUtf8(" ") ) ) );
+        _workers.push_back(worker);
+    }
 }
 
 ProcessHandler::~ProcessHandler()
 {
     Q_EMIT deleted();
 
-    if (_ipcServer) {
-        _ipcServer->close();
-        delete _ipcServer;
-    }
-    if (_bgProcessInputSocket) {
-        _bgProcessInputSocket->close();
-        delete _bgProcessInputSocket;
+    _workers.clear();
+}
+
+BackgroundRenderWorker*
+ProcessHandler::getWorkerFromSender(QObject* sender) const
+{
+    for (std::size_t i = 0; i < _workers.size(); ++i) {
+        BackgroundRenderWorker* w = _workers[i].get();
+        if ( (sender == w->process) || (sender == w->ipcServer) || (sender == w->bgProcessOutputSocket) || (sender == w->bgProcessInputSocket) ) {
+            return w;
+        }
     }
-    if (_process) {
-        _process->close();
-        delete _process;
+
+    return 0;
+}
+
+void
+ProcessHandler::appendToLog(const BackgroundRenderWorker* worker,
+                            const QString& str)
+{
+    if (_workers.size() > 1) {
+        _processLog.append( QString::fromUtf8("[Process %1] ").arg(worker->index + 1) );
     }
+    _processLog.append(str);
 }
 
 void
 ProcessHandler::startProcess()
 {
-    _process->start(QCoreApplication::applicationFilePath(), _processArgs);
+    for (std::size_t i = 0; i < _workers.size(); ++i) {
+        if ( !startNextChunk( _workers[i].get() ) ) {
+            break;
+        }
+    }
+}
+
+bool
+ProcessHandler::startNextChunk(BackgroundRenderWorker* worker)
+{
+    assert(!worker->running);
+
+    QStringList args = _processArgs;
+    if (_useFrameRange) {
+        int remaining = _nFrames - _nextFrameIndex;
+        if ( _canceled || (remaining <= 0) ) {
+            return false;
+        }
+
+        // Guided scheduling: hand out half of the fair share of what remains, so that chunks get smaller
+        // as the render progresses and a worker finishing early can take over frames of slower ones.
+        int chunkSize = remaining;
+        if (_workers.size() > 1) {
+            chunkSize = std::max( NATRON_BACKGROUND_RENDER_MIN_CHUNK_FRAMES, remaining / (2 * (int)_workers.size()) );
+            chunkSize = std::min(chunkSize, remaining);
+        }
+        worker->chunkFirstIndex = _nextFrameIndex;
+        worker->chunkLastIndex = _nextFrameIndex + chunkSize - 1;
+        _nextFrameIndex += chunkSize;
+
+        int chunkFirst = _firstFrame + worker->chunkFirstIndex * _frameStep;
+        int chunkLast = _firstFrame + worker->chunkLastIndex * _frameStep;
+        args << QString::fromUtf8("%1-%2:%3").arg(chunkFirst).arg(chunkLast).arg(_frameStep);
+    } else if (_canceled) {
+        return false;
+    }
+
+    // A previous chunk may have left its pipes open
+    worker->closeSockets();
+    worker->earlyCancel = false;
+    worker->running = true;
+
+    args << QString::fromUtf8("--IPCpipe") << worker->ipcServerName;
+
+    appendToLog( worker, tr("Starting background rendering: %1 %2\n")
+                 .arg( QCoreApplication::applicationFilePath() )
+                 .arg( args.join( QString::fromUtf8(" ") ) ) );
+    worker->process->start(QCoreApplication::applicationFilePath(), args);
+
+    return true;
+}
+
+bool
+ProcessHandler::hasRunningWorker() const
+{
+    for (std::size_t i = 0; i < _workers.size(); ++i) {
+        if (_workers[i]->running) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+ProcessHandler::setFailed(int returnCode)
+{
+    assert(returnCode != 0);
+    // Keep the first failure: the workers aborted because of it exit normally
+    if (_returnCode == 0) {
+        _returnCode = returnCode;
+    }
+}
+
+void
+ProcessHandler::finish()
+{
+    if (_finished) {
+        return;
+    }
+    _finished = true;
+    Q_EMIT processFinished(_returnCode);
 }
 
 const QString &
@@ -144,14 +331,46 @@ ProcessHandler::getProcessLog() const
 void
 ProcessHandler::onNewConnectionPending()
 {
-    ///accept only 1 connection!
-    if (_bgProcessOutputSocket) {
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+
+    ///accept only 1 connection per process!
+    if (!worker || worker->bgProcessOutputSocket) {
+        return;
+    }
+
+    worker->bgProcessOutputSocket = worker->ipcServer->nextPendingConnection();
+
+    QObject::connect( worker->bgProcessOutputSocket, SIGNAL(readyRead()), this, SLOT(onDataWrittenToSocket()) );
+}
+
+void
+ProcessHandler::onWorkerFrameRendered(BackgroundRenderWorker* worker,
+                                      int frame,
+                                      double progressPercent)
+{
+    if (!_useFrameRange) {
+        // We do not know the frame range, report the progress of the process as-is
+        ++_nFramesDone;
+        Q_EMIT frameRendered(frame, progressPercent);
+
         return;
     }
 
-    _bgProcessOutputSocket = _ipcServer->nextPendingConnection();
+    int frameIndex = (frame - _firstFrame) / _frameStep;
+    if ( (frameIndex < worker->chunkFirstIndex) || (frameIndex > worker->chunkLastIndex) || _framesDone[frameIndex] ) {
+        return;
+    }
+    _framesDone[frameIndex] = true;
+    ++_nFramesDone;
+    while ( (_contiguousFramesDone < _nFrames) && _framesDone[_contiguousFramesDone] ) {
+        ++_contiguousFramesDone;
+    }
 
-    QObject::connect( _bgProcessOutputSocket, SIGNAL(readyRead()), this, SLOT(onDataWrittenToSocket()) );
+    // The progress reported by the worker is relative to its chunk, ours is computed from the frames rendered.
+    // Frames are rendered out of order by the workers: report the last frame before which all frames are rendered,
+    // so that a render paused and restarted from that frame does not miss any frame.
+    int lastContiguousFrame = _contiguousFramesDone > 0 ? _firstFrame + (_contiguousFramesDone - 1) * _frameStep : _firstFrame;
+    Q_EMIT frameRendered( lastContiguousFrame, (double)_nFramesDone / _nFrames );
 }
 
 void
@@ -160,49 +379,56 @@ ProcessHandler::onDataWrittenToSocket()
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QString str = QString::fromUtf8( _bgProcessOutputSocket->readLine() );
-    while ( str.endsWith( QLatin1Char('\n') ) ) {
-        str.chop(1);
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+    if (!worker) {
+        return;
     }
-    _processLog.append( QString::fromUtf8("Message received: ") + str + QLatin1Char('\n') );
-    if ( str.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
-        str = str.remove( QString::fromUtf8(kFrameRenderedStringShort) );
-
-        double progressPercent = 0.;
-        int foundProgress = str.lastIndexOf( QString::fromUtf8(kProgressChangedStringShort) );
-        if (foundProgress != -1) {
-            QString progressStr = str.mid(foundProgress);
-            progressStr.remove( QString::fromUtf8(kProgressChangedStringShort) );
-            progressPercent = progressStr.toDouble();
-            str = str.mid(0, foundProgress);
-        }
-        if ( !str.isEmpty() ) {
-            //The report does not have extended timer infos
-            Q_EMIT frameRendered(str.toInt(), progressPercent);
-        }
-    } else if ( str.startsWith( QString::fromUtf8(kRenderingFinishedStringShort) ) ) {
-        ///don't do anything
-    } else if ( str.startsWith( QString::fromUtf8(kBgProcessServerCreatedShort) ) ) {
-        str = str.remove( QString::fromUtf8(kBgProcessServerCreatedShort) );
-        ///the bg process wants us to create the pipe for its input
-        if (!_bgProcessInputSocket) {
-            _bgProcessInputSocket = new QLocalSocket();
-            QObject::connect( _bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
-            _bgProcessInputSocket->connectToServer(str, QLocalSocket::ReadWrite);
+
+    while ( worker->bgProcessOutputSocket && worker->bgProcessOutputSocket->canReadLine() ) {
+        QString str = QString::fromUtf8( worker->bgProcessOutputSocket->readLine() );
+        while ( str.endsWith( QLatin1Char('\n') ) ) {
+            str.chop(1);
         }
-    } else if ( str.startsWith( QString::fromUtf8(kRenderingStartedShort) ) ) {
-        ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
-        ///message right away
-        if (_earlyCancel) {
-            _bgProcessInputSocket->waitForConnected(5000);
-            _earlyCancel = false;
-            onProcessCanceled();
+        appendToLog( worker, QString::fromUtf8("Message received: ") + str + QLatin1Char('\n') );
+        if ( str.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
+            str = str.remove( QString::fromUtf8(kFrameRenderedStringShort) );
+
+            double progressPercent = 0.;
+            int foundProgress = str.lastIndexOf( QString::fromUtf8(kProgressChangedStringShort) );
+            if (foundProgress != -1) {
+                QString progressStr = str.mid(foundProgress);
+                progressStr.remove( QString::fromUtf8(kProgressChangedStringShort) );
+                progressPercent = progressStr.toDouble();
+                str = str.mid(0, foundProgress);
+            }
+            if ( !str.isEmpty() ) {
+                //The report does not have extended timer infos
+                onWorkerFrameRendered( worker, str.toInt(), progressPercent );
+            }
+        } else if ( str.startsWith( QString::fromUtf8(kRenderingFinishedStringShort) ) ) {
+            ///don't do anything
+        } else if ( str.startsWith( QString::fromUtf8(kBgProcessServerCreatedShort) ) ) {
+            str = str.remove( QString::fromUtf8(kBgProcessServerCreatedShort) );
+            ///the bg process wants us to create the pipe for its input
+            if (!worker->bgProcessInputSocket) {
+                worker->bgProcessInputSocket = new QLocalSocket();
+                QObject::connect( worker->bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
+                worker->bgProcessInputSocket->connectToServer(str, QLocalSocket::ReadWrite);
+            }
+        } else if ( str.startsWith( QString::fromUtf8(kRenderingStartedShort) ) ) {
+            ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
+            ///message right away
+            if (worker->earlyCancel) {
+                worker->bgProcessInputSocket->waitForConnected(5000);
+                worker->earlyCancel = false;
+                sendAbortToWorker(worker);
+            }
+        } else {
+            appendToLog( worker, QString::fromUtf8("Error: Unable to interpret message.\n") );
+            throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
         }
-    } else {
-        _processLog.append( QString::fromUtf8("Error: Unable to interpret message.\n") );
-        throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
     }
-}
+} // ProcessHandler::onDataWrittenToSocket
 
 void
 ProcessHandler::onInputPipeConnectionMade()
@@ -210,29 +436,55 @@ ProcessHandler::onInputPipeConnectionMade()
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    _processLog.append( QString::fromUtf8("The input channel (the one the bg process listens to) was successfully created and connected.\n") );
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+    if (!worker) {
+        return;
+    }
+    appendToLog( worker, QString::fromUtf8("The input channel (the one the bg process listens to) was successfully created and connected.\n") );
 }
 
 void
 ProcessHandler::onStandardOutputBytesWritten()
 {
-    QString str = QString::fromUtf8( _process->readAllStandardOutput().data() );
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+    if (!worker) {
+        return;
+    }
+    QString str = QString::fromUtf8( worker->process->readAllStandardOutput().data() );
 
 #ifdef DEBUG
     qDebug() << "Message(stdout):" << str;
 #endif
-    _processLog.append(QString::fromUtf8("Message(stdout): ") + str);
+    appendToLog(worker, QString::fromUtf8("Message(stdout): ") + str);
 }
 
 void
 ProcessHandler::onStandardErrorBytesWritten()
 {
-    QString str = QString::fromUtf8( _process->readAllStandardError().data() );
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+    if (!worker) {
+        return;
+    }
+    QString str = QString::fromUtf8( worker->process->readAllStandardError().data() );
 
 #ifdef DEBUG
     qDebug() << "Message(stderr):" << str;
 #endif
-    _processLog.append(QString::fromUtf8("Error(stderr): ") + str);
+    appendToLog(worker, QString::fromUtf8("Error(stderr): ") + str);
+}
+
+void
+ProcessHandler::sendAbortToWorker(BackgroundRenderWorker* worker)
+{
+    if (!worker->running) {
+        return;
+    }
+    if (!worker->bgProcessInputSocket) {
+        worker->earlyCancel = true;
+    } else {
+        worker->bgProcessInputSocket->write( ( QString::fromUtf8(kAbortRenderingStringShort) + QLatin1Char('\n') ).toUtf8() );
+        worker->bgProcessInputSocket->flush();
+    }
 }
 
 void
@@ -240,11 +492,9 @@ ProcessHandler::onProcessCanceled()
 {
     Q_EMIT processCanceled();
 
-    if (!_bgProcessInputSocket) {
-        _earlyCancel = true;
-    } else {
-        _bgProcessInputSocket->write( ( QString::fromUtf8(kAbortRenderingStringShort) + QLatin1Char('\n') ).toUtf8() );
-        _bgProcessInputSocket->flush();
+    _canceled = true;
+    for (std::size_t i = 0; i < _workers.size(); ++i) {
+        sendAbortToWorker( _workers[i].get() );
     }
 }
 
@@ -252,7 +502,22 @@ void
 ProcessHandler::onProcessError(QProcess::ProcessError err)
 {
     if (err == QProcess::FailedToStart) {
-        Dialogs::errorDialog( _writer->getScriptName(), tr("The render process failed to start.").toStdString() );
+        BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+        if (worker) {
+            // finished() is not emitted for a process that could not start
+            worker->running = false;
+        }
+        setFailed(1);
+        if (!_canceled) {
+            _canceled = true;
+            Dialogs::errorDialog( _writer->getScriptName(), tr("The render process failed to start.").toStdString() );
+            for (std::size_t i = 0; i < _workers.size(); ++i) {
+                sendAbortToWorker( _workers[i].get() );
+            }
+        }
+        if ( !hasRunningWorker() ) {
+            finish();
+        }
     } else if (err == QProcess::Crashed) {
         //@TODO: find out a way to get the backtrace
     }
@@ -262,15 +527,43 @@ void
 ProcessHandler::onProcessEnd(int exitCode,
                              QProcess::ExitStatus stat)
 {
-    int returnCode = 0;
+    BackgroundRenderWorker* worker = getWorkerFromSender( sender() );
+    if (!worker) {
+        return;
+    }
+    worker->running = false;
 
+    int returnCode = 0;
     if (stat == QProcess::CrashExit) {
         returnCode = 2;
     } else if (exitCode == 1) {
         returnCode = 1;
     }
-    Q_EMIT processFinished(returnCode);
-}
+
+    if (returnCode != 0) {
+        // A failing worker fails the whole render: stop the other ones
+        setFailed(returnCode);
+        if (!_canceled) {
+            _canceled = true;
+            for (std::size_t i = 0; i < _workers.size(); ++i) {
+                sendAbortToWorker( _workers[i].get() );
+            }
+        }
+        if ( !hasRunningWorker() ) {
+            finish();
+        }
+
+        return;
+    }
+
+    // The worker is done with its chunk, give it the next one if any
+    if ( startNextChunk(worker) ) {
+        return;
+    }
+    if ( !hasRunningWorker() ) {
+        finish();
+    }
+} // ProcessHandler::onProcessEnd
 
 ProcessInputChannel::ProcessInputChannel(const QString & mainProcessServerName)
     : QThread()
@@ -437,6 +730,205 @@ ProcessInputChannel::onOutputPipeConnectionMade()
     qDebug() << "The output channel was successfully created and connected.";
 }
 
+RenderServer::RenderServer(const QString& serverName)
+    : _serverName(serverName)
+    , _clientMutex()
+    , _client(0)
+    , _loadedProjectFilePath()
+    , _loadedProjectLastModified()
+    , _loadedParamValues()
+{
+}
+
+RenderServer::~RenderServer()
+{
+}
+
+void
+RenderServer::writeToClient(const QString & message)
+{
+    QMutexLocker l(&_clientMutex);
+
+    if (!_client) {
+        return;
+    }
+    _client->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    _client->flush();
+}
+
+int
+RenderServer::exec(const AppInstancePtr& app)
+{
+    QLocalServer server;
+
+    // Remove the socket left by a server that did not quit properly
+    QLocalServer::removeServer(_serverName);
+    if ( !server.listen(_serverName) ) {
+        std::cerr << tr("Error: The render server could not listen to %1: %2").arg(_serverName).arg( server.errorString() ).toStdString() << std::endl;
+
+        return 1;
+    }
+    std::cout << tr("Render server waiting for jobs on %1").arg( server.fullServerName() ).toStdString() << std::endl;
+
+    for (;;) {
+        if ( !server.waitForNewConnection(-1) ) {
+            std::cerr << tr("Error: The render server stopped listening: %1").arg( server.errorString() ).toStdString() << std::endl;
+
+            return 1;
+        }
+        QLocalSocket* client = server.nextPendingConnection();
+        if (!client) {
+            continue;
+        }
+        bool mustQuit = serveClient(app, client);
+        delete client;
+        if (mustQuit) {
+            break;
+        }
+    }
+    server.close();
+
+    return 0;
+}
+
+bool
+RenderServer::serveClient(const AppInstancePtr& app,
+                          QLocalSocket* client)
+{
+    RenderServerJob job;
+
+    {
+        QMutexLocker l(&_clientMutex);
+        _client = client;
+    }
+    bool mustQuit = false;
+    while (!mustQuit) {
+        if ( !client->canReadLine() ) {
+            if ( client->state() != QLocalSocket::ConnectedState ) {
+                break;
+            }
+            client->waitForReadyRead(100);
+            continue;
+        }
+        QString str = QString::fromUtf8( client->readLine() ).trimmed();
+        if ( str.isEmpty() ) {
+            continue;
+        }
+        int firstSpace = str.indexOf( QLatin1Char(' ') );
+        QString command = (firstSpace == -1) ? str : str.left(firstSpace);
+        QString value = (firstSpace == -1) ? QString() : str.mid(firstSpace + 1).trimmed();
+
+        if ( command == QString::fromUtf8(kRenderServerProject) ) {
+            job.projectFilePath = value;
+        } else if ( command == QString::fromUtf8(kRenderServerWriter) ) {
+            job.writers.push_back( value.toStdString() );
+        } else if ( command == QString::fromUtf8(kRenderServerFrameRange) ) {
+            if ( !CLArgs::parseFrameRanges(value, &job.frameRanges) && job.error.isEmpty() ) {
+                job.error = tr("Invalid frame range: %1").arg(value);
+            }
+        } else if ( command == QString::fromUtf8(kRenderServerSetParam) ) {
+            int space = value.indexOf( QLatin1Char(' ') );
+            if (space == -1) {
+                if ( job.error.isEmpty() ) {
+                    job.error = tr("Expected <node>.<param> <value>: %1").arg(value);
+                }
+            } else {
+                job.paramValues.push_back( std::make_pair( value.left(space).toStdString(), value.mid(space + 1).trimmed().toStdString() ) );
+            }
+        } else if ( command == QString::fromUtf8(kRenderServerRenderStats) ) {
+            job.enableRenderStats = true;
+        } else if ( command == QString::fromUtf8(kRenderServerRender) ) {
+            if ( !job.error.isEmpty() ) {
+                std::cerr << job.error.toStdString() << std::endl;
+                writeToClient( QString::fromUtf8(kRenderServerJobErrorShort) + job.error );
+            } else {
+                try {
+                    renderJob(app, job);
+                    writeToClient( QString::fromUtf8(kRenderServerJobFinishedShort) );
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    writeToClient( QString::fromUtf8(kRenderServerJobErrorShort) + QString::fromUtf8( e.what() ) );
+                }
+            }
+            job = RenderServerJob();
+        } else if ( command == QString::fromUtf8(kRenderServerQuit) ) {
+            mustQuit = true;
+        } else if ( job.error.isEmpty() ) {
+            job.error = tr("Unable to interpret message: %1").arg(str);
+        }
+    }
+
+    {
+        QMutexLocker l(&_clientMutex);
+        _client = 0;
+    }
+
+    return mustQuit;
+} // RenderServer::serveClient
+
+void
+RenderServer::renderJob(const AppInstancePtr& app,
+                        const RenderServerJob& job)
+{
+    QFileInfo info(job.projectFilePath);
+
+    if ( !info.exists() ) {
+        throw std::invalid_argument( tr("%1: No such file.").arg(job.projectFilePath).toStdString() );
+    }
+    if ( info.suffix() != QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+        throw std::invalid_argument( tr("The render server only accepts .%1 project files.").arg( QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ).toStdString() );
+    }
+
+    // Re-use the loaded project if nothing changed: parameter values set by the previous job cannot be reverted,
+    // unless they are set again to the same values
+    QString filePath = info.canonicalFilePath();
+    QDateTime lastModified = info.lastModified();
+    if ( (filePath != _loadedProjectFilePath) ||
+         ( lastModified != _loadedProjectLastModified) ||
+         ( !_loadedParamValues.empty() && (_loadedParamValues != job.paramValues) ) ) {
+        _loadedProjectFilePath.clear();
+        _loadedParamValues.clear();
+        // Only create the nodes needed by the writers: the others are created if a later job needs them
+        if ( !job.writers.empty() ) {
+            app->getProject()->setLazyLoadOutputs(job.writers);
+        }
+        if ( !app->getProject()->loadProject( info.path(), info.fileName() ) ) {
+            throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
+        }
+        _loadedProjectFilePath = filePath;
+        _loadedProjectLastModified = lastModified;
+    } else {
+        std::cout << tr("Re-using the loaded project %1").arg(filePath).toStdString() << std::endl;
+    }
+
+    for (std::list<std::pair<std::string, std::string> >::const_iterator it = job.paramValues.begin(); it != job.paramValues.end(); ++it) {
+        std::size_t lastDot = it->first.find_last_of('.');
+        if ( (lastDot == std::string::npos) || (lastDot == 0) || (lastDot == it->first.size() - 1) ) {
+            throw std::invalid_argument( tr("Expected <node>.<param>: %1").arg( QString::fromUtf8( it->first.c_str() ) ).toStdString() );
+        }
+        std::string nodeName = it->first.substr(0, lastDot);
+        std::string paramName = it->first.substr(lastDot + 1);
+        NodePtr node = app->getNodeByFullySpecifiedName(nodeName);
+        if ( !node || !node->getKnobByName(paramName) ) {
+            // The project must be loaded again by the next job since it may have been modified by the previous values
+            _loadedProjectFilePath.clear();
+            throw std::invalid_argument( tr("%1 does not belong to the project file.").arg( QString::fromUtf8( it->first.c_str() ) ).toStdString() );
+        }
+
+        // The value is given in Python so that the parameters of any type and dimension can be set
+        std::string script = app->getAppIDString() + "." + nodeName + ".getParam(\"" + paramName + "\").set(" + it->second + ")\n";
+        std::string err;
+        if ( !NATRON_PYTHON_NAMESPACE::interpretPythonScript(script, &err, 0) ) {
+            _loadedProjectFilePath.clear();
+            throw std::invalid_argument( tr("Failed to set %1: %2").arg( QString::fromUtf8( it->first.c_str() ) ).arg( QString::fromUtf8( err.c_str() ) ).toStdString() );
+        }
+    }
+    _loadedParamValues = job.paramValues;
+
+    // Blocking call
+    app->startWritersRenderingFromNames(job.enableRenderStats, true, job.writers, job.frameRanges);
+} // RenderServer::renderJob
+
 NATRON_NAMESPACE_EXIT
 
 NATRON_NAMESPACE_USING
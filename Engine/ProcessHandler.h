@@ -27,13 +27,24 @@
 
 #include "Global/Macros.h"
 
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
 CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QDateTime>
 #include <QtCore/QProcess>
 #include <QtCore/QThread>
 #include <QtCore/QStringList>
 #include <QtCore/QString>
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
+#include <QtCore/QCoreApplication>
 CLANG_DIAG_ON(deprecated)
 
 #include "Global/GlobalDefines.h"
@@ -78,33 +89,51 @@ NATRON_NAMESPACE_ENTER
  *
  * NB: Message that are exchanged via this channel consists of exactly 1 line, i.e a
  * string terminated with the \n character.
+ *
+ * A ProcessHandler may drive several background processes at once: the frame range of the writer
+ * is then split into chunks which are handed out to K worker processes. Each worker has its own
+ * IPC server and pipes, exactly as described above. Chunks are handed out on demand with a decreasing
+ * size (guided scheduling): when a worker finishes its chunk early, it is restarted on the next
+ * chunk of the remaining frames, so that all workers finish at about the same time. The progress
+ * of all workers is merged and reported through the frameRendered signal as if there was a single process.
  **/
+struct BackgroundRenderWorker;
+typedef boost::shared_ptr<BackgroundRenderWorker> BackgroundRenderWorkerPtr;
+
 class ProcessHandler
     : public QObject
 {
     Q_OBJECT
 
-    QProcess* _process; //< the process executing the render
     OutputEffectInstance* _writer; //< pointer to the writer that will render in the bg process
-    QLocalServer* _ipcServer; //< the server for IPC with the background process
-    QLocalSocket* _bgProcessOutputSocket; //< the socket where data is output by the process
-
-    //the socket where data is read by the process
-    //note that this socket is initialized only when the background process sends the message
-    //kBgProcessServerCreatedShort, meaning it created its server for the input pipe and we can actually open it.
-    QLocalSocket* _bgProcessInputSocket;
-    bool _earlyCancel; //< true if the user pressed cancel but the _bgProcessInput socket was not created yet
-    QString _processLog; //< used to record the log of the process
-    QStringList _processArgs;
+    std::vector<BackgroundRenderWorkerPtr> _workers; //< one per background process
+    QString _processLog; //< used to record the log of the processes
+    QStringList _processArgs; //< the arguments common to all processes, without the frame range
+    bool _useFrameRange; //< if false, the processes render the frame range of the writer
+    int _firstFrame, _lastFrame, _frameStep;
+    int _nFrames; //< number of frames to render in the range
+    int _nextFrameIndex; //< index of the first frame that was not handed out to any worker yet
+    std::vector<bool> _framesDone; //< for each frame index, whether it was rendered already
+    int _nFramesDone;
+    int _contiguousFramesDone; //< number of frames rendered from the start of the range without a hole
+    bool _canceled; //< true once the user canceled, no more chunks are handed out
+    int _returnCode; //< the first non-zero return code of a worker, reported once all workers are done
+    bool _finished; //< true once processFinished was emitted
 
 public:
 
     /**
-     * @brief Starts a new process which will load the project specified by "projectPath".
-     * The process will render using the effect specified by writer.
+     * @brief Starts new processes which will load the project specified by "projectPath".
+     * The processes will render using the effect specified by writer.
+     * If firstFrame is negative, the processes render the frame range of the writer and nProcesses is ignored.
+     * Video writers are always rendered by a single process.
      **/
     ProcessHandler(const QString & projectPath,
-                   OutputEffectInstance* writer);
+                   OutputEffectInstance* writer,
+                   int firstFrame = -1,
+                   int lastFrame = -1,
+                   int frameStep = 1,
+                   int nProcesses = 1);
 
     virtual ~ProcessHandler();
 
@@ -114,6 +143,33 @@ public:
         return _writer;
     }
 
+    int getNumberOfProcesses() const
+    {
+        return (int)_workers.size();
+    }
+
+private:
+
+    BackgroundRenderWorker* getWorkerFromSender(QObject* sender) const;
+
+    /**
+     * @brief Hands out the next chunk of frames to the given worker and starts its process.
+     * @returns False if there was no frame left to render.
+     **/
+    bool startNextChunk(BackgroundRenderWorker* worker);
+
+    void onWorkerFrameRendered(BackgroundRenderWorker* worker, int frame, double progressPercent);
+
+    void appendToLog(const BackgroundRenderWorker* worker, const QString& str);
+
+    void sendAbortToWorker(BackgroundRenderWorker* worker);
+
+    bool hasRunningWorker() const;
+
+    void setFailed(int returnCode);
+
+    void finish();
+
 public Q_SLOTS:
 
     /**
@@ -161,7 +217,7 @@ public Q_SLOTS:
     void onInputPipeConnectionMade();
 
     /**
-     * @brief Start the process execution
+     * @brief Start the process(es) execution
      **/
     void startProcess();
 
@@ -174,7 +230,7 @@ Q_SIGNALS:
     void processCanceled();
 
     /**
-     * @brief Emitted when the process terminates. The parameter contains a return code:
+     * @brief Emitted when all processes terminated. The parameter contains a return code:
      * 0: Everything went OK
      * 1: Underminated error
      * 2: Crash.
@@ -256,6 +312,97 @@ private:
     bool _mustQuit;
 };
 
+/**
+ * @brief A render job received by a RenderServer: the equivalent of the command line of a NatronRenderer process.
+ **/
+struct RenderServerJob
+{
+    QString projectFilePath;
+    std::list<std::string> writers; //< if empty, all writers of the project are rendered
+    std::list<std::pair<int, std::pair<int, int> > > frameRanges; //< if empty, the frame range of each writer is rendered
+    std::list<std::pair<std::string, std::string> > paramValues; //< (node.param, Python value) set after loading the project
+    bool enableRenderStats;
+    QString error; //< the first line of the job that could not be interpreted, reported when the job is rendered
+
+    RenderServerJob()
+        : projectFilePath()
+        , writers()
+        , frameRanges()
+        , paramValues()
+        , enableRenderStats(false)
+        , error()
+    {
+    }
+};
+
+/**
+ * @brief Used by NatronRenderer --render-server <name> to stay resident and render the jobs sent by clients
+ * to a local server with the given name, so that the startup of the process, the loading of plug-ins and the loading
+ * of the project are paid once for many renders, and so that the image cache stays warm between renders.
+ *
+ * Like the ProcessHandler/ProcessInputChannel pipes, messages consist of exactly 1 line.
+ * A client connects to the server and sends the lines of a job:
+ * - kRenderServerProject <project file path> (required)
+ * - kRenderServerWriter <Write node script name> (optional, may be repeated)
+ * - kRenderServerFrameRange <frame ranges, in the command line format> (optional, may be repeated)
+ * - kRenderServerSetParam <node script name>.<param script name> <Python value> (optional, may be repeated)
+ * - kRenderServerRenderStats (optional)
+ * - kRenderServerRender: renders the job and starts a new one.
+ * While rendering, the server writes the kFrameRenderedStringShort messages of a background process to the client, then
+ * kRenderServerJobFinishedShort, or kRenderServerJobErrorShort followed by the error if the job failed.
+ * Exactly one of these two replies ends each job: a line of the job that cannot be interpreted makes the job fail
+ * without rendering, the error is only replied when kRenderServerRender is received.
+ * A client may send several jobs on the same connection. kRenderServerQuit stops the server.
+ *
+ * The project is only loaded again if it is another file, if the file changed or if the previous job set parameter
+ * values that this job does not set identically. Jobs are rendered one at a time in the order they are received.
+ **/
+class RenderServer
+{
+    Q_DECLARE_TR_FUNCTIONS(RenderServer)
+
+public:
+
+    RenderServer(const QString& serverName);
+
+    ~RenderServer();
+
+    /**
+     * @brief Listens to clients and renders their jobs with the given app until a client sends kRenderServerQuit.
+     * This is blocking and must be called on the main thread.
+     * @returns The exit code of the process.
+     **/
+    int exec(const AppInstancePtr& app);
+
+    /**
+     * @brief Writes a message to the client of the job being rendered, if any. This may be called from any thread.
+     **/
+    void writeToClient(const QString& message);
+
+private:
+
+    /**
+     * @brief Reads the messages of the given client until it disconnects.
+     * @returns True if the client asked the server to quit.
+     **/
+    bool serveClient(const AppInstancePtr& app, QLocalSocket* client);
+
+    /**
+     * @brief Loads the project of the job if needed, sets its parameter values and renders it.
+     * Throws an exception on failure.
+     **/
+    void renderJob(const AppInstancePtr& app, const RenderServerJob& job);
+
+    QString _serverName;
+    mutable QMutex _clientMutex;
+    QLocalSocket* _client; //< the client of the job being rendered
+
+    // The project currently loaded and the parameter values that were set on it
+    QString _loadedProjectFilePath;
+    QDateTime _loadedProjectLastModified;
+    std::list<std::pair<std::string, std::string> > _loadedParamValues;
+};
+
 NATRON_NAMESPACE_EXIT
 
 #endif // PROCESSHANDLER_H
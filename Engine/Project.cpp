@@ -35,6 +35,7 @@
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/scoped_ptr.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #endif
 
@@ -201,6 +202,24 @@ public:
 
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 
+// Beyond this number of journals, the next auto-save is a full one
+#define NATRON_AUTOSAVE_MAX_JOURNALS 20
+
+// The journal of "Foo.ntp.autosave" is "Foo.ntp.autojournal": it must not be mistaken for an auto-save
+static QString
+getAutoSaveJournalFilePath(const QString& autoSaveFilePath)
+{
+    QString autoSaveSuffix = QString::fromUtf8(".autosave");
+    QString journalSuffix = QString::fromUtf8(".autojournal");
+    int found = autoSaveFilePath.lastIndexOf(autoSaveSuffix);
+
+    if (found == -1) {
+        return autoSaveFilePath + journalSuffix;
+    }
+
+    return autoSaveFilePath.left(found) + journalSuffix + autoSaveFilePath.mid( found + autoSaveSuffix.size() );
+}
+
 bool
 Project::loadProject(const QString & path,
                      const QString & name,
@@ -230,6 +249,7 @@ Project::loadProject(const QString & path,
                 }
                 if ( (ret == eStandardButtonNo) || (ret == eStandardButtonEscape) ) {
                     QFile::remove(realPath + autosaveFileName);
+                    QFile::remove( getAutoSaveJournalFilePath(realPath + autosaveFileName) );
                 } else {
                     realName = autosaveFileName;
                     isAutoSave = true;
@@ -317,22 +337,40 @@ Project::loadProjectInternal(const QString & path,
         }
     }
 
+    // An auto-save may have a journal of the changes made after it was written
+    FStreamsSupport::ifstream journalFile;
+    if (isAutoSave) {
+        QString journalFilePath = getAutoSaveJournalFilePath(filePath);
+        if ( QFile::exists(journalFilePath) ) {
+            FStreamsSupport::open( &journalFile, journalFilePath.toStdString() );
+        }
+    }
+
     LoadProjectSplashScreen_RAII __raii_splashscreen__(getApp(), name);
 
     try {
         bool bgProject;
         boost::archive::xml_iarchive iArchive(ifile);
+        boost::scoped_ptr<boost::archive::xml_iarchive> journalArchive;
         {
             FlagSetter __raii_loadingProjectInternal__(true, &_imp->isLoadingProjectInternal, &_imp->isLoadingProjectMutex);
 
             iArchive >> boost::serialization::make_nvp("Background_project", bgProject);
             ProjectSerialization projectSerializationObj( getApp() );
             iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
+            if ( journalFile.is_open() && journalFile.good() ) {
+                journalArchive.reset( new boost::archive::xml_iarchive(journalFile) );
+                *journalArchive >> boost::serialization::make_nvp("Background_project", bgProject);
+                ProjectAutoSaveJournal journal( getApp() );
+                *journalArchive >> boost::serialization::make_nvp("Journal", journal);
+                journal.applyTo(&projectSerializationObj);
+            }
             ret = load(projectSerializationObj, name, path, mustSave);
         } // __raii_loadingProjectInternal__
 
         if (!bgProject) {
-            getApp()->loadProjectGui(isAutoSave, iArchive);
+            // The journal has the latest state of the GUI
+            getApp()->loadProjectGui(isAutoSave, journalArchive ? *journalArchive : iArchive);
         }
     } catch (...) {
         const ProjectBeingLoadedInfo& pInfo = getApp()->getProjectBeingLoadedInfo();
@@ -419,6 +457,14 @@ Project::saveProject_imp(const QString & path,
         }
     }
 
+    // A project with dormant nodes must be complete before it is written
+    if ( hasDormantNodes() ) {
+        if ( QThread::currentThread() != qApp->thread() ) {
+            return false;
+        }
+        loadDormantNodes();
+    }
+
     {
         QMutexLocker l(&_imp->isSavingProjectMutex);
         if (_imp->isSavingProject) {
@@ -443,12 +489,15 @@ Project::saveProject_imp(const QString & path,
 
             //}
         } else {
-            if (updateProjectProperties) {
-                ///Replace the last auto-save with a more recent one
-                removeLastAutosave();
-            }
+            // Only write the changes made since the last full auto-save when possible
+            if ( !updateProjectProperties || !saveAutoSaveJournal(&ret) ) {
+                if (updateProjectProperties) {
+                    ///Replace the last auto-save with a more recent one
+                    removeLastAutosave();
+                }
 
-            ret = saveProjectInternal(path, name, true, updateProjectProperties);
+                ret = saveProjectInternal(path, name, true, updateProjectProperties);
+            }
         }
     } catch (const std::exception & e) {
         if (!autoS) {
@@ -497,6 +546,7 @@ Project::saveProjectInternal(const QString & path,
                              bool updateProjectProperties)
 {
     bool isRenderSave = name.contains( QString::fromUtf8("RENDER_SAVE") );
+    bool isFullAutoSave = autoSave && updateProjectProperties && !isRenderSave;
     QDateTime time = QDateTime::currentDateTime();
     QString timeStr = time.toString();
     QString filePath;
@@ -568,7 +618,15 @@ Project::saveProjectInternal(const QString & path,
             bool bgProject = getApp()->isBackground();
             oArchive << boost::serialization::make_nvp("Background_project", bgProject);
             ProjectSerialization projectSerializationObj( getApp() );
-            save(&projectSerializationObj);
+            if (isFullAutoSave) {
+                // Re-use the serialization of the nodes that did not change since the last auto-save
+                std::list<NodeSerializationPtr> nodes, changedNodes;
+                std::list<std::string> nodeNames;
+                _imp->getAutoSaveNodesSerialization(&nodes, &changedNodes, &nodeNames);
+                projectSerializationObj.initialize(this, nodes);
+            } else {
+                save(&projectSerializationObj);
+            }
             oArchive << boost::serialization::make_nvp("Project", projectSerializationObj);
             if (!bgProject) {
                 AppInstancePtr app = getApp();
@@ -600,6 +658,10 @@ Project::saveProjectInternal(const QString & path,
 
     QFile::remove(tmpFilename);
 
+    if (isFullAutoSave) {
+        _imp->onFullAutoSaveWritten();
+    }
+
     if (!autoSave && updateProjectProperties) {
         QString lockFilePath = getLockAbsoluteFilePath();
         if ( QFile::exists(lockFilePath) ) {
@@ -631,6 +693,61 @@ Project::saveProjectInternal(const QString & path,
     return filePath;
 } // saveProjectInternal
 
+bool
+Project::saveAutoSaveJournal(QString* journalFilePath)
+{
+    QString autoSaveFilePath = getLastAutoSaveFilePath();
+    std::list<NodeSerializationPtr> nodes, changedNodes;
+    std::list<std::string> nodeNames;
+    int nJournals = _imp->getAutoSaveNodesSerialization(&nodes, &changedNodes, &nodeNames);
+
+    // Compact the journal in a full auto-save when it gets too big
+    if ( (nJournals < 0) || (nJournals >= NATRON_AUTOSAVE_MAX_JOURNALS) || ( changedNodes.size() * 2 > nodes.size() ) ||
+         autoSaveFilePath.isEmpty() || !QFile::exists(autoSaveFilePath) ) {
+        return false;
+    }
+
+    QString filePath = getAutoSaveJournalFilePath(autoSaveFilePath);
+    QString tmpFilePath = filePath + QString::fromUtf8(".tmp");
+    {
+        FStreamsSupport::ofstream ofile;
+        FStreamsSupport::open( &ofile, tmpFilePath.toStdString() );
+        if (!ofile) {
+            throw std::runtime_error( tr("Failed to open file ").toStdString() + tmpFilePath.toStdString() );
+        }
+
+        boost::archive::xml_oarchive oArchive(ofile);
+        bool bgProject = getApp()->isBackground();
+        oArchive << boost::serialization::make_nvp("Background_project", bgProject);
+        ProjectAutoSaveJournal journal( getApp() );
+        journal.initialize(this, nodeNames, changedNodes);
+        oArchive << boost::serialization::make_nvp("Journal", journal);
+        if (!bgProject) {
+            getApp()->saveProjectGui(oArchive);
+        }
+    }
+
+    // Replace the previous journal at once so that it is never read partially written
+    QFile::remove(filePath);
+    if ( !QFile::rename(tmpFilePath, filePath) ) {
+        QFile::remove(tmpFilePath);
+        throw std::runtime_error( "Failed to save to " + filePath.toStdString() );
+    }
+    _imp->onAutoSaveJournalWritten();
+
+    {
+        QMutexLocker l(&_imp->projectLock);
+        _imp->lastAutoSave = QDateTime::currentDateTime();
+    }
+    QString projectPath = QString::fromUtf8( _imp->getProjectPath().c_str() );
+    QString projectFilename = QString::fromUtf8( _imp->getProjectFilename().c_str() );
+    Q_EMIT projectNameChanged(projectPath + projectFilename, true);
+
+    *journalFilePath = filePath;
+
+    return true;
+} // Project::saveAutoSaveJournal
+
 void
 Project::autoSave()
 {
@@ -1652,6 +1769,38 @@ Project::refreshOpenGLRenderingFlagOnNodes()
     }
 }
 
+void
+Project::setLazyLoadOutputs(const std::list<std::string>& outputNodeNames)
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    _imp->lazyLoadOutputs = outputNodeNames;
+}
+
+bool
+Project::hasDormantNodes() const
+{
+    return !_imp->dormantNodes.empty();
+}
+
+void
+Project::loadDormantNodes()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    if ( _imp->dormantNodes.empty() ) {
+        return;
+    }
+
+    // Clear the list first: looking up nodes while restoring must not recurse in here
+    std::list<NodeSerializationPtr> nodes;
+    nodes.swap(_imp->dormantNodes);
+    {
+        CreatingNodeTreeFlag_RAII creatingNodeTreeFlag( getApp() );
+        std::map<std::string, bool> processedModules;
+        NodeCollectionSerialization::restoreFromSerialization(nodes, shared_from_this(), true, &processedModules);
+    }
+    forceComputeInputDependentDataOnAllTrees();
+}
+
 bool
 Project::isLoadingProject() const
 {
@@ -1788,7 +1937,9 @@ Project::removeLastAutosave()
 
     if ( !filepath.isEmpty() ) {
         QFile::remove(filepath);
+        QFile::remove( getAutoSaveJournalFilePath(filepath) );
     }
+    _imp->invalidateAutoSaveJournal();
 
     /*
      * Since we may have saved the project to an old project, overwriting the existing file, there might be
@@ -1801,6 +1952,10 @@ Project::removeLastAutosave()
     if ( QFile::exists(autoSaveFilePath) ) {
         QFile::remove(autoSaveFilePath);
     }
+    QString journalFilePath = getAutoSaveJournalFilePath(autoSaveFilePath);
+    if ( QFile::exists(journalFilePath) ) {
+        QFile::remove(journalFilePath);
+    }
 }
 
 void
@@ -1938,6 +2093,13 @@ Project::doResetEnd(bool aboutToQuit)
     }
 
 
+    _imp->dormantNodes.clear();
+    {
+        // The auto-save state holds references to the nodes
+        QMutexLocker k(&_imp->autoSaveStateMutex);
+        _imp->autoSaveNodes.clear();
+        _imp->autoSaveJournalsCount = -1;
+    }
     if (aboutToQuit) {
         clearNodesBlocking();
     } else {
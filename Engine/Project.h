@@ -93,6 +93,25 @@ public:
      **/
     bool loadProject(const QString & path, const QString & name, bool isUntitledAutosave = false, bool attemptToLoadAutosave = true);
 
+    /**
+     * @brief When set, the next project loaded only creates the nodes that the given output nodes depend upon.
+     * The other nodes are kept serialized ("dormant") until loadDormantNodes() is called, which happens
+     * automatically when one of them is looked up by name or before the project is saved.
+     * This is used by background renders of given writers to avoid instantiating the nodes they do not need.
+     * The list is cleared once the project is loaded.
+     **/
+    void setLazyLoadOutputs(const std::list<std::string>& outputNodeNames);
+
+    /**
+     * @brief Returns true if nodes of the project were not created yet, see setLazyLoadOutputs()
+     **/
+    bool hasDormantNodes() const;
+
+    /**
+     * @brief Creates the nodes that were left dormant when loading the project. Does nothing if there are none.
+     **/
+    void loadDormantNodes();
+
 
     /**
      * @brief Saves the project with the given path and name corresponding to a file on disk.
@@ -387,6 +406,13 @@ private:
 
     QString saveProjectInternal(const QString & path, const QString & name, bool autosave, bool updateProjectProperties);
 
+    /**
+     * @brief Writes next to the last full auto-save a journal of the changes made since. Returns false without writing
+     * anything if a full auto-save must be written instead, because there is none or because the journal would not be
+     * much smaller.
+     **/
+    bool saveAutoSaveJournal(QString* journalFilePath);
+
 
 
     void doResetEnd(bool aboutToQuit);
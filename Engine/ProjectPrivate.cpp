@@ -39,7 +39,9 @@
 #include "Engine/AppManager.h"
 #include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/Hash64.h"
 #include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
 #include "Engine/NodeSerialization.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/Project.h"
@@ -91,6 +93,12 @@ ProjectPrivate::ProjectPrivate(Project* project)
     , autoSaveTimer( new QTimer() )
     , projectClosing(false)
     , tlsData( new TLSHolder<Project::ProjectTLSData>() )
+    , renderWatchers()
+    , lazyLoadOutputs()
+    , dormantNodes()
+    , autoSaveStateMutex()
+    , autoSaveNodes()
+    , autoSaveJournalsCount(-1)
 
 {
     autoSaveTimer->setSingleShot(true);
@@ -197,8 +205,20 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
 
         /// 3) Restore the nodes
 
+        std::list<NodeSerializationPtr> nodesToRestore;
+        dormantNodes.clear();
+        // The project load callback may reference any node
+        if ( lazyLoadOutputs.empty() || !onProjectLoadCB->getValue().empty() ) {
+            nodesToRestore = obj.getNodesSerialization().getNodesSerialization();
+        } else {
+            NodeCollectionSerialization::getNodesNeededByOutputs(obj.getNodesSerialization().getNodesSerialization(), lazyLoadOutputs,
+                                                                 &nodesToRestore, &dormantNodes);
+        }
+
+        lazyLoadOutputs.clear();
+
         std::map<std::string, bool> processedModules;
-        ok = NodeCollectionSerialization::restoreFromSerialization(obj.getNodesSerialization().getNodesSerialization(),
+        ok = NodeCollectionSerialization::restoreFromSerialization(nodesToRestore,
                                                                    _publicInterface->shared_from_this(), true, &processedModules);
         for (std::map<std::string, bool>::iterator it = processedModules.begin(); it != processedModules.end(); ++it) {
             if (it->second) {
@@ -229,6 +249,113 @@ ProjectPrivate::restoreFromSerialization(const ProjectSerialization & obj,
     return ok;
 } // restoreFromSerialization
 
+// The signature of a node changes whenever something that is serialized with it changes: its parameters, its name,
+// its inputs, or for groups their children
+static void
+appendAutoSaveSignature(const NodePtr& node,
+                        Hash64* hash)
+{
+    hash->append( node->getKnobsAge() );
+    hash->append( node->getSerializationAge() );
+    hash->append( (U64)node->getEffectInstance()->getKnobs_mt_safe().size() );
+    Hash64_appendQString( hash, QString::fromUtf8( node->getScriptName_mt_safe().c_str() ) );
+    Hash64_appendQString( hash, QString::fromUtf8( node->getLabel_mt_safe().c_str() ) );
+
+    std::map<std::string, std::string> inputs;
+    node->getInputNames(inputs);
+    for (std::map<std::string, std::string>::iterator it = inputs.begin(); it != inputs.end(); ++it) {
+        Hash64_appendQString( hash, QString::fromUtf8( it->first.c_str() ) );
+        Hash64_appendQString( hash, QString::fromUtf8( it->second.c_str() ) );
+    }
+
+    NodesList children;
+    NodeGroup* isGroup = node->isEffectGroup();
+    if (isGroup) {
+        children = isGroup->getNodes();
+    }
+    node->getChildrenMultiInstance(&children);
+    hash->append( (U64)children.size() );
+    for (NodesList::iterator it = children.begin(); it != children.end(); ++it) {
+        appendAutoSaveSignature(*it, hash);
+    }
+}
+
+int
+ProjectPrivate::getAutoSaveNodesSerialization(std::list<NodeSerializationPtr>* nodes,
+                                              std::list<NodeSerializationPtr>* changedNodes,
+                                              std::list<std::string>* nodeNames)
+{
+    NodesList activeNodes;
+
+    _publicInterface->getActiveNodes(&activeNodes);
+
+    QMutexLocker k(&autoSaveStateMutex);
+    std::map<std::string, AutoSaveNodeState> states;
+    for (NodesList::iterator it = activeNodes.begin(); it != activeNodes.end(); ++it) {
+        // Same nodes as NodeCollectionSerialization::initialize
+        if ( (*it)->getParentMultiInstance() || !(*it)->isPartOfProject() ) {
+            continue;
+        }
+        Hash64 hash;
+        appendAutoSaveSignature(*it, &hash);
+        hash.computeHash();
+
+        std::string name = (*it)->getScriptName_mt_safe();
+        AutoSaveNodeState state;
+        std::map<std::string, AutoSaveNodeState>::iterator found = autoSaveNodes.find(name);
+        if ( found != autoSaveNodes.end() ) {
+            state = found->second;
+        }
+        // The roto and tracker data do not always make the knobs age change: always serialize them
+        bool hasContext = (*it)->getRotoContext() || (*it)->getTrackerContext();
+        if ( hasContext || !state.serialization || (state.node.lock() != *it) || (state.signature != hash.value()) ) {
+            state.node = *it;
+            state.signature = hash.value();
+            state.serialization = boost::make_shared<NodeSerialization>(*it);
+            state.changedSinceFullAutoSave = true;
+        }
+        nodes->push_back(state.serialization);
+        nodeNames->push_back(name);
+        if (state.changedSinceFullAutoSave) {
+            changedNodes->push_back(state.serialization);
+        }
+        states[name] = state;
+    }
+    // Forget the nodes that were removed
+    autoSaveNodes.swap(states);
+
+    return autoSaveJournalsCount;
+} // ProjectPrivate::getAutoSaveNodesSerialization
+
+void
+ProjectPrivate::onFullAutoSaveWritten()
+{
+    QMutexLocker k(&autoSaveStateMutex);
+
+    for (std::map<std::string, AutoSaveNodeState>::iterator it = autoSaveNodes.begin(); it != autoSaveNodes.end(); ++it) {
+        it->second.changedSinceFullAutoSave = false;
+    }
+    autoSaveJournalsCount = 0;
+}
+
+void
+ProjectPrivate::onAutoSaveJournalWritten()
+{
+    QMutexLocker k(&autoSaveStateMutex);
+
+    if (autoSaveJournalsCount >= 0) {
+        ++autoSaveJournalsCount;
+    }
+}
+
+void
+ProjectPrivate::invalidateAutoSaveJournal()
+{
+    QMutexLocker k(&autoSaveStateMutex);
+
+    autoSaveJournalsCount = -1;
+}
+
 bool
 ProjectPrivate::findFormat(int index,
                            Format* format) const
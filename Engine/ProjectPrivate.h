@@ -118,10 +118,56 @@ public:
 
     std::list<RenderWatcher> renderWatchers;
 
+    // only used on the main-thread, see Project::setLazyLoadOutputs()
+    std::list<std::string> lazyLoadOutputs;
+    std::list<NodeSerializationPtr> dormantNodes;
+
+    // What the auto-save knows of each top-level node, indexed by script-name, see getAutoSaveNodesSerialization()
+    struct AutoSaveNodeState
+    {
+        NodeWPtr node;
+        U64 signature;
+        NodeSerializationPtr serialization;
+        bool changedSinceFullAutoSave;
+
+        AutoSaveNodeState()
+            : node()
+            , signature(0)
+            , serialization()
+            , changedSinceFullAutoSave(true)
+        {
+        }
+    };
+
+    mutable QMutex autoSaveStateMutex; //< protects autoSaveNodes and autoSaveJournalsCount
+    std::map<std::string, AutoSaveNodeState> autoSaveNodes;
+    int autoSaveJournalsCount; //< journals written since the last full auto-save, -1 if there is no full auto-save to write a journal for
+
     ProjectPrivate(Project* project);
 
     bool restoreFromSerialization(const ProjectSerialization & obj, const QString& name, const QString& path, bool* mustSave);
 
+    /**
+     * @brief Returns the serialization of the top-level nodes, in nodes. The serialization made by the previous
+     * auto-save is re-used for the nodes that did not change since, so that their parameters are not read again.
+     * changedNodes is set to the nodes that changed since the last full auto-save and nodeNames to the names of
+     * all top-level nodes.
+     * Returns the number of journals written since the last full auto-save, or -1 if there is none.
+     **/
+    int getAutoSaveNodesSerialization(std::list<NodeSerializationPtr>* nodes,
+                                      std::list<NodeSerializationPtr>* changedNodes,
+                                      std::list<std::string>* nodeNames);
+
+    void onFullAutoSaveWritten();
+
+    void onAutoSaveJournalWritten();
+
+    /**
+     * @brief Called when the last auto-save is removed or replaced by something else than an auto-save:
+     * the next auto-save must be a full one.
+     **/
+    void invalidateAutoSaveJournal();
+
     bool findFormat(int index, Format* format) const;
     bool findFormat(const std::string& formatSpec, Format* format) const;
     /**
@@ -41,6 +41,21 @@ ProjectSerialization::initialize(const Project* project)
 
     _nodes.initialize(*project);
 
+    initializeSettings(project);
+}
+
+void
+ProjectSerialization::initialize(const Project* project,
+                                 const std::list<NodeSerializationPtr>& nodes)
+{
+    _nodes.setNodesSerialization(nodes);
+
+    initializeSettings(project);
+}
+
+void
+ProjectSerialization::initializeSettings(const Project* project)
+{
     project->getAdditionalFormats(&_additionalFormats);
 
     std::vector<KnobIPtr> knobs = project->getKnobs_mt_safe();
@@ -61,4 +76,34 @@ ProjectSerialization::initialize(const Project* project)
     _creationDate = project->getProjectCreationTime();
 }
 
+void
+ProjectSerialization::applyAutoSaveJournal(const ProjectSerialization& journal,
+                                           const std::list<std::string>& nodeNames)
+{
+    std::map<std::string, NodeSerializationPtr> nodesByName;
+    const std::list<NodeSerializationPtr>& fullNodes = _nodes.getNodesSerialization();
+
+    for (std::list<NodeSerializationPtr>::const_iterator it = fullNodes.begin(); it != fullNodes.end(); ++it) {
+        nodesByName[(*it)->getNodeScriptName()] = *it;
+    }
+    const std::list<NodeSerializationPtr>& changedNodes = journal._nodes.getNodesSerialization();
+    for (std::list<NodeSerializationPtr>::const_iterator it = changedNodes.begin(); it != changedNodes.end(); ++it) {
+        nodesByName[(*it)->getNodeScriptName()] = *it;
+    }
+
+    std::list<NodeSerializationPtr> nodes;
+    for (std::list<std::string>::const_iterator it = nodeNames.begin(); it != nodeNames.end(); ++it) {
+        std::map<std::string, NodeSerializationPtr>::const_iterator found = nodesByName.find(*it);
+        if ( found != nodesByName.end() ) {
+            nodes.push_back(found->second);
+        }
+    }
+    _nodes.setNodesSerialization(nodes);
+
+    _additionalFormats = journal._additionalFormats;
+    _projectKnobs = journal._projectKnobs;
+    _timelineCurrent = journal._timelineCurrent;
+    _creationDate = journal._creationDate;
+}
+
 NATRON_NAMESPACE_EXIT
@@ -41,6 +41,7 @@ GCC_DIAG_OFF(unused-parameter)
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/scoped_ptr.hpp>
 #include <boost/serialization/split_member.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/version.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 GCC_DIAG_ON(unused-parameter)
@@ -68,6 +69,8 @@ GCC_DIAG_ON(unused-parameter)
 #define PROJECT_SERIALIZATION_CHANGE_VERSION_SERIALIZATION 6
 #define PROJECT_SERIALIZATION_VERSION PROJECT_SERIALIZATION_CHANGE_VERSION_SERIALIZATION
 
+#define PROJECT_AUTOSAVE_JOURNAL_VERSION 1
+
 NATRON_NAMESPACE_ENTER
 
 class ProjectBeingLoadedInfo
@@ -129,6 +132,18 @@ public:
 
     void initialize(const Project* project);
 
+    /**
+     * @brief Same as initialize(project) except that the given serialization of the top-level nodes is used
+     **/
+    void initialize(const Project* project, const std::list<NodeSerializationPtr>& nodes);
+
+    /**
+     * @brief Replaces the project settings by the ones of the journal and the nodes by the ones it contains.
+     * nodeNames are the names of the top-level nodes when the journal was written: the nodes that are not listed are
+     * removed and the nodes are re-ordered accordingly.
+     **/
+    void applyAutoSaveJournal(const ProjectSerialization& journal, const std::list<std::string>& nodeNames);
+
     SequenceTime getCurrentTime() const
     {
         return _timelineCurrent;
@@ -154,6 +169,12 @@ public:
         return _creationDate;
     }
 
+private:
+
+    void initializeSettings(const Project* project);
+
+public:
+
     friend class ::boost::serialization::access;
     template<class Archive>
     void save(Archive & ar,
@@ -299,8 +320,53 @@ public:
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
+/**
+ * @brief An auto-save journal lists the changes made to the project since the last full auto-save, which it
+ * is written next to: the project settings, the names of all the top-level nodes and the serialization of the
+ * nodes that changed only.
+ **/
+class ProjectAutoSaveJournal
+{
+    std::list<std::string> _nodeNames;
+    ProjectSerialization _project;
+
+public:
+
+    ProjectAutoSaveJournal(const AppInstancePtr& app)
+        : _nodeNames()
+        , _project(app)
+    {
+    }
+
+    void initialize(const Project* project,
+                    const std::list<std::string>& nodeNames,
+                    const std::list<NodeSerializationPtr>& changedNodes)
+    {
+        _nodeNames = nodeNames;
+        _project.initialize(project, changedNodes);
+    }
+
+    /**
+     * @brief Applies the journal to the serialization of the last full auto-save
+     **/
+    void applyTo(ProjectSerialization* fullAutoSave) const
+    {
+        fullAutoSave->applyAutoSaveJournal(_project, _nodeNames);
+    }
+
+    friend class ::boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar,
+                   const unsigned int /*version*/)
+    {
+        ar & ::boost::serialization::make_nvp("NodeNames", _nodeNames);
+        ar & ::boost::serialization::make_nvp("Project", _project);
+    }
+};
+
 NATRON_NAMESPACE_EXIT
 
 BOOST_CLASS_VERSION(NATRON_NAMESPACE::ProjectSerialization, PROJECT_SERIALIZATION_VERSION)
+BOOST_CLASS_VERSION(NATRON_NAMESPACE::ProjectAutoSaveJournal, PROJECT_AUTOSAVE_JOURNAL_VERSION)
 
 #endif // PROJECTSERIALIZATION_H
@@ -29,6 +29,7 @@
 
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
+#include "Engine/Project.h"
 #include "Engine/PyNode.h"
 #include "Engine/ReadNode.h"
 NATRON_NAMESPACE_ENTER
@@ -56,6 +57,14 @@ Group::getNode(const QString& fullySpecifiedName) const
         return 0;
     }
     NodePtr node = _collection.lock()->getNodeByFullySpecifiedName( fullySpecifiedName.toStdString() );
+    if (!node) {
+        // The node may not have been created yet, see Project::setLazyLoadOutputs()
+        ProjectPtr isProject = boost::dynamic_pointer_cast<Project>( _collection.lock() );
+        if ( isProject && isProject->hasDormantNodes() ) {
+            isProject->loadDormantNodes();
+            node = isProject->getNodeByFullySpecifiedName( fullySpecifiedName.toStdString() );
+        }
+    }
     if ( node && node->isActivated() ) {
         return new Effect(node);
     } else {
@@ -72,6 +81,11 @@ Group::getChildren() const
         return ret;
     }
 
+    ProjectPtr isProject = boost::dynamic_pointer_cast<Project>( _collection.lock() );
+    if (isProject) {
+        isProject->loadDormantNodes();
+    }
+
     NodesList nodes = _collection.lock()->getNodes();
 
     for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
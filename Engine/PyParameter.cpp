@@ -25,8 +25,15 @@
 #include "PyParameter.h"
 
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <boost/math/special_functions/fpclassify.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
+
 #include "Engine/EffectInstance.h"
 #include "Engine/Node.h"
 #include "Engine/AppInstance.h"
@@ -580,6 +587,145 @@ AnimatedParam::setInterpolationAtTime(double time,
     return knob->setInterpolationAtTime(eCurveChangeReasonInternal, ViewSpec::current(), dimension, time, interpolation, &newKey);
 }
 
+std::vector<double>
+AnimatedParam::getKeyTimes(int dimension) const
+{
+    std::vector<double> ret;
+    KnobIPtr knob = getInternalKnob();
+
+    if ( !knob || (dimension < 0) || ( dimension >= knob->getDimension() ) ) {
+        return ret;
+    }
+    CurvePtr curve = knob->getCurve(ViewSpec::current(), dimension);
+    if (!curve) {
+        return ret;
+    }
+    KeyFrameSet keys = curve->getKeyFrames_mt_safe();
+    ret.reserve( keys.size() );
+    for (KeyFrameSet::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        ret.push_back( it->getTime() );
+    }
+
+    return ret;
+}
+
+std::vector<double>
+AnimatedParam::getKeyValues(int dimension) const
+{
+    std::vector<double> ret;
+    KnobIPtr knob = getInternalKnob();
+
+    if ( !knob || (dimension < 0) || ( dimension >= knob->getDimension() ) ) {
+        return ret;
+    }
+    CurvePtr curve = knob->getCurve(ViewSpec::current(), dimension);
+    if (!curve) {
+        return ret;
+    }
+    KeyFrameSet keys = curve->getKeyFrames_mt_safe();
+    ret.reserve( keys.size() );
+    for (KeyFrameSet::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        ret.push_back( it->getValue() );
+    }
+
+    return ret;
+}
+
+template <typename T>
+static void
+getKnobValuesAtTimes(Knob<T>* knob,
+                     const std::vector<double>& times,
+                     int dimension,
+                     std::vector<double>* values)
+{
+    values->resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        (*values)[i] = (double)knob->getValueAtTime(times[i], dimension);
+    }
+}
+
+std::vector<double>
+AnimatedParam::getValuesAtTimes(const std::vector<double>& times,
+                                int dimension) const
+{
+    std::vector<double> ret;
+    KnobIPtr knob = getInternalKnob();
+
+    if ( !knob || (dimension < 0) || ( dimension >= knob->getDimension() ) ) {
+        return ret;
+    }
+    KnobDoubleBase* isDouble = dynamic_cast<KnobDoubleBase*>( knob.get() );
+    KnobIntBase* isInt = dynamic_cast<KnobIntBase*>( knob.get() );
+    KnobBoolBase* isBool = dynamic_cast<KnobBoolBase*>( knob.get() );
+    if (isDouble) {
+        getKnobValuesAtTimes(isDouble, times, dimension, &ret);
+    } else if (isInt) {
+        getKnobValuesAtTimes(isInt, times, dimension, &ret);
+    } else if (isBool) {
+        getKnobValuesAtTimes(isBool, times, dimension, &ret);
+    }
+
+    return ret;
+}
+
+bool
+AnimatedParam::setValuesAtTimes(const std::vector<double>& times,
+                                const std::vector<double>& values,
+                                int dimension)
+{
+    KnobIPtr knob = getInternalKnob();
+
+    if ( !knob || ( times.size() != values.size() ) || (dimension < 0) || ( dimension >= knob->getDimension() ) ) {
+        return false;
+    }
+    // String keyframes hold indices in the knob's string table, they cannot be given as numbers
+    if ( !knob->canAnimate() || !knob->isAnimationEnabled() || dynamic_cast<AnimatingKnobStringHelper*>( knob.get() ) ) {
+        return false;
+    }
+    CurvePtr curve = knob->getCurve(ViewSpec::current(), dimension, true);
+    if (!curve) {
+        return false;
+    }
+    if ( times.empty() ) {
+        return true;
+    }
+
+    // Same rounding as Knob::makeKeyFrame, and the interpolation of Curve::addKeyFrame for the new keyframes
+    bool clampToIntegers = curve->areKeyFramesValuesClampedToIntegers();
+    bool clampToBooleans = curve->areKeyFramesValuesClampedToBooleans();
+    KeyframeTypeEnum interpolation = (clampToIntegers || clampToBooleans) ? eKeyframeTypeConstant : eKeyframeTypeSmooth;
+
+    KeyFrameSet keys = curve->getKeyFrames_mt_safe();
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        double value = values[i];
+        if ( !(boost::math::isfinite)(value) || !(boost::math::isfinite)(times[i]) ) {
+            continue;
+        }
+        if (clampToIntegers) {
+            value = std::floor(value + 0.5);
+        } else if (clampToBooleans) {
+            value = (value != 0.) ? 1. : 0.;
+        }
+        KeyFrame key(times[i], value, 0., 0., interpolation);
+        std::pair<KeyFrameSet::iterator, bool> inserted = keys.insert(key);
+        if (!inserted.second) {
+            // Only the value of an existing keyframe changes: keep its interpolation and tangents
+            KeyFrame replaced = *inserted.first;
+            replaced.setValue(value);
+            keys.erase(inserted.first);
+            keys.insert(replaced);
+        }
+    }
+
+    // Build the new curve aside then clone it on the knob: this emits a single value change,
+    // instead of one per keyframe with setValueAtTime
+    Curve newCurve(*curve);
+    newCurve.setKeyframes(keys, true);
+    knob->cloneCurve(ViewSpec::current(), dimension, newCurve);
+
+    return true;
+} // AnimatedParam::setValuesAtTimes
+
 void
 Param::_addAsDependencyOf(int fromExprDimension,
                           Param* param,
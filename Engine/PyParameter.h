@@ -269,6 +269,30 @@ public:
     QString getExpression(int dimension, bool* hasRetVariable) const;
 
     bool setInterpolationAtTime(double time, NATRON_NAMESPACE::KeyframeTypeEnum interpolation, int dimension = 0);
+
+    /**
+     * @brief Returns the times of all keyframes of the given dimension, in increasing order.
+     **/
+    std::vector<double> getKeyTimes(int dimension = 0) const;
+
+    /**
+     * @brief Returns the values of all keyframes of the given dimension, in the same order as getKeyTimes().
+     **/
+    std::vector<double> getKeyValues(int dimension = 0) const;
+
+    /**
+     * @brief Same as calling getValueAtTime() for each of the given times, but in a single call.
+     * Returns an empty list if the parameter does not hold numbers.
+     **/
+    std::vector<double> getValuesAtTimes(const std::vector<double>& times, int dimension = 0) const;
+
+    /**
+     * @brief Same as calling setValueAtTime() for each time with the value at the same index, but all keyframes are
+     * set at once: the parameter is changed, evaluated and its render invalidated a single time.
+     * Unlike setValueAtTime(), a keyframe that already exists at one of the times keeps its interpolation, only its value changes.
+     * Returns false if times and values do not have the same size or if the parameter cannot be animated.
+     **/
+    bool setValuesAtTimes(const std::vector<double>& times, const std::vector<double>& values, int dimension = 0);
 };
 
 /**
@@ -0,0 +1,228 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PyPlugCache.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include "Engine/AppManager.h"
+
+#define PYPLUG_CACHE_MAGIC 0x50595043 // "PYPC"
+// Increment when the layout of the file changes
+#define PYPLUG_CACHE_FORMAT_VERSION 1
+
+NATRON_NAMESPACE_ENTER
+
+static QString
+getPyPlugCacheDirPath()
+{
+    QString cachePath = appPTR->getDiskCacheLocation() + QLatin1Char('/');
+
+    return cachePath + QString::fromUtf8("PyPlugsCache");
+}
+
+static QString
+getPyPlugCacheFilePath()
+{
+    return getPyPlugCacheDirPath() + QLatin1Char('/') + QString::fromUtf8("PyPlugsCache_") +
+           QString::fromUtf8(NATRON_VERSION_STRING) + QString::fromUtf8("_") +
+           QString::fromUtf8(NATRON_DEVELOPMENT_STATUS) + QString::fromUtf8("_") +
+           QString::number(NATRON_BUILD_NUMBER) + QString::fromUtf8(".bin");
+}
+
+static void
+writeString(QDataStream& stream,
+            const std::string& str)
+{
+    stream << QByteArray( str.c_str(), (int)str.size() );
+}
+
+static void
+readString(QDataStream& stream,
+           std::string* str)
+{
+    QByteArray data;
+
+    stream >> data;
+    *str = std::string( data.constData(), data.size() );
+}
+
+PyPlugCache::PyPlugCache()
+    : _entries()
+    , _visited()
+    , _dirty(false)
+{
+}
+
+PyPlugCache::~PyPlugCache()
+{
+}
+
+void
+PyPlugCache::load()
+{
+    _entries.clear();
+    _visited.clear();
+    _dirty = false;
+
+    QFile file( getPyPlugCacheFilePath() );
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_8);
+
+    quint32 magic, formatVersion, nEntries;
+    stream >> magic >> formatVersion >> nEntries;
+    if ( (stream.status() != QDataStream::Ok) || (magic != PYPLUG_CACHE_MAGIC) || (formatVersion != PYPLUG_CACHE_FORMAT_VERSION) ) {
+        return;
+    }
+    for (quint32 i = 0; i < nEntries; ++i) {
+        QString filePath;
+        PyPlugCacheEntry entry;
+        quint32 version;
+        stream >> filePath >> entry.lastModified >> entry.fileSize >> entry.isPyPlug >> entry.importsNatronGui >> entry.hasGroupInfos;
+        readString(stream, &entry.pluginID);
+        readString(stream, &entry.pluginLabel);
+        readString(stream, &entry.iconFilePath);
+        readString(stream, &entry.grouping);
+        readString(stream, &entry.description);
+        stream >> entry.isToolset >> version;
+        entry.version = version;
+        if (stream.status() != QDataStream::Ok) {
+            // Truncated or corrupted file: start from scratch, it will be rewritten
+            qDebug() << "PyPlug cache file is corrupted, ignoring it";
+            _entries.clear();
+            _dirty = true;
+
+            return;
+        }
+        _entries[filePath] = entry;
+    }
+}
+
+void
+PyPlugCache::save()
+{
+    // Forget the scripts that were removed from the search paths
+    for (EntriesMap::iterator it = _entries.begin(); it != _entries.end();) {
+        if ( _visited.find(it->first) == _visited.end() ) {
+            _entries.erase(it++);
+            _dirty = true;
+        } else {
+            ++it;
+        }
+    }
+    if (!_dirty) {
+        return;
+    }
+
+    QDir cacheDir( getPyPlugCacheDirPath() );
+    if ( !cacheDir.exists() && !cacheDir.mkpath( QString::fromUtf8(".") ) ) {
+        return;
+    }
+
+    // Write to a temporary file first so that concurrent launches never read a partial cache
+    QString filePath = getPyPlugCacheFilePath();
+    QString tmpFilePath = filePath + QString::fromUtf8(".") + QString::number( QDateTime::currentMSecsSinceEpoch() );
+    {
+        QFile file(tmpFilePath);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_8);
+        stream << (quint32)PYPLUG_CACHE_MAGIC << (quint32)PYPLUG_CACHE_FORMAT_VERSION << (quint32)_entries.size();
+        for (EntriesMap::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            const PyPlugCacheEntry& entry = it->second;
+            stream << it->first << entry.lastModified << entry.fileSize << entry.isPyPlug << entry.importsNatronGui << entry.hasGroupInfos;
+            writeString(stream, entry.pluginID);
+            writeString(stream, entry.pluginLabel);
+            writeString(stream, entry.iconFilePath);
+            writeString(stream, entry.grouping);
+            writeString(stream, entry.description);
+            stream << entry.isToolset << (quint32)entry.version;
+        }
+        if (stream.status() != QDataStream::Ok) {
+            file.close();
+            QFile::remove(tmpFilePath);
+
+            return;
+        }
+    }
+    QFile::remove(filePath);
+    if ( !QFile::rename(tmpFilePath, filePath) ) {
+        QFile::remove(tmpFilePath);
+
+        return;
+    }
+    _dirty = false;
+} // PyPlugCache::save
+
+bool
+PyPlugCache::lookup(const QString& filePath,
+                    PyPlugCacheEntry* entry)
+{
+    _visited.insert(filePath);
+
+    EntriesMap::const_iterator found = _entries.find(filePath);
+    if ( found == _entries.end() ) {
+        return false;
+    }
+    QFileInfo info(filePath);
+    if ( !info.exists() ||
+         ( info.lastModified().toMSecsSinceEpoch() != found->second.lastModified ) ||
+         ( info.size() != found->second.fileSize ) ) {
+        return false;
+    }
+    *entry = found->second;
+
+    return true;
+}
+
+void
+PyPlugCache::insert(const QString& filePath,
+                    const PyPlugCacheEntry& entry)
+{
+    QFileInfo info(filePath);
+
+    if ( !info.exists() ) {
+        return;
+    }
+    _visited.insert(filePath);
+
+    PyPlugCacheEntry& stored = _entries[filePath];
+    stored = entry;
+    stored.lastModified = info.lastModified().toMSecsSinceEpoch();
+    stored.fileSize = info.size();
+    _dirty = true;
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_PYPLUGCACHE_H
+#define NATRON_ENGINE_PYPLUGCACHE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <QtCore/QString>
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief What AppManager::loadPythonGroups learns about a Python script found in the plug-in search paths:
+ * whether it is a PyPlug at all and, if so, the informations returned by getGroupInfos().
+ **/
+struct PyPlugCacheEntry
+{
+    // Validation of the entry against the script on disk
+    qint64 lastModified;
+    qint64 fileSize;
+
+    bool isPyPlug;
+    bool importsNatronGui;
+
+    // The script was imported and the fields below are valid. This is false for PyPlugs importing NatronGui
+    // that were only seen by NatronRenderer.
+    bool hasGroupInfos;
+    std::string pluginID, pluginLabel, iconFilePath, grouping, description;
+    bool isToolset;
+    unsigned int version;
+
+    PyPlugCacheEntry()
+        : lastModified(0)
+        , fileSize(0)
+        , isPyPlug(false)
+        , importsNatronGui(false)
+        , hasGroupInfos(false)
+        , pluginID()
+        , pluginLabel()
+        , iconFilePath()
+        , grouping()
+        , description()
+        , isToolset(false)
+        , version(1)
+    {
+    }
+};
+
+/**
+ * @brief A binary cache of the PyPlug informations, stored in the disk cache location next to the OpenFX plug-ins cache.
+ * With it, loadPythonGroups does not need to read and import every Python script of the search paths at each launch:
+ * only the scripts that were added or modified since the last launch are imported.
+ * An entry is valid as long as the modification date and size of its script did not change.
+ **/
+class PyPlugCache
+{
+public:
+
+    PyPlugCache();
+
+    ~PyPlugCache();
+
+    /**
+     * @brief Reads the cache file. Does nothing if it does not exist or was written by another version of Natron.
+     **/
+    void load();
+
+    /**
+     * @brief Writes the cache file if entries were added or removed since load().
+     **/
+    void save();
+
+    /**
+     * @brief Returns true and sets entry if the cache has an up to date entry for the given script.
+     **/
+    bool lookup(const QString& filePath, PyPlugCacheEntry* entry);
+
+    /**
+     * @brief Adds or replaces the entry of the given script. The modification date and size of the file are set by this function.
+     **/
+    void insert(const QString& filePath, const PyPlugCacheEntry& entry);
+
+private:
+
+    typedef std::map<QString, PyPlugCacheEntry> EntriesMap;
+
+    EntriesMap _entries;
+
+    // Scripts looked up or inserted since load(): entries of scripts that were not seen are dropped by save()
+    std::set<QString> _visited;
+    bool _dirty;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_PYPLUGCACHE_H
@@ -59,10 +59,12 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
 #include "Engine/Node.h"
+#include "Engine/Image.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/Project.h"
+#include "Engine/ParallelRenderArgs.h"
 #include "Engine/NodeSerialization.h"
 #include "Engine/KnobSerialization.h" // createDefaultValueForParam
 #include "Engine/Plugin.h"
@@ -245,6 +247,15 @@ public:
 
     bool wasCreatedAsHiddenNode;
 
+    // Read-ahead state, protected by readAheadMutex
+    mutable QMutex readAheadMutex;
+    int nActiveReadAhead;
+    bool hasLastSequentialRender;
+    double lastSequentialRenderTimeOffset;
+    ViewIdx lastSequentialRenderView;
+    unsigned int lastSequentialRenderMipMapLevel;
+    bool lastSequentialRenderDraft;
+
 
     ReadNodePrivate(ReadNode* publicInterface)
     : _publicInterface(publicInterface)
@@ -260,6 +271,13 @@ public:
     , creatingReadNode(0)
     , lastPluginIDCreated()
     , wasCreatedAsHiddenNode(false)
+    , readAheadMutex()
+    , nActiveReadAhead(0)
+    , hasLastSequentialRender(false)
+    , lastSequentialRenderTimeOffset(0.)
+    , lastSequentialRenderView(0)
+    , lastSequentialRenderMipMapLevel(0)
+    , lastSequentialRenderDraft(false)
     {
     }
 
@@ -340,6 +358,54 @@ ReadNode::setEmbeddedReader(const NodePtr& node)
     _imp->embeddedPlugin = node;
 }
 
+void
+ReadNode::setReadAheadActive(bool active)
+{
+    QMutexLocker k(&_imp->readAheadMutex);
+
+    if (active) {
+        ++_imp->nActiveReadAhead;
+    } else {
+        assert(_imp->nActiveReadAhead > 0);
+        --_imp->nActiveReadAhead;
+    }
+}
+
+bool
+ReadNode::getLastSequentialRender(double* timeOffset,
+                                  ViewIdx* view,
+                                  unsigned int* mipMapLevel,
+                                  bool* draftMode) const
+{
+    QMutexLocker k(&_imp->readAheadMutex);
+
+    if (!_imp->hasLastSequentialRender) {
+        return false;
+    }
+    *timeOffset = _imp->lastSequentialRenderTimeOffset;
+    *view = _imp->lastSequentialRenderView;
+    *mipMapLevel = _imp->lastSequentialRenderMipMapLevel;
+    *draftMode = _imp->lastSequentialRenderDraft;
+
+    return true;
+}
+
+bool
+ReadNode::shouldCacheOutput(bool isFrameVaryingOrAnimated,
+                            double time,
+                            ViewIdx view,
+                            int visitsCount) const
+{
+    {
+        QMutexLocker k(&_imp->readAheadMutex);
+        if (_imp->nActiveReadAhead > 0) {
+            return true;
+        }
+    }
+
+    return EffectInstance::shouldCacheOutput(isFrameVaryingOrAnimated, time, view, visitsCount);
+}
+
 void
 ReadNodePrivate::placeReadNodeKnobsInPage()
 {
@@ -1413,6 +1479,19 @@ ReadNode::render(const RenderActionArgs& args)
         return eStatusFailed;
     }
 
+    if (args.isSequentialRender) {
+        // Remember how the playback/render reads this node, the read-ahead reads frames the same way.
+        // Frames found in the cache do not get here: the play head itself is given to the read-ahead by the
+        // OutputSchedulerThread, only the offset of this node's time to the frame rendered by the tree is kept.
+        ParallelRenderArgsPtr frameArgs = getParallelRenderArgsTLS();
+        QMutexLocker k(&_imp->readAheadMutex);
+        _imp->hasLastSequentialRender = true;
+        _imp->lastSequentialRenderTimeOffset = frameArgs ? (args.time - frameArgs->time) : 0.;
+        _imp->lastSequentialRenderView = args.view;
+        _imp->lastSequentialRenderMipMapLevel = Image::getLevelFromScale(args.originalScale.x);
+        _imp->lastSequentialRenderDraft = args.draftMode;
+    }
+
     NodePtr p = getEmbeddedReader();
     if (p) {
         return p->getEffectInstance()->render(args);
@@ -79,6 +79,20 @@ public:
     void setEmbeddedReader(const NodePtr& node);
     static bool isVideoReader(const std::string& pluginID);
 
+    /**
+     * @brief Called by a ReadNodePrefetcher when it starts (active = true) or stops reading ahead this node.
+     * While at least one prefetcher is active, the output of this node is always cached so that the frames
+     * decoded ahead can be picked up by the render threads.
+     **/
+    void setReadAheadActive(bool active);
+
+    /**
+     * @brief Returns the parameters of the last frame rendered by a sequential render (playback or render on disk),
+     * or false if there was none. timeOffset is the time of this node minus the time of the frame rendered by the
+     * tree, it is not 0 for time-remapped readers.
+     **/
+    bool getLastSequentialRender(double* timeOffset, ViewIdx* view, unsigned int* mipMapLevel, bool* draftMode) const;
+
     virtual bool isReader() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isVideoReader() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isGenerator() const OVERRIDE FINAL WARN_UNUSED_RETURN;
@@ -160,6 +174,7 @@ private:
                                       ViewIdx view,
                                       RoIMap* ret) OVERRIDE FINAL;
     virtual FramesNeededMap getFramesNeeded(double time, ViewIdx view) OVERRIDE WARN_UNUSED_RETURN;
+    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, double time, ViewIdx view, int visitsCount) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     boost::scoped_ptr<ReadNodePrivate> _imp;
 };
 
@@ -0,0 +1,636 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ReadNodePrefetcher.h"
+
+#include <algorithm> // min, max
+#include <climits> // ULONG_MAX
+#include <cmath> // ceil, floor
+#include <list>
+#include <set>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#endif
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/AbortableRenderInfo.h"
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/Node.h"
+#include "Engine/ParallelRenderArgs.h"
+#include "Engine/ReadNode.h"
+#include "Engine/Settings.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/TimeLine.h"
+#include "Engine/Timer.h"
+#include "Engine/TLSHolder.h"
+
+// How often idle threads look for frames to read when the play head moved (in milliseconds)
+#define NATRON_READ_AHEAD_POLL_MS 10
+
+NATRON_NAMESPACE_ENTER
+
+namespace {
+struct ReadAheadReader
+{
+    NodePtr node;
+    boost::shared_ptr<ReadNode> effect;
+
+    // The parameters of the render threads the frames are read for
+    ViewIdx view;
+    unsigned int mipMapLevel;
+    bool draftMode;
+
+    // The frame of this reader the render threads are at and when it changed (on ReadNodePrefetcherPrivate::clock)
+    bool hasPlayHead;
+    int playHead;
+    double playHeadChangeTime;
+
+    // The frames ahead of the play head already read or being read
+    std::set<int> framesRead;
+
+    // Moving averages, 0 until measured
+    double decodeTime; // seconds to read a frame
+    double frameInterval; // seconds between 2 frames asked by the render threads
+    std::size_t frameSize; // size in bytes of a frame
+
+    ReadAheadReader()
+        : node()
+        , effect()
+        , view(0)
+        , mipMapLevel(0)
+        , draftMode(false)
+        , hasPlayHead(false)
+        , playHead(0)
+        , playHeadChangeTime(0.)
+        , framesRead()
+        , decodeTime(0.)
+        , frameInterval(0.)
+        , frameSize(0)
+    {
+    }
+};
+
+typedef boost::shared_ptr<ReadAheadReader> ReadAheadReaderPtr;
+
+double
+movingAverage(double average,
+              double value)
+{
+    return (average == 0.) ? value : (0.7 * average + 0.3 * value);
+}
+
+void
+getReadNodesUpstream(const NodePtr& node,
+                     std::set<NodePtr>* markedNodes,
+                     std::list<NodePtr>* readers)
+{
+    if ( !node || !markedNodes->insert(node).second || !node->isActivated() ) {
+        return;
+    }
+    ReadNode* isReader = dynamic_cast<ReadNode*>( node->getEffectInstance().get() );
+    if (isReader) {
+        // Video files are decoded sequentially by the reader: reading them out of order would only make it seek
+        if ( isReader->getEmbeddedReader() && !isReader->isVideoReader() ) {
+            readers->push_back(node);
+        }
+
+        return;
+    }
+    int nInputs = node->getNInputs();
+    for (int i = 0; i < nInputs; ++i) {
+        getReadNodesUpstream(node->getInput(i), markedNodes, readers);
+    }
+}
+} // anon namespace
+
+class ReadAheadThread;
+typedef boost::shared_ptr<ReadAheadThread> ReadAheadThreadPtr;
+
+struct ReadNodePrefetcherPrivate
+{
+    // Protects all members below
+    mutable QMutex lock;
+
+    // Threads wait on it for frames to read
+    QWaitCondition framesToReadCond;
+
+    // stop() waits on it for the frames being read to be aborted
+    QWaitCondition noFramesBeingReadCond;
+
+    std::vector<ReadAheadReaderPtr> readers;
+    std::size_t nextReader;
+    std::list<AbortableRenderInfoPtr> framesBeingRead;
+    std::vector<ReadAheadThreadPtr> threads;
+
+    int firstFrame, lastFrame, frameStep;
+    bool forward, loop;
+    double fps;
+    int maxFrames;
+
+    // The last frame picked by the render threads of the OutputSchedulerThread
+    bool hasPlayHead;
+    int playHead;
+
+    bool running;
+    bool mustQuit;
+
+    TimeLapse clock;
+
+    ReadNodePrefetcherPrivate()
+        : lock()
+        , framesToReadCond()
+        , noFramesBeingReadCond()
+        , readers()
+        , nextReader(0)
+        , framesBeingRead()
+        , threads()
+        , firstFrame(0)
+        , lastFrame(0)
+        , frameStep(1)
+        , forward(true)
+        , loop(false)
+        , fps(0.)
+        , maxFrames(0)
+        , hasPlayHead(false)
+        , playHead(0)
+        , running(false)
+        , mustQuit(false)
+        , clock()
+    {
+    }
+
+    void threadLoop(AbortableThread* thread);
+
+    bool pickFrameToRead(ReadAheadReaderPtr* reader, int* frame);
+
+    void updatePlayHead(ReadAheadReader& reader);
+
+    int getReadAheadCount(const ReadAheadReader& reader) const;
+
+    int getFrameOffset(int playHead, int frame) const;
+
+    bool getFrameAhead(int playHead, int offset, int* frame) const;
+
+    bool readFrame(AbortableThread* thread,
+                   const ReadAheadReader& reader,
+                   int frame,
+                   const AbortableRenderInfoPtr& abortInfo,
+                   std::size_t* frameSize) const;
+};
+
+class ReadAheadThread
+    : public QThread
+      , public AbortableThread
+{
+    ReadNodePrefetcherPrivate* _imp;
+
+public:
+
+    ReadAheadThread(ReadNodePrefetcherPrivate* imp)
+        : QThread()
+        , AbortableThread(this)
+        , _imp(imp)
+    {
+        setThreadName("Read-ahead thread");
+    }
+
+    virtual ~ReadAheadThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        _imp->threadLoop(this);
+    }
+};
+
+void
+ReadNodePrefetcherPrivate::threadLoop(AbortableThread* thread)
+{
+    for (;;) {
+        ReadAheadReaderPtr reader;
+        int frame;
+        AbortableRenderInfoPtr abortInfo;
+        {
+            QMutexLocker k(&lock);
+            for (;;) {
+                if (mustQuit) {
+                    return;
+                }
+                if ( running && pickFrameToRead(&reader, &frame) ) {
+                    break;
+                }
+                // Frames may also be read again once the cache has room: look again regularly while running
+                framesToReadCond.wait(&lock, running ? NATRON_READ_AHEAD_POLL_MS : ULONG_MAX);
+            }
+            abortInfo = AbortableRenderInfo::create(true, 0);
+            framesBeingRead.push_back(abortInfo);
+        }
+
+        TimeLapse timer;
+        std::size_t frameSize = 0;
+        bool ok = readFrame(thread, *reader, frame, abortInfo, &frameSize);
+        double decodeTime = timer.getTimeElapsedReset();
+
+        appPTR->getAppTLS()->cleanupTLSForThread();
+
+        QMutexLocker k(&lock);
+        // A frame that failed is not read again: it stays in framesRead
+        if ( ok && !abortInfo->isAborted() ) {
+            reader->decodeTime = movingAverage(reader->decodeTime, decodeTime);
+            reader->frameSize = frameSize;
+        }
+        framesBeingRead.remove(abortInfo);
+        if ( framesBeingRead.empty() ) {
+            noFramesBeingReadCond.wakeAll();
+        }
+    }
+} // ReadNodePrefetcherPrivate::threadLoop
+
+bool
+ReadNodePrefetcherPrivate::pickFrameToRead(ReadAheadReaderPtr* reader,
+                                           int* frame)
+{
+    // Must be locked
+    assert( !lock.tryLock() );
+
+    if ( readers.empty() || appPTR->isNodeCacheAlmostFull() ) {
+        return false;
+    }
+
+    // Read the readers in turn so that they all stay ahead of the render threads
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        std::size_t index = (nextReader + i) % readers.size();
+        ReadAheadReader& r = *readers[index];
+
+        updatePlayHead(r);
+        if (!r.hasPlayHead) {
+            continue;
+        }
+        int count = getReadAheadCount(r);
+        for (int offset = 1; offset <= count; ++offset) {
+            int t;
+            if ( !getFrameAhead(r.playHead, offset, &t) ) {
+                break;
+            }
+            if ( r.framesRead.insert(t).second ) {
+                *reader = readers[index];
+                *frame = t;
+                nextReader = (index + 1) % readers.size();
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void
+ReadNodePrefetcherPrivate::updatePlayHead(ReadAheadReader& r)
+{
+    // Must be locked
+    assert( !lock.tryLock() );
+
+    double timeOffset;
+    ViewIdx view;
+    unsigned int mipMapLevel;
+    bool draftMode;
+
+    if ( !hasPlayHead || !r.effect->getLastSequentialRender(&timeOffset, &view, &mipMapLevel, &draftMode) ) {
+        return;
+    }
+    if ( (view != r.view) || (mipMapLevel != r.mipMapLevel) || (draftMode != r.draftMode) ) {
+        // The frames read so far will not be used
+        r.view = view;
+        r.mipMapLevel = mipMapLevel;
+        r.draftMode = draftMode;
+        r.framesRead.clear();
+    }
+
+    // Frames found in the cache are not rendered again by the reader, so its play head is derived from the frame
+    // the render threads are at rather than from the last frame it rendered
+    int readerPlayHead = (int)std::floor(playHead + timeOffset + 0.5);
+    if ( r.hasPlayHead && (readerPlayHead == r.playHead) ) {
+        return;
+    }
+
+    double now = clock.getTimeSinceCreation();
+    if (r.hasPlayHead) {
+        int offset = getFrameOffset(r.playHead, readerPlayHead);
+        if (offset > 0) {
+            r.frameInterval = movingAverage(r.frameInterval, (now - r.playHeadChangeTime) / offset);
+        }
+    }
+    r.hasPlayHead = true;
+    r.playHead = readerPlayHead;
+    r.playHeadChangeTime = now;
+
+    // Forget the frames the play head went past
+    for (std::set<int>::iterator it = r.framesRead.begin(); it != r.framesRead.end(); ) {
+        int offset = getFrameOffset(readerPlayHead, *it);
+        if ( (offset <= 0) || (offset > maxFrames) ) {
+            r.framesRead.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+} // ReadNodePrefetcherPrivate::updatePlayHead
+
+int
+ReadNodePrefetcherPrivate::getReadAheadCount(const ReadAheadReader& r) const
+{
+    int count = maxFrames;
+
+    // A frame must be asked for about twice its decoding time before the render threads need it
+    double interval = r.frameInterval;
+    if ( (interval == 0.) && (fps > 0.) ) {
+        interval = 1. / fps;
+    }
+    if ( (r.decodeTime > 0.) && (interval > 0.) ) {
+        count = std::min(count, (int)std::ceil(2. * r.decodeTime / interval) + 1);
+    }
+
+    // The frames read ahead of all readers may use at most half of the free node cache
+    if (r.frameSize > 0) {
+        U64 maxSize = appPTR->getCachesMaximumMemorySize();
+        U64 size = appPTR->getCachesTotalMemorySize();
+        U64 freeSize = (maxSize > size) ? (maxSize - size) : 0;
+        U64 nFitting = freeSize / 2 / readers.size() / r.frameSize;
+        count = std::min(count, (int)std::min( nFitting, (U64)maxFrames ) + (int)r.framesRead.size());
+    }
+
+    return count;
+}
+
+int
+ReadNodePrefetcherPrivate::getFrameOffset(int playHead,
+                                          int frame) const
+{
+    int delta = forward ? (frame - playHead) : (playHead - frame);
+
+    if ( loop && (delta < 0) && (playHead >= firstFrame) && (playHead <= lastFrame) ) {
+        delta += lastFrame - firstFrame + 1;
+    }
+
+    return delta / frameStep;
+}
+
+bool
+ReadNodePrefetcherPrivate::getFrameAhead(int playHead,
+                                         int offset,
+                                         int* frame) const
+{
+    int t = playHead + (forward ? 1 : -1) * offset * frameStep;
+
+    // Time-remapped readers may be played outside of the render range, in which case it does not apply
+    if ( (playHead >= firstFrame) && (playHead <= lastFrame) && ( (t < firstFrame) || (t > lastFrame) ) ) {
+        if (!loop) {
+            return false;
+        }
+        int range = lastFrame - firstFrame + 1;
+        t = firstFrame + ( (t - firstFrame) % range + range ) % range;
+        if (t == playHead) {
+            return false;
+        }
+    }
+    *frame = t;
+
+    return true;
+}
+
+bool
+ReadNodePrefetcherPrivate::readFrame(AbortableThread* thread,
+                                     const ReadAheadReader& r,
+                                     int frame,
+                                     const AbortableRenderInfoPtr& abortInfo,
+                                     std::size_t* frameSize) const
+{
+    const NodePtr& node = r.node;
+    EffectInstance* effect = r.effect.get();
+    double time = frame;
+    U64 nodeHash = node->getHashValue();
+    RenderScale scale( Image::getScaleFromMipMapLevel(r.mipMapLevel) );
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = effect->getRegionOfDefinition_public(nodeHash, time, scale, r.view, &rod, &isProjectFormat);
+
+    if ( (stat == eStatusFailed) || rod.isNull() ) {
+        return false;
+    }
+
+    const double par = effect->getAspectRatio(-1);
+    RectI renderWindow;
+    rod.toPixelEnclosing(r.mipMapLevel, par, &renderWindow);
+
+    RenderingFlagSetter flagIsRendering(node);
+
+    thread->setAbortInfo( false, abortInfo, node->getEffectInstance() );
+
+    // Not flagged as sequential, so the ReadNode does not take it for the play head
+    ParallelRenderArgsSetter frameRenderArgs( time,
+                                              r.view,
+                                              false, // isRenderUserInteraction
+                                              false, // isSequential
+                                              abortInfo,
+                                              node, // treeRoot
+                                              0, // texture index
+                                              node->getApp()->getTimeLine().get(),
+                                              NodePtr(), // rotoPaint node
+                                              false, // isAnalysis
+                                              r.draftMode,
+                                              RenderStatsPtr() );
+    FrameRequestMap request;
+    stat = EffectInstance::computeRequestPass(time, r.view, r.mipMapLevel, rod, node, request);
+    if (stat == eStatusFailed) {
+        thread->clearAbortInfo();
+
+        return false;
+    }
+    frameRenderArgs.updateNodesRequest(request);
+
+    std::list<ImagePlaneDesc> requestedComps;
+    {
+        ImagePlaneDesc plane, pairedPlane;
+        effect->getMetadataComponents(-1, &plane, &pairedPlane);
+        requestedComps.push_back(plane);
+    }
+
+    std::map<ImagePlaneDesc, ImagePtr> planes;
+    EffectInstance::RenderRoIRetCode retCode = EffectInstance::eRenderRoIRetCodeFailed;
+    try {
+        EffectInstance::RenderRoIArgs args( time,
+                                            scale,
+                                            r.mipMapLevel,
+                                            r.view,
+                                            false, // byPassCache
+                                            renderWindow,
+                                            rod,
+                                            requestedComps,
+                                            effect->getBitDepth(-1),
+                                            false,
+                                            effect,
+                                            eStorageModeRAM,
+                                            time );
+        retCode = effect->renderRoI(args, &planes);
+    } catch (...) {
+        // The render threads will report the error when they read this frame
+    }
+    thread->clearAbortInfo();
+
+    if ( (retCode != EffectInstance::eRenderRoIRetCodeOk) || planes.empty() ) {
+        return false;
+    }
+    *frameSize = planes.begin()->second->size();
+
+    return true;
+} // ReadNodePrefetcherPrivate::readFrame
+
+ReadNodePrefetcher::ReadNodePrefetcher()
+    : _imp( new ReadNodePrefetcherPrivate() )
+{
+}
+
+ReadNodePrefetcher::~ReadNodePrefetcher()
+{
+    stop();
+
+    std::vector<ReadAheadThreadPtr> threads;
+    {
+        QMutexLocker k(&_imp->lock);
+        _imp->mustQuit = true;
+        _imp->framesToReadCond.wakeAll();
+        threads.swap(_imp->threads);
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->wait();
+    }
+}
+
+void
+ReadNodePrefetcher::start(const NodePtr& output,
+                          int firstFrame,
+                          int lastFrame,
+                          int frameStep,
+                          bool forward,
+                          bool loop,
+                          double fps)
+{
+    stop();
+
+    int maxFrames = appPTR->getCurrentSettings()->getReadAheadMaxFrames();
+    if ( (maxFrames <= 0) || !output ) {
+        return;
+    }
+
+    std::list<NodePtr> readNodes;
+    {
+        std::set<NodePtr> markedNodes;
+        getReadNodesUpstream(output, &markedNodes, &readNodes);
+    }
+    if ( readNodes.empty() ) {
+        return;
+    }
+
+    std::vector<ReadAheadReaderPtr> readers;
+    for (std::list<NodePtr>::iterator it = readNodes.begin(); it != readNodes.end(); ++it) {
+        ReadAheadReaderPtr r = boost::make_shared<ReadAheadReader>();
+        r->node = *it;
+        r->effect = boost::dynamic_pointer_cast<ReadNode>( (*it)->getEffectInstance() );
+        assert(r->effect);
+        r->effect->setReadAheadActive(true);
+        readers.push_back(r);
+    }
+
+    QMutexLocker k(&_imp->lock);
+    _imp->readers = readers;
+    _imp->nextReader = 0;
+    _imp->firstFrame = firstFrame;
+    _imp->lastFrame = lastFrame;
+    _imp->frameStep = std::max(1, frameStep);
+    _imp->forward = forward;
+    _imp->loop = loop;
+    _imp->fps = fps;
+    _imp->maxFrames = maxFrames;
+    _imp->hasPlayHead = false;
+    _imp->running = true;
+
+    // Reading is mostly waiting on I/O, a few threads are enough to keep the disk or network busy
+    int nThreads = std::min( maxFrames, std::max(2, QThread::idealThreadCount() / 4) );
+    while ( (int)_imp->threads.size() < nThreads ) {
+        ReadAheadThreadPtr thread = boost::make_shared<ReadAheadThread>( _imp.get() );
+        thread->start(QThread::LowPriority);
+        _imp->threads.push_back(thread);
+    }
+    _imp->framesToReadCond.wakeAll();
+} // ReadNodePrefetcher::start
+
+void
+ReadNodePrefetcher::setPlayHead(int frame)
+{
+    QMutexLocker k(&_imp->lock);
+
+    if ( !_imp->running || ( _imp->hasPlayHead && (_imp->playHead == frame) ) ) {
+        return;
+    }
+    _imp->hasPlayHead = true;
+    _imp->playHead = frame;
+    _imp->framesToReadCond.wakeAll();
+}
+
+void
+ReadNodePrefetcher::stop()
+{
+    std::vector<ReadAheadReaderPtr> readers;
+    {
+        QMutexLocker k(&_imp->lock);
+        if (!_imp->running) {
+            return;
+        }
+        _imp->running = false;
+        for (std::list<AbortableRenderInfoPtr>::iterator it = _imp->framesBeingRead.begin(); it != _imp->framesBeingRead.end(); ++it) {
+            (*it)->setAborted();
+        }
+        while ( !_imp->framesBeingRead.empty() ) {
+            _imp->noFramesBeingReadCond.wait(&_imp->lock);
+        }
+        readers.swap(_imp->readers);
+    }
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        readers[i]->effect->setReadAheadActive(false);
+    }
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,88 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_READNODEPREFETCHER_H
+#define NATRON_ENGINE_READNODEPREFETCHER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Decodes in background threads the frames that the Read nodes upstream of an output are about to be asked
+ * for during playback or a sequence render, so that the render threads find them in the node cache instead of
+ * waiting on I/O.
+ * The read-ahead of a Read node starts from the frame the render threads are at and covers at most
+ * the number of frames set in the preferences. This number is lowered so that a frame is requested about twice its
+ * decoding time ahead of when it is needed, and so that the prefetched frames fit in half of the free node cache.
+ * The OutputSchedulerThread starts it in startRender(), gives it the frames its render threads pick and stops it
+ * in stopRender(). Other renders, such as the speculative renders of the viewer, do not move the play head.
+ **/
+struct ReadNodePrefetcherPrivate;
+class ReadNodePrefetcher
+{
+public:
+
+    ReadNodePrefetcher();
+
+    ~ReadNodePrefetcher();
+
+    /**
+     * @brief Starts reading ahead the Read nodes upstream of output. Frames are read in the range [firstFrame, lastFrame]
+     * in the given direction, wrapping around if loop is true.
+     * @param fps The expected playback rate, or 0 if the render is not regulated: it is only used until the actual
+     * rate at which frames are consumed is measured.
+     **/
+    void start(const NodePtr& output,
+               int firstFrame,
+               int lastFrame,
+               int frameStep,
+               bool forward,
+               bool loop,
+               double fps);
+
+    /**
+     * @brief Called when a render thread picks the given frame of the output: the frames following it are read ahead.
+     **/
+    void setPlayHead(int frame);
+
+    /**
+     * @brief Aborts the frames being read ahead and waits for the background threads to be idle.
+     **/
+    void stop();
+
+private:
+
+    boost::scoped_ptr<ReadNodePrefetcherPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_READNODEPREFETCHER_H
@@ -30,6 +30,7 @@
 
 #include <QtCore/QMutex>
 
+#include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/Timer.h"
 #include "Engine/RectI.h"
@@ -65,6 +66,10 @@ struct NodeRenderStatsPrivate
     int nbCacheHit;
     int nbCacheHitButDownscaledImages;
 
+    //Cache eviction infos
+    int nbEvictedImages;
+    double evictedRenderTime;
+
     //Is tile support enabled for this render
     bool tileSupportEnabled;
 
@@ -88,6 +93,8 @@ struct NodeRenderStatsPrivate
         , nbCacheMisses(0)
         , nbCacheHit(0)
         , nbCacheHitButDownscaledImages(0)
+        , nbEvictedImages(0)
+        , evictedRenderTime(0)
         , tileSupportEnabled(false)
         , renderScaleSupportEnabled(false)
         , channelsEnabled()
@@ -127,6 +134,8 @@ NodeRenderStats::operator=(const NodeRenderStats& other)
     _imp->nbCacheMisses = other._imp->nbCacheMisses;
     _imp->nbCacheHit = other._imp->nbCacheHit;
     _imp->nbCacheHitButDownscaledImages = other._imp->nbCacheHitButDownscaledImages;
+    _imp->nbEvictedImages = other._imp->nbEvictedImages;
+    _imp->evictedRenderTime = other._imp->evictedRenderTime;
     _imp->tileSupportEnabled = other._imp->tileSupportEnabled;
     _imp->renderScaleSupportEnabled = other._imp->renderScaleSupportEnabled;
     for (int i = 0; i < 4; ++i) {
@@ -253,6 +262,22 @@ NodeRenderStats::getCacheAccessInfos(int* nbCacheMisses,
     *nbCacheHitButDownscaledImages = _imp->nbCacheHitButDownscaledImages;
 }
 
+void
+NodeRenderStats::setCacheEvictionInfos(int nbEvictedImages,
+                                       double evictedRenderTime)
+{
+    _imp->nbEvictedImages = nbEvictedImages;
+    _imp->evictedRenderTime = evictedRenderTime;
+}
+
+void
+NodeRenderStats::getCacheEvictionInfos(int* nbEvictedImages,
+                                       double* evictedRenderTime) const
+{
+    *nbEvictedImages = _imp->nbEvictedImages;
+    *evictedRenderTime = _imp->evictedRenderTime;
+}
+
 void
 NodeRenderStats::setTilesSupported(bool tilesSupported)
 {
@@ -388,11 +413,17 @@ RenderStats::setGlobalRenderInfosForNode(const NodePtr& node,
                                          bool renderScaleSupported,
                                          unsigned int mipmapLevel)
 {
+    U64 nbEvictedImages, evictedBytes;
+    double evictedRenderTime;
+
+    appPTR->getCachesEvictionStats(node->getCacheID(), &nbEvictedImages, &evictedBytes, &evictedRenderTime);
+
     QMutexLocker k(&_imp->lock);
 
     assert(_imp->doNodesProfiling);
 
     NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.setCacheEvictionInfos( (int)nbEvictedImages, evictedRenderTime );
     stats.setOutputPremult(outputPremult);
     stats.setTilesSupported(tilesSupported);
     stats.setRenderScaleSupported(renderScaleSupported);
@@ -87,6 +87,10 @@ public:
     void addCacheAccessInfo(bool isCacheMiss, bool hasDownscaled);
     void getCacheAccessInfos(int* nbCacheMisses, int* nbCacheHits, int* nbCacheHitButDownscaledImages) const;
 
+    // Images of the node evicted from the cache to make room for others, since the node was created
+    void setCacheEvictionInfos(int nbEvictedImages, double evictedRenderTime);
+    void getCacheEvictionInfos(int* nbEvictedImages, double* evictedRenderTime) const;
+
     void setTilesSupported(bool tilesSupported);
     bool isTilesSupportEnabled() const;
 
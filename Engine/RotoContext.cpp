@@ -31,7 +31,9 @@
 #include <cassert>
 #include <stdexcept>
 #include <cstring> // for std::memcpy, std::memset
+#include <iterator> // advance
 #include <sstream> // stringstream
+#include <vector>
 
 #include <boost/scoped_ptr.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
@@ -157,14 +159,15 @@ RotoContext::getRotoPaintBottomMergeNode() const
         return NodePtr();
     }
 
-    int bop;
-    if ( isRotoPaintTreeConcatenatableInternal(items, &bop) ) {
+    {
         QMutexLocker k(&_imp->rotoContextMutex);
-        if ( !_imp->globalMergeNodes.empty() ) {
-            return _imp->globalMergeNodes.front();
+        NodePtr output = _imp->rotoPaintTreeOutput.lock();
+        if (output) {
+            return output;
         }
     }
 
+    // The tree was not built yet
     const RotoDrawableItemPtr& firstStrokeItem = items.back();
     assert(firstStrokeItem);
     NodePtr bottomMerge = firstStrokeItem->getMergeNode();
@@ -798,35 +801,100 @@ RotoContext::getGlobalMotionBlurSettings(const double time,
     if (motionBlurAmnt == 0) {
         return;
     }
-    int nbSamples = std::floor(motionBlurAmnt * 10 + 0.5);
-    double shutterInterval = _imp->globalMotionBlurKnob.lock()->getValueAtTime(time);
-    if (shutterInterval == 0) {
+    int maxSamples = std::floor(motionBlurAmnt * 10 + 0.5);
+    double shutterInterval = _imp->globalShutterKnob.lock()->getValueAtTime(time);
+    if ( (shutterInterval == 0) || (maxSamples == 0) ) {
         return;
     }
-    int shutterType_i = _imp->globalMotionBlurKnob.lock()->getValueAtTime(time);
-    if (nbSamples != 0) {
-        *timeStep = shutterInterval / nbSamples;
-    }
+    int shutterType_i = _imp->globalShutterTypeKnob.lock()->getValueAtTime(time);
+    double shutterStart, shutterEnd;
     if (shutterType_i == 0) { // centered
-        *startTime = time - shutterInterval / 2.;
-        *endTime = time + shutterInterval / 2.;
+        shutterStart = time - shutterInterval / 2.;
+        shutterEnd = time + shutterInterval / 2.;
     } else if (shutterType_i == 1) { // start
-        *startTime = time;
-        *endTime = time + shutterInterval;
+        shutterStart = time;
+        shutterEnd = time + shutterInterval;
     } else if (shutterType_i == 2) { // end
-        *startTime = time - shutterInterval;
-        *endTime = time;
+        shutterStart = time - shutterInterval;
+        shutterEnd = time;
     } else if (shutterType_i == 3) { // custom
-        *startTime = time + _imp->globalCustomOffsetKnob.lock()->getValueAtTime(time);
-        *endTime = *startTime + shutterInterval;
+        shutterStart = time + _imp->globalCustomOffsetKnob.lock()->getValueAtTime(time);
+        shutterEnd = shutterStart + shutterInterval;
     } else {
         assert(false);
+
+        return;
     }
 
+    // All the shapes share the same samples: sample for the one moving the most
+    double displacement = 0.;
+    std::list<RotoDrawableItemPtr> items = getCurvesByRenderOrder();
+    for (std::list<RotoDrawableItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
+        Bezier* isBezier = dynamic_cast<Bezier*>( it->get() );
+        if ( isBezier && !isBezier->isOpenBezier() ) {
+            displacement = std::max( displacement, isBezier->getControlPointsMaxDisplacement(shutterStart, shutterEnd) );
+        }
+    }
+    int nbSamples = Bezier::getMotionBlurSamplesCount(displacement, maxSamples);
+    if (nbSamples == 0) {
+        return;
+    }
+    *startTime = shutterStart;
+    *endTime = shutterEnd;
+    *timeStep = shutterInterval / nbSamples;
 
 #endif
 }
 
+/**
+ * @brief Returns the region of definition of a Bezier or a stroke over the given time range, or a null rect if it
+ * is not activated at time.
+ **/
+static RectD
+getDrawableItemRegionOfDefinition(RotoDrawableItem* item,
+                                  double time,
+                                  double startTime,
+                                  double endTime,
+                                  double mbFrameStep,
+                                  const RotoStrokeItem* activeStroke)
+{
+    RectD rod;
+    Bezier* isBezier = dynamic_cast<Bezier*>(item);
+    RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>(item);
+
+    if ( (!isBezier && !isStroke) || !item->isActivated(time) ) {
+        return rod;
+    }
+    if ( isBezier && !isStroke && (isBezier->getControlPointsCount() <= 1) ) {
+        return rod;
+    }
+
+    bool rodSet = false;
+    for (double t = startTime; t <= endTime; t += mbFrameStep) {
+        RectD bbox;
+        if (isStroke) {
+            if (isStroke == activeStroke) {
+                bbox = isStroke->getMergeNode()->getPaintStrokeRoD_duringPainting();
+            } else {
+                bbox = isStroke->getBoundingBox(t);
+            }
+        } else {
+            bbox = isBezier->getBoundingBox(t);
+        }
+        if ( bbox.isNull() ) {
+            continue;
+        }
+        if (!rodSet) {
+            rod = bbox;
+            rodSet = true;
+        } else {
+            rod.merge(bbox);
+        }
+    }
+
+    return rod;
+} // getDrawableItemRegionOfDefinition
+
 void
 RotoContext::getItemsRegionOfDefinition(const std::list<RotoItemPtr>& items,
                                         double time,
@@ -844,7 +912,6 @@ RotoContext::getItemsRegionOfDefinition(const std::list<RotoItemPtr>& items,
 #endif
 
 
-    bool rodSet = false;
     NodePtr activeRotoPaintNode;
     RotoStrokeItemPtr activeStroke;
     bool isDrawing = false;
@@ -853,72 +920,148 @@ RotoContext::getItemsRegionOfDefinition(const std::list<RotoItemPtr>& items,
         activeStroke.reset();
     }
 
-    QMutexLocker l(&_imp->rotoContextMutex);
-    for (double t = startTime; t <= endTime; t += mbFrameStep) {
-        bool first = true;
-        RectD bbox;
-        for (std::list<RotoItemPtr>::const_iterator it2 = items.begin(); it2 != items.end(); ++it2) {
-            Bezier* isBezier = dynamic_cast<Bezier*>( it2->get() );
-            RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>( it2->get() );
-            if (isBezier && !isStroke) {
-                if ( isBezier->isActivated(time)  && (isBezier->getControlPointsCount() > 1) ) {
-                    RectD splineRoD = isBezier->getBoundingBox(t);
-                    if ( splineRoD.isNull() ) {
-                        continue;
-                    }
+    bool rodSet = false;
+    *rod = RectD();
 
-                    if (first) {
-                        first = false;
-                        bbox = splineRoD;
-                    } else {
-                        bbox.merge(splineRoD);
-                    }
-                }
-            } else if (isStroke) {
-                RectD strokeRod;
-                if ( isStroke->isActivated(time) ) {
-                    if ( isStroke == activeStroke.get() ) {
-                        strokeRod = isStroke->getMergeNode()->getPaintStrokeRoD_duringPainting();
-                    } else {
-                        strokeRod = isStroke->getBoundingBox(t);
-                    }
-                    if (first) {
-                        first = false;
-                        bbox = strokeRod;
-                    } else {
-                        bbox.merge(strokeRod);
-                    }
-                }
-            }
+    QMutexLocker l(&_imp->rotoContextMutex);
+    for (std::list<RotoItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
+        RotoDrawableItem* isDrawable = dynamic_cast<RotoDrawableItem*>( it->get() );
+        if (!isDrawable) {
+            continue;
+        }
+        RectD itemRod = getDrawableItemRegionOfDefinition(isDrawable, time, startTime, endTime, mbFrameStep, activeStroke.get());
+        if ( itemRod.isNull() ) {
+            continue;
         }
         if (!rodSet) {
-            *rod = bbox;
+            *rod = itemRod;
             rodSet = true;
         } else {
-            rod->merge(bbox);
+            rod->merge(itemRod);
         }
     }
 } // RotoContext::getItemsRegionOfDefinition
 
+RotoItemsIndexPtr
+RotoContextPrivate::getItemsIndex(const RotoContext* context,
+                                  double time)
+{
+    std::list<RotoDrawableItemPtr> items = context->getCurvesByRenderOrder(false /*onlyActivated*/);
+    NodePtr contextNode = context->getNode();
+    NodePtr activeRotoPaintNode;
+    RotoStrokeItemPtr activeStroke;
+    bool isDrawing = false;
+
+    contextNode->getApp()->getActiveRotoDrawingStroke(&activeRotoPaintNode, &activeStroke, &isDrawing);
+    if (!isDrawing) {
+        activeStroke.reset();
+    }
+
+    // While a stroke of this context is drawn, its region of definition changes at each mouse move without any change of age
+    bool canCache = !activeStroke || (activeRotoPaintNode != contextNode);
+
+    // Any change to an item increments the age of its nodes, and a change of the global motion blur the age of the context node
+    U64 signature;
+    {
+        Hash64 hash;
+        hash.append( contextNode->getKnobsAge() );
+        for (std::list<RotoDrawableItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
+            hash.append( (U64)(std::size_t)it->get() );
+            NodePtr itemNode = (*it)->getEffectNode();
+            if (itemNode) {
+                hash.append( itemNode->getKnobsAge() );
+            }
+            itemNode = (*it)->getMergeNode();
+            if (itemNode) {
+                hash.append( itemNode->getKnobsAge() );
+            }
+        }
+        hash.computeHash();
+        signature = hash.value();
+    }
+
+    if (canCache) {
+        QMutexLocker k(&itemsIndexesMutex);
+        for (std::list<RotoItemsIndexPtr>::iterator it = itemsIndexes.begin(); it != itemsIndexes.end(); ++it) {
+            if ( ( (*it)->time == time ) && ( (*it)->signature == signature ) ) {
+                RotoItemsIndexPtr ret = *it;
+                itemsIndexes.erase(it);
+                itemsIndexes.push_front(ret);
+
+                return ret;
+            }
+        }
+    }
+
+    RotoItemsIndexPtr ret = boost::make_shared<RotoItemsIndex>();
+    ret->time = time;
+    ret->signature = signature;
+
+    double startTime = time, mbFrameStep = 1., endTime = time;
+#ifdef NATRON_ROTO_ENABLE_MOTION_BLUR
+    int mbType_i = context->getMotionBlurTypeKnob()->getValue();
+    bool applyGlobalMotionBlur = mbType_i == 1;
+    if (applyGlobalMotionBlur) {
+        context->getGlobalMotionBlurSettings(time, &startTime, &endTime, &mbFrameStep);
+    }
+#endif
+
+    std::vector<RectD> boxes;
+    boxes.reserve( items.size() );
+    ret->items.reserve( items.size() );
+    {
+        QMutexLocker l(&rotoContextMutex);
+        for (std::list<RotoDrawableItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
+            boxes.push_back( getDrawableItemRegionOfDefinition(it->get(), time, startTime, endTime, mbFrameStep, activeStroke.get()) );
+            ret->items.push_back(*it);
+        }
+    }
+    ret->index.build(boxes);
+
+    if (canCache) {
+        QMutexLocker k(&itemsIndexesMutex);
+        itemsIndexes.push_front(ret);
+        while (itemsIndexes.size() > NATRON_ROTO_MAX_ITEMS_INDEXES) {
+            itemsIndexes.pop_back();
+        }
+    }
+
+    return ret;
+} // RotoContextPrivate::getItemsIndex
+
 void
 RotoContext::getMaskRegionOfDefinition(double time,
-                                       ViewIdx view,
+                                       ViewIdx /*view*/,
                                        RectD* rod) // rod is in canonical coordinates
 const
 {
-    std::list<RotoItemPtr> allItems;
-    {
-        QMutexLocker l(&_imp->rotoContextMutex);
+    *rod = _imp->getItemsIndex(this, time)->index.getBoundingBox();
+}
 
-        for (std::list<RotoLayerPtr>::const_iterator it = _imp->layers.begin(); it != _imp->layers.end(); ++it) {
-            RotoItems items = (*it)->getItems_mt_safe();
-            for (RotoItems::iterator it2 = items.begin(); it2 != items.end(); ++it2) {
-                allItems.push_back(*it2);
-            }
+void
+RotoContext::getItemsIntersectingRect(double time,
+                                      ViewIdx /*view*/,
+                                      const RectD& rect,
+                                      std::list<RotoDrawableItemPtr>* items) const
+{
+    RotoItemsIndexPtr itemsIndex = _imp->getItemsIndex(this, time);
+    std::vector<int> indices;
+
+    itemsIndex->index.query(rect, &indices);
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        RotoDrawableItemPtr item = itemsIndex->items[indices[i]].lock();
+        if (item) {
+            items->push_back(item);
         }
     }
+}
 
-    getItemsRegionOfDefinition(allItems, time, view, rod);
+bool
+RotoContext::hasItemsIntersectingRect(double time,
+                                      ViewIdx /*view*/,
+                                      const RectD& rect) const
+{
+    return _imp->getItemsIndex(this, time)->index.intersects(rect);
 }
 
 bool
@@ -939,13 +1082,8 @@ RotoContext::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableI
                 return false;
             }
         }
-        RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>( it->get() );
-        if (!isStroke) {
-            assert( dynamic_cast<Bezier*>( it->get() ) );
-        } else {
-            if (isStroke->getBrushType() != eRotoStrokeTypeSolid) {
-                return false;
-            }
+        if ( !isRotoPaintItemConcatenatable(*it) ) {
+            return false;
         }
     }
     if (operatorSet) {
@@ -957,6 +1095,21 @@ RotoContext::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableI
     return false;
 }
 
+bool
+RotoContext::isRotoPaintItemConcatenatable(const RotoDrawableItemPtr& item)
+{
+    RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>( item.get() );
+
+    if (!isStroke) {
+        assert( dynamic_cast<Bezier*>( item.get() ) );
+
+        return true;
+    }
+
+    // Other brushes are masked by the stroke in their own merge node
+    return isStroke->getBrushType() == eRotoStrokeTypeSolid;
+}
+
 bool
 RotoContext::isRotoPaintTreeConcatenatable() const
 {
@@ -3844,6 +3997,39 @@ RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigne
     // First compute the mesh composed of triangles of the feather
     assert( !featherPolygon.empty() && !bezierPolygon.empty() && featherPolygon.size() == bezierPolygon.size());
 
+    // The outer vertices are the feather points moved by the feather distance along the normal of the feather polygon.
+    // The normal at a point is given by its neighbours on the whole polygon, not only on its segment: a nearly
+    // straight segment is discretized to its first point only (the last one is the first point of the next segment).
+    std::vector<const ParametricPoint*> featherContour;
+    for (std::list<std::list<ParametricPoint> >::const_iterator fIt = featherPolygon.begin(); fIt != featherPolygon.end(); ++fIt) {
+        for (std::list<ParametricPoint>::const_iterator fSegmentIt = fIt->begin(); fSegmentIt != fIt->end(); ++fSegmentIt) {
+            featherContour.push_back(&*fSegmentIt);
+        }
+    }
+    std::vector<Point> outterPoints( featherContour.size() );
+    for (std::size_t i = 0; i < featherContour.size(); ++i) {
+        outterPoints[i].x = featherContour[i]->x;
+        outterPoints[i].y = featherContour[i]->y;
+        if (absFeatherDist) {
+            const ParametricPoint* fprev = featherContour[(i + featherContour.size() - 1) % featherContour.size()];
+            const ParametricPoint* fnext = featherContour[(i + 1) % featherContour.size()];
+            double diffx = fnext->x - fprev->x;
+            double diffy = fnext->y - fprev->y;
+            double norm = std::sqrt( diffx * diffx + diffy * diffy );
+            double dx = (norm != 0) ? -( diffy / norm ) : 0;
+            double dy = (norm != 0) ? ( diffx / norm ) : 1;
+
+            if (!clockWise) {
+                outterPoints[i].x -= dx * absFeatherDist;
+                outterPoints[i].y -= dy * absFeatherDist;
+            } else {
+                outterPoints[i].x += dx * absFeatherDist;
+                outterPoints[i].y += dy * absFeatherDist;
+            }
+        }
+    }
+
+    std::vector<Point>::const_iterator outterIt = outterPoints.begin();
     std::list<std::list<ParametricPoint> >::const_iterator fIt = featherPolygon.begin();
     for (std::list<std::list<ParametricPoint> > ::const_iterator it = bezierPolygon.begin(); it != bezierPolygon.end(); ++it, ++fIt) {
 
@@ -3856,16 +4042,6 @@ RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigne
         assert(!it->empty() && !fIt->empty());
 
 
-        // prepare iterators to compute derivatives for feather distance
-        std::list<ParametricPoint>::const_iterator fnext = fSegmentIt;
-        ++fnext;  // can only be valid since we assert the list is not empty
-        if ( fnext == fIt->end() ) {
-            fnext = fIt->begin();
-        }
-        std::list<ParametricPoint>::const_iterator fprev = fIt->end();
-        --fprev; // can only be valid since we assert the list is not empty
-
-
         // initialize the state with a segment between the first inner vertex and first outer vertex
         RotoFeatherVertex lastInnerVert,lastOutterVert;
         {
@@ -3876,48 +4052,15 @@ RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigne
             ++bSegmentIt;
         }
         if ( fSegmentIt != fIt->end() ) {
-            lastOutterVert.x = fSegmentIt->x;
-            lastOutterVert.y = fSegmentIt->y;
-
-            if (absFeatherDist) {
-                double diffx = fnext->x - fprev->x;
-                double diffy = fnext->y - fprev->y;
-                double norm = std::sqrt( diffx * diffx + diffy * diffy );
-                double dx = (norm != 0) ? -( diffy / norm ) : 0;
-                double dy = (norm != 0) ? ( diffx / norm ) : 1;
-
-                if (!clockWise) {
-                    lastOutterVert.x -= dx * absFeatherDist;
-                    lastOutterVert.y -= dy * absFeatherDist;
-                } else {
-                    lastOutterVert.x += dx * absFeatherDist;
-                    lastOutterVert.y += dy * absFeatherDist;
-                }
-            }
-
+            lastOutterVert.x = outterIt->x;
+            lastOutterVert.y = outterIt->y;
             lastOutterVert.isInner = false;
             featherMesh->push_back(lastOutterVert);
             ++fSegmentIt;
+            ++outterIt;
         }
 
-        if ( fprev != fIt->end() ) {
-            ++fprev;
-        }
-        if ( fnext != fIt->end() ) {
-            ++fnext;
-        }
-
-
-
         for (;;) {
-
-            if ( fnext == fIt->end() ) {
-                fnext = fIt->begin();
-            }
-            if ( fprev == fIt->end() ) {
-                fprev = fIt->begin();
-            }
-
             double inner_t = (double)INT_MAX;
             double outter_t = (double)INT_MAX;
             bool gotOne = false;
@@ -3945,48 +4088,41 @@ RotoContextPrivate::computeTriangles(const Bezier * bezier, double time, unsigne
                 }
             } else {
                 if ( fSegmentIt != fIt->end() ) {
-                    lastOutterVert.x = fSegmentIt->x;
-                    lastOutterVert.y = fSegmentIt->y;
-
-                    if (absFeatherDist) {
-                        double diffx = fnext->x - fprev->x;
-                        double diffy = fnext->y - fprev->y;
-                        double norm = std::sqrt( diffx * diffx + diffy * diffy );
-                        double dx = (norm != 0) ? -( diffy / norm ) : 0;
-                        double dy = (norm != 0) ? ( diffx / norm ) : 1;
-
-                        if (!clockWise) {
-                            lastOutterVert.x -= dx * absFeatherDist;
-                            lastOutterVert.y -= dy * absFeatherDist;
-                        } else {
-                            lastOutterVert.x += dx * absFeatherDist;
-                            lastOutterVert.y += dy * absFeatherDist;
-                        }
-                    }
+                    lastOutterVert.x = outterIt->x;
+                    lastOutterVert.y = outterIt->y;
                     lastOutterVert.isInner = false;
                     featherMesh->push_back(lastOutterVert);
                     ++fSegmentIt;
-                }
-
-
-                if ( fprev != fIt->end() ) {
-                    ++fprev;
-                }
-                if ( fnext != fIt->end() ) {
-                    ++fnext;
+                    ++outterIt;
                 }
             }
 
-            // Initialize the first segment of the next triangle if we did not reach the end
-            if (fSegmentIt == fIt->end() && bSegmentIt == it->end()) {
-                break;
-            }
+            // Initialize the first segment of the next triangle
             featherMesh->push_back(lastOutterVert);
             featherMesh->push_back(lastInnerVert);
 
 
         } // for(;;)
 
+        // Close the strip with the first vertices of the next segment, which were removed from this one since they are
+        // shared: a segment may have a single vertex
+        std::list<std::list<ParametricPoint> >::const_iterator nextIt = it;
+        ++nextIt;
+        if ( nextIt == bezierPolygon.end() ) {
+            nextIt = bezierPolygon.begin();
+        }
+        RotoFeatherVertex nextInnerVert, nextOutterVert;
+        nextInnerVert.x = nextIt->front().x;
+        nextInnerVert.y = nextIt->front().y;
+        nextInnerVert.isInner = true;
+        const Point& nextOutterPoint = outterIt == outterPoints.end() ? outterPoints.front() : *outterIt;
+        nextOutterVert.x = nextOutterPoint.x;
+        nextOutterVert.y = nextOutterPoint.y;
+        nextOutterVert.isInner = false;
+        featherMesh->push_back(nextInnerVert);
+        featherMesh->push_back(lastOutterVert);
+        featherMesh->push_back(nextInnerVert);
+        featherMesh->push_back(nextOutterVert);
 
     } // for all points in polygon
 
@@ -4640,30 +4776,17 @@ RotoContext::removeItemAsPythonField(const RotoItemPtr& item)
 }
 
 NodePtr
-RotoContext::getOrCreateGlobalMergeNode(int *availableInputIndex)
+RotoContext::getOrCreateGlobalMergeNode(std::size_t index)
 {
     {
         QMutexLocker k(&_imp->rotoContextMutex);
-        for (NodesList::iterator it = _imp->globalMergeNodes.begin(); it != _imp->globalMergeNodes.end(); ++it) {
-            const std::vector<NodeWPtr> &inputs = (*it)->getInputs();
-
-            //Merge node goes like this: B, A, Mask, A2, A3, A4 ...
-            assert( inputs.size() >= 3 && (*it)->getEffectInstance()->isInputMask(2) );
-            if ( !inputs[1].lock() ) {
-                *availableInputIndex = 1;
+        if ( index < _imp->globalMergeNodes.size() ) {
+            NodesList::iterator it = _imp->globalMergeNodes.begin();
+            std::advance(it, index);
 
-                return *it;
-            }
-
-            //Leave the B empty to connect the next merge node
-            for (std::size_t i = 3; i < inputs.size(); ++i) {
-                if ( !inputs[i].lock() ) {
-                    *availableInputIndex = (int)i;
-
-                    return *it;
-                }
-            }
+            return *it;
         }
+        assert( index == _imp->globalMergeNodes.size() );
     }
 
     NodePtr node = getNode();
@@ -4688,7 +4811,6 @@ RotoContext::getOrCreateGlobalMergeNode(int *availableInputIndex)
     if ( getNode()->isDuringPaintStrokeCreation() ) {
         mergeNode->setWhileCreatingPaintStroke(true);
     }
-    *availableInputIndex = 1;
 
     QMutexLocker k(&_imp->rotoContextMutex);
     _imp->globalMergeNodes.push_back(mergeNode);
@@ -4705,10 +4827,6 @@ RotoContext::refreshRotoPaintTree()
 
     // Do not use only activated items when defining the shape of the RotoPaint tree otherwise we would have to adjust the tree at each frame.
     std::list<RotoDrawableItemPtr> items = getCurvesByRenderOrder(false /*onlyActivatedItems*/);
-    int blendingOperator;
-    bool canConcatenate = isRotoPaintTreeConcatenatableInternal(items, &blendingOperator);
-    NodePtr globalMerge;
-    int globalMergeIndex = -1;
     NodesList mergeNodes;
     {
         QMutexLocker k(&_imp->rotoContextMutex);
@@ -4721,43 +4839,74 @@ RotoContext::refreshRotoPaintTree()
             (*it)->disconnectInput(i);
         }
     }
-    if (canConcatenate) {
-        globalMerge = getOrCreateGlobalMergeNode(&globalMergeIndex);
-    }
-    if (globalMerge) {
-        NodePtr rotopaintNodeInput = getNode()->getInput(0);
-        //Connect the rotopaint node input to the B input of the Merge
-        if (rotopaintNodeInput) {
-            globalMerge->connectInput(rotopaintNodeInput, 0);
-        }
-    }
+
+    /*
+       Each run of consecutive items sharing the same compositing operator that can be concatenated (see isRotoPaintItemConcatenatable)
+       is composited at once by a global merge node, other items are composited by their own merge node:
+
+       Upstream Node ---- Global Merge (over) ---- Item Merge (blur) ---- Global Merge (plus) ---- ...
+                          | | | |                  |                      | |
+                          Item effects             Item effect            Item effects
+     */
+    NodePtr upstreamNode = getNode()->getInput(0);
+    NodePtr globalMerge;
+    int globalMergeOperator = -1;
+    int globalMergeIndex = -1;
+    std::size_t nGlobalMergesUsed = 0;
 
     for (std::list<RotoDrawableItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
-        (*it)->refreshNodesConnections();
-
-        if (globalMerge) {
-            {
-                KnobIPtr mergeOperatorKnob = globalMerge->getKnobByName(kMergeOFXParamOperation);
-                KnobChoice* mergeOp = dynamic_cast<KnobChoice*>( mergeOperatorKnob.get() );
-                if (mergeOp) {
-                    mergeOp->setValue(blendingOperator);
-                }
-            }
+        if ( !isRotoPaintItemConcatenatable(*it) ) {
+            (*it)->refreshNodesConnections(upstreamNode);
+            upstreamNode = (*it)->getMergeNode();
+            globalMerge.reset();
+            continue;
+        }
 
-            NodePtr effectNode = (*it)->getEffectNode();
-            assert(effectNode);
-            //qDebug() << "Connecting" << (*it)->getScriptName().c_str() << "to input" << globalMergeIndex <<
-            //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
-            globalMerge->connectInput(effectNode, globalMergeIndex);
-
-            ///Refresh for next node
-            NodePtr nextMerge = getOrCreateGlobalMergeNode(&globalMergeIndex);
-            if (nextMerge != globalMerge) {
-                assert( !nextMerge->getInput(0) );
-                nextMerge->connectInput(globalMerge, 0);
-                globalMerge = nextMerge;
+        // The item merge node is not used, but its inputs are used to render the item
+        (*it)->refreshNodesConnections(upstreamNode);
+
+        int op = (*it)->getCompositingOperator();
+        //Merge node goes like this: B, A, Mask, A2, A3, A4 ...
+        if ( globalMerge && ( (op != globalMergeOperator) || ( globalMergeIndex >= globalMerge->getNInputs() ) ) ) {
+            globalMerge.reset();
+        }
+        if (!globalMerge) {
+            globalMerge = getOrCreateGlobalMergeNode(nGlobalMergesUsed);
+            if (!globalMerge) {
+                // Composite the item with its own merge node
+                upstreamNode = (*it)->getMergeNode();
+                continue;
+            }
+            ++nGlobalMergesUsed;
+            assert( globalMerge->getNInputs() >= 3 && globalMerge->getEffectInstance()->isInputMask(2) );
+            if (upstreamNode) {
+                globalMerge->connectInput(upstreamNode, 0);
+            }
+            KnobIPtr mergeOperatorKnob = globalMerge->getKnobByName(kMergeOFXParamOperation);
+            KnobChoice* mergeOp = dynamic_cast<KnobChoice*>( mergeOperatorKnob.get() );
+            if (mergeOp) {
+                mergeOp->setValue(op);
             }
+            globalMergeOperator = op;
+            globalMergeIndex = 1;
+            upstreamNode = globalMerge;
         }
+
+        NodePtr effectNode = (*it)->getEffectNode();
+        assert(effectNode);
+        //qDebug() << "Connecting" << (*it)->getScriptName().c_str() << "to input" << globalMergeIndex <<
+        //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
+        globalMerge->connectInput(effectNode, globalMergeIndex);
+
+        ///Refresh for next item, skipping the mask input
+        globalMergeIndex = (globalMergeIndex == 1) ? 3 : globalMergeIndex + 1;
+    }
+
+    QMutexLocker k(&_imp->rotoContextMutex);
+    if ( items.empty() ) {
+        _imp->rotoPaintTreeOutput.reset();
+    } else {
+        _imp->rotoPaintTreeOutput = upstreamNode;
     }
 } // RotoContext::refreshRotoPaintTree
 
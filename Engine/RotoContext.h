@@ -55,6 +55,9 @@ CLANG_DIAG_ON(deprecated-declarations)
 //#define NATRON_ROTO_INVERTIBLE
 //#define NATRON_ROTO_ENABLE_MOTION_BLUR
 
+// With motion blur, a shape gets one sample per this many pixels travelled by its points during the shutter
+#define NATRON_ROTO_MOTION_BLUR_PIXELS_PER_SAMPLE 2.
+
 NATRON_NAMESPACE_ENTER
 
 //Small RAII class that properly destroys the cairo image upon destruction
@@ -203,6 +206,23 @@ public:
                                    ViewIdx view,
                                    RectD* rod) const; //!< rod in canonical coordinates
 
+    /**
+     * @brief Returns the drawable items, in render order, whose region of definition at the given time intersects rect
+     * (in canonical coordinates). The regions of definition of the items are computed once per time and kept in a
+     * spatial index until an item changes, so that each tile of a render only considers the items overlapping it.
+     **/
+    void getItemsIntersectingRect(double time,
+                                  ViewIdx view,
+                                  const RectD& rect,
+                                  std::list<RotoDrawableItemPtr>* items) const;
+
+    /**
+     * @brief Same as getItemsIntersectingRect but only tells whether there is any such item.
+     **/
+    bool hasItemsIntersectingRect(double time,
+                                  ViewIdx view,
+                                  const RectD& rect) const;
+
     /**
      * @brief Returns true if  all items have the same compositing operator and there are only strokes or bezier (because they
      * are not masked)
@@ -211,6 +231,12 @@ public:
 
     static bool isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr>& items, int* blendingMode);
 
+    /**
+     * @brief Returns true if the item can be composited along with the items around it sharing the same compositing operator,
+     * i.e it is a Bezier or a solid stroke
+     **/
+    static bool isRotoPaintItemConcatenatable(const RotoDrawableItemPtr& item);
+
     void getGlobalMotionBlurSettings(const double time,
                                      double* startTime,
                                      double* endTime,
@@ -454,7 +480,7 @@ public Q_SLOTS:
 private:
 
 
-    NodePtr getOrCreateGlobalMergeNode(int *availableInputIndex);
+    NodePtr getOrCreateGlobalMergeNode(std::size_t index);
 
     void selectInternal(const RotoItemPtr& b, bool slaveKnobs = true);
     void deselectInternal(RotoItemPtr b);
@@ -56,6 +56,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Global/GlobalDefines.h"
 
 #include "Engine/AppManager.h"
+#include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/Curve.h"
 #include "Engine/EffectInstance.h"
@@ -65,6 +66,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/Node.h"
 #include "Engine/RotoContext.h"
 #include "Engine/RotoPaint.h"
+#include "Engine/RotoSpatialIndex.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
@@ -396,6 +398,30 @@ struct RotoTriangles
     std::list<Point> vertices;
 };
 
+// Number of evaluations of its points that a Bezier keeps, see getFlattenedPolygonKey in Bezier.cpp
+#define NATRON_BEZIER_MAX_FLATTENED_POLYGONS 6
+
+/**
+ * @brief The points of a Bezier or of its feather evaluated by Bezier::deCastelJau, segment by segment, and their bounding box.
+ **/
+struct BezierFlattenedPolygon
+{
+    // Hash of all the parameters of the evaluation, including the position of the control points
+    U64 key;
+    std::list<std::list<ParametricPoint> > segments;
+    RectD bbox;
+
+    BezierFlattenedPolygon()
+        : key(0)
+        , segments()
+        , bbox()
+    {
+        bbox.setupInfinity();
+    }
+};
+
+typedef boost::shared_ptr<BezierFlattenedPolygon> BezierFlattenedPolygonPtr;
+
 struct BezierPrivate
 {
     BezierCPs points; //< the control points of the curve
@@ -413,6 +439,10 @@ struct BezierPrivate
     mutable QMutex guiCopyMutex;
     bool mustCopyGui;
 
+    // The last evaluations of the points, most recently used first. The overlay, the feather and the render evaluate
+    // the same points several times per frame. Protected by the itemMutex
+    std::list<BezierFlattenedPolygonPtr> flattenedPolygons;
+
     BezierPrivate(bool isOpenBezier)
         : points()
         , featherPoints()
@@ -425,9 +455,33 @@ struct BezierPrivate
         , isOpenBezier(isOpenBezier)
         , guiCopyMutex()
         , mustCopyGui(false)
+        , flattenedPolygons()
     {
     }
 
+    BezierFlattenedPolygonPtr findFlattenedPolygon(U64 key)
+    {
+        for (std::list<BezierFlattenedPolygonPtr>::iterator it = flattenedPolygons.begin(); it != flattenedPolygons.end(); ++it) {
+            if ( (*it)->key == key ) {
+                BezierFlattenedPolygonPtr ret = *it;
+                flattenedPolygons.erase(it);
+                flattenedPolygons.push_front(ret);
+
+                return ret;
+            }
+        }
+
+        return BezierFlattenedPolygonPtr();
+    }
+
+    void insertFlattenedPolygon(const BezierFlattenedPolygonPtr& polygon)
+    {
+        flattenedPolygons.push_front(polygon);
+        while (flattenedPolygons.size() > NATRON_BEZIER_MAX_FLATTENED_POLYGONS) {
+            flattenedPolygons.pop_back();
+        }
+    }
+
     void setMustCopyGuiBezier(bool copy)
     {
         QMutexLocker k(&guiCopyMutex);
@@ -1305,6 +1359,34 @@ struct RotoStrokeItemPrivate
     }
 };
 
+// Number of times for which RotoContextPrivate::getItemsIndex keeps the regions of definition of the items
+#define NATRON_ROTO_MAX_ITEMS_INDEXES 8
+
+/**
+ * @brief The regions of definition of all the drawable items of a RotoContext at a given time.
+ **/
+struct RotoItemsIndex
+{
+    double time;
+
+    // Hash of the items and of the age of their nodes when the index was built
+    U64 signature;
+
+    // The items in render order, the spatial index refers to them by their index in this vector
+    std::vector<RotoDrawableItemWPtr> items;
+    RotoSpatialIndex index;
+
+    RotoItemsIndex()
+        : time(0)
+        , signature(0)
+        , items()
+        , index()
+    {
+    }
+};
+
+typedef boost::shared_ptr<RotoItemsIndex> RotoItemsIndexPtr;
+
 struct RotoContextPrivate
 {
     Q_DECLARE_TR_FUNCTIONS(RotoContext)
@@ -1400,10 +1482,18 @@ public:
     bool mustDoNeatRender;
 
     /*
-     * A merge node (or more if there are more than 64 items) used when all items share the same compositing operator to make the rotopaint tree shallow
+     * Merge nodes compositing at once each run of consecutive items sharing the same compositing operator that do not need
+     * their own mask (Beziers and solid strokes), to make the rotopaint tree shallow. A run of more than 64 items uses several merge nodes.
      */
     NodesList globalMergeNodes;
 
+    // The node at the bottom of the rotopaint tree, set by refreshRotoPaintTree()
+    NodeWPtr rotoPaintTreeOutput;
+
+    // The regions of definition of the items at the last times they were needed, most recently used first
+    mutable QMutex itemsIndexesMutex;
+    std::list<RotoItemsIndexPtr> itemsIndexes;
+
     RotoContextPrivate(const NodePtr& n )
         : rotoContextMutex()
         , isPaintNode(false)
@@ -1417,6 +1507,9 @@ public:
         , doingNeatRender(false)
         , mustDoNeatRender(false)
         , globalMergeNodes()
+        , rotoPaintTreeOutput()
+        , itemsIndexesMutex()
+        , itemsIndexes()
     {
         EffectInstancePtr effect = n->getEffectInstance();
         RotoPaint* isRotoNode = dynamic_cast<RotoPaint*>( effect.get() );
@@ -2173,6 +2266,12 @@ public:
 #endif // ifdef NATRON_ROTO_ENABLE_MOTION_BLUR
     }
 
+    /**
+     * @brief Returns the regions of definition of all the items at the given time, computing them only if an item
+     * changed since the last call for this time.
+     **/
+    RotoItemsIndexPtr getItemsIndex(const RotoContext* context, double time);
+
     /**
      * @brief Call this after any change to notify the mask has changed for the cache.
      **/
@@ -701,9 +701,20 @@ RotoDrawableItem::getFrameHoldNode() const
 void
 RotoDrawableItem::refreshNodesConnections()
 {
-    RotoDrawableItem* previous = findPreviousInHierarchy();
+    // The rotopaint tree may composite the items below at once, in which case the merge node of the item below is not in the tree
+    NodePtr upstreamNode = _imp->mergeNode->getInput(0);
+
+    if (!upstreamNode) {
+        RotoDrawableItem* previous = findPreviousInHierarchy();
+        upstreamNode = previous ? previous->getMergeNode() : getContext()->getNode()->getInput(0);
+    }
+    refreshNodesConnections(upstreamNode);
+}
+
+void
+RotoDrawableItem::refreshNodesConnections(const NodePtr& upstreamNode)
+{
     NodePtr rotoPaintInput =  getContext()->getNode()->getInput(0);
-    NodePtr upstreamNode = previous ? previous->getMergeNode() : rotoPaintInput;
     RotoStrokeItem* isStroke = dynamic_cast<RotoStrokeItem*>(this);
     RotoStrokeType type;
 
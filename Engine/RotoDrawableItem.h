@@ -84,7 +84,12 @@ public:
 
     void incrementNodesAge();
 
+    /**
+     * @brief Connects the nodes of this item. The item is composited over upstreamNode, which is the node set by the last
+     * RotoContext::refreshRotoPaintTree() or, if the item was not connected yet, the merge node of the item below
+     **/
     void refreshNodesConnections();
+    void refreshNodesConnections(const NodePtr& upstreamNode);
 
     virtual void clone(const RotoItem*  other) OVERRIDE;
 
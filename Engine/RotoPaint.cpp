@@ -1368,6 +1368,59 @@ RotoPaint::onInputChanged(int inputNb)
     EffectInstance::onInputChanged(inputNb);
 }
 
+/**
+ * @brief Returns true if merging a transparent A over B with the given operator yields B.
+ **/
+static bool
+isMergeOperatorIdentityOutsideA(MergingFunctionEnum op)
+{
+    switch (op) {
+    case eMergeATop:
+    case eMergeConjointOver:
+    case eMergeDisjointOver:
+    case eMergeMatte:
+    case eMergeOver:
+    case eMergePlus:
+    case eMergeScreen:
+    case eMergeUnder:
+    case eMergeXOR:
+
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Returns true if, outside of the region of definition of the items, the rotopaint tree outputs a copy of its source.
+ * This is not the case if an item is inverted or uses an operator that modifies B where A is transparent.
+ **/
+static bool
+itemsOnlyAffectTheirRegionOfDefinition(const std::list<RotoDrawableItemPtr>& items,
+                                       double time)
+{
+    for (std::list<RotoDrawableItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it) {
+        if ( (*it)->getInverted(time) || !isMergeOperatorIdentityOutsideA( (MergingFunctionEnum)(*it)->getCompositingOperator() ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the canonical rect covered by a rect of pixels. Used to query the items of the RotoContext overlapping a tile.
+ **/
+static RectD
+pixelRectToCanonical(const RectI& rect,
+                     const RenderScale& scale,
+                     double par)
+{
+    return RectD(rect.x1 * par / scale.x, rect.y1 / scale.y, rect.x2 * par / scale.x, rect.y2 / scale.y);
+}
+
 StatusEnum
 RotoPaint::getRegionOfDefinition(U64 hash,
                                  double time,
@@ -1450,7 +1503,8 @@ RotoPaint::isIdentity(double time,
         }
     }
 
-    std::list<RotoDrawableItemPtr> items = node->getRotoContext()->getCurvesByRenderOrder();
+    RotoContextPtr roto = node->getRotoContext();
+    std::list<RotoDrawableItemPtr> items = roto->getCurvesByRenderOrder();
     if ( items.empty() ) {
         *inputNb = 0;
         *inputTime = time;
@@ -1458,8 +1512,19 @@ RotoPaint::isIdentity(double time,
         return true;
     }
 
+    // Tiles that no item touches are a copy of the source: the host copies them instead of rendering them
+    if ( _imp->premultKnob.lock()->getValueAtTime(time) || !itemsOnlyAffectTheirRegionOfDefinition(items, time) ) {
+        return false;
+    }
+    if ( !roto->hasItemsIntersectingRect( time, view, pixelRectToCanonical( roi, scale, getAspectRatio(-1) ) ) ) {
+        *inputTime = time;
+        *inputNb = 0;
+
+        return true;
+    }
+
     return false;
-}
+} // RotoPaint::isIdentity
 
 StatusEnum
 RotoPaint::render(const RenderActionArgs& args)
@@ -1478,7 +1543,10 @@ RotoPaint::render(const RenderActionArgs& args)
     assert(premultKnob);
     bool premultiply = premultKnob->getValueAtTime(args.time);
 
-    if ( items.empty() ) {
+    // When no item overlaps the roi, the rotopaint tree would only copy the source
+    if ( items.empty() ||
+         ( itemsOnlyAffectTheirRegionOfDefinition(items, args.time) &&
+           !roto->hasItemsIntersectingRect( args.time, args.view, pixelRectToCanonical( args.roi, args.mappedScale, getAspectRatio(-1) ) ) ) ) {
         RectI bgImgRoI;
         ImagePtr bgImg = getImage(0, args.time, args.mappedScale, args.view, 0, 0, false /*mapToClipPrefs*/, false /*dontUpscale*/, eStorageModeRAM /*returnOpenGLtexture*/, 0 /*textureDepth*/, &bgImgRoI);
 
@@ -1607,10 +1675,14 @@ RotoPaint::render(const RenderActionArgs& args)
                     dRect.x2 = bgBounds.x1;
                     dRect.y2 = bgBounds.y2;
 
-                    plane->second->fillZero(aRect);
-                    plane->second->fillZero(bRect);
-                    plane->second->fillZero(cRect);
-                    plane->second->fillZero(dRect);
+                    // Do not write outside of the roi: other tiles of the same image may be rendered concurrently
+                    RectI borders[4] = {aRect, bRect, cRect, dRect};
+                    for (int i = 0; i < 4; ++i) {
+                        RectI border;
+                        if ( borders[i].intersect(args.roi, &border) ) {
+                            plane->second->fillZero(border);
+                        }
+                    }
 
                     if ( bgImg->getComponents() != plane->second->getComponents() ) {
                         RectI intersection;
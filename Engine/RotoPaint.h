@@ -96,10 +96,10 @@ public:
     virtual void addAcceptedComponents(int inputNb, std::list<ImagePlaneDesc>* comps) OVERRIDE FINAL;
     virtual void addSupportedBitDepth(std::list<ImageBitDepthEnum>* depths) const OVERRIDE FINAL;
 
-    ///Doesn't really matter here since it won't be used (this effect is always an identity)
+    ///The render window is sliced in tiles rendered concurrently, tiles that no item touches are copied from the source
     virtual RenderSafetyEnum renderThreadSafety() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
-        return eRenderSafetyFullySafe;
+        return eRenderSafetyFullySafeFrame;
     }
 
     virtual bool supportsTiles() const OVERRIDE FINAL WARN_UNUSED_RETURN
@@ -107,6 +107,12 @@ public:
         return true;
     }
 
+    virtual bool isRenderSingleThreaded() const OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        // While drawing, only the area of the last stroke tick is rendered
+        return !isDuringPaintStrokeCreationThreadLocal();
+    }
+
     virtual bool supportsMultiResolution() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
         return true;
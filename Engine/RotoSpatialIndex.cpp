@@ -0,0 +1,165 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoSpatialIndex.h"
+
+#include <algorithm> // min, max, sort, unique
+#include <cmath>
+
+// Above this many cells per side, the grid costs more memory than it saves time
+#define ROTO_SPATIAL_INDEX_MAX_CELLS_PER_SIDE 64
+
+NATRON_NAMESPACE_ENTER
+
+RotoSpatialIndex::RotoSpatialIndex()
+    : _boxes()
+    , _bbox()
+    , _nx(0)
+    , _ny(0)
+    , _cellWidth(0.)
+    , _cellHeight(0.)
+    , _cells()
+{
+}
+
+RotoSpatialIndex::~RotoSpatialIndex()
+{
+}
+
+void
+RotoSpatialIndex::build(const std::vector<RectD>& boxes)
+{
+    _boxes = boxes;
+    _bbox.clear();
+    _cells.clear();
+    _nx = _ny = 0;
+
+    int nBoxes = 0;
+    for (std::size_t i = 0; i < _boxes.size(); ++i) {
+        if ( _boxes[i].isNull() ) {
+            continue;
+        }
+        if (nBoxes == 0) {
+            _bbox = _boxes[i];
+        } else {
+            _bbox.merge(_boxes[i]);
+        }
+        ++nBoxes;
+    }
+    if (nBoxes == 0) {
+        return;
+    }
+
+    // About one cell per box, as square as possible
+    double aspect = _bbox.width() / _bbox.height();
+    _nx = (int)std::ceil( std::sqrt(nBoxes * aspect) );
+    _nx = std::max( 1, std::min(_nx, ROTO_SPATIAL_INDEX_MAX_CELLS_PER_SIDE) );
+    _ny = (int)std::ceil( (double)nBoxes / _nx );
+    _ny = std::max( 1, std::min(_ny, ROTO_SPATIAL_INDEX_MAX_CELLS_PER_SIDE) );
+    _cellWidth = _bbox.width() / _nx;
+    _cellHeight = _bbox.height() / _ny;
+    _cells.resize(_nx * _ny);
+
+    for (std::size_t i = 0; i < _boxes.size(); ++i) {
+        int x1, y1, x2, y2;
+        if ( _boxes[i].isNull() || !getCellsRange(_boxes[i], &x1, &y1, &x2, &y2) ) {
+            continue;
+        }
+        for (int y = y1; y <= y2; ++y) {
+            for (int x = x1; x <= x2; ++x) {
+                _cells[y * _nx + x].push_back( (int)i );
+            }
+        }
+    }
+} // RotoSpatialIndex::build
+
+bool
+RotoSpatialIndex::getCellsRange(const RectD& rect,
+                                int* x1,
+                                int* y1,
+                                int* x2,
+                                int* y2) const
+{
+    RectD clipped;
+
+    if ( _cells.empty() || !rect.intersect(_bbox, &clipped) ) {
+        return false;
+    }
+    *x1 = std::max( 0, std::min( _nx - 1, (int)std::floor( (clipped.x1 - _bbox.x1) / _cellWidth ) ) );
+    *x2 = std::max( 0, std::min( _nx - 1, (int)std::floor( (clipped.x2 - _bbox.x1) / _cellWidth ) ) );
+    *y1 = std::max( 0, std::min( _ny - 1, (int)std::floor( (clipped.y1 - _bbox.y1) / _cellHeight ) ) );
+    *y2 = std::max( 0, std::min( _ny - 1, (int)std::floor( (clipped.y2 - _bbox.y1) / _cellHeight ) ) );
+
+    return true;
+}
+
+void
+RotoSpatialIndex::query(const RectD& rect,
+                        std::vector<int>* indices) const
+{
+    indices->clear();
+
+    int x1, y1, x2, y2;
+    if ( !getCellsRange(rect, &x1, &y1, &x2, &y2) ) {
+        return;
+    }
+    for (int y = y1; y <= y2; ++y) {
+        for (int x = x1; x <= x2; ++x) {
+            const std::vector<int>& cell = _cells[y * _nx + x];
+            for (std::size_t i = 0; i < cell.size(); ++i) {
+                if ( _boxes[cell[i]].intersects(rect) ) {
+                    indices->push_back(cell[i]);
+                }
+            }
+        }
+    }
+
+    // A box overlapping several cells was found once per cell
+    std::sort( indices->begin(), indices->end() );
+    indices->erase( std::unique( indices->begin(), indices->end() ), indices->end() );
+}
+
+bool
+RotoSpatialIndex::intersects(const RectD& rect) const
+{
+    int x1, y1, x2, y2;
+
+    if ( !getCellsRange(rect, &x1, &y1, &x2, &y2) ) {
+        return false;
+    }
+    for (int y = y1; y <= y2; ++y) {
+        for (int x = x1; x <= x2; ++x) {
+            const std::vector<int>& cell = _cells[y * _nx + x];
+            for (std::size_t i = 0; i < cell.size(); ++i) {
+                if ( _boxes[cell[i]].intersects(rect) ) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,88 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ROTOSPATIALINDEX_H
+#define NATRON_ENGINE_ROTOSPATIALINDEX_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include "Engine/RectD.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief A uniform grid over a set of bounding boxes, used by the RotoContext to find the items overlapping a tile
+ * without testing the bounding box of every item of the context.
+ * Boxes are identified by their index in the vector passed to build(). Null boxes are never returned.
+ **/
+class RotoSpatialIndex
+{
+public:
+
+    RotoSpatialIndex();
+
+    ~RotoSpatialIndex();
+
+    /**
+     * @brief Builds the grid for the given boxes, replacing any previous content.
+     **/
+    void build(const std::vector<RectD>& boxes);
+
+    /**
+     * @brief Returns the union of all the boxes, which is null if there is none.
+     **/
+    const RectD& getBoundingBox() const
+    {
+        return _bbox;
+    }
+
+    /**
+     * @brief Returns the indices of the boxes intersecting rect, in increasing order.
+     **/
+    void query(const RectD& rect, std::vector<int>* indices) const;
+
+    /**
+     * @brief Returns true if any box intersects rect. Cheaper than query() as it stops at the first box found.
+     **/
+    bool intersects(const RectD& rect) const;
+
+private:
+
+    bool getCellsRange(const RectD& rect, int* x1, int* y1, int* x2, int* y2) const;
+
+    std::vector<RectD> _boxes;
+    RectD _bbox;
+    int _nx, _ny;
+    double _cellWidth, _cellHeight;
+
+    // _nx * _ny cells, row by row, each listing the boxes overlapping it
+    std::vector<std::vector<int> > _cells;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_ROTOSPATIALINDEX_H
@@ -332,6 +332,18 @@ Settings::initializeKnobsThreading()
                                                  "a separate process so that if the main application crashes, the render goes on.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
     _threadingPage->addKnob(_renderInSeparateProcess);
 
+    _nRenderProcesses = AppManager::createKnob<KnobInt>( this, tr("Number of render processes") );
+    _nRenderProcesses->setName("nRenderProcesses");
+    _nRenderProcesses->setHintToolTip( tr("When rendering in a separate process, this is the number of processes "
+                                          "the frame range of a Write node is split across. Each process renders a chunk of "
+                                          "frames and takes the next chunk when done, so that all processes finish at about "
+                                          "the same time. Using several processes is useful when a single process cannot use all "
+                                          "the cores of the machine, for instance because of Python scripts or plug-ins that do not scale. "
+                                          "Video files are always rendered by a single process.") );
+    _nRenderProcesses->setMinimum(1);
+    _nRenderProcesses->disableSlider();
+    _threadingPage->addKnob(_nRenderProcesses);
+
     _queueRenders = AppManager::createKnob<KnobBool>( this, tr("Append new renders to queue") );
     _queueRenders->setHintToolTip( tr("When checked, renders will be queued in the Progress Panel and will start only when all "
                                       "other prior tasks are done.") );
@@ -1113,6 +1125,14 @@ Settings::initializeKnobsViewers()
 
     _viewersTab->addKnob(_autoProxyLevel);
 
+    _adaptivePlaybackResolution = AppManager::createKnob<KnobBool>( this, tr("Lower resolution to hold the frame rate during playback") );
+    _adaptivePlaybackResolution->setName("adaptivePlaybackResolution");
+    _adaptivePlaybackResolution->setHintToolTip( tr("When checked, the cost of the frames rendered during playback is measured and "
+                                                    "the viewer renders at a lower resolution when they cannot be rendered at the "
+                                                    "desired frame rate. The current frame is rendered again at full resolution "
+                                                    "once playback stops.") );
+    _viewersTab->addKnob(_adaptivePlaybackResolution);
+
     _maximumNodeViewerUIOpened = AppManager::createKnob<KnobInt>( this, tr("Max. opened node viewer interface") );
     _maximumNodeViewerUIOpened->setName("maxNodeUiOpened");
     _maximumNodeViewerUIOpened->setMinimum(1);
@@ -1266,6 +1286,46 @@ Settings::initializeKnobsCaching()
     _maxDiskCacheNodeGB->setHintToolTip( tr("The maximum size that may be used by the DiskCache node on disk (in GiB)") );
     _cachingTab->addKnob(_maxDiskCacheNodeGB);
 
+    _compressDiskCacheNode = AppManager::createKnob<KnobBool>( this, tr("Compress DiskCache node images") );
+    _compressDiskCacheNode->setName("compressDiskCacheNode");
+    _compressDiskCacheNode->setHintToolTip( tr("When checked, images cached by the DiskCache node are compressed losslessly "
+                                               "once they are not used anymore. Compression happens in a background thread and "
+                                               "typically halves the disk usage of the cache, at the expense of some CPU time when "
+                                               "images are read back.") );
+    _cachingTab->addKnob(_compressDiskCacheNode);
+
+    _readAheadMaxFrames = AppManager::createKnob<KnobInt>( this, tr("Read-ahead frames") );
+    _readAheadMaxFrames->setName("readAheadFrames");
+    _readAheadMaxFrames->disableSlider();
+    _readAheadMaxFrames->setMinimum(0);
+    _readAheadMaxFrames->setMaximum(100);
+    _readAheadMaxFrames->setHintToolTip( tr("During playback and when rendering a sequence, Read nodes decode in background threads "
+                                            "up to this number of frames ahead of the frame being rendered, so that they are already "
+                                            "in the cache when needed. The actual number of frames adapts to the decoding time and "
+                                            "to the space left in the cache. Set to 0 to disable read-ahead.") );
+    _cachingTab->addKnob(_readAheadMaxFrames);
+
+    _speculativeRenderFrames = AppManager::createKnob<KnobInt>( this, tr("Frames rendered around the current frame") );
+    _speculativeRenderFrames->setName("speculativeRenderFrames");
+    _speculativeRenderFrames->disableSlider();
+    _speculativeRenderFrames->setMinimum(0);
+    _speculativeRenderFrames->setMaximum(50);
+    _speculativeRenderFrames->setHintToolTip( tr("When the viewer is idle, up to this number of frames before and after the current frame "
+                                                 "are rendered in a low priority background thread and stored in the playback cache, so that "
+                                                 "stepping to them or scrubbing over them is immediate. These renders are aborted as soon as "
+                                                 "anything else needs to be rendered. Set to 0 to disable.") );
+    _speculativeRenderFrames->setAddNewLine(false);
+    _cachingTab->addKnob(_speculativeRenderFrames);
+
+    _speculativeRenderCachePercent = AppManager::createKnob<KnobInt>( this, tr("Playback cache used by these frames (%)") );
+    _speculativeRenderCachePercent->setName("speculativeRenderCachePercent");
+    _speculativeRenderCachePercent->disableSlider();
+    _speculativeRenderCachePercent->setMinimum(1);
+    _speculativeRenderCachePercent->setMaximum(100);
+    _speculativeRenderCachePercent->setHintToolTip( tr("The frames rendered around the current frame may use at most this percentage "
+                                                       "of the maximum size of the playback cache, in memory and on disk.") );
+    _cachingTab->addKnob(_speculativeRenderCachePercent);
+
 
     _diskCachePath = AppManager::createKnob<KnobPath>( this, tr("Disk cache path") );
     _diskCachePath->setName("diskCachePath");
@@ -1450,6 +1510,7 @@ Settings::setDefaultValues()
     _useThreadPool->setDefaultValue(true);
     _nThreadsPerEffect->setDefaultValue(0);
     _renderInSeparateProcess->setDefaultValue(false, 0);
+    _nRenderProcesses->setDefaultValue(1);
     _queueRenders->setDefaultValue(false);
 
     // General/Rendering
@@ -1503,6 +1564,10 @@ Settings::setDefaultValues()
     _unreachableRAMPercent->setDefaultValue(5);
     _maxViewerDiskCacheGB->setDefaultValue(5, 0);
     _maxDiskCacheNodeGB->setDefaultValue(10, 0);
+    _compressDiskCacheNode->setDefaultValue(false);
+    _readAheadMaxFrames->setDefaultValue(16);
+    _speculativeRenderFrames->setDefaultValue(2);
+    _speculativeRenderCachePercent->setDefaultValue(25);
     //_diskCachePath
     setCachingLabels();
 
@@ -1521,6 +1586,7 @@ Settings::setDefaultValues()
     _autoWipe->setDefaultValue(true);
     _autoProxyWhenScrubbingTimeline->setDefaultValue(true);
     _autoProxyLevel->setDefaultValue(1);
+    _adaptivePlaybackResolution->setDefaultValue(false);
     _maximumNodeViewerUIOpened->setDefaultValue(2);
     _viewerKeys->setDefaultValue(true);
 
@@ -2250,6 +2316,10 @@ Settings::onKnobValueChanged(KnobI* k,
         if (!_restoringSettings) {
             appPTR->setApplicationsCachesMaximumDiskSpace( getMaximumDiskCacheNodeSize() );
         }
+    } else if ( k == _compressDiskCacheNode.get() ) {
+        if (!_restoringSettings) {
+            appPTR->setDiskCacheCompressionEnabled( isDiskCacheNodeCompressionEnabled() );
+        }
     } else if ( k == _maxRAMPercent.get() ) {
         if (!_restoringSettings) {
             appPTR->setApplicationsCachesMaximumMemoryPercent( getRamMaximumPercent() );
@@ -2458,6 +2528,12 @@ Settings::getAutoProxyMipMapLevel() const
     return (unsigned int)_autoProxyLevel->getValue() + 1;
 }
 
+bool
+Settings::isAdaptivePlaybackResolutionEnabled() const
+{
+    return _adaptivePlaybackResolution->getValue();
+}
+
 int
 Settings::getMaxOpenedNodesViewerContext() const
 {
@@ -2497,6 +2573,30 @@ Settings::getMaximumDiskCacheNodeSize() const
     return (U64)( _maxDiskCacheNodeGB->getValue() ) * 1024 * 1024 * 1024;
 }
 
+bool
+Settings::isDiskCacheNodeCompressionEnabled() const
+{
+    return _compressDiskCacheNode->getValue();
+}
+
+int
+Settings::getReadAheadMaxFrames() const
+{
+    return _readAheadMaxFrames->getValue();
+}
+
+int
+Settings::getSpeculativeRenderFrames() const
+{
+    return _speculativeRenderFrames->getValue();
+}
+
+double
+Settings::getSpeculativeRenderCacheShare() const
+{
+    return (double)_speculativeRenderCachePercent->getValue() / 100.;
+}
+
 ///////////////////////////////////////////////////
 
 double
@@ -2747,6 +2847,12 @@ Settings::isRenderInSeparatedProcessEnabled() const
     return _renderInSeparateProcess->getValue();
 }
 
+int
+Settings::getNumberOfRenderProcesses() const
+{
+    return _nRenderProcesses->getValue();
+}
+
 int
 Settings::getMaximumUndoRedoNodeGraph() const
 {
@@ -110,6 +110,12 @@ public:
 
     U64 getMaximumDiskCacheNodeSize() const;
 
+    bool isDiskCacheNodeCompressionEnabled() const;
+
+    int getReadAheadMaxFrames() const;
+    int getSpeculativeRenderFrames() const;
+    double getSpeculativeRenderCacheShare() const;
+
     double getUnreachableRamPercent() const;
 
     bool getColorPickerLinear() const;
@@ -166,6 +172,8 @@ public:
 
     bool isRenderInSeparatedProcessEnabled() const;
 
+    int getNumberOfRenderProcesses() const;
+
     bool isRenderQueuingEnabled() const;
 
     void setRenderQueuingEnabled(bool enabled);
@@ -247,6 +255,7 @@ public:
     bool isAutoWipeEnabled() const;
     bool isAutoProxyEnabled() const;
     unsigned int getAutoProxyMipMapLevel() const;
+    bool isAdaptivePlaybackResolutionEnabled() const;
     int getMaxOpenedNodesViewerContext() const;
     bool isViewerKeysEnabled() const;
     ///////////////////////////////////////////////////////
@@ -436,6 +445,7 @@ private:
     KnobBoolPtr _useThreadPool;
     KnobIntPtr _nThreadsPerEffect;
     KnobBoolPtr _renderInSeparateProcess;
+    KnobIntPtr _nRenderProcesses;
     KnobBoolPtr _queueRenders;
 
     // General/Rendering
@@ -512,6 +522,10 @@ private:
     ///The total disk space allowed for all Natron's caches
     KnobIntPtr _maxViewerDiskCacheGB;
     KnobIntPtr _maxDiskCacheNodeGB;
+    KnobBoolPtr _compressDiskCacheNode;
+    KnobIntPtr _readAheadMaxFrames;
+    KnobIntPtr _speculativeRenderFrames;
+    KnobIntPtr _speculativeRenderCachePercent;
     KnobPathPtr _diskCachePath;
     KnobButtonPtr _wipeDiskCache;
 
@@ -525,6 +539,7 @@ private:
     KnobBoolPtr _autoWipe;
     KnobBoolPtr _autoProxyWhenScrubbingTimeline;
     KnobChoicePtr _autoProxyLevel;
+    KnobBoolPtr _adaptivePlaybackResolution;
     KnobIntPtr _maximumNodeViewerUIOpened;
     KnobBoolPtr _viewerKeys;
 
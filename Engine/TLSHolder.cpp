@@ -26,7 +26,10 @@
 #include "TLSHolderImpl.h"
 
 #include <cassert>
+#include <map>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "Engine/OfxClipInstance.h"
 #include "Engine/OfxHost.h"
@@ -34,6 +37,7 @@
 #include "Engine/Project.h"
 #include "Engine/ThreadPool.h"
 
+#include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
 #include <QtCore/QThread>
 #include <QtCore/QDebug>
@@ -41,11 +45,46 @@
 NATRON_NAMESPACE_ENTER
 
 
+namespace {
+// The process-wide state of the TLS. It is never deleted, so that TLSHolders destroyed after the
+// AppManager can still release their slot.
+struct TLSRegistry
+{
+    // Protects everything below. When a thread slot table is locked too, this one is locked first.
+    QMutex lock;
+
+    // The slot table of every thread that used TLS since it last cleaned it up
+    std::map<const QThread*, TLSThreadSlots*> threads;
+
+    // Slot indices of destroyed holders, to be reused
+    std::vector<std::size_t> freeSlots;
+    std::size_t nSlots;
+
+    TLSRegistry()
+        : lock()
+        , threads()
+        , freeSlots()
+        , nSlots(0)
+    {
+    }
+};
+
+TLSRegistry* const tlsRegistry = new TLSRegistry();
+}
+
+NATRON_THREAD_LOCAL TLSThreadSlots* AppTLS::_currentThreadSlots = 0;
+
+TLSHolderBase::TLSHolderBase()
+    : _slotIndex( AppTLS::allocateSlotIndex() )
+{
+}
+
+TLSHolderBase::~TLSHolderBase()
+{
+    AppTLS::releaseSlotIndex(_slotIndex);
+}
+
 AppTLS::AppTLS()
-    : _objectMutex()
-    , _object( new GLobalTLSObject() )
-    , _spawnsMutex()
-    , _spawns()
 {
 }
 
@@ -53,16 +92,133 @@ AppTLS::~AppTLS()
 {
 }
 
+std::size_t
+AppTLS::allocateSlotIndex()
+{
+    QMutexLocker k(&tlsRegistry->lock);
+
+    if ( !tlsRegistry->freeSlots.empty() ) {
+        std::size_t index = tlsRegistry->freeSlots.back();
+        tlsRegistry->freeSlots.pop_back();
+
+        return index;
+    }
+
+    return tlsRegistry->nSlots++;
+}
+
+void
+AppTLS::releaseSlotIndex(std::size_t index)
+{
+    //The values are destroyed once the locks are released, since they may own other TLSHolders
+    std::vector<boost::shared_ptr<void> > values;
+    {
+        QMutexLocker k(&tlsRegistry->lock);
+        for (std::map<const QThread*, TLSThreadSlots*>::iterator it = tlsRegistry->threads.begin(); it != tlsRegistry->threads.end(); ++it) {
+            QMutexLocker l(&it->second->lock);
+            if ( ( index < it->second->values.size() ) && it->second->values[index].value ) {
+                values.push_back(it->second->values[index].value);
+                it->second->values[index] = TLSSlot();
+            }
+        }
+        tlsRegistry->freeSlots.push_back(index);
+    }
+}
+
+TLSThreadSlots*
+AppTLS::getOrCreateCurrentThreadSlots()
+{
+    if (_currentThreadSlots) {
+        return _currentThreadSlots;
+    }
+
+    TLSThreadSlots* slots = new TLSThreadSlots();
+    //A table left by a finished thread that never cleaned up its TLS
+    TLSThreadSlots* deadThreadSlots = 0;
+    {
+        QMutexLocker k(&tlsRegistry->lock);
+        TLSThreadSlots*& registered = tlsRegistry->threads[QThread::currentThread()];
+        deadThreadSlots = registered;
+        registered = slots;
+    }
+    delete deadThreadSlots;
+    _currentThreadSlots = slots;
+
+    return slots;
+}
+
 void
-AppTLS::registerTLSHolder(const TLSHolderBaseConstPtr& holder)
+AppTLS::setCurrentThreadData(std::size_t index,
+                             const boost::shared_ptr<void>& value,
+                             boost::shared_ptr<void> (*copy)(const boost::shared_ptr<void>&))
 {
-    //This must be the first time for this thread that we reach here since cleanupTLSForThread() was made, otherwise
-    //the TLS data should always be available on the TLSHolder
+    TLSThreadSlots* slots = getOrCreateCurrentThreadSlots();
+    TLSSlot slot;
+
+    slot.value = value;
+    slot.copy = copy;
+
+    QMutexLocker k(&slots->lock);
+    if ( index >= slots->values.size() ) {
+        slots->values.resize(index + 1);
+    }
+    slots->values[index] = slot;
+}
+
+static void
+copyTLSFromThread(const QThread* fromThread,
+                  TLSThreadSlots* toSlots)
+{
+    //The values referenced here are destroyed once the locks are released, since they may own other TLSHolders
+    std::vector<TLSSlot> fromValues, replaced;
+    std::vector<std::pair<std::size_t, TLSSlot> > copies;
+
+    QMutexLocker k(&tlsRegistry->lock);
+    std::map<const QThread*, TLSThreadSlots*>::iterator found = tlsRegistry->threads.find(fromThread);
+
+    if ( ( found == tlsRegistry->threads.end() ) || (found->second == toSlots) ) {
+        //fromThread did not use any TLS
+        return;
+    }
+
     {
-        QWriteLocker k(&_objectMutex);
-        //The insert call might not succeed because another thread inserted this holder in the set already, that's fine
-        _object->objects.insert(holder);
+        QMutexLocker l(&found->second->lock);
+        fromValues = found->second->values;
+    }
+
+    //Copies are made while the registry is locked so that no holder can release its slot meanwhile
+    for (std::size_t i = 0; i < fromValues.size(); ++i) {
+        if (fromValues[i].value && fromValues[i].copy) {
+            TLSSlot slot;
+            slot.value = fromValues[i].copy(fromValues[i].value);
+            if (slot.value) {
+                slot.copy = fromValues[i].copy;
+                copies.push_back( std::make_pair(i, slot) );
+            }
+        }
+    }
+    if ( copies.empty() ) {
+        return;
+    }
+
+    QMutexLocker l(&toSlots->lock);
+    if ( copies.back().first >= toSlots->values.size() ) {
+        toSlots->values.resize(copies.back().first + 1);
     }
+    for (std::size_t i = 0; i < copies.size(); ++i) {
+        TLSSlot& slot = toSlots->values[copies[i].first];
+        replaced.push_back(slot);
+        slot = copies[i].second;
+    }
+}
+
+void
+AppTLS::copyTLSFromSpawnerThread(TLSThreadSlots* slots)
+{
+    const QThread* spawner = slots->spawner;
+
+    slots->spawner = 0;
+    copyTLSFromThread(spawner, slots);
 }
 
 static void
@@ -88,18 +244,11 @@ AppTLS::copyTLS(QThread* fromThread,
     if ( (fromThread == toThread) || !fromThread || !toThread ) {
         return;
     }
+    assert( toThread == QThread::currentThread() );
 
     copyAbortInfo(fromThread, toThread);
 
-    QReadLocker k(&_objectMutex);
-    const TLSObjects& objectsCRef = _object->objects; // take a const ref, since it's a read lock
-    for (TLSObjects::const_iterator it = objectsCRef.begin();
-         it != objectsCRef.end(); ++it) {
-        TLSHolderBaseConstPtr p = (*it).lock();
-        if (p) {
-            p->copyTLS(fromThread, toThread);
-        }
-    }
+    copyTLSFromThread( fromThread, getOrCreateCurrentThreadSlots() );
 }
 
 void
@@ -109,11 +258,11 @@ AppTLS::softCopy(QThread* fromThread,
     if ( (fromThread == toThread) || !fromThread || !toThread ) {
         return;
     }
+    assert( toThread == QThread::currentThread() );
 
     copyAbortInfo(fromThread, toThread);
 
-    QWriteLocker k(&_spawnsMutex);
-    _spawns[toThread] = fromThread;
+    getOrCreateCurrentThreadSlots()->spawner = fromThread;
 }
 
 void
@@ -126,66 +275,20 @@ AppTLS::cleanupTLSForThread()
         isAbortableThread->clearAbortInfo();
     }
 
-    //Cleanup any cached data on the TLSHolder
-    {
-        QWriteLocker l(&_spawnsMutex);
-
-        //This thread was spawned, but TLS not used, do not bother to clean-up
-        ThreadSpawnMap::iterator foundSpawned = _spawns.find(curThread);
-        if ( foundSpawned != _spawns.end() ) {
-            _spawns.erase(foundSpawned);
-
-            return;
-        }
+    TLSThreadSlots* slots = _currentThreadSlots;
+    if (!slots) {
+        return;
     }
-    std::list<TLSHolderBaseConstPtr> objectsToClean;
+    _currentThreadSlots = 0;
     {
-        QReadLocker k (&_objectMutex);
-        const TLSObjects& objectsCRef = _object->objects;
-        for (TLSObjects::iterator it = objectsCRef.begin();
-             it != objectsCRef.end();
-             ++it) {
-            TLSHolderBaseConstPtr p = (*it).lock();
-            if (p) {
-                if ( p->canCleanupPerThreadData(curThread) ) {
-                    objectsToClean.push_back(p);
-                }
-            }
-        }
-    }
-    if ( !objectsToClean.empty() ) {
-#if 1
-        // version from 1a0712b
-        // should be OK, since the bug in 1a0712b was in canCleanupPerThreadData
-        QWriteLocker k (&_objectMutex);
-        for (std::list<TLSHolderBaseConstPtr>::iterator it = objectsToClean.begin();
-             it != objectsToClean.end();
-             ++it) {
-            if ( (*it)->cleanupPerThreadData(curThread) ) {
-                TLSObjects::iterator found = _object->objects.find(*it);
-                if ( found != _object->objects.end() ) {
-                    _object->objects.erase(found);
-                }
-            }
-        }
-#else
-        // original version
-        TLSObjects newObjects;
-        QWriteLocker k (&_objectMutex);
-        for (TLSObjects::iterator it = _object->objects.begin();
-             it != _object->objects.end(); ++it) {
-            TLSHolderBaseConstPtr p = (*it).lock();
-            if (p) {
-                if ( !p->cleanupPerThreadData(curThread) ) {
-                    //The TLSHolder still has TLS on it for another thread and is still alive,
-                    //then leave it in the set
-                    newObjects.insert(p);
-                }
-            }
+        QMutexLocker k(&tlsRegistry->lock);
+        std::map<const QThread*, TLSThreadSlots*>::iterator found = tlsRegistry->threads.find(curThread);
+        if ( ( found != tlsRegistry->threads.end() ) && (found->second == slots) ) {
+            tlsRegistry->threads.erase(found);
         }
-        _object->objects = newObjects;
-#endif
     }
+    //Nobody else can access the table anymore, the TLS of this thread is destroyed here
+    delete slots;
 } // AppTLS::cleanupTLSForThread
 
 template class TLSHolder<EffectInstance::EffectTLSData>;
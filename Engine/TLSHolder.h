@@ -27,83 +27,106 @@
 
 #include "Global/Macros.h"
 
-#include <list>
-#include <map>
+#include <cstddef> // size_t
 #include <vector>
-#include <string>
-#include <set>
 
 #include "Global/GlobalDefines.h"
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
-#include <boost/weak_ptr.hpp>
-#include <boost/enable_shared_from_this.hpp>
 #endif
 
-#include <QtCore/QReadWriteLock>
+#include <QtCore/QMutex>
 #include <QtCore/QThread>
 
 #include "Engine/EngineFwd.h"
 
+// Compiler thread-local storage, used for the per-thread slot table so that looking up the TLS of
+// a TLSHolder on the current thread is a single load.
+#ifdef _MSC_VER
+#define NATRON_THREAD_LOCAL __declspec(thread)
+#else
+#define NATRON_THREAD_LOCAL __thread
+#endif
+
 NATRON_NAMESPACE_ENTER
 
-///This must be stored as a shared_ptr
+/**
+ * @brief The TLS value of one TLSHolder on one thread.
+ **/
+struct TLSSlot
+{
+    boost::shared_ptr<void> value;
+
+    // Returns a copy of value for a thread spawned by the thread owning it, or NULL if the
+    // value is not inherited by spawned threads.
+    boost::shared_ptr<void> (*copy)(const boost::shared_ptr<void>& value);
+
+    TLSSlot()
+        : value()
+        , copy(0)
+    {
+    }
+};
+
+/**
+ * @brief All the TLS of a thread: one slot per TLSHolder, indexed by the slot index of the holder.
+ * Only the thread owning the table modifies it, except when a TLSHolder is destroyed and its slot is reset
+ * on all threads. All writes are done under the mutex, as well as the reads from other threads (when a spawned
+ * thread copies the TLS of its spawner), so the owning thread can read its own slots without locking.
+ **/
+struct TLSThreadSlots
+{
+    QMutex lock;
+    std::vector<TLSSlot> values;
+
+    // Set by AppTLS::softCopy(): the TLS of this thread is copied from this thread on first access
+    const QThread* spawner;
+
+    TLSThreadSlots()
+        : lock()
+        , values()
+        , spawner(0)
+    {
+    }
+};
+
+/**
+ * @brief Base class of the TLSHolder: it owns a slot index, which is unique among the living holders
+ * and is given back to be reused when the holder is destroyed.
+ **/
 class TLSHolderBase
-    : public boost::enable_shared_from_this<TLSHolderBase>
 {
     friend class AppTLS;
 
 public:
-    // TODO: enable_shared_from_this
-    // constructors should be privatized in any class that derives from boost::enable_shared_from_this<>
 
-    TLSHolderBase() {}
+    TLSHolderBase();
 
-public:
-    virtual ~TLSHolderBase() {}
+    virtual ~TLSHolderBase();
 
 protected:
 
-    /**
-     * @brief Returns true if cleanupPerThreadData would do anything OR would return true.
-     * It does not return the same value as cleanupPerThreadData, since cleanupPerThreadData
-     * may do something and return false.
-     * This is much faster than cleanupPerThreadData as it does not take any write lock.
-     **/
-    virtual bool canCleanupPerThreadData(const QThread* curThread) const = 0;
+    const std::size_t _slotIndex;
 
-    /**
-     * @brief Must clean-up any data stored for the given thread 'curThread'
-     * @returns True if this object no longer holds any per-thread data
-     **/
-    virtual bool cleanupPerThreadData(const QThread* curThread) const = 0;
+private:
 
-    /**
-     * @brief Copy all the TLS from fromThread to toThread
-     **/
-    virtual void copyTLS(const QThread* fromThread, const QThread* toThread) const = 0;
+    // The slot index may not be shared
+    TLSHolderBase(const TLSHolderBase&);
+    TLSHolderBase& operator=(const TLSHolderBase&);
 };
 
 
 /**
- * @brief Stores globally to the application any thread-local storage object so that it gets
- * destroyed when all threads are shutdown.
+ * @brief Gives access to the thread-local storage of the application: each thread using TLS has
+ * a table of slots (see TLSThreadSlots) and each TLSHolder a slot index in these tables.
+ * Looking up the TLS of a holder on the current thread does not take any lock.
  **/
 class AppTLS
 {
-    //This is the object in the QThreadStorage, it is duplicated on every thread
-
-    typedef std::set<TLSHolderBaseConstWPtr> TLSObjects;
-    struct GLobalTLSObject
-    {
-        TLSObjects objects;
-    };
-
-    typedef boost::shared_ptr<GLobalTLSObject> GLobalTLSObjectPtr;
-
-    //<spawned thread, spawner thread>
-    typedef std::map<const QThread*, const QThread*> ThreadSpawnMap;
+    friend class TLSHolderBase;
+    template <typename T>
+    friend class TLSHolder;
 
 public:
 
@@ -112,38 +135,23 @@ public:
     virtual ~AppTLS();
 
     /**
-     * @brief Registers the holder as using TLS.
-     **/
-    void registerTLSHolder(const TLSHolderBaseConstPtr& holder);
-
-
-    /**
-     * @brief Copy all the TLS from fromThread to toThread
+     * @brief Copy all the TLS from fromThread to toThread. This must be called on toThread.
      **/
     void copyTLS(QThread* fromThread, QThread* toThread);
 
     /**
      * @brief This function registers fromThread as a thread who spawned toThread.
-     * The first time attempting to call getOrCreateTLSData() for toThread, it will
-     * call copyTLS() first before returning the TLS value.
+     * The first time attempting to call getTLSData() or getOrCreateTLSData() for toThread, the TLS
+     * will be copied from fromThread before returning the TLS value.
      * This is to ensure that threads that "may" need TLS do not always copy the TLS
      * if it is not needed.
      * Note that when calling softCopy,  fromThread may not already have
      * the TLS that may be required for the copy to happen, in which case a new value will
      * be constructed.
+     * This must be called on toThread.
      **/
     void softCopy(QThread* fromThread, QThread* toThread);
 
-    /**
-     * @brief Same as copyTLS() except that if a spawner thread was register for curThread beforehand
-     * with softCopy() then the TLS will be copied from the spawner thread.
-     * This function also returns the TLS for the given holder for convenience.
-     **/
-    template <typename T>
-    boost::shared_ptr<T> copyTLSFromSpawnerThread(const TLSHolderBase* holder,
-                                                  const QThread* curThread);
-
-
     /**
      * @brief Should be called by any thread using TLS when done to cleanup its TLS
      **/
@@ -151,43 +159,38 @@ public:
 
 private:
 
-    template <typename T>
-    boost::shared_ptr<T> copyTLSFromSpawnerThreadInternal(const TLSHolderBase* holder,
-                                                          const QThread* curThread,
-                                                          const QThread* spawnerThread);
+    static std::size_t allocateSlotIndex();
 
+    /**
+     * @brief Resets the slot of a TLSHolder being destroyed on all threads and makes its index reusable.
+     **/
+    static void releaseSlotIndex(std::size_t index);
 
-    //This is the "TLS" object: it stores a set of all TLSHolder's who used the TLS to clean it up afterwards
-    mutable QReadWriteLock _objectMutex;
-    GLobalTLSObjectPtr _object;
+    static TLSThreadSlots* getOrCreateCurrentThreadSlots();
 
-    //if a thread is a spawned thread, then copy the tls from the spawner thread instead
-    //of creating a new object and no longer mark it as spawned
-    mutable QReadWriteLock _spawnsMutex;
-    ThreadSpawnMap _spawns;
+    /**
+     * @brief Copies the TLS of the thread registered with softCopy() on the current thread.
+     **/
+    static void copyTLSFromSpawnerThread(TLSThreadSlots* slots);
+
+    static void setCurrentThreadData(std::size_t index,
+                                     const boost::shared_ptr<void>& value,
+                                     boost::shared_ptr<void> (*copy)(const boost::shared_ptr<void>&));
+
+    // The slot table of the current thread, or NULL if it did not use any TLS since the last
+    // call to cleanupTLSForThread()
+    static NATRON_THREAD_LOCAL TLSThreadSlots* _currentThreadSlots;
 };
 
 
 /**
  * @brief Use this class if you need to hold TLS data on an object.
  * @param T is the data type held in the thread-local storage.
- * @param multipleInstance If true, then the TLS object will be mapped against this object
- * so that there can be multiple instance of it in the global TLS. Otherwise only
- * a single instance of the TLS object will be present.
  **/
 template <typename T>
 class TLSHolder
     : public TLSHolderBase
 {
-    friend class AppTLS;
-
-    struct ThreadData
-    {
-        boost::shared_ptr<T> value;
-    };
-
-    typedef std::map<const QThread*, ThreadData> ThreadDataMap;
-
 public:
 
     TLSHolder()
@@ -200,14 +203,10 @@ public:
 
 private:
 
-    virtual bool canCleanupPerThreadData(const QThread* curThread) const OVERRIDE FINAL WARN_UNUSED_RETURN;
-    virtual bool cleanupPerThreadData(const QThread* curThread) const OVERRIDE FINAL WARN_UNUSED_RETURN;
-    virtual void copyTLS(const QThread* fromThread, const QThread* toThread) const OVERRIDE FINAL;
-    boost::shared_ptr<T> copyAndReturnNewTLS(const QThread* fromThread, const QThread* toThread) const WARN_UNUSED_RETURN;
-
-    //Store a cache on the object to be faster than using the getOrCreate... function from AppTLS
-    mutable QReadWriteLock perThreadDataMutex;
-    mutable ThreadDataMap perThreadData;
+    /**
+     * @brief Returns the value a spawned thread inherits from its spawner, see AppTLS::softCopy().
+     **/
+    static boost::shared_ptr<void> copyValue(const boost::shared_ptr<void>& value);
 };
 
 NATRON_NAMESPACE_EXIT
@@ -24,6 +24,7 @@
 
 #include "ThreadPool.h"
 
+#include <algorithm> // max
 #include <string>
 #include <sstream> // stringstream
 
@@ -31,9 +32,19 @@
 #include <QtCore/QMutex>
 #include <QtCore/QThread>
 #include <QtCore/QThreadPool>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QWaitCondition>
 
 #include "Engine/AbortableRenderInfo.h"
+#include "Engine/AppManager.h"
 #include "Engine/Node.h"
+#include "Engine/Timer.h"
+
+// While interactive work is running, background tasks may only use this share of the threads (at least one)
+#define NATRON_RENDER_THREAD_BACKGROUND_SHARE 0.25
+
+// A task never waits longer than this for more urgent work, in milliseconds
+#define NATRON_RENDER_THREAD_MAX_WAIT_MS 250
 
 NATRON_NAMESPACE_ENTER
 
@@ -49,6 +60,8 @@ struct AbortableThreadPrivate
     bool abortInfoValid;
     std::string currentActionName;
     NodeWPtr currentActionNode;
+    RenderThreadPriorityEnum renderPriority;
+    bool renderPrioritySet;
 
     AbortableThreadPrivate(QThread* thread)
         : thread(thread)
@@ -60,6 +73,8 @@ struct AbortableThreadPrivate
         , abortInfoValid(false)
         , currentActionName()
         , currentActionNode()
+        , renderPriority(eRenderThreadPriorityBackground)
+        , renderPrioritySet(false)
     {
     }
 };
@@ -89,6 +104,28 @@ AbortableThread::getThreadName() const
     return _imp->threadName;
 }
 
+void
+AbortableThread::setRenderThreadPriority(RenderThreadPriorityEnum priority)
+{
+    QMutexLocker k(&_imp->abortInfoMutex);
+
+    _imp->renderPriority = priority;
+    _imp->renderPrioritySet = true;
+}
+
+bool
+AbortableThread::getRenderThreadPriority(RenderThreadPriorityEnum* priority) const
+{
+    QMutexLocker k(&_imp->abortInfoMutex);
+
+    if (!_imp->renderPrioritySet) {
+        return false;
+    }
+    *priority = _imp->renderPriority;
+
+    return true;
+}
+
 void
 AbortableThread::setCurrentActionInfos(const std::string& actionName,
                                        const NodePtr& node)
@@ -173,6 +210,183 @@ AbortableThread::getAbortInfo(bool* isRenderResponseToUserInteraction,
     return true;
 }
 
+struct RenderThreadTaskTLS
+{
+    // How many tasks the thread is nested in: only the outermost one is scheduled
+    int depth;
+
+    // The priority of the outermost task
+    RenderThreadPriorityEnum priority;
+
+    RenderThreadTaskTLS()
+        : depth(0)
+        , priority(eRenderThreadPriorityBackground)
+    {
+    }
+};
+
+struct RenderThreadSchedulerPrivate
+{
+    // Protects all members below
+    mutable QMutex lock;
+
+    // Woken up whenever a task ends
+    QWaitCondition taskEndedCond;
+    int nRunningTasks[NATRON_RENDER_THREAD_PRIORITY_COUNT];
+    RenderThreadPriorityStats stats[NATRON_RENDER_THREAD_PRIORITY_COUNT];
+
+    QThreadStorage<RenderThreadTaskTLS> currentTask;
+
+    RenderThreadSchedulerPrivate()
+        : lock()
+        , taskEndedCond()
+        , currentTask()
+    {
+        for (int i = 0; i < NATRON_RENDER_THREAD_PRIORITY_COUNT; ++i) {
+            nRunningTasks[i] = 0;
+        }
+    }
+
+    bool mustWait(RenderThreadPriorityEnum priority) const
+    {
+        int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+        int nInteractive = nRunningTasks[eRenderThreadPriorityInteractive];
+
+        switch (priority) {
+        case eRenderThreadPriorityInteractive:
+
+            return false;
+        case eRenderThreadPriorityBackground:
+
+            return nInteractive > 0 && nRunningTasks[eRenderThreadPriorityBackground] >= std::max(1, (int)(maxThreads * NATRON_RENDER_THREAD_BACKGROUND_SHARE));
+        case eRenderThreadPriorityIdle:
+
+            return nInteractive > 0 || (nInteractive + nRunningTasks[eRenderThreadPriorityBackground] + nRunningTasks[eRenderThreadPriorityIdle] >= maxThreads);
+        }
+
+        return false;
+    }
+};
+
+RenderThreadScheduler::RenderThreadScheduler()
+    : _imp( new RenderThreadSchedulerPrivate() )
+{
+}
+
+RenderThreadScheduler::~RenderThreadScheduler()
+{
+}
+
+RenderThreadPriorityEnum
+RenderThreadScheduler::getRenderPriority(const NodePtr& treeRoot)
+{
+    AbortableThread* isAbortable = dynamic_cast<AbortableThread*>( QThread::currentThread() );
+    RenderThreadPriorityEnum priority;
+
+    if ( isAbortable && isAbortable->getRenderThreadPriority(&priority) ) {
+        return priority;
+    }
+    if ( treeRoot && treeRoot->isEffectViewer() ) {
+        return eRenderThreadPriorityInteractive;
+    }
+
+    return eRenderThreadPriorityBackground;
+}
+
+void
+RenderThreadScheduler::beginTask(RenderThreadPriorityEnum priority)
+{
+    RenderThreadTaskTLS& task = _imp->currentTask.localData();
+
+    if (task.depth++ > 0) {
+        return;
+    }
+    task.priority = priority;
+
+    QMutexLocker k(&_imp->lock);
+    if ( _imp->mustWait(priority) ) {
+        // Let the pool start another thread for the tasks queued behind this one while we wait
+        QThreadPool::globalInstance()->releaseThread();
+        TimeLapse timer;
+        int waited = 0;
+        while ( _imp->mustWait(priority) && (waited < NATRON_RENDER_THREAD_MAX_WAIT_MS) ) {
+            _imp->taskEndedCond.wait(&_imp->lock, NATRON_RENDER_THREAD_MAX_WAIT_MS - waited);
+            waited = (int)(timer.getTimeSinceCreation() * 1000);
+        }
+        ++_imp->stats[priority].nWaits;
+        _imp->stats[priority].waitTime += timer.getTimeSinceCreation();
+        k.unlock();
+        QThreadPool::globalInstance()->reserveThread();
+        k.relock();
+    }
+    ++_imp->nRunningTasks[priority];
+    ++_imp->stats[priority].nTasks;
+}
+
+void
+RenderThreadScheduler::endTask(RenderThreadPriorityEnum priority,
+                               double busyTime)
+{
+    RenderThreadTaskTLS& task = _imp->currentTask.localData();
+
+    assert(task.depth > 0);
+    if (--task.depth > 0) {
+        return;
+    }
+
+    QMutexLocker k(&_imp->lock);
+    --_imp->nRunningTasks[priority];
+    assert(_imp->nRunningTasks[priority] >= 0);
+    _imp->stats[priority].busyTime += busyTime;
+    _imp->taskEndedCond.wakeAll();
+}
+
+bool
+RenderThreadScheduler::getCurrentThreadTaskPriority(RenderThreadPriorityEnum* priority) const
+{
+    if ( !_imp->currentTask.hasLocalData() ) {
+        return false;
+    }
+    const RenderThreadTaskTLS& task = _imp->currentTask.localData();
+    if (task.depth == 0) {
+        return false;
+    }
+    *priority = task.priority;
+
+    return true;
+}
+
+int
+RenderThreadScheduler::getNumRunningTasks(RenderThreadPriorityEnum priority) const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->nRunningTasks[priority];
+}
+
+void
+RenderThreadScheduler::getStats(RenderThreadPriorityEnum priority,
+                                RenderThreadPriorityStats* stats) const
+{
+    QMutexLocker k(&_imp->lock);
+
+    *stats = _imp->stats[priority];
+}
+
+RenderThreadSchedulerTask::RenderThreadSchedulerTask(RenderThreadPriorityEnum priority)
+    : _priority(priority)
+    , _timer()
+{
+    appPTR->getRenderThreadScheduler()->beginTask(priority);
+    // Do not count the time spent waiting
+    _timer.reset( new TimeLapse() );
+}
+
+RenderThreadSchedulerTask::~RenderThreadSchedulerTask()
+{
+    appPTR->getRenderThreadScheduler()->endTask( _priority, _timer->getTimeSinceCreation() );
+}
+
 // We patched Qt to be able to derive QThreadPool to control the threads that are spawned to improve performances
 // of the EffectInstance::aborted() function
 #ifdef QT_CUSTOM_THREADPOOL
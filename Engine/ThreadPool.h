@@ -33,11 +33,25 @@
 
 #include <QtCore/QThreadPool> // defines QT_CUSTOM_THREADPOOL (or not)
 
+#include "Global/GlobalDefines.h"
+
 #include "Engine/EngineFwd.h"
 
 
 NATRON_NAMESPACE_ENTER
 
+/**
+ * @brief The classes of render work sharing the global thread pool, from the most to the least urgent.
+ * @see RenderThreadScheduler
+ **/
+enum RenderThreadPriorityEnum
+{
+    eRenderThreadPriorityInteractive = 0, //< Viewer renders, the user is waiting for them
+    eRenderThreadPriorityBackground, //< Write nodes, tracking and any other render not displayed in a viewer
+    eRenderThreadPriorityIdle //< Node previews and frames rendered ahead in the viewer, they only use idle threads
+};
+
+#define NATRON_RENDER_THREAD_PRIORITY_COUNT 3
 
 /**
  * @brief This class provides a fast way to determine whether a render thread
@@ -72,6 +86,13 @@ public:
                       AbortableRenderInfoPtr* abortInfo,
                       EffectInstancePtr* treeRoot) const;
 
+    /**
+     * @brief Set the priority of the renders started from this thread. If not set, it depends on the node
+     * the render is started from, see RenderThreadScheduler::getRenderPriority()
+     **/
+    void setRenderThreadPriority(RenderThreadPriorityEnum priority);
+    bool getRenderThreadPriority(RenderThreadPriorityEnum* priority) const;
+
     // For debug purposes, so that the debugger can display the thread name
     void setThreadName(const std::string& threadName);
 
@@ -114,6 +135,92 @@ private:
         } \
     } \
 
+struct RenderThreadPriorityStats
+{
+    // Number of tasks run
+    U64 nTasks;
+
+    // Time spent by threads running tasks, in seconds
+    double busyTime;
+
+    // Number of tasks that waited for more urgent work and the time they waited, in seconds
+    U64 nWaits;
+    double waitTime;
+
+    RenderThreadPriorityStats()
+        : nTasks(0)
+        , busyTime(0)
+        , nWaits(0)
+        , waitTime(0)
+    {
+    }
+};
+
+/**
+ * @brief Shares the threads of the global thread pool between the render priority classes.
+ * QThreadPool runs its tasks in the order they were queued: a Write node splitting its frames in tiles
+ * could hold all threads while the user waits for the viewer. Each tile asks the scheduler before running:
+ * - Interactive tiles always run.
+ * - Background tiles wait while interactive work is running and background tiles already use their share of the threads.
+ * - Idle tiles wait while interactive work is running or all threads are busy.
+ * A waiting tile releases its thread to the pool, which can then run the more urgent tiles queued behind it.
+ * Waits are bounded because a more urgent render may itself wait for an image being computed by a less urgent one.
+ **/
+struct RenderThreadSchedulerPrivate;
+class RenderThreadScheduler
+{
+public:
+
+    RenderThreadScheduler();
+
+    ~RenderThreadScheduler();
+
+    /**
+     * @brief Returns the priority of a render started from the current thread on the tree upstream of treeRoot
+     **/
+    static RenderThreadPriorityEnum getRenderPriority(const NodePtr& treeRoot);
+
+    /**
+     * @brief Called by a thread before running a task of the given priority, this may wait for more urgent work.
+     * Each call must be matched by a call to endTask(), see RenderThreadSchedulerTask
+     **/
+    void beginTask(RenderThreadPriorityEnum priority);
+
+    void endTask(RenderThreadPriorityEnum priority, double busyTime);
+
+    /**
+     * @brief Returns the priority of the task the current thread is running, if any. Work spawned by this task
+     * on other threads should be scheduled with the same priority.
+     **/
+    bool getCurrentThreadTaskPriority(RenderThreadPriorityEnum* priority) const;
+
+    /**
+     * @brief Returns the number of tasks of the given priority currently running
+     **/
+    int getNumRunningTasks(RenderThreadPriorityEnum priority) const;
+
+    void getStats(RenderThreadPriorityEnum priority, RenderThreadPriorityStats* stats) const;
+
+private:
+
+    boost::scoped_ptr<RenderThreadSchedulerPrivate> _imp;
+};
+
+/**
+ * @brief Begins a task of the given priority on the application's RenderThreadScheduler for the lifetime of this object
+ **/
+class RenderThreadSchedulerTask
+{
+    RenderThreadPriorityEnum _priority;
+    boost::scoped_ptr<TimeLapse> _timer;
+
+public:
+
+    RenderThreadSchedulerTask(RenderThreadPriorityEnum priority);
+
+    ~RenderThreadSchedulerTask();
+};
+
 // We patched Qt to be able to derive QThreadPool to control the threads that are spawned to improve performances
 // of the EffectInstance::aborted() function. This is done by enabling QThreadPoolThread* to derive AbortableThread.
 #ifdef QT_CUSTOM_THREADPOOL
@@ -181,6 +181,7 @@ ViewerInstance::ViewerInstance(NodePtr node)
     QObject::connect( this, SIGNAL(disconnectTextureRequest(int,bool)), this, SLOT(executeDisconnectTextureRequestOnMainThread(int,bool)) );
     QObject::connect( _imp.get(), SIGNAL(mustRedrawViewer()), this, SLOT(redrawViewer()) );
     QObject::connect( this, SIGNAL(s_callRedrawOnMainThread()), this, SLOT(redrawViewer()) );
+    QObject::connect( this, SIGNAL(s_refineCurrentFrameRequested()), this, SLOT(onRefineCurrentFrameRequested()) );
 }
 
 ViewerInstance::~ViewerInstance()
@@ -703,6 +704,65 @@ ViewerInstance::renderViewer(ViewIdx view,
     return eViewerRenderRetCodeRender;
 } // ViewerInstance::renderViewer
 
+std::size_t
+ViewerInstance::renderFrameToCache(SequenceTime time,
+                                   ViewIdx view,
+                                   U64 viewerHash,
+                                   const AbortableRenderInfoPtr& abortInfo)
+{
+    if (!_imp->uiContext) {
+        return 0;
+    }
+
+    std::size_t frameSize = 0;
+    for (int i = 0; i < 2; ++i) {
+        if ( (i == 1) && (_imp->uiContext->getCompositingOperator() == eViewerCompositingOperatorNone) ) {
+            break;
+        }
+        if ( abortInfo->isAborted() ) {
+            return 0;
+        }
+
+        ViewerArgs args;
+        ViewerRenderRetCode stat = getRenderViewerArgsAndCheckCache(time, true, view, i, viewerHash, NodePtr(), abortInfo, RenderStatsPtr(), &args);
+        if ( (stat != eViewerRenderRetCodeRender) || !args.params ) {
+            continue;
+        }
+
+        // These textures are never stored in the cache
+        if (args.userRoIEnabled || args.autoContrast || args.isDoingPartialUpdates) {
+            return 0;
+        }
+
+        if ( args.params->nbCachedTile != (int)args.params->tiles.size() ) {
+            try {
+                stat = renderViewer_internal(view,
+                                             false, // singleThreaded
+                                             true, // isSequentialRender
+                                             viewerHash,
+                                             true, // canAbort
+                                             NodePtr(), // rotoPaintNode
+                                             true, // useTLS
+                                             ViewerCurrentFrameRequestSchedulerStartArgsPtr(),
+                                             RenderStatsPtr(),
+                                             args);
+            } catch (...) {
+                stat = eViewerRenderRetCodeFail;
+            }
+            args.isRenderingFlag.reset();
+            if ( (stat != eViewerRenderRetCodeRender) || abortInfo->isAborted() ) {
+                return 0;
+            }
+        }
+
+        for (std::list<UpdateViewerParams::CachedTile>::const_iterator it = args.params->tiles.begin(); it != args.params->tiles.end(); ++it) {
+            frameSize += it->bytesCount;
+        }
+    }
+
+    return frameSize;
+} // ViewerInstance::renderFrameToCache
+
 static bool
 checkTreeCanRender_internal(Node* node,
                             std::list<Node*>& marked)
@@ -843,6 +903,7 @@ ViewerInstance::setupMinimalUpdateViewerParams(const SequenceTime time,
     {
         QMutexLocker l(&_imp->viewerParamsMutex);
         outArgs->mipmapLevelWithoutDraft = (unsigned int)_imp->viewerMipMapLevel;
+        outArgs->playbackMipMapLevelBias = isSequential ? _imp->playbackMipMapLevelBias : 0;
     }
 
     assert(_imp->uiContext);
@@ -885,6 +946,12 @@ ViewerInstance::setupMinimalUpdateViewerParams(const SequenceTime time,
         outArgs->mipMapLevelWithDraft = (unsigned int)std::max( (int)outArgs->mipmapLevelWithoutDraft, (int)autoProxyLevel );
     }
 
+    // During playback, render at a lower resolution if frames cannot be rendered at the desired frame rate.
+    // A full resolution texture is still looked up first in the cache.
+    if (outArgs->playbackMipMapLevelBias > 0) {
+        outArgs->mipMapLevelWithDraft = std::max(outArgs->mipMapLevelWithDraft, outArgs->mipmapLevelWithoutDraft + outArgs->playbackMipMapLevelBias);
+    }
+
 
     // The hash of the node to render, we store it and make sure we never call getHash() again for the render of this frame
     outArgs->activeInputHash = outArgs->activeInputToRender->getHash();
@@ -1173,8 +1240,8 @@ ViewerInstance::getRoDAndLookupCache(const bool useOnlyRoDCache,
     EffectInstance::SupportsEnum supportsRS = outArgs->activeInputToRender->supportsRenderScaleMaybe();
 
 
-    // When in draft mode first try to get a texture without draft and then try with draft
-    const int nLookups = outArgs->draftModeEnabled ? 2 : 1;
+    // When in draft mode (or when playback lowered the resolution) first try to get a texture without draft and then try with draft
+    const int nLookups = ( outArgs->draftModeEnabled || (outArgs->mipMapLevelWithDraft != outArgs->mipmapLevelWithoutDraft) ) ? 2 : 1;
 
     for (int lookup = 0; lookup < nLookups; ++lookup) {
         const unsigned mipMapLevel = lookup == 0 ? outArgs->mipmapLevelWithoutDraft : outArgs->mipMapLevelWithDraft;
@@ -1224,7 +1291,7 @@ ViewerInstance::getRoDAndLookupCache(const bool useOnlyRoDCache,
         Q_UNUSED(isRodProjectFormat);
 
         // Ok we go the RoD, we can actually compute the RoI and look-up the cache
-        ViewerRenderRetCode retCode = getViewerRoIAndTexture(rod, viewerHash, useTextureCache, lookup == 1, mipMapLevel, stats, outArgs);
+        ViewerRenderRetCode retCode = getViewerRoIAndTexture(rod, viewerHash, useTextureCache, lookup == 1 && outArgs->draftModeEnabled, mipMapLevel, stats, outArgs);
         if (retCode != eViewerRenderRetCodeRender) {
             return retCode;
         }
@@ -1451,6 +1518,10 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
     ImagePlaneDesc components, pairedComponents;
     inArgs.activeInputToRender->getMetadataComponents(-1, &components, &pairedComponents);
     ImageBitDepthEnum imageDepth = inArgs.activeInputToRender->getBitDepth(-1);
+    if (imageDepth == eImageBitDepthHalf) {
+        // The texture upload works on byte, short and float images: let renderRoI convert half images to float
+        imageDepth = eImageBitDepthFloat;
+    }
     std::list<ImagePlaneDesc> requestedComponents;
     int alphaChannelIndex = -1;
     if ( (inArgs.channels != eDisplayChannelsA) &&
@@ -2580,6 +2651,18 @@ ViewerInstance::markAllOnGoingRendersAsAborted(bool keepOldestRender)
     }
 }
 
+void
+ViewerInstance::abortAllOnGoingRenders()
+{
+    QMutexLocker k(&_imp->renderAgeMutex);
+
+    for (int i = 0; i < 2; ++i) {
+        for (OnGoingRenders::iterator it = _imp->currentRenderAges[i].begin(); it != _imp->currentRenderAges[i].end(); ++it) {
+            (*it)->setAborted();
+        }
+    }
+}
+
 template <typename PIX, int maxValue, bool opaque, bool applyMatte, int rOffset, int gOffset, int bOffset>
 void
 scaleToTexture32bitsGeneric(const RectI& roi,
@@ -3087,6 +3170,40 @@ ViewerInstance::onMipMapLevelChanged(int level)
     }
 }
 
+void
+ViewerInstance::setPlaybackMipMapLevelBias(unsigned int bias)
+{
+    QMutexLocker l(&_imp->viewerParamsMutex);
+
+    _imp->playbackMipMapLevelBias = bias;
+}
+
+unsigned int
+ViewerInstance::getPlaybackMipMapLevelBias() const
+{
+    QMutexLocker l(&_imp->viewerParamsMutex);
+
+    return _imp->playbackMipMapLevelBias;
+}
+
+void
+ViewerInstance::refineCurrentFrameAfterPlayback()
+{
+    setPlaybackMipMapLevelBias(0);
+    Q_EMIT s_refineCurrentFrameRequested();
+}
+
+void
+ViewerInstance::onRefineCurrentFrameRequested()
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+    if ( !_imp->uiContext || getApp()->isGuiFrozen() ) {
+        return;
+    }
+    renderCurrentFrame(true);
+}
+
 void
 ViewerInstance::onAutoContrastChanged(bool autoContrast,
                                       bool refresh)
@@ -55,6 +55,7 @@ public:
     RenderingFlagSetterPtr isRenderingFlag;
     bool draftModeEnabled;
     unsigned int mipMapLevelWithDraft, mipmapLevelWithoutDraft;
+    unsigned int playbackMipMapLevelBias;
     bool autoContrast;
     DisplayChannelsEnum channels;
     bool userRoIEnabled;
@@ -215,6 +216,18 @@ public:
                                                      ViewerArgsPtr* argsA,
                                                      ViewerArgsPtr* argsB);
 
+    /**
+     * @brief Renders the textures of the given frame into the viewer cache without displaying them, as
+     * the playback does. This does not take part in the render ages of the displayed textures, the render
+     * can only be aborted through abortInfo.
+     * @returns The size in bytes of the textures of the frame, or 0 if they could not be rendered or would
+     * not be stored in the cache (e.g: the user RoI or auto-contrast is enabled).
+     **/
+    std::size_t renderFrameToCache(SequenceTime time,
+                                   ViewIdx view,
+                                   U64 viewerHash,
+                                   const AbortableRenderInfoPtr& abortInfo);
+
     void aboutToUpdateTextures();
 
     void updateViewer(UpdateViewerParamsPtr & frame);
@@ -306,6 +319,12 @@ public:
 
     void markAllOnGoingRendersAsAborted(bool keepOldestRender);
 
+    /**
+     * @brief Aborts all the renders of the current frame, including the oldest one. This is called when playback starts
+     * on this viewer, since renders of the current frame are aborted by a sequential render.
+     **/
+    void abortAllOnGoingRenders();
+
     /**
      * @brief Used to re-render only selected portions of the texture.
      * This requires that the renderviewer_internal() function gets called on a single thread
@@ -332,6 +351,20 @@ public:
 
     unsigned int getViewerMipMapLevel() const;
 
+    /**
+     * @brief Set the number of mipmap levels added to the level at which the viewer renders during playback,
+     * @see ViewerDisplayScheduler::notifyFrameRenderCost
+     **/
+    void setPlaybackMipMapLevelBias(unsigned int bias);
+
+    unsigned int getPlaybackMipMapLevelBias() const;
+
+    /**
+     * @brief Resets the playback mipmap level bias and renders again the current frame at full resolution.
+     * Can be called from any thread.
+     **/
+    void refineCurrentFrameAfterPlayback();
+
 public Q_SLOTS:
 
 
@@ -348,6 +381,8 @@ public Q_SLOTS:
 
     void executeDisconnectTextureRequestOnMainThread(int index, bool clearRoD);
 
+    void onRefineCurrentFrameRequested();
+
 
 Q_SIGNALS:
 
@@ -355,6 +390,8 @@ Q_SIGNALS:
 
     void s_callRedrawOnMainThread();
 
+    void s_refineCurrentFrameRequested();
+
     void viewerDisconnected();
 
     void clipPreferencesChanged();
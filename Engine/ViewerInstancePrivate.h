@@ -140,6 +140,7 @@ public:
         , viewerParamsAlphaLayer( ImagePlaneDesc::getRGBAComponents() )
         , viewerParamsAlphaChannelName("a")
         , viewerMipMapLevel(0)
+        , playbackMipMapLevelBias(0)
         , fullFrameProcessingEnabled(false)
         , activateInputChangedFromViewer(false)
         , gammaLookupMutex()
@@ -387,6 +388,7 @@ public:
     ImagePlaneDesc viewerParamsAlphaLayer;
     std::string viewerParamsAlphaChannelName;
     unsigned int viewerMipMapLevel; //< the mipmap level the viewer should render at (0 == no downscaling)
+    unsigned int playbackMipMapLevelBias; //< levels added to the mipmap level during playback to hold the frame rate
     bool fullFrameProcessingEnabled;
 
     ///Only accessed from MT
@@ -0,0 +1,267 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ViewerSpeculativeRenderer.h"
+
+#include <algorithm> // min, max
+#include <list>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#endif
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/AbortableRenderInfo.h"
+#include "Engine/AppManager.h"
+#include "Engine/Settings.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/TLSHolder.h"
+#include "Engine/ViewerInstance.h"
+
+NATRON_NAMESPACE_ENTER
+
+class SpeculativeRenderThread;
+typedef boost::shared_ptr<SpeculativeRenderThread> SpeculativeRenderThreadPtr;
+
+struct ViewerSpeculativeRendererPrivate
+{
+    ViewerInstance* viewer;
+
+    // Protects all members below
+    QMutex lock;
+
+    // The thread waits on it for frames to render
+    QWaitCondition framesToRenderCond;
+
+    // The request being rendered
+    bool hasRequest;
+    int time;
+    ViewIdx view;
+    U64 viewerHash;
+
+    // The frames left to render, closest to time first
+    std::list<int> framesToRender;
+    AbortableRenderInfoPtr currentRender;
+
+    // Size in bytes of the textures of the last frame rendered, 0 until measured
+    std::size_t frameSize;
+
+    SpeculativeRenderThreadPtr thread;
+    bool mustQuit;
+
+    ViewerSpeculativeRendererPrivate(ViewerInstance* viewer)
+        : viewer(viewer)
+        , lock()
+        , framesToRenderCond()
+        , hasRequest(false)
+        , time(0)
+        , view(0)
+        , viewerHash(0)
+        , framesToRender()
+        , currentRender()
+        , frameSize(0)
+        , thread()
+        , mustQuit(false)
+    {
+    }
+
+    void threadLoop(AbortableThread* thread);
+
+    void abortInternal();
+};
+
+class SpeculativeRenderThread
+    : public QThread
+      , public AbortableThread
+{
+    ViewerSpeculativeRendererPrivate* _imp;
+
+public:
+
+    SpeculativeRenderThread(ViewerSpeculativeRendererPrivate* imp)
+        : QThread()
+        , AbortableThread(this)
+        , _imp(imp)
+    {
+        setThreadName("Viewer speculative render thread");
+        setRenderThreadPriority(eRenderThreadPriorityIdle);
+    }
+
+    virtual ~SpeculativeRenderThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        _imp->threadLoop(this);
+    }
+};
+
+void
+ViewerSpeculativeRendererPrivate::threadLoop(AbortableThread* thread)
+{
+    for (;;) {
+        int frame;
+        ViewIdx frameView;
+        U64 hash;
+        AbortableRenderInfoPtr abortInfo;
+        {
+            QMutexLocker k(&lock);
+            while ( !mustQuit && framesToRender.empty() ) {
+                framesToRenderCond.wait(&lock);
+            }
+            if (mustQuit) {
+                return;
+            }
+            frame = framesToRender.front();
+            framesToRender.pop_front();
+            frameView = view;
+            hash = viewerHash;
+            abortInfo = AbortableRenderInfo::create(true, 0);
+            currentRender = abortInfo;
+        }
+
+        std::size_t size = viewer->renderFrameToCache(frame, frameView, hash, abortInfo);
+
+        thread->clearAbortInfo();
+        appPTR->getAppTLS()->cleanupTLSForThread();
+
+        QMutexLocker k(&lock);
+        if ( (size > 0) && !abortInfo->isAborted() ) {
+            frameSize = size;
+        }
+        if (currentRender == abortInfo) {
+            currentRender.reset();
+        }
+    }
+}
+
+void
+ViewerSpeculativeRendererPrivate::abortInternal()
+{
+    // Must be locked
+    assert( !lock.tryLock() );
+
+    hasRequest = false;
+    framesToRender.clear();
+    if (currentRender) {
+        currentRender->setAborted();
+        currentRender.reset();
+    }
+}
+
+ViewerSpeculativeRenderer::ViewerSpeculativeRenderer(ViewerInstance* viewer)
+    : _imp( new ViewerSpeculativeRendererPrivate(viewer) )
+{
+}
+
+ViewerSpeculativeRenderer::~ViewerSpeculativeRenderer()
+{
+    quit();
+}
+
+void
+ViewerSpeculativeRenderer::start(int time,
+                                 ViewIdx view)
+{
+    int maxFrames = appPTR->getCurrentSettings()->getSpeculativeRenderFrames();
+
+    if (maxFrames <= 0) {
+        abort();
+
+        return;
+    }
+
+    U64 viewerHash = _imp->viewer->getHash();
+    int firstFrame, lastFrame;
+    _imp->viewer->getTimelineBounds(&firstFrame, &lastFrame);
+
+    QMutexLocker k(&_imp->lock);
+    if ( _imp->hasRequest && (_imp->time == time) && (_imp->view == view) && (_imp->viewerHash == viewerHash) ) {
+        return;
+    }
+    _imp->abortInternal();
+    _imp->hasRequest = true;
+    _imp->time = time;
+    _imp->view = view;
+    _imp->viewerHash = viewerHash;
+
+    // The frames rendered around the current frame may use at most this part of the viewer cache
+    U64 nFrames = 2 * maxFrames;
+    if (_imp->frameSize > 0) {
+        U64 maxSize = (U64)( appPTR->getViewerCacheMaximumSize() * appPTR->getCurrentSettings()->getSpeculativeRenderCacheShare() );
+        nFrames = std::min(nFrames, maxSize / _imp->frameSize);
+    }
+    for (int offset = 1; offset <= maxFrames; ++offset) {
+        if ( (_imp->framesToRender.size() < nFrames) && (time + offset <= lastFrame) ) {
+            _imp->framesToRender.push_back(time + offset);
+        }
+        if ( (_imp->framesToRender.size() < nFrames) && (time - offset >= firstFrame) ) {
+            _imp->framesToRender.push_back(time - offset);
+        }
+    }
+    if ( _imp->framesToRender.empty() ) {
+        return;
+    }
+
+    if (!_imp->thread) {
+        _imp->mustQuit = false;
+        _imp->thread = boost::make_shared<SpeculativeRenderThread>( _imp.get() );
+        _imp->thread->start(QThread::LowPriority);
+    }
+    _imp->framesToRenderCond.wakeOne();
+} // ViewerSpeculativeRenderer::start
+
+void
+ViewerSpeculativeRenderer::abort()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->abortInternal();
+}
+
+void
+ViewerSpeculativeRenderer::quit()
+{
+    SpeculativeRenderThreadPtr thread;
+    {
+        QMutexLocker k(&_imp->lock);
+        _imp->abortInternal();
+        _imp->mustQuit = true;
+        _imp->framesToRenderCond.wakeAll();
+        thread = _imp->thread;
+        _imp->thread.reset();
+    }
+    if (thread) {
+        thread->wait();
+    }
+}
+
+NATRON_NAMESPACE_EXIT
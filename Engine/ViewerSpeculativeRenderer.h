@@ -0,0 +1,80 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_VIEWERSPECULATIVERENDERER_H
+#define NATRON_ENGINE_VIEWERSPECULATIVERENDERER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Renders in a low priority background thread the viewer textures of the frames around the current frame
+ * once it is displayed, so that stepping or scrubbing to them finds them in the viewer cache.
+ * Frames are rendered closest first, alternating after and before the current frame, up to the number of frames set
+ * in the preferences and as long as they fit in the share of the viewer cache set in the preferences.
+ * The ViewerCurrentFrameRequestScheduler starts it when the latest current frame render is displayed and aborts it
+ * whenever the viewer renders anything else.
+ **/
+struct ViewerSpeculativeRendererPrivate;
+class ViewerSpeculativeRenderer
+{
+public:
+
+    ViewerSpeculativeRenderer(ViewerInstance* viewer);
+
+    ~ViewerSpeculativeRenderer();
+
+    /**
+     * @brief Starts rendering the frames around time. If they are already being rendered for the same time, view and
+     * viewer hash this does nothing, otherwise the frames being rendered are aborted first.
+     **/
+    void start(int time, ViewIdx view);
+
+    /**
+     * @brief Aborts the frame being rendered and forgets the frames left to render. This does not wait for the
+     * render to return.
+     **/
+    void abort();
+
+    /**
+     * @brief Aborts and waits for the background thread to finish.
+     **/
+    void quit();
+
+private:
+
+    boost::scoped_ptr<ViewerSpeculativeRendererPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_VIEWERSPECULATIVERENDERER_H
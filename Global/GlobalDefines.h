@@ -105,6 +105,26 @@ typedef OfxRangeD RangeD;
 
 #define kBgProcessServerCreatedShort "--bg_server_created"
 
+///these are the messages a client sends to a render server (NatronRenderer --render-server), see RenderServer
+#define kRenderServerProject "project"
+
+#define kRenderServerWriter "writer"
+
+#define kRenderServerFrameRange "range"
+
+#define kRenderServerSetParam "set"
+
+#define kRenderServerRenderStats "stats"
+
+#define kRenderServerRender "render"
+
+#define kRenderServerQuit "quit"
+
+///and the messages it replies with, besides the frame rendered and progress messages above
+#define kRenderServerJobFinishedShort "--job_finished"
+
+#define kRenderServerJobErrorShort "--job_error"
+
 //Increment this to wipe all disk cache structure and ensure that the user has a clean cache when starting the next version of Natron
 #define NATRON_CACHE_VERSION 4
 #define kNatronCacheVersionSettingsKey "NatronCacheVersionSettingsKey"
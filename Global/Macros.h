@@ -253,6 +253,7 @@ NATRON_VERSION_STRINGIZE__(major, minor)
 
 #define NATRON_PLUGIN_PATH_ENV_VAR "NATRON_PLUGIN_PATH"
 #define NATRON_DISK_CACHE_PATH_ENV_VAR "NATRON_DISK_CACHE_PATH"
+#define NATRON_STARTUP_TIMINGS_ENV_VAR "NATRON_STARTUP_TIMINGS"
 #define NATRON_IMAGES_PATH ":/Resources/Images/"
 #define NATRON_APPLICATION_ICON_PATH NATRON_IMAGES_PATH "natronIcon256_linux.png"
 #define NATRON_PYPLUG_MAGIC "# Natron PyPlug"
@@ -76,6 +76,8 @@ PreviewThread::PreviewThread()
     , _imp( new PreviewThreadPrivate() )
 {
     setThreadName("PreviewThread");
+    // Previews only use the threads left idle by the other renders
+    setRenderThreadPriority(eRenderThreadPriorityIdle);
 }
 
 PreviewThread::~PreviewThread()
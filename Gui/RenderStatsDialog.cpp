@@ -24,10 +24,12 @@
 
 #include "RenderStatsDialog.h"
 
+#include <algorithm> // max
 #include <bitset>
 #include <stdexcept>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -35,7 +37,9 @@
 #include <QItemSelectionModel>
 #include <QtCore/QRegExp>
 
+#include "Engine/AppManager.h"
 #include "Engine/Node.h"
+#include "Engine/ThreadPool.h"
 #include "Engine/Timer.h"
 #include "Engine/Utils.h" // convertFromPlainText
 #include "Engine/ViewIdx.h"
@@ -64,8 +68,9 @@
 #define COL_NB_CACHE_HIT 13
 #define COL_NB_CACHE_HIT_DOWNSCALED 14
 #define COL_NB_CACHE_MISS 15
+#define COL_NB_CACHE_EVICTIONS 16
 
-#define NUM_COLS 16
+#define NUM_COLS 17
 
 NATRON_NAMESPACE_ENTER
 
@@ -645,6 +650,35 @@ public:
                 }
             }
         }
+        {
+            TableItem* item = 0;
+            if (exists) {
+                item = view->item(row, COL_NB_CACHE_EVICTIONS);
+            } else {
+                item = new TableItem;
+                item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            assert(item);
+            if (item) {
+                // This is a total since the node was created, it is not accumulated
+                int nbEvicted;
+                double evictedRenderTime;
+                stats.getCacheEvictionInfos(&nbEvicted, &evictedRenderTime);
+
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The number of images of this node evicted from the cache to make room "
+                                                                       "for other images since the node was created. They took %1 to render.")
+                                                                    .arg( Timer::printAsTime(evictedRenderTime, false) ), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(tt);
+                if (nodeUi) {
+                    item->setTextColor(Qt::black);
+                    item->setBackgroundColor(c);
+                }
+                item->setText( QString::number(nbEvicted) );
+                if (!exists) {
+                    view->setItem(row, COL_NB_CACHE_EVICTIONS, item);
+                }
+            }
+        }
         if (!exists) {
             rows.push_back(node);
         }
@@ -703,6 +737,12 @@ struct RenderStatsDialogPrivate
     Label* totalTimeSpentDescLabel;
     Label* totalTimeSpentValueLabel;
     double totalSpentTime;
+    Label* threadUsageDescLabel;
+    Label* threadUsageValueLabel;
+    // Thread usage of each render priority when the statistics were reset
+    RenderThreadPriorityStats threadStatsAtReset[NATRON_RENDER_THREAD_PRIORITY_COUNT];
+    TimeLapse threadUsageTimer;
+    double threadUsageResetTime;
     Button* resetButton;
     QWidget* filterContainer;
     QHBoxLayout* filterLayout;
@@ -729,6 +769,11 @@ struct RenderStatsDialogPrivate
         , totalTimeSpentDescLabel(0)
         , totalTimeSpentValueLabel(0)
         , totalSpentTime(0)
+        , threadUsageDescLabel(0)
+        , threadUsageValueLabel(0)
+        , threadStatsAtReset()
+        , threadUsageTimer()
+        , threadUsageResetTime(0)
         , resetButton(0)
         , filterContainer(0)
         , filterLayout(0)
@@ -746,9 +791,55 @@ struct RenderStatsDialogPrivate
 
     void editNodeRow(const NodePtr& node, const NodeRenderStats& stats);
 
+    void resetThreadUsage();
+
+    QString getThreadUsage() const;
+
     void updateVisibleRowsInternal(const QString& nameFilter, const QString& pluginIDFilter);
 };
 
+void
+RenderStatsDialogPrivate::resetThreadUsage()
+{
+    RenderThreadScheduler* scheduler = appPTR->getRenderThreadScheduler();
+
+    for (int i = 0; i < NATRON_RENDER_THREAD_PRIORITY_COUNT; ++i) {
+        scheduler->getStats( (RenderThreadPriorityEnum)i, &threadStatsAtReset[i] );
+    }
+    threadUsageResetTime = threadUsageTimer.getTimeSinceCreation();
+}
+
+QString
+RenderStatsDialogPrivate::getThreadUsage() const
+{
+    RenderThreadScheduler* scheduler = appPTR->getRenderThreadScheduler();
+    // The time all the threads of the pool could have spent rendering since the reset
+    double capacity = (threadUsageTimer.getTimeSinceCreation() - threadUsageResetTime) * std::max(1, appPTR->getMaxThreadCount());
+    QStringList ret;
+
+    for (int i = 0; i < NATRON_RENDER_THREAD_PRIORITY_COUNT; ++i) {
+        RenderThreadPriorityStats stats;
+        scheduler->getStats( (RenderThreadPriorityEnum)i, &stats );
+        double busyTime = stats.busyTime - threadStatsAtReset[i].busyTime;
+        int percent = capacity > 0 ? (int)(busyTime / capacity * 100. + 0.5) : 0;
+        QString name;
+        switch ( (RenderThreadPriorityEnum)i ) {
+        case eRenderThreadPriorityInteractive:
+            name = RenderStatsDialog::tr("Viewer");
+            break;
+        case eRenderThreadPriorityBackground:
+            name = RenderStatsDialog::tr("Background");
+            break;
+        case eRenderThreadPriorityIdle:
+            name = RenderStatsDialog::tr("Idle");
+            break;
+        }
+        ret.push_back( QString::fromUtf8("%1 %2% (%3 waits)").arg(name).arg(percent).arg(stats.nWaits - threadStatsAtReset[i].nWaits) );
+    }
+
+    return ret.join( QString::fromUtf8(", ") );
+}
+
 RenderStatsDialog::RenderStatsDialog(Gui* gui)
     : QWidget(gui)
     , _imp( new RenderStatsDialogPrivate(gui) )
@@ -810,6 +901,21 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentDescLabel);
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentValueLabel);
 
+    _imp->globalInfosLayout->addSpacing(20);
+
+    QString threadUsageTt = NATRON_NAMESPACE::convertFromPlainText(tr("The share of the render threads used since the statistics were reset "
+                                                                      "by viewer renders, background renders (Write nodes, tracking) and renders "
+                                                                      "that only use idle threads (node previews, frames rendered around the current frame).\n"
+                                                                      "The waits are the number of tasks that waited for more urgent renders."), NATRON_NAMESPACE::WhiteSpaceNormal);
+    _imp->threadUsageDescLabel = new Label(tr("Thread usage:"), _imp->globalInfosContainer);
+    _imp->threadUsageDescLabel->setToolTip(threadUsageTt);
+    _imp->threadUsageValueLabel = new Label(_imp->globalInfosContainer);
+    _imp->threadUsageValueLabel->setToolTip(threadUsageTt);
+    _imp->resetThreadUsage();
+
+    _imp->globalInfosLayout->addWidget(_imp->threadUsageDescLabel);
+    _imp->globalInfosLayout->addWidget(_imp->threadUsageValueLabel);
+
     _imp->resetButton = new Button(tr("Reset"), _imp->globalInfosContainer);
     _imp->resetButton->setToolTip( tr("Clears the statistics.") );
     QObject::connect( _imp->resetButton, SIGNAL(clicked(bool)), this, SLOT(resetStats()) );
@@ -890,7 +996,8 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
         << tr("Rendered Planes")
         << tr("Cache Hits")
         << tr("Cache Hits Higher Scale")
-        << tr("Cache Misses");
+        << tr("Cache Misses")
+        << tr("Cache Evictions");
 
     _imp->view->setColumnCount( dimensionNames.size() );
     _imp->view->setHorizontalHeaderLabels(dimensionNames);
@@ -964,6 +1071,7 @@ RenderStatsDialog::refreshAdvancedColsVisibility()
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT_DOWNSCALED, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_MISS, !checked);
+    _imp->view->setColumnHidden(COL_NB_CACHE_EVICTIONS, !checked);
 }
 
 void
@@ -972,6 +1080,8 @@ RenderStatsDialog::resetStats()
     _imp->model->clearRows();
     _imp->totalTimeSpentValueLabel->setText( QString::fromUtf8("0.0 sec") );
     _imp->totalSpentTime = 0;
+    _imp->resetThreadUsage();
+    _imp->threadUsageValueLabel->clear();
 }
 
 void
@@ -987,6 +1097,7 @@ RenderStatsDialog::addStats(int /*time*/,
 
     _imp->totalSpentTime += wallTime;
     _imp->totalTimeSpentValueLabel->setText( Timer::printAsTime(_imp->totalSpentTime, false) );
+    _imp->threadUsageValueLabel->setText( _imp->getThreadUsage() );
 
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = stats.begin(); it != stats.end(); ++it) {
         _imp->model->editNodeRow(it->first, it->second);
@@ -29,6 +29,7 @@
 #include <algorithm> // min, max
 #include <cstring> // for std::memcpy, std::memset, std::strcmp, std::strchr
 #include <stdexcept>
+#include <vector>
 
 #include "Global/GLIncludes.h" //!<must be included before QGlWidget because of gl.h and glew.h
 
@@ -48,6 +49,8 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_OFF
 #include <QtGui/QMouseEvent>
 GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 #include <QtOpenGL/QGLShaderProgram>
+#include <QtCore/QThreadPool>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 #include <QTreeWidget>
 #include <QTabBar>
 
@@ -90,6 +93,12 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 
 #define PERSISTENT_MESSAGE_LEFT_OFFSET_PIXELS 20
 
+///The number of pixel buffer objects the viewer textures are uploaded through, in turn
+#define NATRON_VIEWER_PBO_RING_SIZE 4
+
+///Buffers copied to a pixel buffer object are split in chunks of at least this size, copied by the global thread pool
+#define NATRON_VIEWER_PBO_MIN_BYTES_PER_COPY_TASK (4 * 1024 * 1024)
+
 #ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi             */
 #endif
@@ -110,6 +119,52 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 
 NATRON_NAMESPACE_ENTER
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct PboCopyChunk
+{
+    const unsigned char* src;
+    unsigned char* dst;
+    std::size_t bytesCount;
+};
+
+void
+copyPboChunk(const PboCopyChunk& chunk)
+{
+    std::memcpy(chunk.dst, chunk.src, chunk.bytesCount);
+}
+
+/**
+ * @brief Copies a viewer buffer to a mapped pixel buffer object. The copy of a large 32-bit float frame is
+ * memory bound and would stall the main thread for as long with a single thread, so large buffers are
+ * split between the threads of the global thread pool.
+ **/
+void
+copyToMappedPbo(const unsigned char* src,
+                unsigned char* dst,
+                std::size_t bytesCount)
+{
+    std::size_t nChunks = std::min<std::size_t>( bytesCount / NATRON_VIEWER_PBO_MIN_BYTES_PER_COPY_TASK,
+                                                 QThreadPool::globalInstance()->maxThreadCount() );
+
+    if (nChunks <= 1) {
+        std::memcpy(dst, src, bytesCount);
+
+        return;
+    }
+    std::vector<PboCopyChunk> chunks(nChunks);
+    for (std::size_t i = 0; i < nChunks; ++i) {
+        std::size_t start = bytesCount * i / nChunks;
+        std::size_t end = bytesCount * (i + 1) / nChunks;
+        chunks[i].src = src + start;
+        chunks[i].dst = dst + start;
+        chunks[i].bytesCount = end - start;
+    }
+    QtConcurrent::blockingMap(chunks, copyPboChunk);
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 
 ViewerGL::ViewerGL(ViewerTab* parent,
                    const QGLWidget* shareWidget)
@@ -1556,6 +1611,13 @@ ViewerGL::endTransferBufferFromRAMToGPU(int textureIndex,
         }
         setRegionOfDefinition(rod, par, textureIndex);
     }
+
+#ifdef TRACE_VIEWER_UPLOAD
+    qDebug() << "Viewer upload: frame" << time << "texture" << textureIndex << ":" << _imp->frameUploadBytes / (1024. * 1024.) << "MB in"
+             << _imp->frameUploadTime * 1000. << "ms";
+    _imp->frameUploadTime = 0.;
+    _imp->frameUploadBytes = 0;
+#endif
 } // ViewerGL::endTransferBufferFromRAMToGPU
 
 void
@@ -1575,6 +1637,10 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
     GLenum e = glGetError();
     Q_UNUSED(e);
 
+#ifdef TRACE_VIEWER_UPLOAD
+    TimeLapse uploadTimer;
+#endif
+
     GLint currentBoundPBO = 0;
     glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING_ARB, &currentBoundPBO);
     GLenum err = glGetError();
@@ -1582,7 +1648,8 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
         qDebug() << "(ViewerGL::allocateAndMapPBO): Another PBO is currently mapped, glMap failed.";
     }
 
-    // We use 2 PBOs to make use of asynchronous data uploading
+    // We use a ring of PBOs to make use of asynchronous data uploading: the texture update from a PBO
+    // may still be in progress when the next tiles are copied to the following ones
     GLuint pboId = getPboID(_imp->updateViewerPboIndex);
 
     // The bitdepth of the texture
@@ -1650,7 +1717,7 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
     assert(ramBuffer);
     if (ret && ramBuffer) {
         // update data directly on the mapped buffer
-        std::memcpy(ret, (void*)ramBuffer, bytesCount);
+        copyToMappedPbo( ramBuffer, (unsigned char*)ret, bytesCount );
         GLboolean result = glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB); // release the mapped buffer
         assert(result == GL_TRUE);
         Q_UNUSED(result);
@@ -1669,7 +1736,12 @@ ViewerGL::transferBufferFromRAMtoGPU(const unsigned char* ramBuffer,
 
     *texture = tex;
 
-    _imp->updateViewerPboIndex = (_imp->updateViewerPboIndex + 1) % 2;
+    _imp->updateViewerPboIndex = (_imp->updateViewerPboIndex + 1) % NATRON_VIEWER_PBO_RING_SIZE;
+
+#ifdef TRACE_VIEWER_UPLOAD
+    _imp->frameUploadTime += uploadTimer.getTimeSinceCreation();
+    _imp->frameUploadBytes += bytesCount;
+#endif
 } // ViewerGL::transferBufferFromRAMtoGPU
 
 void
@@ -4390,6 +4462,14 @@ ViewerGL::getColorAt(double x,
                                                            dstColorSpace,
                                                            r, g, b, a);
         break;
+    case eImageBitDepthHalf:
+        gotval = getColorAtInternal<Half, 1>(image,
+                                             xPixel, yPixel,
+                                             forceLinear,
+                                             srcColorSpace,
+                                             dstColorSpace,
+                                             r, g, b, a);
+        break;
     case eImageBitDepthFloat:
         gotval = getColorAtInternal<float, 1>(image,
                                               xPixel, yPixel,
@@ -4565,6 +4645,12 @@ ViewerGL::getColorAtRect(const RectD &rect, // rectangle in canonical coordinate
                                                                    &rPix, &gPix, &bPix, &aPix);
                 break;
             case eImageBitDepthHalf:
+                gotval = getColorAtInternal<Half, 1>(image,
+                                                     xPixel, yPixel,
+                                                     forceLinear,
+                                                     srcColorSpace,
+                                                     dstColorSpace,
+                                                     &rPix, &gPix, &bPix, &aPix);
                 break;
             case eImageBitDepthFloat:
                 gotval = getColorAtInternal<float, 1>(image,
@@ -123,6 +123,10 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
     , isUpdatingTexture(false)
     , renderOnPenUp(false)
     , updateViewerPboIndex(0)
+#ifdef TRACE_VIEWER_UPLOAD
+    , frameUploadTime(0.)
+    , frameUploadBytes(0)
+#endif
 {
     infoViewer[0] = 0;
     infoViewer[1] = 0;
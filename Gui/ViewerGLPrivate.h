@@ -48,6 +48,9 @@ CLANG_DIAG_ON(uninitialized)
 
 #define MAX_MIP_MAP_LEVELS 20
 
+///Print the time spent uploading each frame to the viewer textures
+//#define TRACE_VIEWER_UPLOAD
+
 NATRON_NAMESPACE_ENTER
 
 /*This class is the the core of the viewer : what displays images, overlays, etc...
@@ -226,6 +229,10 @@ struct ViewerGL::Implementation
     bool isUpdatingTexture;
     bool renderOnPenUp;
     int updateViewerPboIndex;  // always accessed in the main thread: initialized in the constructor, then always accessed and modified by updateViewer()
+#ifdef TRACE_VIEWER_UPLOAD
+    double frameUploadTime; // the time spent in transferBufferFromRAMtoGPU() for the tiles of the frame being uploaded
+    std::size_t frameUploadBytes;
+#endif
 
 public:
 
@@ -0,0 +1,135 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QThread>
+
+#include "Engine/AbortableRenderInfo.h"
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/ParallelRenderArgs.h"
+#include "Engine/TLSHolder.h"
+#include "Engine/Timer.h"
+#include "Engine/ViewIdx.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+// Stands for a long render of a plug-in that polls the abort state in its inner loop
+class LongRenderThread
+    : public QThread
+{
+public:
+
+    LongRenderThread(const NodePtr& node,
+                     const AbortableRenderInfoPtr& abortInfo,
+                     bool isRenderUserInteraction,
+                     const TimeLapse* clock,
+                     double timeout)
+        : QThread()
+        , node(node)
+        , abortInfo(abortInfo)
+        , isRenderUserInteraction(isRenderUserInteraction)
+        , clock(clock)
+        , timeout(timeout)
+        , abortedAtStart(true)
+        , abortSeen(false)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        {
+            ParallelRenderArgsSetter frameArgs( 1., ViewIdx(0), isRenderUserInteraction, false, abortInfo, node, 0,
+                                                node->getApp()->getTimeLine().get(), NodePtr(), false, false, RenderStatsPtr() );
+            EffectInstancePtr effect = node->getEffectInstance();
+            abortedAtStart = effect->aborted();
+
+            while ( !effect->aborted() ) {
+                if (clock->getTimeSinceCreation() > timeout) {
+                    break;
+                }
+            }
+            abortSeen = effect->aborted();
+        }
+        appPTR->getAppTLS()->cleanupTLSForThread();
+    }
+
+    NodePtr node;
+    AbortableRenderInfoPtr abortInfo;
+    bool isRenderUserInteraction;
+    const TimeLapse* clock;
+    // Stop waiting for the abort after this time
+    double timeout;
+    bool abortedAtStart;
+    bool abortSeen;
+};
+}
+
+TEST_F(BaseTest, RenderAbortIsSeen)
+{
+    NodePtr node = createNode( QString::fromUtf8(PLUGINID_NATRON_DOT) );
+
+    ASSERT_TRUE( bool(node) );
+
+    for (int userInteraction = 0; userInteraction < 2; ++userInteraction) {
+        TimeLapse clock;
+        AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(true, 0);
+        LongRenderThread render(node, abortInfo, (bool)userInteraction, &clock, 10.);
+        render.start();
+
+        // Let the render spin for a while before aborting it
+        EXPECT_FALSE( render.wait(100) );
+        abortInfo->setAborted();
+        render.wait();
+
+        // The render stops because it saw the abort, not because it timed out
+        EXPECT_FALSE(render.abortedAtStart);
+        EXPECT_TRUE(render.abortSeen);
+    }
+}
+
+TEST_F(BaseTest, NotAbortableRender)
+{
+    NodePtr node = createNode( QString::fromUtf8(PLUGINID_NATRON_DOT) );
+
+    ASSERT_TRUE( bool(node) );
+
+    // Renders in response to a user interaction that cannot be aborted are never aborted
+    TimeLapse clock;
+    AbortableRenderInfoPtr abortInfo = AbortableRenderInfo::create(false, 0);
+    LongRenderThread render(node, abortInfo, true, &clock, 0.1);
+    abortInfo->setAborted();
+    render.start();
+    render.wait();
+    EXPECT_FALSE(render.abortedAtStart);
+    EXPECT_FALSE(render.abortSeen);
+}
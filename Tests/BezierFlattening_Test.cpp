@@ -0,0 +1,184 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/Bezier.h"
+#include "Engine/BezierCP.h"
+#include "Engine/Node.h"
+#include "Engine/RotoContext.h"
+#include "Engine/ViewIdx.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+// The forward differences accumulate rounding errors, but far below a pixel
+const double kForwardDifferencesEpsilon = 1e-6;
+
+// Number of points of the curve checked between two consecutive points of the polyline
+const int kFlatnessSamples = 16;
+
+double
+distanceToSegment(const Point& p,
+                  const Point& a,
+                  const Point& b)
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double lengthSquared = dx * dx + dy * dy;
+    double u = 0.;
+
+    if (lengthSquared > 0.) {
+        u = std::max( 0., std::min( 1., ( (p.x - a.x) * dx + (p.y - a.y) * dy ) / lengthSquared ) );
+    }
+    double x = a.x + u * dx - p.x;
+    double y = a.y + u * dy - p.y;
+
+    return std::sqrt(x * x + y * y);
+}
+
+/*
+ * Flattens the closed shape with an automatic number of points, and checks each segment against the de Casteljau
+ * evaluation of its control points: the points must lie on the curve, and the curve must stay within the flatness
+ * tolerance of the polyline.
+ */
+void
+checkFlattening(const BezierPtr& shape,
+                double time,
+                std::list<std::list<ParametricPoint> >* points)
+{
+    RectD bbox;
+
+    bbox.setupInfinity();
+    shape->evaluateAtTime_DeCasteljau_autoNbPoints(false, time, 0, points, &bbox);
+
+    int nbCps = shape->getControlPointsCount();
+    ASSERT_EQ( nbCps, (int)points->size() );
+
+    int index = 0;
+    for (std::list<std::list<ParametricPoint> >::const_iterator it = points->begin(); it != points->end(); ++it, ++index) {
+        BezierCPPtr first = shape->getControlPointAtIndex(index);
+        BezierCPPtr last = shape->getControlPointAtIndex( (index + 1) % nbCps );
+        Point p0, p1, p2, p3;
+        first->getPositionAtTime(false, time, ViewIdx(0), &p0.x, &p0.y);
+        first->getRightBezierPointAtTime(false, time, ViewIdx(0), &p1.x, &p1.y);
+        last->getLeftBezierPointAtTime(false, time, ViewIdx(0), &p2.x, &p2.y);
+        last->getPositionAtTime(false, time, ViewIdx(0), &p3.x, &p3.y);
+
+        // The shape is closed: the end point of each segment is the first point of the next one
+        ASSERT_FALSE( it->empty() );
+        std::vector<ParametricPoint> polyline( it->begin(), it->end() );
+        ParametricPoint end = {p3.x, p3.y, 1.};
+        polyline.push_back(end);
+        EXPECT_EQ( 0., polyline.front().t );
+
+        for (std::size_t i = 0; i < polyline.size(); ++i) {
+            Point onCurve;
+            Bezier::bezierPoint(p0, p1, p2, p3, polyline[i].t, &onCurve);
+            EXPECT_NEAR( onCurve.x, polyline[i].x, kForwardDifferencesEpsilon );
+            EXPECT_NEAR( onCurve.y, polyline[i].y, kForwardDifferencesEpsilon );
+            EXPECT_TRUE( polyline[i].x >= bbox.x1 - kForwardDifferencesEpsilon && polyline[i].x <= bbox.x2 + kForwardDifferencesEpsilon &&
+                         polyline[i].y >= bbox.y1 - kForwardDifferencesEpsilon && polyline[i].y <= bbox.y2 + kForwardDifferencesEpsilon );
+            if (i == 0) {
+                continue;
+            }
+
+            EXPECT_LT( polyline[i - 1].t, polyline[i].t );
+            Point a = {polyline[i - 1].x, polyline[i - 1].y};
+            Point b = {polyline[i].x, polyline[i].y};
+            for (int s = 1; s < kFlatnessSamples; ++s) {
+                double t = polyline[i - 1].t + (polyline[i].t - polyline[i - 1].t) * s / (double)kFlatnessSamples;
+                Bezier::bezierPoint(p0, p1, p2, p3, t, &onCurve);
+                EXPECT_LE( distanceToSegment(onCurve, a, b), ROTO_BEZIER_FLATNESS_TOLERANCE + kForwardDifferencesEpsilon );
+            }
+        }
+    }
+} // checkFlattening
+
+bool
+samePoints(const std::list<std::list<ParametricPoint> >& a,
+           const std::list<std::list<ParametricPoint> >& b)
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+    std::list<std::list<ParametricPoint> >::const_iterator itB = b.begin();
+    for (std::list<std::list<ParametricPoint> >::const_iterator itA = a.begin(); itA != a.end(); ++itA, ++itB) {
+        if ( itA->size() != itB->size() ) {
+            return false;
+        }
+        std::list<ParametricPoint>::const_iterator pB = itB->begin();
+        for (std::list<ParametricPoint>::const_iterator pA = itA->begin(); pA != itA->end(); ++pA, ++pB) {
+            if ( (pA->x != pB->x) || (pA->y != pB->y) || (pA->t != pB->t) ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+}
+
+TEST_F(BaseTest, BezierFlattening)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr ctx = roto->getRotoContext();
+    ASSERT_TRUE(ctx);
+
+    // A small and a large ellipse: the large one bends over more pixels and needs more points per segment
+    BezierPtr smallShape = ctx->makeEllipse(0, 0, 20, true, 0);
+    BezierPtr largeShape = ctx->makeEllipse(0, 0, 2000, true, 0);
+    ASSERT_TRUE( bool(smallShape) && bool(largeShape) );
+
+    std::list<std::list<ParametricPoint> > smallPoints, largePoints;
+    checkFlattening(smallShape, 0, &smallPoints);
+    checkFlattening(largeShape, 0, &largePoints);
+    ASSERT_FALSE( smallPoints.empty() || largePoints.empty() );
+    EXPECT_LT( smallPoints.front().size(), largePoints.front().size() );
+
+    // The same evaluation gives the same polygon
+    std::list<std::list<ParametricPoint> > again;
+    largeShape->evaluateAtTime_DeCasteljau_autoNbPoints(false, 0, 0, &again, 0);
+    EXPECT_TRUE( samePoints(largePoints, again) );
+
+    // Editing the shape changes its polygon, no stale flattened polygon is returned
+    double x, y;
+    largeShape->getControlPointAtIndex(0)->getPositionAtTime(false, 0, ViewIdx(0), &x, &y);
+    largeShape->setPointByIndex(0, 0, x + 300, y);
+    std::list<std::list<ParametricPoint> > moved;
+    checkFlattening(largeShape, 0, &moved);
+    ASSERT_FALSE( moved.empty() || moved.front().empty() );
+    EXPECT_NEAR( x + 300, moved.front().front().x, kForwardDifferencesEpsilon );
+    EXPECT_FALSE( samePoints(largePoints, moved) );
+}
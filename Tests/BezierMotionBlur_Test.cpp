@@ -0,0 +1,84 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include "Engine/Bezier.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/RotoContext.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+TEST(BezierMotionBlur, SamplesCount)
+{
+    // A shape that does not move needs no motion blur at all
+    EXPECT_EQ( 0, Bezier::getMotionBlurSamplesCount(0., 10) );
+    EXPECT_EQ( 0, Bezier::getMotionBlurSamplesCount(-1., 10) );
+
+    // One sample per NATRON_ROTO_MOTION_BLUR_PIXELS_PER_SAMPLE pixels travelled, rounded up
+    EXPECT_EQ( 1, Bezier::getMotionBlurSamplesCount(0.1, 10) );
+    EXPECT_EQ( 4, Bezier::getMotionBlurSamplesCount(3.5 * NATRON_ROTO_MOTION_BLUR_PIXELS_PER_SAMPLE, 10) );
+
+    // Never more than the motion blur amount
+    EXPECT_EQ( 10, Bezier::getMotionBlurSamplesCount(1e6, 10) );
+    EXPECT_EQ( 1, Bezier::getMotionBlurSamplesCount(1e6, 1) );
+}
+
+TEST_F(BaseTest, BezierDisplacement)
+{
+    NodePtr roto = createNode( QString::fromUtf8(PLUGINID_NATRON_ROTO) );
+    ASSERT_TRUE(roto);
+    RotoContextPtr ctx = roto->getRotoContext();
+    ASSERT_TRUE(ctx);
+
+    BezierPtr shape = ctx->makeSquare(0, 100, 100, 0);
+    ASSERT_TRUE(shape);
+    ASSERT_EQ(4, shape->getControlPointsCount());
+
+    // Static shape: nothing to blur
+    EXPECT_EQ( 0., shape->getControlPointsMaxDisplacement(0, 10) );
+    EXPECT_EQ( 0, Bezier::getMotionBlurSamplesCount(shape->getControlPointsMaxDisplacement(0, 10), 10) );
+
+    // An empty shutter does not move either
+    EXPECT_EQ( 0., shape->getControlPointsMaxDisplacement(10, 10) );
+
+    // Move the first point 40 pixels to the right at frame 10 and back at frame 20
+    shape->setPointByIndex(0, 10, 40, 100);
+    shape->setPointByIndex(0, 20, 0, 100);
+
+    EXPECT_NEAR( 40., shape->getControlPointsMaxDisplacement(0, 10), 1e-6 );
+    EXPECT_NEAR( 40., shape->getControlPointsMaxDisplacement(10, 20), 1e-6 );
+
+    // The shape is at the same place at both ends of the shutter, but it went back and forth in between
+    // and needs as much motion blur as if it had travelled the whole path
+    double backAndForth = shape->getControlPointsMaxDisplacement(0, 20);
+    EXPECT_NEAR( 80., backAndForth, 1e-6 );
+    EXPECT_EQ( 40, Bezier::getMotionBlurSamplesCount(backAndForth, 100) );
+    EXPECT_EQ( 5, Bezier::getMotionBlurSamplesCount(backAndForth, 5) );
+}
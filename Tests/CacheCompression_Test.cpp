@@ -0,0 +1,207 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <QtCore/QDir>
+
+#include "Global/QtCompat.h"
+
+#include "Engine/Cache.h"
+#include "Engine/CacheCompression.h"
+#include "Engine/CacheSerialization.h"
+#include "Engine/Image.h"
+#include "Engine/ImageParams.h"
+
+NATRON_NAMESPACE_USING
+
+// A smooth gradient with some noise, similar to what a rendered float image looks like
+static void
+makeFloatImage(std::size_t nPixels,
+               std::vector<float>* pixels)
+{
+    pixels->resize(nPixels * 4);
+    srand(2000);
+    for (std::size_t i = 0; i < nPixels; ++i) {
+        float v = 0.5f + 0.4f * std::sin(i * 0.0005f);
+        // coverity[dont_call]
+        float noise = (rand() % 16) / 4096.f;
+        (*pixels)[i * 4] = v + noise;
+        (*pixels)[i * 4 + 1] = v * 0.8f + noise;
+        (*pixels)[i * 4 + 2] = v * 0.6f;
+        (*pixels)[i * 4 + 3] = 1.f;
+    }
+}
+
+TEST(CacheCompression,
+     RoundTrip)
+{
+    // Sizes that are not a multiple of the data type size nor of the block size
+    const std::size_t sizes[] = { 0, 1, 7, 4096, (1 << 20) + 3, 3 * (1 << 20) + 6 };
+
+    for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        std::vector<float> pixels;
+        makeFloatImage(sizes[i] / 16 + 1, &pixels);
+        const char* data = (const char*)&pixels[0];
+        for (std::size_t dataTypeSize = 1; dataTypeSize <= 4; dataTypeSize *= 2) {
+            std::vector<char> compressed;
+            CacheCompression::compress(data, sizes[i], dataTypeSize, &compressed);
+            ASSERT_EQ( sizes[i], CacheCompression::getDecompressedSize( &compressed[0], compressed.size() ) );
+
+            std::vector<char> decompressed(sizes[i] + 1);
+            ASSERT_TRUE( CacheCompression::decompress(&compressed[0], compressed.size(), &decompressed[0], sizes[i]) );
+            EXPECT_EQ( 0, std::memcmp(data, &decompressed[0], sizes[i]) );
+        }
+    }
+}
+
+TEST(CacheCompression,
+     CorruptedData)
+{
+    std::vector<float> pixels;
+
+    makeFloatImage(1 << 16, &pixels);
+    std::size_t size = pixels.size() * sizeof(float);
+    std::vector<char> compressed;
+    CacheCompression::compress( (const char*)&pixels[0], size, sizeof(float), &compressed );
+
+    // The decompressor must never write out of bounds, whatever the input
+    std::vector<char> decompressed(size);
+    srand(2000);
+    for (int i = 0; i < 100; ++i) {
+        std::vector<char> corrupted = compressed;
+        // coverity[dont_call]
+        corrupted[rand() % corrupted.size()] ^= 0x5a;
+        CacheCompression::decompress(&corrupted[0], corrupted.size(), &decompressed[0], size, false);
+    }
+
+    // Truncated data must be rejected
+    EXPECT_FALSE( CacheCompression::decompress(&compressed[0], compressed.size() / 2, &decompressed[0], size) );
+}
+
+TEST(CacheCompression,
+     LargeImage)
+{
+    // 2K float RGBA image
+    const std::size_t nPixels = 2048 * 1556;
+    std::vector<float> pixels;
+
+    makeFloatImage(nPixels, &pixels);
+    const char* data = (const char*)&pixels[0];
+    std::size_t size = pixels.size() * sizeof(float);
+    std::vector<char> decompressed(size);
+    std::vector<char> compressed;
+
+    CacheCompression::compress(data, size, sizeof(float), &compressed);
+    ASSERT_TRUE( CacheCompression::decompress(&compressed[0], compressed.size(), &decompressed[0], size) );
+    ASSERT_EQ( 0, std::memcmp(data, &decompressed[0], size) );
+    EXPECT_LT( compressed.size(), size );
+}
+
+// A cache saved with compressed entries must give them back after a restart, even with compression turned off
+TEST(CacheCompression,
+     SaveRestore)
+{
+    const RectI bounds(0, 0, 64, 48);
+    RectD rod(bounds.x1, bounds.y1, bounds.x2, bounds.y2);
+    ImageKey key = Image::makeKey(0, 1234, false, 0., ViewIdx(0), false, false);
+    ImageParamsPtr params = Image::makeParams(rod, bounds, 1., 0, false, ImagePlaneDesc::getRGBAComponents(), eImageBitDepthFloat,
+                                              eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, eStorageModeDisk);
+    const std::string cacheName("CacheCompressionTest");
+    const U64 cacheSize = 256 * 1024 * 1024;
+    std::vector<float> expected;
+    Cache<Image>::CacheTOC toc;
+    QString cachePath;
+
+    {
+        Cache<Image> cache(cacheName, 1, cacheSize, 0.5);
+        cachePath = cache.getCachePath();
+        for (int i = 0; i < 256; ++i) {
+            QDir(cachePath).mkpath( QString::fromUtf8("%1").arg(i, 2, 16, QLatin1Char('0')) );
+        }
+        cache.setCompressionEnabled(true);
+
+        ImagePtr img;
+        cache.getOrCreate(key, params, 0, &img);
+        ASSERT_TRUE(img);
+        img->allocateMemory();
+        {
+            Image::WriteAccess acc = img->getWriteRights();
+            for (int y = bounds.y1; y < bounds.y2; ++y) {
+                float* pix = (float*)acc.pixelAt(bounds.x1, y);
+                for (int x = bounds.x1; x < bounds.x2; ++x) {
+                    for (int k = 0; k < 4; ++k, ++pix) {
+                        *pix = ( (x * 7 + y * 13 + k * 5) % 101 ) / 7.f;
+                        expected.push_back(*pix);
+                    }
+                }
+            }
+        }
+        img.reset();
+
+        // Saving moves the entry to disk, which compresses it
+        cache.save(&toc);
+        cache.waitForPendingCompressions();
+    }
+
+    ASSERT_EQ( 1, (int)toc.size() );
+    const std::string& filePath = toc.front().filePath;
+    std::string compressedFilePath = CacheCompression::getCompressedFilePath(filePath);
+    ASSERT_TRUE( CacheAPI::fileExists(compressedFilePath) );
+    EXPECT_FALSE( CacheAPI::fileExists(filePath) );
+
+    {
+        Cache<Image> cache(cacheName, 1, cacheSize, 0.5);
+        cache.restore(toc);
+        EXPECT_TRUE( CacheAPI::fileExists(compressedFilePath) );
+
+        std::list<ImagePtr> images;
+        ASSERT_TRUE( cache.get(key, &images) );
+        ASSERT_EQ( 1, (int)images.size() );
+        ImagePtr img = images.front();
+        {
+            Image::ReadAccess acc = img->getReadRights();
+            std::size_t i = 0;
+            for (int y = bounds.y1; y < bounds.y2; ++y) {
+                const float* pix = (const float*)acc.pixelAt(bounds.x1, y);
+                for (int x = bounds.x1; x < bounds.x2; ++x) {
+                    for (int k = 0; k < 4; ++k, ++pix, ++i) {
+                        ASSERT_EQ(expected[i], *pix);
+                    }
+                }
+            }
+        }
+        img.reset();
+        images.clear();
+        cache.clear();
+    }
+    QtCompat::removeRecursively(cachePath);
+}
@@ -24,10 +24,19 @@
 
 #include "Global/Macros.h"
 
+#include <bitset>
+#include <cmath>
 #include <cstring>
+#include <limits>
+#include <vector>
 #include <gtest/gtest.h>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/make_shared.hpp>
+#endif
+
 #include "Engine/Image.h"
+#include "Engine/Timer.h"
 #include "Engine/ViewIdx.h"
 
 NATRON_NAMESPACE_USING
@@ -159,3 +168,548 @@ TEST(ImageKeyTest, Difference) {
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+
+TEST(HalfTest, Conversion) {
+    // values that are exactly representable
+    const float exact[] = { 0.f, -0.f, 1.f, -2.f, 0.5f, 65504.f, 6.103515625e-05f /*smallest normal*/, 5.9604644775390625e-08f /*smallest denormal*/ };
+
+    for (std::size_t i = 0; i < sizeof(exact) / sizeof(exact[0]); ++i) {
+        EXPECT_EQ( exact[i], (float)Half(exact[i]) );
+    }
+    EXPECT_EQ( 0x3c00, Half(1.f).bits() );
+    EXPECT_EQ( 0xc000, Half(-2.f).bits() );
+
+    // round to nearest even: 1 + 2^-11 is halfway between 1 and the next half
+    EXPECT_EQ( 0x3c00, Half(1.f + 1.f / 2048.f).bits() );
+    EXPECT_EQ( 0x3c01, Half(1.f + 3.f / 4096.f).bits() );
+
+    // overflow, infinity and nan
+    EXPECT_EQ( 0x7c00, Half(65520.f).bits() );
+    EXPECT_EQ( 0xfc00, Half(-1e10f).bits() );
+    EXPECT_TRUE( Half( std::numeric_limits<float>::quiet_NaN() ).isNan() );
+    EXPECT_FALSE( Half( std::numeric_limits<float>::infinity() ).isNan() );
+
+    // every half converts to float and back to the same bits (except nans)
+    for (unsigned int b = 0; b < 0x10000; ++b) {
+        Half h = Half::fromBits( (unsigned short)b );
+        if ( !h.isNan() ) {
+            ASSERT_EQ( b, Half( (float)h ).bits() );
+        }
+    }
+}
+
+TEST(HalfTest, RowConversion) {
+    // a size that is not a multiple of the vector width
+    const std::size_t n = 1027;
+    std::vector<float> src(n), back(n);
+    std::vector<Half> halves(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        src[i] = (i - 500.f) * 0.0123f;
+    }
+    Half::fromFloat(&src[0], &halves[0], n);
+    Half::toFloat(&halves[0], &back[0], n);
+    for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_EQ( Half(src[i]).bits(), halves[i].bits() );
+        ASSERT_EQ( (float)Half(src[i]), back[i] );
+        // half has 11 significant bits
+        EXPECT_NEAR( src[i], back[i], std::fabs(src[i]) / 1024.f );
+    }
+}
+
+static ImagePtr
+makeTestImage(const RectI& bounds,
+                    unsigned int mipMapLevel,
+                    const ImagePlaneDesc& components)
+{
+    RectD rod(bounds.x1, bounds.y1, bounds.x2, bounds.y2);
+
+    return boost::make_shared<Image>(components, rod, bounds, mipMapLevel, 1., eImageBitDepthFloat, eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, true);
+}
+
+static void
+fillTestImage(const ImagePtr& img)
+{
+    const RectI& bounds = img->getBounds();
+    int nComps = img->getComponentsCount();
+    Image::WriteAccess acc = img->getWriteRights();
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        float* pix = (float*)acc.pixelAt(bounds.x1, y);
+        for (int x = bounds.x1; x < bounds.x2; ++x) {
+            for (int k = 0; k < nComps; ++k, ++pix) {
+                *pix = ( (x * 7 + y * 13 + k * 5) % 101 ) / 7.f;
+            }
+        }
+    }
+    img->markForRendered(bounds);
+}
+
+// The mipmap levels are the 2x2 box filter of the previous level
+TEST(ImageMipMapTest, BoxFilter) {
+    const ImagePlaneDesc* components[] = { &ImagePlaneDesc::getAlphaComponents(), &ImagePlaneDesc::getRGBAComponents() };
+
+    for (int c = 0; c < 2; ++c) {
+        RectI bounds(0, 0, 64, 48);
+        ImagePtr src = makeTestImage(bounds, 0, *components[c]);
+        fillTestImage(src);
+        int nComps = src->getComponentsCount();
+
+        ImagePtr dst = makeTestImage(RectI(0, 0, 16, 12), 2, *components[c]);
+        src->downscaleMipMap(src->getRoD(), bounds, 0, 2, true, dst.get());
+
+        // the reference, level by level
+        std::vector<float> level(bounds.area() * nComps);
+        int width = bounds.width(), height = bounds.height();
+        {
+            Image::ReadAccess acc = src->getReadRights();
+            std::memcpy( &level[0], acc.pixelAt(0, 0), level.size() * sizeof(float) );
+        }
+        for (int l = 0; l < 2; ++l) {
+            std::vector<float> halved( (width / 2) * (height / 2) * nComps );
+            for (int y = 0; y < height / 2; ++y) {
+                for (int x = 0; x < width / 2; ++x) {
+                    for (int k = 0; k < nComps; ++k) {
+                        float a = level[( (y * 2) * width + x * 2 ) * nComps + k];
+                        float b = level[( (y * 2) * width + x * 2 + 1 ) * nComps + k];
+                        float c = level[( (y * 2 + 1) * width + x * 2 ) * nComps + k];
+                        float d = level[( (y * 2 + 1) * width + x * 2 + 1 ) * nComps + k];
+                        halved[( y * (width / 2) + x ) * nComps + k] = (a + b + c + d) / 4;
+                    }
+                }
+            }
+            level.swap(halved);
+            width /= 2;
+            height /= 2;
+        }
+
+        Image::ReadAccess acc = dst->getReadRights();
+        for (int y = 0; y < height; ++y) {
+            const float* pix = (const float*)acc.pixelAt(0, y);
+            for (int i = 0; i < width * nComps; ++i) {
+                ASSERT_EQ(level[y * width * nComps + i], pix[i]);
+            }
+            for (int x = 0; x < width; ++x) {
+                ASSERT_EQ(1, *acc.bitmapAt(x, y));
+            }
+        }
+    }
+}
+
+// Building several levels in one pass gives the same result as building them one after the other,
+// including on the borders of bounds that are not aligned on the levels
+TEST(ImageMipMapTest, IntermediateLevels) {
+    RectI bounds(-3, -5, 517, 389);
+    ImagePtr src = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+
+    fillTestImage(src);
+    int nComps = src->getComponentsCount();
+
+    std::vector<ImagePtr> pyramid(3);
+    std::vector<Image*> intermediateOutputs(2);
+    for (int l = 0; l < 3; ++l) {
+        pyramid[l] = makeTestImage(bounds.downscalePowerOfTwoSmallestEnclosing(l + 1), l + 1, ImagePlaneDesc::getRGBAComponents());
+        if (l < 2) {
+            intermediateOutputs[l] = pyramid[l].get();
+        }
+    }
+    src->downscaleMipMap(src->getRoD(), bounds, 0, 3, true, pyramid[2].get(), &intermediateOutputs);
+
+    for (int l = 0; l < 3; ++l) {
+        const Image* previous = (l == 0) ? src.get() : pyramid[l - 1].get();
+        ImagePtr level = makeTestImage(pyramid[l]->getBounds(), l + 1, ImagePlaneDesc::getRGBAComponents());
+        previous->downscaleMipMap(src->getRoD(), previous->getBounds(), l, l + 1, true, level.get());
+
+        const RectI& levelBounds = level->getBounds();
+        Image::ReadAccess expected = level->getReadRights();
+        Image::ReadAccess actual = pyramid[l]->getReadRights();
+        // the pixels that are not computed are left uninitialized, they are marked as not rendered in the bitmap
+        for (int y = levelBounds.y1; y < levelBounds.y2; ++y) {
+            ASSERT_EQ( 0, std::memcmp( expected.bitmapAt(levelBounds.x1, y), actual.bitmapAt(levelBounds.x1, y), levelBounds.width() ) );
+            for (int x = levelBounds.x1; x < levelBounds.x2; ++x) {
+                if ( *actual.bitmapAt(x, y) ) {
+                    ASSERT_EQ( 0, std::memcmp( expected.pixelAt(x, y), actual.pixelAt(x, y), nComps * sizeof(float) ) );
+                }
+            }
+        }
+    }
+}
+
+///Copies the pixels of img, row by row
+static std::vector<float>
+getTestImagePixels(const ImagePtr& img)
+{
+    const RectI& bounds = img->getBounds();
+    int rowElements = bounds.width() * img->getComponentsCount();
+    std::vector<float> pixels(bounds.height() * rowElements);
+    Image::ReadAccess acc = img->getReadRights();
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        std::memcpy( &pixels[(y - bounds.y1) * rowElements], acc.pixelAt(bounds.x1, y), rowElements * sizeof(float) );
+    }
+
+    return pixels;
+}
+
+///The pixel of img at (x, y) in pixels, a copy of img made by getTestImagePixels, or NULL if it is outside img
+static float*
+getTestImagePixel(const ImagePtr& img,
+                  std::vector<float>& pixels,
+                  int x,
+                  int y)
+{
+    const RectI& bounds = img->getBounds();
+
+    if ( (x < bounds.x1) || (x >= bounds.x2) || (y < bounds.y1) || (y >= bounds.y2) ) {
+        return 0;
+    }
+
+    return &pixels[( (y - bounds.y1) * bounds.width() + (x - bounds.x1) ) * img->getComponentsCount()];
+}
+
+///The scalar versions of premultImage, applyMaskMix and copyUnProcessedChannels (without premultiplication), pixel by pixel
+static void
+premultReference(const ImagePtr& img,
+                 std::vector<float>& pixels,
+                 const RectI& roi,
+                 bool doPremult)
+{
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        for (int x = roi.x1; x < roi.x2; ++x) {
+            float* pix = getTestImagePixel(img, pixels, x, y);
+            for (int c = 0; c < 3; ++c) {
+                if (doPremult) {
+                    pix[c] = pix[c] * pix[3];
+                } else if (pix[3] != 0) {
+                    pix[c] = pix[c] / pix[3];
+                }
+            }
+        }
+    }
+}
+
+static void
+maskMixReference(const ImagePtr& dst,
+                 std::vector<float>& dstPixels,
+                 const ImagePtr& mask,
+                 std::vector<float>& maskPixels,
+                 const ImagePtr& original,
+                 std::vector<float>& originalPixels,
+                 const RectI& roi,
+                 bool maskInvert,
+                 float mix)
+{
+    int nComps = dst->getComponentsCount();
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        for (int x = roi.x1; x < roi.x2; ++x) {
+            float* pix = getTestImagePixel(dst, dstPixels, x, y);
+            const float* maskPix = getTestImagePixel(mask, maskPixels, x, y);
+            const float* srcPix = getTestImagePixel(original, originalPixels, x, y);
+            float maskScale = maskPix ? *maskPix : 0.f;
+            if (maskInvert) {
+                maskScale = 1.f - maskScale;
+            }
+            float alpha = mix * maskScale;
+            for (int c = 0; c < nComps; ++c) {
+                pix[c] = srcPix ? pix[c] * alpha + (1.f - alpha) * srcPix[c] : pix[c] * alpha;
+            }
+        }
+    }
+}
+
+static void
+copyAlphaReference(const ImagePtr& dst,
+                   std::vector<float>& dstPixels,
+                   const ImagePtr& original,
+                   std::vector<float>& originalPixels,
+                   const RectI& roi)
+{
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        for (int x = roi.x1; x < roi.x2; ++x) {
+            const float* srcPix = getTestImagePixel(original, originalPixels, x, y);
+            getTestImagePixel(dst, dstPixels, x, y)[3] = srcPix ? srcPix[3] : 0.f;
+        }
+    }
+}
+
+// The images are large enough to be processed by several threads, and the original and mask images
+// only partially cover the output image.
+TEST(ImageKernelsTest, Premult) {
+    RectI bounds(-10, -20, 390, 280);
+    RectI roi(0, -15, 385, 250);
+
+    for (int doPremult = 0; doPremult < 2; ++doPremult) {
+        ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+        fillTestImage(img);
+        std::vector<float> expected = getTestImagePixels(img);
+        premultReference(img, expected, roi, doPremult);
+        if (doPremult) {
+            img->premultImage(roi);
+        } else {
+            img->unpremultImage(roi);
+        }
+        std::vector<float> actual = getTestImagePixels(img);
+        ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+    }
+}
+
+TEST(ImageKernelsTest, MaskMix) {
+    RectI bounds(0, 0, 400, 300);
+
+    for (int maskInvert = 0; maskInvert < 2; ++maskInvert) {
+        ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+        ImagePtr original = makeTestImage(RectI(-50, 20, 350, 400), 0, ImagePlaneDesc::getRGBAComponents());
+        ImagePtr mask = makeTestImage(RectI(30, -10, 500, 250), 0, ImagePlaneDesc::getAlphaComponents());
+        fillTestImage(img);
+        fillTestImage(original);
+        fillTestImage(mask);
+        {
+            // the mask must be in [0, 1]
+            Image::WriteAccess acc = mask->getWriteRights();
+            const RectI& maskBounds = mask->getBounds();
+            for (int y = maskBounds.y1; y < maskBounds.y2; ++y) {
+                float* pix = (float*)acc.pixelAt(maskBounds.x1, y);
+                for (int x = maskBounds.x1; x < maskBounds.x2; ++x, ++pix) {
+                    *pix /= 15.f;
+                }
+            }
+        }
+        std::vector<float> expected = getTestImagePixels(img);
+        std::vector<float> maskPixels = getTestImagePixels(mask);
+        std::vector<float> originalPixels = getTestImagePixels(original);
+        maskMixReference(img, expected, mask, maskPixels, original, originalPixels, bounds, maskInvert, 0.7f);
+        img->applyMaskMix(bounds, mask.get(), original.get(), true, maskInvert, 0.7f);
+        std::vector<float> actual = getTestImagePixels(img);
+        ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+    }
+}
+
+TEST(ImageKernelsTest, CopyUnProcessedChannels) {
+    RectI bounds(0, 0, 400, 300);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+    ImagePtr original = makeTestImage(RectI(-50, 20, 350, 400), 0, ImagePlaneDesc::getRGBAComponents());
+
+    fillTestImage(img);
+    fillTestImage(original);
+    std::vector<float> expected = getTestImagePixels(img);
+    std::vector<float> originalPixels = getTestImagePixels(original);
+    copyAlphaReference(img, expected, original, originalPixels, bounds);
+
+    // RGB were processed: copy A
+    std::bitset<4> processChannels;
+    processChannels[0] = processChannels[1] = processChannels[2] = true;
+    img->copyUnProcessedChannels(bounds, eImagePremultiplicationOpaque, eImagePremultiplicationOpaque, processChannels, original, false);
+    std::vector<float> actual = getTestImagePixels(img);
+    ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+}
+
+TEST(ImageViewTest, SharesPixels) {
+    ImagePtr img = makeTestImage(RectI(0, 0, 64, 32), 0, ImagePlaneDesc::getForwardMotionComponents());
+
+    fillTestImage(img);
+
+    ImagePtr view = boost::make_shared<Image>(img, ImagePlaneDesc::getXYComponents(), eImagePremultiplicationOpaque);
+    EXPECT_TRUE( view->getComponents() == ImagePlaneDesc::getXYComponents() );
+    EXPECT_EQ( eImagePremultiplicationOpaque, view->getPremultiplication() );
+    EXPECT_TRUE( view->getBounds() == img->getBounds() );
+    {
+        Image::ReadAccess viewAcc = view->getReadRights();
+        Image::ReadAccess imgAcc = img->getReadRights();
+        ASSERT_EQ( imgAcc.pixelAt(10, 10), viewAcc.pixelAt(10, 10) );
+    }
+
+    // a view of a view is a view of the same image
+    ImagePtr viewOfView = boost::make_shared<Image>(view, ImagePlaneDesc::getForwardMotionComponents(), eImagePremultiplicationOpaque);
+    EXPECT_EQ( img, viewOfView->getViewedImage() );
+
+    // the view follows the viewed image when it is resized
+    img->ensureBounds(RectI(-10, -5, 64, 40), true);
+    EXPECT_TRUE( view->getBounds() == img->getBounds() );
+    std::vector<float> expected = getTestImagePixels(img);
+    std::vector<float> actual = getTestImagePixels(view);
+    ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+
+    // the kernels read the view as they would read the viewed image
+    ImagePtr copy = makeTestImage(img->getBounds(), 0, ImagePlaneDesc::getXYComponents());
+    copy->pasteFrom(*view, view->getBounds(), false);
+    actual = getTestImagePixels(copy);
+    ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+}
+
+// The kernels that are applied to the output of the OpenFX renders, chained on an HD RGBA image as a render
+// does, give the same result as the scalar versions above
+TEST(ImageKernelsTest, ChainedOnHDImage) {
+    RectI bounds(0, 0, 1920, 1080);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+    ImagePtr original = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+    ImagePtr mask = makeTestImage(bounds, 0, ImagePlaneDesc::getAlphaComponents());
+
+    fillTestImage(img);
+    fillTestImage(original);
+    fillTestImage(mask);
+    {
+        // the mask must be in [0, 1]
+        Image::WriteAccess acc = mask->getWriteRights();
+        for (int y = bounds.y1; y < bounds.y2; ++y) {
+            float* pix = (float*)acc.pixelAt(bounds.x1, y);
+            for (int x = bounds.x1; x < bounds.x2; ++x, ++pix) {
+                *pix /= 15.f;
+            }
+        }
+    }
+    std::vector<float> expected = getTestImagePixels(img);
+    std::vector<float> maskPixels = getTestImagePixels(mask);
+    std::vector<float> originalPixels = getTestImagePixels(original);
+    std::bitset<4> processChannels;
+    processChannels[0] = processChannels[1] = processChannels[2] = true;
+
+    premultReference(img, expected, bounds, true);
+    maskMixReference(img, expected, mask, maskPixels, original, originalPixels, bounds, false, 0.5f);
+    copyAlphaReference(img, expected, original, originalPixels, bounds);
+
+    img->premultImage(bounds);
+    img->applyMaskMix(bounds, mask.get(), original.get(), true, false, 0.5f);
+    img->copyUnProcessedChannels(bounds, eImagePremultiplicationOpaque, eImagePremultiplicationOpaque, processChannels, original, false);
+    std::vector<float> actual = getTestImagePixels(img);
+    ASSERT_EQ( 0, std::memcmp( &expected[0], &actual[0], expected.size() * sizeof(float) ) );
+}
+
+// Measures the kernels that are applied to the output of the OpenFX renders on an HD RGBA image, compared to the
+// scalar versions above. This does not check anything: the average times, in microseconds, are recorded as properties
+// of the test in the XML report (--gtest_output=xml)
+TEST(ImageKernelsTest, Benchmark) {
+    RectI bounds(0, 0, 1920, 1080);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+    ImagePtr original = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+    ImagePtr mask = makeTestImage(bounds, 0, ImagePlaneDesc::getAlphaComponents());
+
+    fillTestImage(img);
+    fillTestImage(original);
+    fillTestImage(mask);
+    std::vector<float> pixels = getTestImagePixels(img);
+    std::vector<float> maskPixels = getTestImagePixels(mask);
+    std::vector<float> originalPixels = getTestImagePixels(original);
+    std::bitset<4> processChannels;
+    processChannels[0] = processChannels[1] = processChannels[2] = true;
+    const int nIterations = 10;
+
+    TimeLapse referenceTimer;
+    for (int i = 0; i < nIterations; ++i) {
+        premultReference(img, pixels, bounds, true);
+        maskMixReference(img, pixels, mask, maskPixels, original, originalPixels, bounds, false, 0.5f);
+        copyAlphaReference(img, pixels, original, originalPixels, bounds);
+    }
+    double referenceTime = referenceTimer.getTimeSinceCreation();
+
+    TimeLapse kernelsTimer;
+    for (int i = 0; i < nIterations; ++i) {
+        img->premultImage(bounds);
+        img->applyMaskMix(bounds, mask.get(), original.get(), true, false, 0.5f);
+        img->copyUnProcessedChannels(bounds, eImagePremultiplicationOpaque, eImagePremultiplicationOpaque, processChannels, original, false);
+    }
+    double kernelsTime = kernelsTimer.getTimeSinceCreation();
+
+    RecordProperty( "scalarMicroseconds", (int)(referenceTime * 1e6 / nIterations) );
+    RecordProperty( "kernelsMicroseconds", (int)(kernelsTime * 1e6 / nIterations) );
+}
+
+TEST(ImagePlanarTest, Channels) {
+    RectI bounds(-10, -20, 90, 60);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+
+    fillTestImage(img);
+    std::vector<float> pixels = getTestImagePixels(img);
+
+    // the window is partially outside of the image
+    RectI roi(-30, 0, 50, 80);
+    std::vector<int> channels;
+    channels.push_back(3);
+    channels.push_back(1);
+    std::vector<std::vector<float> > planes;
+    img->copyChannelsToPlanar(roi, channels, &planes);
+    ASSERT_EQ( channels.size(), planes.size() );
+
+    for (std::size_t c = 0; c < channels.size(); ++c) {
+        ASSERT_EQ( roi.area(), (U64)planes[c].size() );
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            for (int x = roi.x1; x < roi.x2; ++x) {
+                const float* pix = getTestImagePixel(img, pixels, x, y);
+                float expected = pix ? pix[channels[c]] : 0.f;
+                ASSERT_EQ( expected, planes[c][(y - roi.y1) * roi.width() + (x - roi.x1)] );
+            }
+        }
+    }
+}
+
+// A single-channel operation (the sum of a channel) gives the same result on an HD RGBA float image read
+// interleaved, as it is stored, and on the planar copy of that channel
+TEST(ImagePlanarTest, SingleChannelSum) {
+    RectI bounds(0, 0, 1920, 1080);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+
+    fillTestImage(img);
+    const int nComps = 4;
+    std::vector<float> pixels = getTestImagePixels(img);
+
+    double interleavedSum = 0.;
+    for (std::size_t p = 1; p < pixels.size(); p += nComps) {
+        interleavedSum += pixels[p];
+    }
+
+    std::vector<int> channels(1, 1);
+    std::vector<std::vector<float> > planes;
+    img->copyChannelsToPlanar(bounds, channels, &planes);
+    ASSERT_EQ( 1u, planes.size() );
+    ASSERT_EQ( bounds.area(), (U64)planes[0].size() );
+
+    double planarSum = 0.;
+    for (std::size_t p = 0; p < planes[0].size(); ++p) {
+        planarSum += planes[0][p];
+    }
+    EXPECT_EQ(interleavedSum, planarSum);
+}
+
+// Measures a single-channel operation (the sum of a channel) reading an HD RGBA float image interleaved, as it is
+// stored, and planar, including the conversion. This does not check anything: the times, in microseconds, are
+// recorded as properties of the test in the XML report (--gtest_output=xml)
+TEST(ImagePlanarTest, Benchmark) {
+    RectI bounds(0, 0, 1920, 1080);
+    ImagePtr img = makeTestImage(bounds, 0, ImagePlaneDesc::getRGBAComponents());
+
+    fillTestImage(img);
+    const int nIterations = 10;
+    const int nComps = 4;
+    std::vector<float> pixels = getTestImagePixels(img);
+
+    TimeLapse interleavedTimer;
+    double interleavedSum = 0.;
+    for (int i = 0; i < nIterations; ++i) {
+        for (std::size_t p = 1; p < pixels.size(); p += nComps) {
+            interleavedSum += pixels[p];
+        }
+    }
+    double interleavedTime = interleavedTimer.getTimeSinceCreation();
+
+    std::vector<int> channels(1, 1);
+    std::vector<std::vector<float> > planes;
+    TimeLapse conversionTimer;
+    img->copyChannelsToPlanar(bounds, channels, &planes);
+    double conversionTime = conversionTimer.getTimeSinceCreation();
+
+    TimeLapse planarTimer;
+    double planarSum = 0.;
+    for (int i = 0; i < nIterations; ++i) {
+        const std::vector<float>& plane = planes[0];
+        for (std::size_t p = 0; p < plane.size(); ++p) {
+            planarSum += plane[p];
+        }
+    }
+    double planarTime = planarTimer.getTimeSinceCreation();
+
+    // Keep the sums alive so that the loops are not optimized out
+    RecordProperty( "sumsMatch", (interleavedSum == planarSum) ? 1 : 0 );
+    RecordProperty( "interleavedMicroseconds", (int)(interleavedTime * 1e6 / nIterations) );
+    RecordProperty( "planarMicroseconds", (int)(planarTime * 1e6 / nIterations) );
+    RecordProperty( "conversionMicroseconds", (int)(conversionTime * 1e6) );
+}
@@ -0,0 +1,112 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/LRUHashTable.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+// Stands for a cache entry: only the eviction cost matters to the table
+struct CostEntry
+{
+    double cost;
+
+    CostEntry(double c)
+        : cost(c)
+    {
+    }
+
+    double getEvictionCost() const
+    {
+        return cost;
+    }
+};
+
+typedef boost::shared_ptr<CostEntry> CostEntryPtr;
+typedef BoostLRUHashTable<unsigned int, CostEntryPtr> CostTable;
+}
+
+TEST(LRUHashTable,
+     EvictCheapestEqualCostsIsLRU)
+{
+    CostTable table;
+
+    for (unsigned int i = 0; i < 5; ++i) {
+        table.insert( i, CostEntryPtr( new CostEntry(1.) ) );
+    }
+    for (unsigned int i = 0; i < 5; ++i) {
+        std::pair<unsigned int, CostEntryPtr> evicted = table.evictCheapest(16);
+        ASSERT_TRUE(evicted.second);
+        EXPECT_EQ(i, evicted.first);
+    }
+    EXPECT_EQ(0u, table.size());
+    EXPECT_FALSE( table.evictCheapest(16).second );
+}
+
+TEST(LRUHashTable,
+     EvictCheapestPrefersLowCost)
+{
+    CostTable table;
+
+    table.insert( 0, CostEntryPtr( new CostEntry(10.) ) );
+    table.insert( 1, CostEntryPtr( new CostEntry(5.) ) );
+    table.insert( 2, CostEntryPtr( new CostEntry(0.5) ) );
+    table.insert( 3, CostEntryPtr( new CostEntry(0.1) ) );
+
+    // Only the 3 oldest entries are candidates
+    std::pair<unsigned int, CostEntryPtr> evicted = table.evictCheapest(3);
+    ASSERT_TRUE(evicted.second);
+    EXPECT_EQ(2u, evicted.first);
+
+    evicted = table.evictCheapest(16);
+    ASSERT_TRUE(evicted.second);
+    EXPECT_EQ(3u, evicted.first);
+    EXPECT_EQ(2u, table.size());
+}
+
+TEST(LRUHashTable,
+     EvictCheapestSkipsEntriesInUse)
+{
+    CostTable table;
+    CostEntryPtr inUse( new CostEntry(0.) );
+
+    table.insert(0, inUse);
+    table.insert( 1, CostEntryPtr( new CostEntry(2.) ) );
+
+    std::pair<unsigned int, CostEntryPtr> evicted = table.evictCheapest(16);
+    ASSERT_TRUE(evicted.second);
+    EXPECT_EQ(1u, evicted.first);
+
+    // The only entry left is still referenced outside of the table
+    EXPECT_FALSE( table.evictCheapest(16).second );
+    EXPECT_EQ(1u, table.size());
+}
@@ -0,0 +1,279 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <list>
+#include <sstream> // stringstream
+#include <string>
+#include <gtest/gtest.h>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+GCC_DIAG_OFF(unused-parameter)
+// /opt/local/include/boost/serialization/smart_cast.hpp:254:25: warning: unused parameter 'u' [-Wunused-parameter]
+#include <boost/archive/xml_iarchive.hpp>
+#include <boost/archive/xml_oarchive.hpp>
+#include <boost/make_shared.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+#endif
+
+#include "Engine/AppInstance.h"
+#include "Engine/CreateNodeArgs.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Knob.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
+#include "Engine/NodeGroupSerialization.h"
+#include "Engine/NodeSerialization.h"
+#include "Engine/Project.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+NodePtr
+createNamedNode(const AppInstancePtr& app,
+                const NodeCollectionPtr& group,
+                const std::string& pluginID,
+                const std::string& name,
+                const std::string& multiInstanceParentName = std::string())
+{
+    CreateNodeArgs args(pluginID, group);
+
+    args.setProperty<std::string>(kCreateNodeArgsPropNodeInitialName, name);
+    args.setProperty<bool>(kCreateNodeArgsPropNodeGroupDisableCreateInitialNodes, true);
+    args.setProperty<bool>(kCreateNodeArgsPropAutoConnect, false);
+    args.setProperty<bool>(kCreateNodeArgsPropSilent, true);
+    if ( !multiInstanceParentName.empty() ) {
+        args.setProperty<std::string>(kCreateNodeArgsPropMultiInstanceParentName, multiInstanceParentName);
+    }
+    NodePtr node = app->createNode(args);
+    EXPECT_TRUE( bool(node) );
+    if (node) {
+        EXPECT_EQ( name, node->getScriptName() );
+    }
+
+    return node;
+}
+
+void
+setExpression(const NodePtr& node,
+              int dimension,
+              const std::string& expression)
+{
+    node->getKnobByName(kLifeTimeNodeKnobName)->setExpression(dimension, expression, false, false);
+}
+
+// Saves the nodes and loads them back, as the project loader sees them: the links to other nodes
+// are only known once loaded
+std::list<NodeSerializationPtr>
+saveAndLoad(const std::list<NodePtr>& nodes)
+{
+    NodeCollectionSerialization saved;
+
+    for (std::list<NodePtr>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        saved.addNodeSerialization( boost::make_shared<NodeSerialization>(*it) );
+    }
+
+    std::stringstream ss;
+    {
+        // xml_oarchive must be destroyed before reading ss, or the </boost_serialization> tag is missing
+        boost::archive::xml_oarchive oArchive(ss);
+        oArchive << boost::serialization::make_nvp("Nodes", saved);
+    }
+    NodeCollectionSerialization loaded;
+    {
+        boost::archive::xml_iarchive iArchive(ss);
+        iArchive >> boost::serialization::make_nvp("Nodes", loaded);
+    }
+
+    return loaded.getNodesSerialization();
+}
+
+std::list<std::string>
+getScriptNames(const std::list<NodeSerializationPtr>& nodes)
+{
+    std::list<std::string> ret;
+
+    for (std::list<NodeSerializationPtr>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        ret.push_back( (*it)->getNodeScriptName() );
+    }
+
+    return ret;
+}
+}
+
+// The output depends on nodes through its inputs, a cloned node, a parameter link, expressions (also from
+// within a group), and the multi-instance children of a needed node come along with their parent
+TEST_F(BaseTest, NodesNeededByOutputs)
+{
+    AppInstancePtr app = getApp();
+    NodeCollectionPtr project = app->getProject();
+    const std::string dot = PLUGINID_NATRON_DOT;
+
+    // "1e10" in an expression is a number, not a reference to this node
+    NodePtr e10 = createNamedNode(app, project, dot, "e10");
+    NodePtr upstream = createNamedNode(app, project, dot, "depsUpstream");
+    NodePtr unrelated = createNamedNode(app, project, dot, "depsUnrelated");
+    NodePtr input = createNamedNode(app, project, dot, "depsInput");
+    NodePtr cloneMaster = createNamedNode(app, project, dot, "depsCloneMaster");
+    NodePtr linkMaster = createNamedNode(app, project, dot, "depsLinkMaster");
+    NodePtr expr = createNamedNode(app, project, dot, "depsExpr");
+    NodePtr group = createNamedNode(app, project, PLUGINID_NATRON_GROUP, "depsGroup");
+    NodePtr fromGroup = createNamedNode(app, project, dot, "depsFromGroup");
+    NodePtr multiParent = createNamedNode(app, project, dot, "depsMultiParent");
+    NodePtr multiChild = createNamedNode(app, project, dot, "depsMultiChild", "depsMultiParent");
+    NodePtr output = createNamedNode(app, project, dot, "depsOutput");
+    ASSERT_TRUE( e10 && upstream && unrelated && input && cloneMaster && linkMaster && expr && group && fromGroup && multiParent && multiChild && output );
+
+    std::list<NodePtr> nodes;
+    nodes.push_back(e10);
+    nodes.push_back(upstream);
+    nodes.push_back(unrelated);
+    nodes.push_back(input);
+    nodes.push_back(cloneMaster);
+    nodes.push_back(linkMaster);
+    nodes.push_back(expr);
+    nodes.push_back(group);
+    nodes.push_back(fromGroup);
+    nodes.push_back(multiParent);
+    nodes.push_back(multiChild);
+    nodes.push_back(output);
+
+    NodeGroupPtr groupEffect = boost::dynamic_pointer_cast<NodeGroup>( group->getEffectInstance() );
+    ASSERT_TRUE( bool(groupEffect) );
+    NodePtr inGroup = createNamedNode(app, groupEffect, dot, "depsInGroup");
+    ASSERT_TRUE( bool(inGroup) );
+
+    connectNodes(input, output, 0, true);
+    connectNodes(upstream, input, 0, true);
+    upstream->getEffectInstance()->slaveAllKnobs(cloneMaster->getEffectInstance().get(), false);
+    ASSERT_EQ( cloneMaster, upstream->getMasterNode() );
+    ASSERT_TRUE( output->getKnobByName(kLifeTimeNodeKnobName)->slaveTo( 0, linkMaster->getKnobByName(kLifeTimeNodeKnobName), 0 ) );
+    setExpression(output, 1, "depsExpr.nodeLifeTime.get()[1] + 1e10");
+    setExpression(expr, 0, "depsGroup.depsInGroup.nodeLifeTime.get()[0]");
+    setExpression(inGroup, 0, "app.depsFromGroup.nodeLifeTime.get()[0]");
+    setExpression(input, 0, "depsMultiParent.nodeLifeTime.get()[0]");
+
+    std::list<NodeSerializationPtr> serialized = saveAndLoad(nodes);
+    ASSERT_EQ( nodes.size(), serialized.size() );
+
+    std::list<std::string> outputs;
+    outputs.push_back("depsOutput");
+    std::list<NodeSerializationPtr> needed, others;
+    EXPECT_TRUE( NodeCollectionSerialization::getNodesNeededByOutputs(serialized, outputs, &needed, &others) );
+    // both lists keep the order of the serialized nodes
+    std::list<std::string> expectedNeeded, expectedOthers;
+    expectedOthers.push_back("e10");
+    expectedNeeded.push_back("depsUpstream");
+    expectedOthers.push_back("depsUnrelated");
+    expectedNeeded.push_back("depsInput");
+    expectedNeeded.push_back("depsCloneMaster");
+    expectedNeeded.push_back("depsLinkMaster");
+    expectedNeeded.push_back("depsExpr");
+    expectedNeeded.push_back("depsGroup");
+    expectedNeeded.push_back("depsFromGroup");
+    expectedNeeded.push_back("depsMultiParent");
+    expectedNeeded.push_back("depsMultiChild");
+    expectedNeeded.push_back("depsOutput");
+    EXPECT_EQ( expectedNeeded, getScriptNames(needed) );
+    EXPECT_EQ( expectedOthers, getScriptNames(others) );
+
+    // an output inside a group needs the whole group
+    outputs.clear();
+    outputs.push_back("depsGroup.depsInGroup");
+    needed.clear();
+    others.clear();
+    EXPECT_TRUE( NodeCollectionSerialization::getNodesNeededByOutputs(serialized, outputs, &needed, &others) );
+    std::list<std::string> expectedGroupNeeded;
+    expectedGroupNeeded.push_back("depsGroup");
+    expectedGroupNeeded.push_back("depsFromGroup");
+    EXPECT_EQ( expectedGroupNeeded, getScriptNames(needed) );
+    EXPECT_EQ( nodes.size() - expectedGroupNeeded.size(), others.size() );
+}
+
+// When an output cannot be found, everything is loaded
+TEST_F(BaseTest, NodesNeededByUnknownOutput)
+{
+    AppInstancePtr app = getApp();
+    std::list<NodePtr> nodes;
+
+    nodes.push_back( createNamedNode(app, app->getProject(), PLUGINID_NATRON_DOT, "depsUnknownA") );
+    nodes.push_back( createNamedNode(app, app->getProject(), PLUGINID_NATRON_DOT, "depsUnknownB") );
+    ASSERT_TRUE( bool( nodes.front() ) && bool( nodes.back() ) );
+    connectNodes(nodes.front(), nodes.back(), 0, true);
+
+    std::list<NodeSerializationPtr> serialized = saveAndLoad(nodes);
+    std::list<std::string> outputs;
+    outputs.push_back("depsUnknownB");
+    outputs.push_back("depsNotInTheProject");
+    std::list<NodeSerializationPtr> needed, others;
+    EXPECT_FALSE( NodeCollectionSerialization::getNodesNeededByOutputs(serialized, outputs, &needed, &others) );
+    EXPECT_EQ( getScriptNames(serialized), getScriptNames(needed) );
+    EXPECT_TRUE( others.empty() );
+}
+
+// Python callbacks may reference any node: a needed node with a callback needs everything
+TEST_F(BaseTest, NodesNeededByOutputWithCallback)
+{
+    AppInstancePtr app = getApp();
+    NodePtr input = createNamedNode(app, app->getProject(), PLUGINID_NATRON_DOT, "depsCallbackInput");
+    NodePtr other = createNamedNode(app, app->getProject(), PLUGINID_NATRON_DOT, "depsCallbackOther");
+    NodePtr output = createNamedNode(app, app->getProject(), PLUGINID_NATRON_DOT, "depsCallbackOutput");
+    ASSERT_TRUE( input && other && output );
+    connectNodes(input, output, 0, true);
+
+    std::list<NodePtr> nodes;
+    nodes.push_back(input);
+    nodes.push_back(other);
+    nodes.push_back(output);
+
+    std::list<std::string> outputs;
+    outputs.push_back("depsCallbackOutput");
+
+    // The callback of a node that is not needed only runs once it is loaded
+    KnobStringPtr otherCallback = boost::dynamic_pointer_cast<KnobString>( other->getKnobByName("onParamChanged") );
+    ASSERT_TRUE( bool(otherCallback) );
+    otherCallback->setValue("myCallbacks.onOtherChanged");
+    std::list<NodeSerializationPtr> serialized = saveAndLoad(nodes);
+    std::list<NodeSerializationPtr> needed, others;
+    EXPECT_TRUE( NodeCollectionSerialization::getNodesNeededByOutputs(serialized, outputs, &needed, &others) );
+    std::list<std::string> expectedOthers;
+    expectedOthers.push_back("depsCallbackOther");
+    EXPECT_EQ( expectedOthers, getScriptNames(others) );
+
+    KnobStringPtr inputCallback = boost::dynamic_pointer_cast<KnobString>( input->getKnobByName("onParamChanged") );
+    ASSERT_TRUE( bool(inputCallback) );
+    inputCallback->setValue("myCallbacks.onInputChanged");
+    serialized = saveAndLoad(nodes);
+    needed.clear();
+    others.clear();
+    EXPECT_FALSE( NodeCollectionSerialization::getNodesNeededByOutputs(serialized, outputs, &needed, &others) );
+    EXPECT_EQ( getScriptNames(serialized), getScriptNames(needed) );
+    EXPECT_TRUE( others.empty() );
+}
@@ -0,0 +1,117 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+// The noise slope of each active node of the project, by script-name
+std::map<std::string, double>
+getNodesSlope(const ProjectPtr& project)
+{
+    std::map<std::string, double> ret;
+    NodesList nodes = project->getNodes();
+
+    for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        if ( !(*it)->isActivated() ) {
+            continue;
+        }
+        KnobDoublePtr slope = boost::dynamic_pointer_cast<KnobDouble>( (*it)->getKnobByName("noiseZSlope") );
+        ret[(*it)->getScriptName()] = slope ? slope->getValue() : 0.;
+    }
+
+    return ret;
+}
+}
+
+// Writes a full auto-save then a journal of the changes made since, and loads the auto-save back
+TEST_F(BaseTest, AutoSaveJournal)
+{
+    NodePtr changed = createNode(_generatorPluginID);
+    NodePtr unchanged = createNode(_generatorPluginID);
+    NodePtr removed = createNode(_generatorPluginID);
+    NodePtr other = createNode(_generatorPluginID);
+    ASSERT_TRUE( bool(changed) && bool(unchanged) && bool(removed) && bool(other) );
+
+    ProjectPtr project = getApp()->getProject();
+    const QString& binPath = appPTR->getApplicationBinaryPath();
+    QString projectName = QString::fromUtf8("test_autosave_journal.ntp");
+
+    // The first auto-save is a full one
+    ASSERT_TRUE( project->saveProject_imp(binPath, projectName, true, true) );
+    QString autoSavePath = project->getLastAutoSaveFilePath();
+    ASSERT_TRUE( QFile::exists(autoSavePath) );
+    QString journalPath = autoSavePath;
+    journalPath.replace( QString::fromUtf8(".autosave"), QString::fromUtf8(".autojournal") );
+    EXPECT_FALSE( QFile::exists(journalPath) );
+
+    // Change, remove and add less than half of the nodes: the next auto-save is a journal
+    KnobDoublePtr slope = boost::dynamic_pointer_cast<KnobDouble>( changed->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE( bool(slope) );
+    slope->setValue(0.25);
+    std::string removedName = removed->getScriptName();
+    removed->destroyNode(true, false);
+    removed.reset();
+    NodePtr added = createNode(_generatorPluginID);
+    ASSERT_TRUE( bool(added) );
+
+    ASSERT_TRUE( project->saveProject_imp(binPath, projectName, true, true) );
+    EXPECT_EQ( autoSavePath, project->getLastAutoSaveFilePath() );
+    ASSERT_TRUE( QFile::exists(journalPath) );
+
+    std::map<std::string, double> savedNodes = getNodesSlope(project);
+    EXPECT_EQ( 4U, savedNodes.size() );
+    EXPECT_TRUE( savedNodes.find(removedName) == savedNodes.end() );
+    EXPECT_EQ( 0.25, savedNodes[changed->getScriptName()] );
+    changed.reset();
+    unchanged.reset();
+    other.reset();
+    added.reset();
+
+    // Loading the auto-save applies the journal
+    QString autoSaveName = QFileInfo(autoSavePath).fileName();
+    ASSERT_TRUE( project->loadProject(binPath, autoSaveName, true) );
+    std::map<std::string, double> loadedNodes = getNodesSlope(project);
+    EXPECT_TRUE( savedNodes == loadedNodes );
+
+    QFile::remove(autoSavePath);
+    QFile::remove(journalPath);
+}
@@ -0,0 +1,89 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Curve.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/ViewIdx.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+// Sets keyframes from Python with setValuesAtTimes and reads them back with getKeyTimes, getKeyValues and getValuesAtTimes
+TEST_F(BaseTest, AnimatedParamValuesAtTimes)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator);
+    KnobDoublePtr slope = boost::dynamic_pointer_cast<KnobDouble>( generator->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE(slope);
+
+    // A linear keyframe that setValuesAtTimes replaces
+    slope->setValueAtTime(2, 5., ViewSpec::all(), 0);
+    KeyFrame newKey;
+    ASSERT_TRUE( slope->setInterpolationAtTime(eCurveChangeReasonInternal, ViewSpec::all(), 0, 2, eKeyframeTypeLinear, &newKey) );
+
+    std::stringstream ss;
+    ss << "param = " << getApp()->getAppIDString() << ".getNode(\"" << generator->getScriptName() << "\").getParam(\"noiseZSlope\")\n";
+    // Any sequence of numbers is accepted
+    ss << "if not param.setValuesAtTimes((1, 2, 3), [0.5, 0.25, 0.75], 0):\n";
+    ss << "    raise RuntimeError(\"setValuesAtTimes failed\")\n";
+    ss << "if param.setValuesAtTimes([4], [], 0):\n";
+    ss << "    raise RuntimeError(\"setValuesAtTimes accepted times and values of different sizes\")\n";
+    ss << "if list( param.getKeyTimes(0) ) != [1., 2., 3.]:\n";
+    ss << "    raise RuntimeError(\"getKeyTimes returned \" + str( param.getKeyTimes(0) ) )\n";
+    ss << "if list( param.getKeyValues(0) ) != [0.5, 0.25, 0.75]:\n";
+    ss << "    raise RuntimeError(\"getKeyValues returned \" + str( param.getKeyValues(0) ) )\n";
+    ss << "if list( param.getValuesAtTimes([3, 1, 2], 0) ) != [0.75, 0.5, 0.25]:\n";
+    ss << "    raise RuntimeError(\"getValuesAtTimes returned \" + str( param.getValuesAtTimes([3, 1, 2], 0) ) )\n";
+    ss << "if list( param.getValuesAtTimes([1.5], 0) ) != [param.getValueAtTime(1.5, 0)]:\n";
+    ss << "    raise RuntimeError(\"getValuesAtTimes differs from getValueAtTime\")\n";
+    std::string err;
+    std::string output;
+    EXPECT_TRUE( NATRON_PYTHON_NAMESPACE::interpretPythonScript(ss.str(), &err, &output) );
+    EXPECT_EQ( std::string(), err );
+
+    CurvePtr curve = slope->getCurve(ViewSpec::current(), 0);
+    ASSERT_TRUE(curve);
+    EXPECT_EQ( 3, curve->getKeyFramesCount() );
+
+    // The replaced keyframe only got its new value, the new ones are smooth
+    KeyFrame key;
+    ASSERT_TRUE( curve->getKeyFrameWithTime(2, &key) );
+    EXPECT_EQ( 0.25, key.getValue() );
+    EXPECT_EQ( eKeyframeTypeLinear, key.getInterpolation() );
+    ASSERT_TRUE( curve->getKeyFrameWithTime(1, &key) );
+    EXPECT_EQ( 0.5, key.getValue() );
+    EXPECT_EQ( eKeyframeTypeSmooth, key.getInterpolation() );
+    EXPECT_EQ( 0.75, slope->getValueAtTime(3, 0) );
+}
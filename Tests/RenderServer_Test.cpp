@@ -0,0 +1,229 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtNetwork/QLocalSocket>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Format.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/ProcessHandler.h"
+#include "Engine/Project.h"
+#include "Engine/ViewIdx.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+namespace {
+// A local client sending messages to the render server and recording its replies
+class RenderServerClientThread
+    : public QThread
+{
+public:
+
+    RenderServerClientThread(const QString& serverName,
+                             const QStringList& messages)
+        : QThread()
+        , serverName(serverName)
+        , messages(messages)
+        , replies()
+        , connected(false)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        QLocalSocket socket;
+
+        // The server may not be listening yet
+        for (int i = 0; i < 100 && !connected; ++i) {
+            socket.connectToServer(serverName);
+            connected = socket.waitForConnected(100);
+            if (!connected) {
+                msleep(50);
+            }
+        }
+        if (!connected) {
+            return;
+        }
+        Q_FOREACH(const QString &message, messages) {
+            socket.write( ( message + QLatin1Char('\n') ).toUtf8() );
+        }
+        socket.flush();
+        while ( socket.waitForReadyRead(2000) || socket.canReadLine() ) {
+            while ( socket.canReadLine() ) {
+                replies.push_back( QString::fromUtf8( socket.readLine() ).trimmed() );
+            }
+        }
+    }
+
+    QString serverName;
+    QStringList messages;
+    QStringList replies;
+    bool connected;
+};
+
+QString
+getServerName()
+{
+    return QString::fromUtf8("NatronRenderServerTest_") + QString::number( QCoreApplication::applicationPid() );
+}
+
+// Serves the messages of one client until it sends the quit message, and returns the replies of the server
+QStringList
+serve(RenderServer& server,
+      const AppInstancePtr& app,
+      const QStringList& messages)
+{
+    RenderServerClientThread client(getServerName(), messages);
+
+    client.start();
+    // Returns once the client sent the quit message
+    EXPECT_EQ( 0, server.exec(app) );
+    client.wait();
+    EXPECT_TRUE(client.connected);
+
+    return client.replies;
+}
+
+QString
+makeMessage(const char* command,
+            const QString& value = QString())
+{
+    QString ret = QString::fromUtf8(command);
+
+    if ( !value.isEmpty() ) {
+        ret += QLatin1Char(' ') + value;
+    }
+
+    return ret;
+}
+}
+
+// Each job gets exactly one reply, even when several of its lines are wrong
+TEST_F(BaseTest, RenderServerInvalidJobs)
+{
+    QStringList messages;
+
+    messages.push_back( makeMessage( kRenderServerProject, QString::fromUtf8("/nonexistent/project.ntp") ) );
+    messages.push_back( makeMessage( kRenderServerFrameRange, QString::fromUtf8("1-10:2") ) );
+    messages.push_back( makeMessage(kRenderServerRender) );
+    messages.push_back( makeMessage( kRenderServerFrameRange, QString::fromUtf8("notarange") ) );
+    messages.push_back( makeMessage( kRenderServerSetParam, QString::fromUtf8("novalue") ) );
+    messages.push_back( QString::fromUtf8("unknown") );
+    messages.push_back( makeMessage(kRenderServerRender) );
+    messages.push_back( makeMessage(kRenderServerQuit) );
+
+    RenderServer server( getServerName() );
+    QStringList replies = serve( server, getApp(), messages );
+
+    // The job with a missing project fails when rendered, the job with invalid lines fails once, with its first error
+    ASSERT_EQ( 2, replies.size() );
+    EXPECT_TRUE( replies[0].startsWith( QString::fromUtf8(kRenderServerJobErrorShort) ) );
+    EXPECT_TRUE( replies[1].startsWith( QString::fromUtf8(kRenderServerJobErrorShort) ) );
+    EXPECT_TRUE( replies[1].contains( QString::fromUtf8("notarange") ) );
+}
+
+// Renders a project, then renders it again with a parameter set: the loaded project is reused
+TEST_F(BaseTest, RenderServerJobs)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr writer = createNode(_writeOIIOPluginID);
+    ASSERT_TRUE( bool(generator) && bool(writer) );
+    connectNodes(generator, writer, 0, true);
+
+    ProjectPtr project = getApp()->getProject();
+    KnobIntPtr frameRange = boost::dynamic_pointer_cast<KnobInt>( project->getKnobByName("frameRange") );
+    ASSERT_TRUE( bool(frameRange) );
+    frameRange->setValue(1, ViewSpec::all(), 0);
+    frameRange->setValue(1, ViewSpec::all(), 1);
+    Format f(0, 0, 200, 200, "renderServerFormat", 1.);
+    project->setOrAddProjectFormat(f);
+
+    const QString& binPath = appPTR->getApplicationBinaryPath();
+    QString imagePath = binPath + QString::fromUtf8("/test_render_server.jpg");
+    QFile::remove(imagePath);
+    writer->setOutputFilesForWriter( imagePath.toStdString() );
+
+    std::string generatorName = generator->getScriptName();
+    QString writerName = QString::fromUtf8( writer->getScriptName().c_str() );
+    QString projectDir = binPath + QLatin1Char('/');
+    QString projectName = QString::fromUtf8("test_render_server.ntp");
+    QString projectPath = projectDir + projectName;
+    ASSERT_TRUE( project->saveProject(projectDir, projectName, 0) );
+    generator.reset();
+    writer.reset();
+
+    RenderServer server( getServerName() );
+
+    QStringList messages;
+    messages.push_back( makeMessage(kRenderServerProject, projectPath) );
+    messages.push_back( makeMessage(kRenderServerWriter, writerName) );
+    messages.push_back( makeMessage( kRenderServerFrameRange, QString::fromUtf8("1-1") ) );
+    messages.push_back( makeMessage(kRenderServerRender) );
+    messages.push_back( makeMessage(kRenderServerQuit) );
+    QStringList replies = serve( server, getApp(), messages );
+    ASSERT_EQ( 1, replies.size() );
+    EXPECT_EQ( QString::fromUtf8(kRenderServerJobFinishedShort), replies[0] );
+    EXPECT_TRUE( QFile::exists(imagePath) );
+    QFile::remove(imagePath);
+
+    // The nodes of the project loaded by the server
+    NodeWPtr loadedWriter = getApp()->getNodeByFullySpecifiedName( writerName.toStdString() );
+    ASSERT_TRUE( bool( loadedWriter.lock() ) );
+
+    messages.clear();
+    messages.push_back( makeMessage(kRenderServerProject, projectPath) );
+    messages.push_back( makeMessage(kRenderServerWriter, writerName) );
+    messages.push_back( makeMessage(kRenderServerSetParam, QString::fromUtf8( generatorName.c_str() ) + QString::fromUtf8(".noiseZSlope 0.25") ) );
+    messages.push_back( makeMessage(kRenderServerRender) );
+    messages.push_back( makeMessage(kRenderServerQuit) );
+    replies = serve( server, getApp(), messages );
+    ASSERT_EQ( 1, replies.size() );
+    EXPECT_EQ( QString::fromUtf8(kRenderServerJobFinishedShort), replies[0] );
+    EXPECT_TRUE( QFile::exists(imagePath) );
+    QFile::remove(imagePath);
+
+    // The project was not loaded again, and the parameter was set on it
+    NodePtr writerAfter = getApp()->getNodeByFullySpecifiedName( writerName.toStdString() );
+    EXPECT_TRUE( writerAfter && (writerAfter == loadedWriter.lock()) );
+    NodePtr generatorAfter = getApp()->getNodeByFullySpecifiedName(generatorName);
+    ASSERT_TRUE( bool(generatorAfter) );
+    KnobDoublePtr slope = boost::dynamic_pointer_cast<KnobDouble>( generatorAfter->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE( bool(slope) );
+    EXPECT_EQ( 0.25, slope->getValue() );
+
+    QFile::remove(projectPath);
+}
+
@@ -0,0 +1,87 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/RotoSpatialIndex.h"
+
+NATRON_NAMESPACE_USING
+
+TEST(RotoSpatialIndex,
+     QueryMatchesBruteForce)
+{
+    // A grid of small shapes, one large shape covering them and a null one
+    std::vector<RectD> boxes;
+
+    for (int y = 0; y < 10; ++y) {
+        for (int x = 0; x < 10; ++x) {
+            boxes.push_back( RectD(x * 100 + 10, y * 100 + 10, x * 100 + 60, y * 100 + 60) );
+        }
+    }
+    boxes.push_back( RectD(200, 200, 700, 500) );
+    boxes.push_back( RectD() );
+
+    RotoSpatialIndex index;
+    index.build(boxes);
+    EXPECT_EQ( RectD(10, 10, 960, 960), index.getBoundingBox() );
+
+    std::vector<RectD> tiles;
+    tiles.push_back( RectD(0, 0, 128, 128) );
+    tiles.push_back( RectD(65, 65, 105, 105) );
+    tiles.push_back( RectD(250, 250, 260, 260) );
+    tiles.push_back( RectD(-500, -500, 2000, 2000) );
+    tiles.push_back( RectD(2000, 2000, 2100, 2100) );
+
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        std::vector<int> expected;
+        for (std::size_t j = 0; j < boxes.size(); ++j) {
+            if ( boxes[j].intersects(tiles[i]) ) {
+                expected.push_back( (int)j );
+            }
+        }
+        std::vector<int> found;
+        index.query(tiles[i], &found);
+        EXPECT_EQ(expected, found);
+        EXPECT_EQ( !expected.empty(), index.intersects(tiles[i]) );
+    }
+}
+
+TEST(RotoSpatialIndex,
+     Empty)
+{
+    RotoSpatialIndex index;
+    std::vector<RectD> boxes(3);
+
+    index.build(boxes);
+    EXPECT_TRUE( index.getBoundingBox().isNull() );
+
+    std::vector<int> found;
+    index.query(RectD(0, 0, 100, 100), &found);
+    EXPECT_TRUE( found.empty() );
+    EXPECT_FALSE( index.intersects( RectD(0, 0, 100, 100) ) );
+}
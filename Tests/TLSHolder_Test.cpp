@@ -0,0 +1,232 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <https://natrongithub.github.io/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include <QtCore/QString>
+#include <QtCore/QThread>
+
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Project.h"
+#include "Engine/TLSHolder.h"
+
+NATRON_NAMESPACE_USING
+
+typedef TLSHolder<Project::ProjectTLSData> ProjectTLSHolder;
+typedef TLSHolder<EffectInstance::EffectTLSData> EffectTLSHolder;
+
+namespace {
+class CreateDataThread
+    : public QThread
+{
+public:
+
+    CreateDataThread(const ProjectTLSHolder* holder)
+        : QThread()
+        , holder(holder)
+        , hadDataBefore(true)
+        , sameDataTwice(false)
+        , hasDataAfterCleanup(true)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        hadDataBefore = (bool)holder->getTLSData();
+        holder->getOrCreateTLSData()->viewNames.push_back("thread");
+        sameDataTwice = holder->getOrCreateTLSData() == holder->getTLSData();
+        appPTR->getAppTLS()->cleanupTLSForThread();
+        hasDataAfterCleanup = (bool)holder->getTLSData();
+    }
+
+    const ProjectTLSHolder* holder;
+    bool hadDataBefore, sameDataTwice, hasDataAfterCleanup;
+};
+
+class SpawnedThread
+    : public QThread
+{
+public:
+
+    SpawnedThread(const EffectTLSHolder* holder,
+                  QThread* spawner,
+                  bool soft)
+        : QThread()
+        , holder(holder)
+        , spawner(spawner)
+        , soft(soft)
+        , data()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        if (soft) {
+            appPTR->getAppTLS()->softCopy(spawner, this);
+        } else {
+            appPTR->getAppTLS()->copyTLS(spawner, this);
+        }
+        data = holder->getTLSData();
+        appPTR->getAppTLS()->cleanupTLSForThread();
+    }
+
+    const EffectTLSHolder* holder;
+    QThread* spawner;
+    bool soft;
+    EffectInstance::EffectTLSDataPtr data;
+};
+
+// Looks up the data of every holder many times and checks it is always the data of this thread
+class LookupThread
+    : public QThread
+{
+public:
+
+    LookupThread(const std::vector<ProjectTLSHolder*>* holders,
+                 int nLookups)
+        : QThread()
+        , holders(holders)
+        , nLookups(nLookups)
+        , nMismatches(0)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        const std::string name = QString::number( (quintptr)this ).toStdString();
+
+        for (int i = 0; i < nLookups; ++i) {
+            Project::ProjectDataTLSPtr data = (*holders)[i % holders->size()]->getOrCreateTLSData();
+            if ( data->viewNames.empty() ) {
+                data->viewNames.push_back(name);
+            }
+            if ( (data->viewNames.size() != 1) || (data->viewNames[0] != name) ) {
+                ++nMismatches;
+            }
+        }
+        appPTR->getAppTLS()->cleanupTLSForThread();
+    }
+
+    const std::vector<ProjectTLSHolder*>* holders;
+    int nLookups;
+    int nMismatches;
+};
+}
+
+TEST(TLSHolder,
+     PerThreadData)
+{
+    boost::shared_ptr<ProjectTLSHolder> holder = boost::make_shared<ProjectTLSHolder>();
+
+    EXPECT_FALSE( holder->getTLSData() );
+    holder->getOrCreateTLSData()->viewNames.push_back("main");
+
+    CreateDataThread thread( holder.get() );
+    thread.start();
+    thread.wait();
+    EXPECT_FALSE(thread.hadDataBefore);
+    EXPECT_TRUE(thread.sameDataTwice);
+    EXPECT_FALSE(thread.hasDataAfterCleanup);
+
+    // The other thread did not touch the data of this one
+    ASSERT_TRUE( holder->getTLSData() );
+    ASSERT_EQ( 1u, holder->getTLSData()->viewNames.size() );
+    EXPECT_EQ( std::string("main"), holder->getTLSData()->viewNames[0] );
+}
+
+TEST(TLSHolder,
+     SlotReuse)
+{
+    boost::shared_ptr<ProjectTLSHolder> holder = boost::make_shared<ProjectTLSHolder>();
+
+    holder->getOrCreateTLSData()->viewNames.push_back("main");
+    holder.reset();
+
+    // The new holder most likely gets the slot of the destroyed one, which must be empty
+    holder = boost::make_shared<ProjectTLSHolder>();
+    EXPECT_FALSE( holder->getTLSData() );
+}
+
+TEST(TLSHolder,
+     CopyFromSpawnerThread)
+{
+    boost::shared_ptr<EffectTLSHolder> holder = boost::make_shared<EffectTLSHolder>();
+    EffectInstance::EffectTLSDataPtr data = holder->getOrCreateTLSData();
+
+    data->actionRecursionLevel = 3;
+
+    for (int soft = 0; soft < 2; ++soft) {
+        SpawnedThread thread(holder.get(), QThread::currentThread(), (bool)soft);
+        thread.start();
+        thread.wait();
+
+        // The spawned thread gets a copy of the TLS of the spawner thread
+        ASSERT_TRUE(thread.data);
+        EXPECT_NE(data, thread.data);
+        EXPECT_EQ(3, thread.data->actionRecursionLevel);
+    }
+    appPTR->getAppTLS()->cleanupTLSForThread();
+}
+
+TEST(TLSHolder,
+     ConcurrentLookups)
+{
+    const int nThreads = 16;
+    const int nLookups = 10000;
+    const int nHolders = 16;
+    std::vector<ProjectTLSHolder*> holders;
+
+    for (int i = 0; i < nHolders; ++i) {
+        holders.push_back( new ProjectTLSHolder() );
+    }
+
+    std::vector<LookupThread*> threads;
+    for (int i = 0; i < nThreads; ++i) {
+        threads.push_back( new LookupThread(&holders, nLookups) );
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->start();
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->wait();
+        EXPECT_EQ(0, threads[i]->nMismatches);
+        delete threads[i];
+    }
+
+    // The threads did not leave data in the holders for this thread
+    for (int i = 0; i < nHolders; ++i) {
+        EXPECT_FALSE( holders[i]->getTLSData() );
+        delete holders[i];
+    }
+}
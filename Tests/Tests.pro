@@ -42,12 +42,23 @@ include(../global.pri)
 SOURCES += \
     google-test/src/gtest-all.cc \
     google-mock/src/gmock-all.cc \
+    AbortableRender_Test.cpp \
     BaseTest.cpp \
+    BezierFlattening_Test.cpp \
+    BezierMotionBlur_Test.cpp \
+    CacheCompression_Test.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
     Lut_Test.cpp \
     KnobFile_Test.cpp \
+    LRUHashTable_Test.cpp \
+    NodeGroupSerialization_Test.cpp \
+    ProjectAutoSave_Test.cpp \
+    PyParameter_Test.cpp \
+    RenderServer_Test.cpp \
+    RotoSpatialIndex_Test.cpp \
     Curve_Test.cpp \
+    TLSHolder_Test.cpp \
     Tracker_Test.cpp \
     wmain.cpp
 